@@ -0,0 +1,167 @@
+#include "adc_sampler.h"
+
+#include <stdbool.h>
+
+#include "pico/stdlib.h"
+#include "hardware/adc.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+
+#define ADC_SAMPLER_CHANNELS 3                 // Ordem no FIFO: ADC0, ADC1, ADC4
+#define ADC_SAMPLER_RR_MASK ((1u << 0) | (1u << 1) | (1u << 4))
+#define ADC_SAMPLER_BLOCK_LEN (ADC_SAMPLER_DECIMATION * ADC_SAMPLER_CHANNELS)
+#define ADC_CLOCK_HZ 48000000u                 // clk_adc padrão (USB PLL)
+
+static uint16_t g_adc_buffers[2][ADC_SAMPLER_BLOCK_LEN];
+static int g_dma_channels[2];
+
+// Últimos valores publicados. 'g_publish_seq' é ímpar durante a escrita (na IRQ), então o
+// leitor repete a cópia se pegar uma atualização no meio.
+static volatile adc_sampler_values_t g_latest;
+static volatile uint32_t g_publish_seq = 0;
+
+// Somas de todos os conjuntos desde o último adc_sampler_take_mean() (oversampling do ciclo).
+// Só a IRQ e o consumidor, no mesmo núcleo, as tocam: basta desabilitar interrupções para ler.
+static uint32_t g_acc_sums[ADC_SAMPLER_CHANNELS];
+static uint32_t g_acc_sets = 0;
+
+// Janela de adc_sampler_watch(): raio 0 = desligada.
+static volatile uint16_t g_watch_vrx, g_watch_vry, g_watch_radius = 0;
+static volatile uint32_t g_wake_count = 0;
+
+static void adc_sampler_publish(const uint16_t *block) {
+    uint32_t sums[ADC_SAMPLER_CHANNELS] = {0};
+    for (int i = 0; i < ADC_SAMPLER_BLOCK_LEN; i += ADC_SAMPLER_CHANNELS) {
+        sums[0] += block[i];
+        sums[1] += block[i + 1];
+        sums[2] += block[i + 2];
+    }
+    g_acc_sums[0] += sums[0];
+    g_acc_sums[1] += sums[1];
+    g_acc_sums[2] += sums[2];
+    g_acc_sets += ADC_SAMPLER_DECIMATION;
+
+    uint16_t radius = g_watch_radius;
+    if (radius > 0) {
+        int32_t dx = (int32_t)(sums[1] / ADC_SAMPLER_DECIMATION) - g_watch_vrx;
+        int32_t dy = (int32_t)(sums[0] / ADC_SAMPLER_DECIMATION) - g_watch_vry;
+        if (dx > radius || dx < -radius || dy > radius || dy < -radius) {
+            g_wake_count++; // A própria IRQ tira o núcleo do WFE; o laço confere o contador
+        }
+    }
+
+    g_publish_seq++;
+    __dmb();
+    g_latest.vry = (uint16_t)(sums[0] / ADC_SAMPLER_DECIMATION);
+    g_latest.vrx = (uint16_t)(sums[1] / ADC_SAMPLER_DECIMATION);
+    g_latest.temp_raw = (uint16_t)(sums[2] / ADC_SAMPLER_DECIMATION);
+    g_latest.sequence++;
+    __dmb();
+    g_publish_seq++;
+}
+
+// Um canal de DMA terminou seu buffer (o outro já assumiu pelo encadeamento):
+// publica a média e rearma o endereço de escrita para a próxima volta.
+static void adc_sampler_dma_irq_handler(void) {
+    for (int i = 0; i < 2; i++) {
+        if (dma_channel_get_irq1_status(g_dma_channels[i])) {
+            dma_channel_acknowledge_irq1(g_dma_channels[i]);
+            adc_sampler_publish(g_adc_buffers[i]);
+            dma_channel_set_write_addr(g_dma_channels[i], g_adc_buffers[i], false);
+        }
+    }
+}
+
+// Uma conversão a cada (1 + div) ciclos de clk_adc; são 3 conversões por conjunto.
+static void adc_sampler_apply_rate(uint32_t rate_hz) {
+    if (rate_hz < 1000) rate_hz = 1000;
+    if (rate_hz > 10000) rate_hz = 10000;
+    adc_set_clkdiv((float)ADC_CLOCK_HZ / (float)(rate_hz * ADC_SAMPLER_CHANNELS) - 1.0f);
+}
+
+void adc_sampler_init(uint32_t rate_hz) {
+
+    adc_init();
+    adc_set_temp_sensor_enabled(true);
+    adc_select_input(0); // O round-robin começa no ADC0: mantém o alinhamento dos blocos
+    adc_set_round_robin(ADC_SAMPLER_RR_MASK);
+    adc_fifo_setup(true,   // Escreve cada conversão no FIFO
+                   true,   // Habilita DREQ para o DMA
+                   1,      // DREQ a cada amostra
+                   false,  // Sem bit de erro no FIFO (mantém 12 bits limpos)
+                   false); // Amostras de 16 bits
+    adc_sampler_apply_rate(rate_hz);
+
+    g_dma_channels[0] = dma_claim_unused_channel(true);
+    g_dma_channels[1] = dma_claim_unused_channel(true);
+    for (int i = 0; i < 2; i++) {
+        dma_channel_config config = dma_channel_get_default_config(g_dma_channels[i]);
+        channel_config_set_transfer_data_size(&config, DMA_SIZE_16);
+        channel_config_set_read_increment(&config, false);  // Sempre o registrador do FIFO
+        channel_config_set_write_increment(&config, true);
+        channel_config_set_dreq(&config, DREQ_ADC);
+        channel_config_set_chain_to(&config, g_dma_channels[i ^ 1]); // Pingue-pongue
+        dma_channel_configure(g_dma_channels[i], &config, g_adc_buffers[i], &adc_hw->fifo,
+                              ADC_SAMPLER_BLOCK_LEN, false);
+        dma_channel_set_irq1_enabled(g_dma_channels[i], true);
+    }
+    // DMA_IRQ_1 compartilhado: não interfere com outros usuários de DMA (ex.: driver do CYW43)
+    irq_add_shared_handler(DMA_IRQ_1, adc_sampler_dma_irq_handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_1, true);
+
+    dma_channel_start(g_dma_channels[0]);
+    adc_run(true);
+}
+
+void adc_sampler_get_latest(adc_sampler_values_t *out) {
+    uint32_t seq;
+    do {
+        seq = g_publish_seq;
+        __dmb();
+        out->vry = g_latest.vry;
+        out->vrx = g_latest.vrx;
+        out->temp_raw = g_latest.temp_raw;
+        out->sequence = g_latest.sequence;
+        __dmb();
+    } while ((seq & 1u) != 0 || seq != g_publish_seq);
+}
+
+void adc_sampler_take_mean(adc_sampler_values_t *out) {
+    uint32_t sums[ADC_SAMPLER_CHANNELS];
+    uint32_t status = save_and_disable_interrupts();
+    uint32_t sets = g_acc_sets;
+    sums[0] = g_acc_sums[0];
+    sums[1] = g_acc_sums[1];
+    sums[2] = g_acc_sums[2];
+    g_acc_sums[0] = g_acc_sums[1] = g_acc_sums[2] = 0;
+    g_acc_sets = 0;
+    uint32_t sequence = g_latest.sequence;
+    restore_interrupts(status);
+
+    if (sets == 0) {
+        // Nenhum buffer completo desde a última chamada: repete a última média
+        adc_sampler_get_latest(out);
+        return;
+    }
+    out->vry = (uint16_t)((sums[0] + sets / 2) / sets);
+    out->vrx = (uint16_t)((sums[1] + sets / 2) / sets);
+    out->temp_raw = (uint16_t)((sums[2] + sets / 2) / sets);
+    out->sequence = sequence;
+}
+
+void adc_sampler_set_rate(uint32_t rate_hz) {
+    adc_sampler_apply_rate(rate_hz); // O divisor vale a partir da próxima conversão
+}
+
+void adc_sampler_watch(uint16_t center_vrx, uint16_t center_vry, uint16_t radius) {
+    uint32_t status = save_and_disable_interrupts();
+    g_watch_vrx = center_vrx;
+    g_watch_vry = center_vry;
+    g_watch_radius = radius;
+    restore_interrupts(status);
+}
+
+uint32_t adc_sampler_wake_count(void) {
+    return g_wake_count;
+}
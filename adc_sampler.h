@@ -0,0 +1,56 @@
+/**
+ * @file adc_sampler.h
+ * @brief Amostragem contínua do ADC (joystick + sensor de temperatura) via DMA.
+ *
+ * O ADC roda em modo round-robin nos canais 0 (VRy), 1 (VRx) e 4 (temperatura). O FIFO é
+ * esvaziado por dois canais de DMA encadeados em pingue-pongue sobre dois buffers; a cada buffer
+ * completo, a interrupção do DMA calcula a média (decimação) de cada canal e publica os valores.
+ * Os consumidores só leem os últimos valores, sem nunca tocar no ADC nem no multiplexador.
+ *
+ * A IRQ também acumula as somas de todos os buffers; adc_sampler_take_mean() devolve a média de
+ * tudo o que foi convertido desde a chamada anterior (oversampling sobre o ciclo inteiro do
+ * consumidor, em vez de só os últimos ADC_SAMPLER_DECIMATION conjuntos).
+ *
+ * Com adc_sampler_watch() ligado, a IRQ compara a média de cada buffer com uma janela em torno do
+ * centro do joystick e conta as saídas: o laço de aquisição dorme no modo ocioso e acorda assim
+ * que o joystick se mexe (a cada buffer, ~16 ms a ADC_SAMPLER_IDLE_RATE_HZ), sem esperar o período.
+ */
+
+#ifndef ADC_SAMPLER_H
+#define ADC_SAMPLER_H
+
+#include <stdint.h>
+
+// Conjuntos que adc_sampler_take_mean() soma por ciclo do núcleo 1 (sample_scheduler.h): na rajada,
+// 4 kHz x 5 ms = ~20; no ocioso, 1 kHz x 500 ms = ~500
+#define ADC_SAMPLER_RATE_HZ 4000       // Conjuntos (VRy, VRx, temp) por segundo: 1000 a 10000
+#define ADC_SAMPLER_IDLE_RATE_HZ 1000  // No modo ocioso (sample_scheduler.h): 4x menos IRQs
+#define ADC_SAMPLER_DECIMATION 16      // Conjuntos por buffer; cada publicação é a média deles
+
+typedef struct {
+    uint16_t vry;            // ADC0 (GPIO26)
+    uint16_t vrx;            // ADC1 (GPIO27)
+    uint16_t temp_raw;       // ADC4 (sensor interno)
+    uint32_t sequence;       // Incrementado a cada publicação (buffer de DMA completo)
+} adc_sampler_values_t;
+
+// Configura ADC, round-robin, FIFO e DMA e inicia a conversão contínua.
+// Os pinos do joystick já devem ter sido configurados com adc_gpio_init().
+void adc_sampler_init(uint32_t rate_hz);
+
+// Copia os últimos valores decimados (consistentes entre si).
+void adc_sampler_get_latest(adc_sampler_values_t *out);
+
+// Média de todos os conjuntos convertidos desde a chamada anterior, e zera o acumulador. Chamar
+// só no núcleo da IRQ (o de adc_sampler_init); sem buffer novo, devolve adc_sampler_get_latest().
+void adc_sampler_take_mean(adc_sampler_values_t *out);
+
+// Troca a taxa de conversão (mesma faixa de adc_sampler_init) sem parar o DMA.
+void adc_sampler_set_rate(uint32_t rate_hz);
+
+// Liga (radius > 0) ou desliga (0) a vigilância: cada buffer com VRx ou VRy a mais de 'radius' do
+// centro incrementa adc_sampler_wake_count().
+void adc_sampler_watch(uint16_t center_vrx, uint16_t center_vry, uint16_t radius);
+uint32_t adc_sampler_wake_count(void);
+
+#endif /* ADC_SAMPLER_H */
@@ -0,0 +1,180 @@
+#include "button_events.h"
+
+#include "pico/stdlib.h"
+#include "hardware/gpio.h"
+
+#include "input_classifier.h"
+
+#define BUTTON_EDGE_MASK (GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE)
+#define BUTTON_EVENTS_BARRIER() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+typedef struct {
+    unsigned pin;
+    button_debounce_t debounce;   // Com a captura desligada, a IRQ do pino fica desligada durante a janela
+} button_tracker_t;
+
+// Anel com um único produtor e leitores não destrutivos (eventos confirmados ou bordas brutas).
+typedef struct {
+    button_event_t *slots;
+    uint32_t mask;                // Tamanho - 1 (potência de 2)
+    volatile uint32_t head_seq;
+} button_ring_t;
+
+static button_tracker_t g_buttons[BUTTON_ID_COUNT];
+static alarm_pool_t *g_debounce_pool = NULL;
+static volatile bool g_capture_edges = false;
+
+static button_event_t g_event_slots[BUTTON_EVENTS_RING_SIZE];
+static button_event_t g_edge_slots[BUTTON_EDGES_RING_SIZE];
+static button_ring_t g_events = { g_event_slots, BUTTON_EVENTS_RING_SIZE - 1, 0 };
+static button_ring_t g_edges = { g_edge_slots, BUTTON_EDGES_RING_SIZE - 1, 0 };
+static volatile button_event_stats_t g_stats;
+
+// Único produtor: invalida o slot, preenche e só então publica a sequência.
+static void button_ring_push(button_ring_t *ring, button_id_t button, bool pressed, uint64_t timestamp_us, uint32_t duration_us) {
+    uint32_t seq = ring->head_seq + 1;
+    button_event_t *slot = &ring->slots[seq & ring->mask];
+    slot->seq = 0;
+    BUTTON_EVENTS_BARRIER();
+    slot->timestamp_us = timestamp_us;
+    slot->duration_us = duration_us;
+    slot->button = (uint8_t)button;
+    slot->pressed = pressed;
+    BUTTON_EVENTS_BARRIER();
+    slot->seq = seq;
+    BUTTON_EVENTS_BARRIER();
+    ring->head_seq = seq;
+}
+
+static size_t button_ring_read_since(const button_ring_t *ring, uint32_t since, button_event_t *out, size_t max) {
+    uint32_t head = ring->head_seq;
+    BUTTON_EVENTS_BARRIER();
+
+    uint32_t size = ring->mask + 1;
+    uint32_t first = since + 1;
+    if (head >= size && first < head - size + 1) {
+        first = head - size + 1; // Os mais antigos já foram sobrescritos
+    }
+
+    size_t count = 0;
+    for (uint32_t seq = first; seq <= head && count < max; seq++) {
+        const button_event_t *slot = &ring->slots[seq & ring->mask];
+        uint32_t seq_before = slot->seq;
+        BUTTON_EVENTS_BARRIER();
+        out[count] = *slot;
+        BUTTON_EVENTS_BARRIER();
+        if (seq_before == seq && slot->seq == seq) {
+            count++; // Cópia válida; senão o produtor sobrescreveu o slot durante a leitura
+        }
+    }
+    return count;
+}
+
+static void button_rearm_irq(button_tracker_t *tracker);
+
+static int64_t button_debounce_alarm_callback(alarm_id_t id, void *user_data) {
+    button_tracker_t *tracker = (button_tracker_t *)user_data;
+    button_id_t button = (button_id_t)(tracker - g_buttons);
+    bool pressed = !gpio_get(tracker->pin); // Pull-up: pressionado = nível baixo
+
+    button_debounce_event_t event;
+    if (button_debounce_settle(&tracker->debounce, pressed, &event)) {
+        if (event.pressed) {
+            g_stats.press_count[button]++;
+        } else {
+            g_stats.last_duration_us[button] = event.duration_us;
+        }
+        button_ring_push(&g_events, button, event.pressed, event.timestamp_us, event.duration_us);
+    }
+
+    button_rearm_irq(tracker);
+    return 0; // Não repete
+}
+
+static void button_start_debounce(button_tracker_t *tracker, uint64_t edge_time_us) {
+    if (!button_debounce_edge(&tracker->debounce, edge_time_us)) {
+        return; // Repique dentro da janela (só chega aqui com a captura de bordas ligada)
+    }
+    if (!g_capture_edges) {
+        gpio_set_irq_enabled(tracker->pin, BUTTON_EDGE_MASK, false); // Ignora o repique até o alarme
+    }
+    if (alarm_pool_add_alarm_in_us(g_debounce_pool, BUTTON_DEBOUNCE_US, button_debounce_alarm_callback, tracker, true) < 0) {
+        // Sem alarmes livres: aceita o nível atual imediatamente
+        button_debounce_alarm_callback(0, tracker);
+    }
+}
+
+static void button_rearm_irq(button_tracker_t *tracker) {
+    gpio_acknowledge_irq(tracker->pin, BUTTON_EDGE_MASK);
+    gpio_set_irq_enabled(tracker->pin, BUTTON_EDGE_MASK, true);
+    // Uma borda entre a leitura no alarme e a reativação da IRQ seria perdida: confere o nível.
+    bool pressed = !gpio_get(tracker->pin);
+    if (pressed != tracker->debounce.stable_pressed) {
+        button_start_debounce(tracker, time_us_64());
+    }
+}
+
+static void button_gpio_irq_callback(unsigned gpio, uint32_t event_mask) {
+    uint64_t now_us = time_us_64();
+    for (int i = 0; i < BUTTON_ID_COUNT; i++) {
+        if (g_buttons[i].pin != gpio) {
+            continue;
+        }
+        if (g_capture_edges) {
+            button_ring_push(&g_edges, (button_id_t)i, !gpio_get(gpio), now_us, 0);
+        }
+        button_start_debounce(&g_buttons[i], now_us);
+    }
+}
+
+void button_events_init(unsigned pin_a, unsigned pin_b) {
+    g_buttons[BUTTON_ID_A].pin = pin_a;
+    g_buttons[BUTTON_ID_B].pin = pin_b;
+    for (int i = 0; i < BUTTON_ID_COUNT; i++) {
+        button_debounce_init(&g_buttons[i].debounce, !gpio_get(g_buttons[i].pin));
+    }
+
+    // Pool de alarmes próprio: os callbacks rodam neste núcleo, junto com a IRQ do GPIO,
+    // o que mantém um único produtor para o anel.
+    g_debounce_pool = alarm_pool_create_with_unused_hardware_alarm(BUTTON_ID_COUNT + 1);
+
+    gpio_set_irq_enabled_with_callback(pin_a, BUTTON_EDGE_MASK, true, button_gpio_irq_callback);
+    gpio_set_irq_enabled(pin_b, BUTTON_EDGE_MASK, true);
+}
+
+size_t button_events_read_since(uint32_t since, button_event_t *out, size_t max) {
+    return button_ring_read_since(&g_events, since, out, max);
+}
+
+uint32_t button_events_latest_seq(void) {
+    return g_events.head_seq;
+}
+
+void button_events_get_stats(button_event_stats_t *out) {
+    for (int i = 0; i < BUTTON_ID_COUNT; i++) {
+        out->press_count[i] = g_stats.press_count[i];
+        out->last_duration_us[i] = g_stats.last_duration_us[i];
+    }
+}
+
+void button_events_capture_edges(bool enable) {
+    g_capture_edges = enable;
+}
+
+size_t button_events_read_edges_since(uint32_t since, button_event_t *out, size_t max) {
+    return button_ring_read_since(&g_edges, since, out, max);
+}
+
+uint32_t button_events_latest_edge_seq(void) {
+    return g_edges.head_seq;
+}
+
+uint8_t button_events_raw_levels(void) {
+    uint8_t bits = 0;
+    for (int i = 0; i < BUTTON_ID_COUNT; i++) {
+        if (!gpio_get(g_buttons[i].pin)) {
+            bits |= (uint8_t)(1u << i);
+        }
+    }
+    return bits;
+}
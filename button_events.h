@@ -0,0 +1,70 @@
+/**
+ * @file button_events.h
+ * @brief Captura dos botões por interrupção, com debounce por timer e histórico em anel.
+ *
+ * Cada borda dispara a IRQ do GPIO, que guarda o instante (µs) e agenda um alarme de debounce;
+ * só então o nível é confirmado e um evento de pressionamento/soltura é publicado. Os eventos
+ * ficam num anel de tamanho fixo com um único produtor (o alarme) e leitores não destrutivos:
+ * cada leitor guarda o último número de sequência visto e pede apenas os novos.
+ *
+ * Para o trace de entradas (input_trace.h) a captura de bordas pode ser ligada: a IRQ continua
+ * ativa durante a janela de debounce e cada borda, inclusive o repique, vai para um segundo anel
+ * com o nível lido no pino. O debounce em si (input_classifier.h) não muda.
+ *
+ * Tudo (IRQ do GPIO e pool de alarmes) é registrado no núcleo que chama button_events_init().
+ */
+
+#ifndef BUTTON_EVENTS_H
+#define BUTTON_EVENTS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define BUTTON_EVENTS_RING_SIZE 32     // Potência de 2
+#define BUTTON_EDGES_RING_SIZE 64      // Bordas brutas (captura ligada); potência de 2
+#define BUTTON_DEBOUNCE_US 5000        // Tempo que o nível precisa ficar estável após a borda
+
+typedef enum {
+    BUTTON_ID_A = 0,
+    BUTTON_ID_B = 1,
+    BUTTON_ID_COUNT
+} button_id_t;
+
+typedef struct {
+    uint32_t seq;              // 1, 2, 3... (0 = slot vazio/em escrita)
+    uint64_t timestamp_us;     // Instante da borda que originou o evento
+    uint32_t duration_us;      // Na soltura: quanto tempo o botão ficou pressionado
+    uint8_t button;            // button_id_t
+    bool pressed;              // true = pressionamento, false = soltura
+} button_event_t;
+
+typedef struct {
+    uint32_t press_count[BUTTON_ID_COUNT];
+    uint32_t last_duration_us[BUTTON_ID_COUNT];
+} button_event_stats_t;
+
+// Configura as IRQs de borda dos dois pinos (já inicializados como entrada com pull-up).
+void button_events_init(unsigned pin_a, unsigned pin_b);
+
+// Copia até 'max' eventos com seq > 'since', do mais antigo ao mais novo. Eventos que já foram
+// sobrescritos no anel são pulados. Retorna quantos foram copiados.
+size_t button_events_read_since(uint32_t since, button_event_t *out, size_t max);
+
+// Número de sequência do evento mais recente (0 se nenhum).
+uint32_t button_events_latest_seq(void);
+
+void button_events_get_stats(button_event_stats_t *out);
+
+// Liga/desliga a captura de bordas brutas.
+void button_events_capture_edges(bool enable);
+
+// Como button_events_read_since, para as bordas brutas: 'pressed' é o nível no pino logo após a
+// borda e 'duration_us' é sempre 0.
+size_t button_events_read_edges_since(uint32_t since, button_event_t *out, size_t max);
+uint32_t button_events_latest_edge_seq(void);
+
+// Nível atual dos pinos, sem debounce: bit0 = A pressionado, bit1 = B pressionado.
+uint8_t button_events_raw_levels(void);
+
+#endif /* BUTTON_EVENTS_H */
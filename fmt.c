@@ -0,0 +1,91 @@
+#include "fmt.h"
+
+#include <string.h>
+
+void fmt_mem(fmt_buf_t *buf, const char *data, size_t len) {
+    size_t room = buf->size - buf->len;
+    if (len > room) {
+        len = room;
+        buf->overflow = true;
+    }
+    memcpy(buf->data + buf->len, data, len);
+    buf->len += len;
+}
+
+void fmt_str(fmt_buf_t *buf, const char *str) {
+    fmt_mem(buf, str, strlen(str));
+}
+
+void fmt_char(fmt_buf_t *buf, char c) {
+    if (buf->len < buf->size) {
+        buf->data[buf->len++] = c;
+    } else {
+        buf->overflow = true;
+    }
+}
+
+void fmt_u32(fmt_buf_t *buf, uint32_t value) {
+    char digits[10];
+    size_t n = sizeof(digits);
+    do {
+        digits[--n] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    fmt_mem(buf, digits + n, sizeof(digits) - n);
+}
+
+void fmt_u64(fmt_buf_t *buf, uint64_t value) {
+    if (value <= UINT32_MAX) {
+        fmt_u32(buf, (uint32_t)value); // Caso comum: evita a divisão de 64 bits em software
+        return;
+    }
+    char digits[20];
+    size_t n = sizeof(digits);
+    do {
+        digits[--n] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    fmt_mem(buf, digits + n, sizeof(digits) - n);
+}
+
+void fmt_i32(fmt_buf_t *buf, int32_t value) {
+    if (value < 0) {
+        fmt_char(buf, '-');
+        fmt_u32(buf, 0u - (uint32_t)value);
+    } else {
+        fmt_u32(buf, (uint32_t)value);
+    }
+}
+
+void fmt_hex(fmt_buf_t *buf, uint32_t value) {
+    static const char hex[] = "0123456789abcdef";
+    char digits[8];
+    size_t n = sizeof(digits);
+    do {
+        digits[--n] = hex[value & 0xF];
+        value >>= 4;
+    } while (value != 0);
+    fmt_mem(buf, digits + n, sizeof(digits) - n);
+}
+
+void fmt_centi(fmt_buf_t *buf, int32_t centi) {
+    uint32_t magnitude = (centi < 0) ? 0u - (uint32_t)centi : (uint32_t)centi;
+    if (centi < 0) {
+        fmt_char(buf, '-');
+    }
+    uint32_t fraction = magnitude % 100;
+    fmt_u32(buf, magnitude / 100);
+    char tail[3] = { '.', (char)('0' + fraction / 10), (char)('0' + fraction % 10) };
+    fmt_mem(buf, tail, sizeof(tail));
+}
+
+const char *fmt_cstr(fmt_buf_t *buf) {
+    if (buf->len < buf->size) {
+        buf->data[buf->len] = '\0';
+    } else if (buf->size > 0) {
+        buf->data[buf->size - 1] = '\0';
+        buf->len = buf->size - 1;
+        buf->overflow = true;
+    }
+    return buf->data;
+}
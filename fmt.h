@@ -0,0 +1,50 @@
+/**
+ * @file fmt.h
+ * @brief Formatação de texto sem snprintf para as respostas: inteiros, hexadecimal e valores em
+ * centésimos ("27.53"), acrescentados a um buffer com limite.
+ *
+ * No Cortex-M0+ cada snprintf interpreta a string de formato em tempo de execução e, com "%f",
+ * ainda passa por ponto flutuante em software. Aqui cada campo é uma chamada direta: dígitos por
+ * divisão inteira (o divisor em hardware do RP2040 atende o '/') e texto por memcpy.
+ *
+ * Como o snprintf, nunca escreve além de 'size': o que não couber é descartado e 'overflow' fica
+ * verdadeiro. O texto não é terminado em '\0' (use fmt_cstr se precisar).
+ */
+
+#ifndef FMT_H
+#define FMT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    char *data;
+    size_t len;
+    size_t size;
+    bool overflow;
+} fmt_buf_t;
+
+static inline void fmt_init(fmt_buf_t *buf, char *data, size_t size) {
+    buf->data = data;
+    buf->len = 0;
+    buf->size = size;
+    buf->overflow = false;
+}
+
+void fmt_mem(fmt_buf_t *buf, const char *data, size_t len);
+void fmt_str(fmt_buf_t *buf, const char *str);
+void fmt_char(fmt_buf_t *buf, char c);
+void fmt_u32(fmt_buf_t *buf, uint32_t value);
+void fmt_u64(fmt_buf_t *buf, uint64_t value);
+void fmt_i32(fmt_buf_t *buf, int32_t value);
+void fmt_hex(fmt_buf_t *buf, uint32_t value);        // Minúsculas, sem "0x" (tamanho de chunk)
+void fmt_centi(fmt_buf_t *buf, int32_t centi);       // -1234 => "-12.34"
+
+// Termina em '\0' (conta no limite, não em 'len'). Retorna o texto.
+const char *fmt_cstr(fmt_buf_t *buf);
+
+// Literal de string, sem strlen em tempo de execução.
+#define FMT_LIT(buf, literal) fmt_mem((buf), (literal), sizeof(literal) - 1)
+
+#endif /* FMT_H */
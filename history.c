@@ -0,0 +1,316 @@
+#include "history.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "fmt.h"
+
+#define HISTORY_BARRIER() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define HISTORY_ROLLUP_LEVELS 2          // 1 s e 1 min
+
+// Amostra bruta: só os valores, sem min/max/média (o anel maior fica com 24 bytes por slot).
+typedef struct {
+    uint32_t seq;                        // 0 = slot vazio/em escrita
+    uint16_t vrx;
+    uint16_t vry;
+    uint16_t temp_raw;
+    uint8_t buttons;
+    uint64_t timestamp_us;
+} history_raw_slot_t;
+
+typedef struct {
+    uint32_t seq;
+    history_point_t point;
+} history_rollup_slot_t;
+
+// Intervalo em agregação (só o núcleo 1 acessa).
+typedef struct {
+    uint64_t period_index;               // timestamp_us / período
+    uint32_t count;
+    uint32_t sum[HISTORY_CH_COUNT];      // Até 60 s a 200 Hz de 12 bits: cabe com folga
+    uint16_t min[HISTORY_CH_COUNT];
+    uint16_t max[HISTORY_CH_COUNT];
+    uint8_t buttons;
+} history_acc_t;
+
+static history_raw_slot_t g_raw[HISTORY_RAW_LEN];
+static history_rollup_slot_t g_seconds[HISTORY_SECONDS_LEN];
+static history_rollup_slot_t g_minutes[HISTORY_MINUTES_LEN];
+static volatile uint32_t g_head_seq[HISTORY_RES_COUNT];
+
+static history_rollup_slot_t *const g_rollup_rings[HISTORY_ROLLUP_LEVELS] = { g_seconds, g_minutes };
+static const uint32_t g_ring_len[HISTORY_RES_COUNT] = { HISTORY_RAW_LEN, HISTORY_SECONDS_LEN, HISTORY_MINUTES_LEN };
+static const uint64_t g_period_us[HISTORY_ROLLUP_LEVELS] = { 1000000ull, 60000000ull };
+
+static history_acc_t g_acc[HISTORY_ROLLUP_LEVELS];
+
+// --- Produtor (núcleo 1) ---
+
+static void history_push_raw(const input_snapshot_t *sample) {
+    uint32_t seq = g_head_seq[HISTORY_RES_RAW] + 1;
+    history_raw_slot_t *slot = &g_raw[seq & (HISTORY_RAW_LEN - 1)];
+    slot->seq = 0;
+    HISTORY_BARRIER();
+    slot->vrx = sample->vrx;
+    slot->vry = sample->vry;
+    slot->temp_raw = sample->temp_raw;
+    slot->buttons = sample->button_state_bits;
+    slot->timestamp_us = sample->timestamp_us;
+    HISTORY_BARRIER();
+    slot->seq = seq;
+    HISTORY_BARRIER();
+    g_head_seq[HISTORY_RES_RAW] = seq;
+}
+
+static void history_push_rollup(unsigned level, const history_acc_t *acc) {
+    history_res_t res = (history_res_t)(HISTORY_RES_1S + level);
+    uint32_t seq = g_head_seq[res] + 1;
+    history_rollup_slot_t *slot = &g_rollup_rings[level][seq & (g_ring_len[res] - 1)];
+    slot->seq = 0;
+    HISTORY_BARRIER();
+    slot->point.timestamp_us = acc->period_index * g_period_us[level];
+    slot->point.count = (uint16_t)acc->count;
+    slot->point.buttons = acc->buttons;
+    for (int ch = 0; ch < HISTORY_CH_COUNT; ch++) {
+        slot->point.min[ch] = acc->min[ch];
+        slot->point.max[ch] = acc->max[ch];
+        slot->point.mean[ch] = (uint16_t)((acc->sum[ch] + acc->count / 2) / acc->count);
+    }
+    HISTORY_BARRIER();
+    slot->seq = seq;
+    HISTORY_BARRIER();
+    g_head_seq[res] = seq;
+}
+
+static void history_acc_merge(history_acc_t *acc, const history_acc_t *src) {
+    for (int ch = 0; ch < HISTORY_CH_COUNT; ch++) {
+        if (acc->count == 0 || src->min[ch] < acc->min[ch]) acc->min[ch] = src->min[ch];
+        if (acc->count == 0 || src->max[ch] > acc->max[ch]) acc->max[ch] = src->max[ch];
+        acc->sum[ch] += src->sum[ch];
+    }
+    acc->count += src->count;
+    acc->buttons |= src->buttons;
+}
+
+// Soma 'src' ao intervalo do nível; se 'timestamp_us' já é de outro intervalo, o atual é
+// publicado e repassado ao nível seguinte (os segundos compõem os minutos).
+static void history_fold(unsigned level, const history_acc_t *src, uint64_t timestamp_us) {
+    history_acc_t *acc = &g_acc[level];
+    uint64_t period_index = timestamp_us / g_period_us[level];
+    if (acc->count > 0 && period_index != acc->period_index) {
+        history_push_rollup(level, acc);
+        if (level + 1 < HISTORY_ROLLUP_LEVELS) {
+            history_fold(level + 1, acc, acc->period_index * g_period_us[level]);
+        }
+        memset(acc, 0, sizeof(*acc));
+    }
+    acc->period_index = period_index;
+    history_acc_merge(acc, src);
+}
+
+void history_add(const input_snapshot_t *sample) {
+    history_push_raw(sample);
+
+    const uint16_t values[HISTORY_CH_COUNT] = { sample->vrx, sample->vry, sample->temp_raw };
+    history_acc_t one = { .count = 1, .buttons = sample->button_state_bits };
+    for (int ch = 0; ch < HISTORY_CH_COUNT; ch++) {
+        one.sum[ch] = one.min[ch] = one.max[ch] = values[ch];
+    }
+    history_fold(0, &one, sample->timestamp_us);
+}
+
+// --- Leitores ---
+
+uint32_t history_latest_seq(history_res_t res) {
+    return g_head_seq[res];
+}
+
+bool history_read(history_res_t res, uint32_t seq, history_point_t *out) {
+    uint32_t head = g_head_seq[res];
+    HISTORY_BARRIER();
+    if (seq == 0 || seq > head || head - seq >= g_ring_len[res]) {
+        return false;
+    }
+
+    uint32_t seq_before;
+    uint32_t seq_after;
+    if (res == HISTORY_RES_RAW) {
+        const history_raw_slot_t *slot = &g_raw[seq & (HISTORY_RAW_LEN - 1)];
+        seq_before = slot->seq;
+        HISTORY_BARRIER();
+        history_raw_slot_t copy = *slot;
+        HISTORY_BARRIER();
+        seq_after = slot->seq;
+
+        const uint16_t values[HISTORY_CH_COUNT] = { copy.vrx, copy.vry, copy.temp_raw };
+        out->timestamp_us = copy.timestamp_us;
+        out->count = 1;
+        out->buttons = copy.buttons;
+        for (int ch = 0; ch < HISTORY_CH_COUNT; ch++) {
+            out->min[ch] = out->max[ch] = out->mean[ch] = values[ch];
+        }
+    } else {
+        const history_rollup_slot_t *slot = &g_rollup_rings[res - HISTORY_RES_1S][seq & (g_ring_len[res] - 1)];
+        seq_before = slot->seq;
+        HISTORY_BARRIER();
+        *out = slot->point;
+        HISTORY_BARRIER();
+        seq_after = slot->seq;
+    }
+    return seq_before == seq && seq_after == seq; // Senão o produtor sobrescreveu o slot durante a cópia
+}
+
+uint32_t history_find(history_res_t res, uint64_t from_us) {
+    uint32_t head = g_head_seq[res];
+    uint32_t lo = (head >= g_ring_len[res]) ? head - g_ring_len[res] + 1 : 1;
+    uint32_t hi = head + 1;
+    // Timestamps crescem com a sequência: busca binária. Um slot sobrescrito durante a busca é
+    // mais antigo que qualquer 'from' que ainda esteja no anel.
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        history_point_t point;
+        if (!history_read(res, mid, &point) || point.timestamp_us < from_us) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// --- GET /history ---
+
+// Estado do stream (copiado para a conexão por http_send_stream).
+typedef struct {
+    uint32_t next;       // Próximo registro a enviar
+    uint32_t last;       // Último registro desta resposta (fixado na requisição)
+    uint8_t res;         // history_res_t
+    uint8_t binary;
+} history_stream_state_t;
+
+static const char g_csv_header[] =
+    "t_us,n,vrx_min,vrx_max,vrx_mean,vry_min,vry_max,vry_mean,temp_min,temp_max,temp_mean,buttons\n";
+
+static void history_put_u16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void history_encode_record(uint8_t *p, const history_point_t *point) {
+    for (int i = 0; i < 8; i++) {
+        p[i] = (uint8_t)(point->timestamp_us >> (8 * i));
+    }
+    history_put_u16(p + 8, point->count);
+    p[10] = point->buttons;
+    p[11] = 0;
+    for (int ch = 0; ch < HISTORY_CH_COUNT; ch++) {
+        history_put_u16(p + 12 + ch * 6, point->min[ch]);
+        history_put_u16(p + 14 + ch * 6, point->max[ch]);
+        history_put_u16(p + 16 + ch * 6, point->mean[ch]);
+    }
+}
+
+// Próximo registro ainda legível; os sobrescritos desde a requisição são pulados.
+static bool history_stream_next(history_stream_state_t *st, history_point_t *point) {
+    while (st->next <= st->last) {
+        if (history_read((history_res_t)st->res, st->next++, point)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// CSV: trecho 0 é o cabeçalho e depois uma linha por trecho. Binário: quantos registros couberem
+// no scratch por trecho.
+static bool history_stream_piece(void *state, u32_t index, char *scratch, http_piece_t *out) {
+    history_stream_state_t *st = (history_stream_state_t *)state;
+    history_point_t point;
+    if (st->binary) {
+        u16_t len = 0;
+        while (len + HISTORY_RECORD_LEN <= HTTP_STREAM_SCRATCH_LEN && history_stream_next(st, &point)) {
+            history_encode_record((uint8_t *)scratch + len, &point);
+            len += HISTORY_RECORD_LEN;
+        }
+        out->data = scratch;
+        out->len = len;
+        return len > 0;
+    }
+
+    if (index == 0) {
+        out->data = g_csv_header;
+        out->len = sizeof(g_csv_header) - 1;
+        return true;
+    }
+    if (!history_stream_next(st, &point)) {
+        return false;
+    }
+    fmt_buf_t text;
+    fmt_init(&text, scratch, HTTP_STREAM_SCRATCH_LEN);
+    fmt_u64(&text, point.timestamp_us);
+    fmt_char(&text, ',');
+    fmt_u32(&text, point.count);
+    for (int ch = 0; ch < HISTORY_CH_COUNT; ch++) {
+        fmt_char(&text, ',');
+        fmt_u32(&text, point.min[ch]);
+        fmt_char(&text, ',');
+        fmt_u32(&text, point.max[ch]);
+        fmt_char(&text, ',');
+        fmt_u32(&text, point.mean[ch]);
+    }
+    fmt_char(&text, ',');
+    fmt_u32(&text, point.buttons);
+    fmt_char(&text, '\n');
+    out->data = scratch;
+    out->len = (u16_t)text.len;
+    return true;
+}
+
+// Valor do parâmetro 'name' ("res=") na query, ou NULL. Termina no próximo '&'.
+static const char *history_query_param(const char *query, const char *name, size_t *len) {
+    size_t name_len = strlen(name);
+    for (const char *p = query; *p != '\0'; ) {
+        if (strncmp(p, name, name_len) == 0) {
+            const char *value = p + name_len;
+            *len = strcspn(value, "&");
+            return value;
+        }
+        p += strcspn(p, "&");
+        if (*p == '&') p++;
+    }
+    return NULL;
+}
+
+static bool history_query_is(const char *value, size_t len, const char *expected) {
+    return len == strlen(expected) && strncmp(value, expected, len) == 0;
+}
+
+err_t history_serve(http_conn_t *conn, const http_request_t *request) {
+    history_stream_state_t state = { .res = HISTORY_RES_1S };
+    uint64_t from_us = 0;
+    size_t len;
+    const char *value = history_query_param(request->query, "res=", &len);
+    if (value != NULL) {
+        if (history_query_is(value, len, "raw")) state.res = HISTORY_RES_RAW;
+        else if (history_query_is(value, len, "1s")) state.res = HISTORY_RES_1S;
+        else if (history_query_is(value, len, "1m")) state.res = HISTORY_RES_1M;
+        else return http_send_response(conn, 400, NULL, NULL, 0, false);
+    }
+    value = history_query_param(request->query, "from=", &len);
+    if (value != NULL) {
+        from_us = strtoull(value, NULL, 10);
+    }
+    value = history_query_param(request->query, "fmt=", &len);
+    if (value != NULL) {
+        if (history_query_is(value, len, "bin")) state.binary = 1;
+        else if (!history_query_is(value, len, "csv")) return http_send_response(conn, 400, NULL, NULL, 0, false);
+    }
+
+    // Fixa o intervalo da resposta: o que chegar depois fica para o próximo 'from'
+    state.last = history_latest_seq((history_res_t)state.res);
+    state.next = history_find((history_res_t)state.res, from_us);
+
+    const char *headers = state.binary
+        ? "Content-Type: application/octet-stream\r\nCache-Control: no-store\r\nAccess-Control-Allow-Origin: *\r\n"
+        : "Content-Type: text/csv\r\nCache-Control: no-store\r\nAccess-Control-Allow-Origin: *\r\n";
+    return http_send_stream(conn, 200, headers, -1, history_stream_piece, NULL, &state, sizeof(state));
+}
@@ -0,0 +1,80 @@
+/**
+ * @file history.h
+ * @brief Histórico das entradas em memória fixa: amostras brutas dos últimos segundos e agregados
+ * (mínimo, máximo e média) por segundo e por minuto, servidos em GET /history.
+ *
+ * O núcleo 1 alimenta o histórico a cada amostra publicada (history_add). Cada resolução é um anel
+ * de tamanho fixo com um único produtor e leitores não destrutivos, como o de button_events.c: o
+ * slot é invalidado, preenchido e só então recebe o número de sequência, e o leitor descarta a
+ * cópia se a sequência mudou durante a leitura. Um agregado só entra no anel quando o seu
+ * intervalo termina; intervalos sem amostras não geram registro.
+ *
+ * GET /history?res=raw|1s|1m&from=<µs>&fmt=csv|bin devolve, do mais antigo ao mais novo, os
+ * registros com início em 'from' ou depois (mesmo relógio do campo 't' de /events). Para
+ * continuar de onde parou, use o último 't' + 1 como próximo 'from'.
+ *
+ * CSV: cabeçalho e uma linha por registro:
+ *   t_us,n,vrx_min,vrx_max,vrx_mean,vry_min,vry_max,vry_mean,temp_min,temp_max,temp_mean,buttons
+ * Binário (application/octet-stream): registros de HISTORY_RECORD_LEN bytes, little-endian:
+ *   t_us (u64), n (u16), buttons (u8), reservado (u8), depois min/max/média (u16) de VRx, VRy e
+ *   temperatura (ADC bruto).
+ * Nas amostras brutas n = 1 e min = max = média. 'buttons' é o OU dos bits (bit0 = A, bit1 = B)
+ * no intervalo.
+ */
+
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "http_server.h"
+#include "input_state.h"
+
+// Profundidade de cada anel (potências de 2): ~4 min por segundo e ~1 h por minuto, em ~37 KB de
+// RAM. Os brutos cobrem ~5 s com a amostragem em rajada (200 Hz) e ~8 min no modo ocioso (2 Hz).
+#define HISTORY_RAW_LEN 1024
+#define HISTORY_SECONDS_LEN 256
+#define HISTORY_MINUTES_LEN 64
+
+#define HISTORY_RECORD_LEN 30         // Registro do formato binário
+
+typedef enum {
+    HISTORY_RES_RAW,
+    HISTORY_RES_1S,
+    HISTORY_RES_1M,
+    HISTORY_RES_COUNT
+} history_res_t;
+
+typedef enum {
+    HISTORY_CH_VRX,
+    HISTORY_CH_VRY,
+    HISTORY_CH_TEMP,
+    HISTORY_CH_COUNT
+} history_channel_t;
+
+typedef struct {
+    uint64_t timestamp_us;             // Amostra, ou início do intervalo do agregado
+    uint16_t count;                    // Amostras agregadas
+    uint8_t buttons;
+    uint16_t min[HISTORY_CH_COUNT];
+    uint16_t max[HISTORY_CH_COUNT];
+    uint16_t mean[HISTORY_CH_COUNT];
+} history_point_t;
+
+// Acrescenta uma amostra (somente o núcleo de aquisição).
+void history_add(const input_snapshot_t *sample);
+
+// Sequência do registro mais recente da resolução (0 se nenhum). Os registros são 1, 2, 3...
+uint32_t history_latest_seq(history_res_t res);
+
+// Primeiro registro ainda no anel com timestamp >= 'from_us' (latest + 1 se nenhum).
+uint32_t history_find(history_res_t res, uint64_t from_us);
+
+// Copia o registro 'seq'. Retorna false se ele já foi sobrescrito (ou ainda não existe).
+bool history_read(history_res_t res, uint32_t seq, history_point_t *out);
+
+// Handler da rota /history.
+err_t history_serve(http_conn_t *conn, const http_request_t *request);
+
+#endif /* HISTORY_H */
@@ -0,0 +1,54 @@
+/**
+ * @file adc_sampler_host.c
+ * @brief adc_sampler.h no build host: sem DMA, cada leitura é a média de amostras simuladas.
+ */
+
+#include "adc_sampler.h"
+
+#include "hal_shim.h"
+
+static uint32_t g_sequence = 0;
+
+void adc_sampler_init(uint32_t rate_hz) {
+}
+
+void adc_sampler_get_latest(adc_sampler_values_t *out) {
+    uint32_t vry = 0, vrx = 0, temp = 0;
+    for (int i = 0; i < ADC_SAMPLER_DECIMATION; i++) {
+        vry += host_sim_adc_value(0);
+        vrx += host_sim_adc_value(1);
+        temp += host_sim_adc_value(4);
+    }
+    out->vry = (uint16_t)(vry / ADC_SAMPLER_DECIMATION);
+    out->vrx = (uint16_t)(vrx / ADC_SAMPLER_DECIMATION);
+    out->temp_raw = (uint16_t)(temp / ADC_SAMPLER_DECIMATION);
+    out->sequence = ++g_sequence; // Só o núcleo 1 (thread de aquisição) chama esta função
+}
+
+void adc_sampler_take_mean(adc_sampler_values_t *out) {
+    adc_sampler_get_latest(out);
+}
+
+void adc_sampler_set_rate(uint32_t rate_hz) {
+}
+
+static uint16_t g_watch_vrx, g_watch_vry, g_watch_radius = 0;
+static uint32_t g_wake_count = 0;
+
+void adc_sampler_watch(uint16_t center_vrx, uint16_t center_vry, uint16_t radius) {
+    g_watch_vrx = center_vrx;
+    g_watch_vry = center_vry;
+    g_watch_radius = radius;
+}
+
+// Sem IRQ no host: a janela é conferida a cada consulta do laço de espera.
+uint32_t adc_sampler_wake_count(void) {
+    if (g_watch_radius > 0) {
+        int dx = (int)host_sim_adc_value(1) - g_watch_vrx;
+        int dy = (int)host_sim_adc_value(0) - g_watch_vry;
+        if (dx > g_watch_radius || dx < -g_watch_radius || dy > g_watch_radius || dy < -g_watch_radius) {
+            g_wake_count++;
+        }
+    }
+    return g_wake_count;
+}
@@ -0,0 +1,353 @@
+/**
+ * @file cyw43_arch_host.c
+ * @brief cyw43_arch e async_context do build host.
+ *
+ * Uma thread de rede faz o papel do contexto "threadsafe_background": espera pacotes da TUN
+ * (ou um aviso de trabalho pendente), e com o mutex tomado entrega os pacotes à LwIP, roda os
+ * timers dela e executa os workers registrados. cyw43_arch_lwip_begin()/end() tomam o mesmo
+ * mutex (recursivo), como no SDK.
+ *
+ * Variáveis de ambiente: HOST_TUN_DEV (padrão "tun0"), HOST_IP ("192.168.7.2") e
+ * HOST_GW ("192.168.7.1", o IP da TUN do lado do Linux). SIGUSR1 simula a perda do Wi-Fi
+ * (a netif perde o enlace até a próxima cyw43_arch_wifi_connect_async).
+ */
+
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "pico/cyw43_arch.h"
+#include "pico/async_context.h"
+
+#include "lwip/init.h"
+#include "lwip/ip4_addr.h"
+#include "lwip/netif.h"
+#include "lwip/stats.h"
+#include "lwip/timeouts.h"
+
+#include "tunif.h"
+
+#define HOST_LWIP_TIMER_MS 5          // Espera máxima entre chamadas a sys_check_timeouts()
+#define HOST_POOL_CHECK_MS 1000       // Intervalo de verificação dos contadores de erro dos pools
+
+struct async_context {
+    async_when_pending_worker_t *when_pending;
+    async_at_time_worker_t *at_time;
+};
+
+cyw43_t cyw43_state;
+
+static pthread_mutex_t g_lwip_mutex;
+static async_context_t g_context;
+static struct netif g_netif;
+static int g_tun_fd = -1;
+static int g_wake_pipe[2] = { -1, -1 };
+static volatile sig_atomic_t g_stop = 0;
+static volatile sig_atomic_t g_drop_link = 0;  // SIGUSR1
+static unsigned g_rx_dropped = 0;
+static STAT_COUNTER g_last_pool_err[MEMP_MAX + 1]; // Último valor de err visto por pool (+ heap)
+
+static const char *host_env(const char *name, const char *fallback) {
+    const char *value = getenv(name);
+    return value && value[0] ? value : fallback;
+}
+
+static void host_wake_network_thread(void) {
+    char byte = 1;
+    ssize_t ignored = write(g_wake_pipe[1], &byte, 1); // Pipe cheio já garante o despertar
+    (void)ignored;
+}
+
+// --- async_context ---
+
+bool async_context_add_when_pending_worker(async_context_t *context, async_when_pending_worker_t *worker) {
+    async_context_acquire_lock_blocking(context);
+    worker->next = context->when_pending;
+    context->when_pending = worker;
+    async_context_release_lock(context);
+    return true;
+}
+
+bool async_context_remove_when_pending_worker(async_context_t *context, async_when_pending_worker_t *worker) {
+    bool found = false;
+    async_context_acquire_lock_blocking(context);
+    for (async_when_pending_worker_t **it = &context->when_pending; *it; it = &(*it)->next) {
+        if (*it == worker) {
+            *it = worker->next;
+            found = true;
+            break;
+        }
+    }
+    async_context_release_lock(context);
+    return found;
+}
+
+void async_context_set_work_pending(async_context_t *context, async_when_pending_worker_t *worker) {
+    worker->work_pending = true; // Pode ser chamada de qualquer thread, sem o lock
+    host_wake_network_thread();
+}
+
+bool async_context_add_at_time_worker_at(async_context_t *context, async_at_time_worker_t *worker, absolute_time_t at) {
+    async_context_acquire_lock_blocking(context);
+    async_context_remove_at_time_worker(context, worker);
+    worker->next_time = at;
+    worker->next = context->at_time;
+    context->at_time = worker;
+    async_context_release_lock(context);
+    host_wake_network_thread();
+    return true;
+}
+
+bool async_context_add_at_time_worker_in_ms(async_context_t *context, async_at_time_worker_t *worker, uint32_t ms) {
+    return async_context_add_at_time_worker_at(context, worker, make_timeout_time_ms(ms));
+}
+
+bool async_context_remove_at_time_worker(async_context_t *context, async_at_time_worker_t *worker) {
+    bool found = false;
+    async_context_acquire_lock_blocking(context);
+    for (async_at_time_worker_t **it = &context->at_time; *it; it = &(*it)->next) {
+        if (*it == worker) {
+            *it = worker->next;
+            found = true;
+            break;
+        }
+    }
+    async_context_release_lock(context);
+    return found;
+}
+
+void async_context_acquire_lock_blocking(async_context_t *context) {
+    pthread_mutex_lock(&g_lwip_mutex);
+}
+
+void async_context_release_lock(async_context_t *context) {
+    pthread_mutex_unlock(&g_lwip_mutex);
+}
+
+// Chamada com o lock tomado. Retorna o próximo instante de um worker por tempo (0 = nenhum).
+static absolute_time_t host_run_workers(async_context_t *context) {
+    for (async_when_pending_worker_t *worker = context->when_pending; worker; worker = worker->next) {
+        if (worker->work_pending) {
+            worker->work_pending = false;
+            worker->do_work(context, worker);
+        }
+    }
+
+    absolute_time_t now = get_absolute_time();
+    for (async_at_time_worker_t **it = &context->at_time; *it;) {
+        async_at_time_worker_t *worker = *it;
+        if (worker->next_time <= now) {
+            *it = worker->next; // Sai da lista antes; do_work pode se registrar de novo
+            worker->do_work(context, worker);
+            it = &context->at_time;
+        } else {
+            it = &worker->next;
+        }
+    }
+
+    absolute_time_t next = 0;
+    for (async_at_time_worker_t *worker = context->at_time; worker; worker = worker->next) {
+        if (next == 0 || worker->next_time < next) {
+            next = worker->next_time;
+        }
+    }
+    return next;
+}
+
+// --- Estatísticas da LwIP ---
+
+static void host_report_pool_errors(bool final_report) {
+    for (int i = 0; i < MEMP_MAX; i++) {
+        const struct stats_mem *pool = lwip_stats.memp[i];
+        if (!pool) {
+            continue;
+        }
+        if (final_report) {
+            printf("LWIP: %-16s usados=%u max=%u total=%u falhas=%u\n", pool->name, (unsigned)pool->used,
+                   (unsigned)pool->max, (unsigned)pool->avail, (unsigned)pool->err);
+        } else if (pool->err != g_last_pool_err[i]) {
+            printf("LWIP: pool %s esgotado (+%u falhas de alocação)\n", pool->name,
+                   (unsigned)(pool->err - g_last_pool_err[i]));
+        }
+        g_last_pool_err[i] = pool->err;
+    }
+
+    const struct stats_mem *heap = &lwip_stats.mem;
+    if (final_report) {
+        printf("LWIP: %-16s usados=%u max=%u total=%u falhas=%u\n", "HEAP", (unsigned)heap->used,
+               (unsigned)heap->max, (unsigned)heap->avail, (unsigned)heap->err);
+        printf("LWIP: pacotes da TUN descartados por falta de pbuf: %u\n", g_rx_dropped);
+    } else if (heap->err != g_last_pool_err[MEMP_MAX]) {
+        printf("LWIP: heap esgotado (+%u falhas de alocação)\n", (unsigned)(heap->err - g_last_pool_err[MEMP_MAX]));
+    }
+    g_last_pool_err[MEMP_MAX] = heap->err;
+}
+
+static void host_signal_handler(int signo) {
+    if (signo == SIGUSR1) {
+        g_drop_link = 1;
+    } else {
+        g_stop = 1;
+    }
+    host_wake_network_thread();
+}
+
+// --- Thread de rede ---
+
+static void *host_network_thread(void *arg) {
+    struct pollfd fds[2] = {
+        { .fd = g_wake_pipe[0], .events = POLLIN },
+        { .fd = g_tun_fd, .events = POLLIN },
+    };
+    absolute_time_t next_worker_time = 0;
+    absolute_time_t next_pool_check = make_timeout_time_ms(HOST_POOL_CHECK_MS);
+
+    while (!g_stop) {
+        int timeout_ms = HOST_LWIP_TIMER_MS;
+        if (next_worker_time != 0) {
+            int64_t until_ms = absolute_time_diff_us(get_absolute_time(), next_worker_time) / 1000;
+            if (until_ms < timeout_ms) {
+                timeout_ms = until_ms > 0 ? (int)until_ms : 0;
+            }
+        }
+        poll(fds, 2, timeout_ms);
+
+        if (fds[0].revents & POLLIN) {
+            char drain[64];
+            while (read(g_wake_pipe[0], drain, sizeof(drain)) > 0) {
+            }
+        }
+
+        pthread_mutex_lock(&g_lwip_mutex);
+        if (fds[1].revents & POLLIN) {
+            g_rx_dropped += tunif_input_pending(&g_netif);
+        }
+        if (g_drop_link) {
+            g_drop_link = 0;
+            printf("HOST: enlace derrubado (SIGUSR1)\n");
+            netif_set_link_down(&g_netif);
+            cyw43_state.link_status = CYW43_LINK_DOWN;
+        }
+        sys_check_timeouts();
+        next_worker_time = host_run_workers(&g_context);
+        if (get_absolute_time() >= next_pool_check) {
+            host_report_pool_errors(false);
+            next_pool_check = make_timeout_time_ms(HOST_POOL_CHECK_MS);
+        }
+        pthread_mutex_unlock(&g_lwip_mutex);
+    }
+
+    pthread_mutex_lock(&g_lwip_mutex);
+    host_report_pool_errors(true);
+    pthread_mutex_unlock(&g_lwip_mutex);
+    exit(0);
+    return NULL;
+}
+
+// --- cyw43_arch ---
+
+int cyw43_arch_init(void) {
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&g_lwip_mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+
+    if (pipe2(g_wake_pipe, O_NONBLOCK | O_CLOEXEC) != 0) {
+        perror("cyw43_arch_init: pipe");
+        return -1;
+    }
+    const char *dev = host_env("HOST_TUN_DEV", "tun0");
+    g_tun_fd = tunif_open(dev);
+    if (g_tun_fd < 0) {
+        printf("Crie a interface antes: sudo ip tuntap add dev %s mode tun user $USER && "
+               "sudo ip addr add %s/24 dev %s && sudo ip link set %s up\n",
+               dev, host_env("HOST_GW", "192.168.7.1"), dev, dev);
+        return -1;
+    }
+
+    ip4_addr_t ip, mask, gw;
+    if (!ip4addr_aton(host_env("HOST_IP", "192.168.7.2"), &ip) || !ip4addr_aton(host_env("HOST_GW", "192.168.7.1"), &gw)) {
+        printf("cyw43_arch_init: HOST_IP/HOST_GW inválidos\n");
+        return -1;
+    }
+    IP4_ADDR(&mask, 255, 255, 255, 0);
+
+    pthread_mutex_lock(&g_lwip_mutex);
+    lwip_init();
+    netif_add(&g_netif, &ip, &mask, &gw, &g_tun_fd, tunif_init, netif_input);
+    netif_set_default(&g_netif);
+    pthread_mutex_unlock(&g_lwip_mutex);
+
+    struct sigaction action = { .sa_handler = host_signal_handler };
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    sigaction(SIGUSR1, &action, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, host_network_thread, NULL) != 0) {
+        perror("cyw43_arch_init: thread de rede");
+        return -1;
+    }
+    pthread_detach(thread);
+    return 0;
+}
+
+void cyw43_arch_deinit(void) {
+    g_stop = 1;
+    host_wake_network_thread();
+}
+
+void cyw43_arch_enable_sta_mode(void) {
+}
+
+void cyw43_arch_poll(void) {
+}
+
+int cyw43_arch_wifi_connect_async(const char *ssid, const char *pw, uint32_t auth) {
+    pthread_mutex_lock(&g_lwip_mutex);
+    netif_set_up(&g_netif);
+    netif_set_link_up(&g_netif);
+    cyw43_state.link_status = CYW43_LINK_UP;
+    pthread_mutex_unlock(&g_lwip_mutex);
+    return 0;
+}
+
+int cyw43_arch_wifi_connect_timeout_ms(const char *ssid, const char *pw, uint32_t auth, uint32_t timeout_ms) {
+    return cyw43_arch_wifi_connect_async(ssid, pw, auth);
+}
+
+int cyw43_tcpip_link_status(cyw43_t *self, int itf) {
+    return netif_is_up(&g_netif) && netif_is_link_up(&g_netif) ? CYW43_LINK_UP : CYW43_LINK_DOWN;
+}
+
+int cyw43_wifi_link_status(cyw43_t *self, int itf) {
+    return self->link_status == CYW43_LINK_UP ? CYW43_LINK_JOIN : self->link_status;
+}
+
+int cyw43_wifi_leave(cyw43_t *self, int itf) {
+    pthread_mutex_lock(&g_lwip_mutex);
+    netif_set_link_down(&g_netif);
+    self->link_status = CYW43_LINK_DOWN;
+    pthread_mutex_unlock(&g_lwip_mutex);
+    return 0;
+}
+
+void cyw43_arch_lwip_begin(void) {
+    pthread_mutex_lock(&g_lwip_mutex);
+}
+
+void cyw43_arch_lwip_end(void) {
+    pthread_mutex_unlock(&g_lwip_mutex);
+}
+
+async_context_t *cyw43_arch_async_context(void) {
+    return &g_context;
+}
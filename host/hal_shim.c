@@ -0,0 +1,309 @@
+/**
+ * @file hal_shim.c
+ * @brief Implementação Linux das APIs de tempo, GPIO, ADC e multicore usadas pelo firmware.
+ *
+ * As IRQs de GPIO e os alarmes do "núcleo 1" rodam numa única thread (irq thread), que também
+ * gera as entradas simuladas. Assim o anel de button_events.c continua com um único produtor.
+ */
+
+#define _GNU_SOURCE
+
+#include "hal_shim.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+#include "hardware/adc.h"
+#include "hardware/gpio.h"
+#include "hardware/sync.h"
+
+#define SHIM_GPIO_COUNT 30
+#define SHIM_MAX_ALARMS 16
+#define SHIM_IRQ_TICK_US 200
+#define SHIM_WFE_SLICE_US 1000 // Espera máxima de best_effort_wfe_or_timeout (uma "interrupção" a cada 1 ms)
+
+#define SIM_JOYSTICK_STEP_MS 900      // Tempo em cada uma das 9 posições
+#define SIM_BUTTON_A_PERIOD_MS 3000
+#define SIM_BUTTON_A_HOLD_MS 120
+#define SIM_BUTTON_B_PERIOD_MS 7000
+#define SIM_BUTTON_B_HOLD_MS 300
+#define SIM_BOUNCE_US 800             // Repique gerado junto de cada borda
+#define SIM_TEMP_RAW 876              // ~27 °C
+#define SIM_BUTTON_A_PIN 5
+#define SIM_BUTTON_B_PIN 6
+
+// --- Tempo ---
+
+static struct timespec g_boot_time;
+static pthread_once_t g_boot_once = PTHREAD_ONCE_INIT;
+
+static void shim_record_boot_time(void) {
+    clock_gettime(CLOCK_MONOTONIC, &g_boot_time);
+}
+
+uint64_t time_us_64(void) {
+    pthread_once(&g_boot_once, shim_record_boot_time);
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)(now.tv_sec - g_boot_time.tv_sec) * 1000000ull +
+           (uint64_t)((now.tv_nsec - g_boot_time.tv_nsec) / 1000);
+}
+
+void sleep_us(uint64_t us) {
+    struct timespec ts = { .tv_sec = (time_t)(us / 1000000), .tv_nsec = (long)(us % 1000000) * 1000 };
+    while (nanosleep(&ts, &ts) != 0) {
+    }
+}
+
+void sleep_ms(uint32_t ms) {
+    sleep_us(1000ull * ms);
+}
+
+void sleep_until(absolute_time_t target) {
+    uint64_t now = time_us_64();
+    if (target > now) {
+        sleep_us(target - now);
+    }
+}
+
+bool best_effort_wfe_or_timeout(absolute_time_t timeout_timestamp) {
+    uint64_t now = time_us_64();
+    if (timeout_timestamp > now) {
+        uint64_t remaining = timeout_timestamp - now;
+        sleep_us(remaining < SHIM_WFE_SLICE_US ? remaining : SHIM_WFE_SLICE_US);
+    }
+    return time_reached(timeout_timestamp);
+}
+
+void stdio_init_all(void) {
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    pthread_once(&g_boot_once, shim_record_boot_time);
+}
+
+void __wfe(void) {
+    sleep_ms(100); // Nada a fazer no laço principal: a rede roda na thread do async_context
+}
+
+// --- Multicore ---
+
+static void *shim_core1_thread(void *arg) {
+    void (*entry)(void) = (void (*)(void))arg;
+    entry();
+    return NULL;
+}
+
+void multicore_launch_core1(void (*entry)(void)) {
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, shim_core1_thread, (void *)entry) != 0) {
+        perror("multicore_launch_core1");
+        exit(1);
+    }
+    pthread_detach(thread);
+}
+
+// --- Entradas simuladas ---
+
+static bool g_sim_idle = false;
+
+static uint16_t sim_noise(void) {
+    return (uint16_t)(rand() % 17); // 0..16
+}
+
+uint16_t host_sim_adc_value(unsigned channel) {
+    if (channel == 4) {
+        return (uint16_t)(SIM_TEMP_RAW + sim_noise() / 4);
+    }
+    // Posições: centro, N, NE, E, SE, S, SW, W, NW (VRx: esquerda->direita, VRy: baixo->cima)
+    static const uint16_t positions[9][2] = {
+        { 2047, 2047 }, { 2047, 4000 }, { 4000, 4000 }, { 4000, 2047 }, { 4000, 100 },
+        { 2047, 100 },  { 100, 100 },   { 100, 2047 },  { 100, 4000 },
+    };
+    unsigned step = g_sim_idle ? 0 : (unsigned)((time_us_64() / 1000 / SIM_JOYSTICK_STEP_MS) % 9);
+    uint16_t value = channel == 1 ? positions[step][0] : positions[step][1];
+    return (uint16_t)(value - 8 + sim_noise());
+}
+
+// --- ADC ---
+
+static unsigned g_adc_input = 0;
+
+void adc_init(void) {}
+void adc_gpio_init(unsigned gpio) {}
+void adc_set_temp_sensor_enabled(bool enable) {}
+
+void adc_select_input(unsigned input) {
+    g_adc_input = input;
+}
+
+uint16_t adc_read(void) {
+    return host_sim_adc_value(g_adc_input);
+}
+
+// --- GPIO ---
+
+static volatile bool g_gpio_level[SHIM_GPIO_COUNT];
+static volatile uint32_t g_gpio_irq_mask[SHIM_GPIO_COUNT];
+static gpio_irq_callback_t g_gpio_callback = NULL;
+
+void gpio_init(unsigned gpio) {}
+void gpio_set_dir(unsigned gpio, bool out) {}
+
+void gpio_pull_up(unsigned gpio) {
+    g_gpio_level[gpio] = true;
+}
+
+bool gpio_get(unsigned gpio) {
+    return g_gpio_level[gpio];
+}
+
+void gpio_set_irq_enabled(unsigned gpio, uint32_t events, bool enabled) {
+    if (enabled) {
+        g_gpio_irq_mask[gpio] |= events;
+    } else {
+        g_gpio_irq_mask[gpio] &= ~events;
+    }
+}
+
+void gpio_set_irq_enabled_with_callback(unsigned gpio, uint32_t events, bool enabled, gpio_irq_callback_t callback) {
+    g_gpio_callback = callback;
+    gpio_set_irq_enabled(gpio, events, enabled);
+}
+
+void gpio_acknowledge_irq(unsigned gpio, uint32_t events) {}
+
+// Só chamada pela irq thread: muda o nível e "dispara a IRQ" se a borda estiver habilitada.
+static void sim_gpio_drive(unsigned gpio, bool level) {
+    if (g_gpio_level[gpio] == level) {
+        return;
+    }
+    g_gpio_level[gpio] = level;
+    uint32_t event = level ? GPIO_IRQ_EDGE_RISE : GPIO_IRQ_EDGE_FALL;
+    if (g_gpio_callback && (g_gpio_irq_mask[gpio] & event)) {
+        g_gpio_callback(gpio, event);
+    }
+}
+
+// --- Alarmes ---
+
+typedef struct {
+    bool active;
+    alarm_id_t id;
+    uint64_t deadline_us;
+    alarm_callback_t callback;
+    void *user_data;
+} shim_alarm_t;
+
+struct alarm_pool {
+    int unused;
+};
+
+static pthread_mutex_t g_alarm_mutex = PTHREAD_MUTEX_INITIALIZER;
+static shim_alarm_t g_alarms[SHIM_MAX_ALARMS];
+static alarm_id_t g_next_alarm_id = 1;
+static struct alarm_pool g_alarm_pool;
+static pthread_once_t g_irq_thread_once = PTHREAD_ONCE_INIT;
+
+static void sim_buttons_step(uint64_t now_us) {
+    if (g_sim_idle) {
+        return;
+    }
+    uint64_t now_ms = now_us / 1000;
+    const struct { unsigned pin; uint32_t period_ms; uint32_t hold_ms; } buttons[] = {
+        { SIM_BUTTON_A_PIN, SIM_BUTTON_A_PERIOD_MS, SIM_BUTTON_A_HOLD_MS },
+        { SIM_BUTTON_B_PIN, SIM_BUTTON_B_PERIOD_MS, SIM_BUTTON_B_HOLD_MS },
+    };
+    for (size_t i = 0; i < sizeof(buttons) / sizeof(buttons[0]); i++) {
+        uint64_t phase_us = (now_ms % buttons[i].period_ms) * 1000 + now_us % 1000;
+        uint64_t hold_us = 1000ull * buttons[i].hold_ms;
+        bool pressed = phase_us >= 1000 && phase_us < hold_us; // Começa 1 ms após o período
+        // Repique: nos primeiros SIM_BOUNCE_US após cada borda o nível oscila
+        if ((phase_us >= 1000 && phase_us < 1000 + SIM_BOUNCE_US) ||
+            (phase_us >= hold_us && phase_us < hold_us + SIM_BOUNCE_US)) {
+            pressed = (phase_us / SHIM_IRQ_TICK_US) % 2 == 0 ? pressed : !pressed;
+        }
+        sim_gpio_drive(buttons[i].pin, !pressed); // Pull-up: pressionado = nível baixo
+    }
+}
+
+static void *shim_irq_thread(void *arg) {
+    for (;;) {
+        uint64_t now_us = time_us_64();
+        sim_buttons_step(now_us);
+
+        pthread_mutex_lock(&g_alarm_mutex);
+        for (int i = 0; i < SHIM_MAX_ALARMS; i++) {
+            if (g_alarms[i].active && g_alarms[i].deadline_us <= now_us) {
+                shim_alarm_t alarm = g_alarms[i];
+                g_alarms[i].active = false;
+                pthread_mutex_unlock(&g_alarm_mutex);
+                int64_t repeat_us = alarm.callback(alarm.id, alarm.user_data);
+                pthread_mutex_lock(&g_alarm_mutex);
+                if (repeat_us != 0 && !g_alarms[i].active) {
+                    g_alarms[i] = alarm;
+                    g_alarms[i].active = true;
+                    g_alarms[i].deadline_us = repeat_us > 0 ? now_us + (uint64_t)repeat_us : now_us - (uint64_t)repeat_us;
+                }
+            }
+        }
+        pthread_mutex_unlock(&g_alarm_mutex);
+
+        sleep_us(SHIM_IRQ_TICK_US);
+    }
+    return NULL;
+}
+
+static void shim_start_irq_thread(void) {
+    const char *sim = getenv("HOST_SIM");
+    g_sim_idle = sim && strcmp(sim, "idle") == 0;
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, shim_irq_thread, NULL) != 0) {
+        perror("irq thread");
+        exit(1);
+    }
+    pthread_detach(thread);
+}
+
+alarm_pool_t *alarm_pool_create_with_unused_hardware_alarm(unsigned max_timers) {
+    pthread_once(&g_irq_thread_once, shim_start_irq_thread);
+    return &g_alarm_pool;
+}
+
+alarm_id_t alarm_pool_add_alarm_in_us(alarm_pool_t *pool, uint64_t us, alarm_callback_t callback,
+                                      void *user_data, bool fire_if_past) {
+    pthread_once(&g_irq_thread_once, shim_start_irq_thread);
+    alarm_id_t id = -1;
+    pthread_mutex_lock(&g_alarm_mutex);
+    for (int i = 0; i < SHIM_MAX_ALARMS; i++) {
+        if (!g_alarms[i].active) {
+            id = g_next_alarm_id++;
+            g_alarms[i] = (shim_alarm_t){ true, id, time_us_64() + us, callback, user_data };
+            break;
+        }
+    }
+    pthread_mutex_unlock(&g_alarm_mutex);
+    return id;
+}
+
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void *user_data, bool fire_if_past) {
+    return alarm_pool_add_alarm_in_us(&g_alarm_pool, us, callback, user_data, fire_if_past);
+}
+
+bool cancel_alarm(alarm_id_t id) {
+    bool found = false;
+    pthread_mutex_lock(&g_alarm_mutex);
+    for (int i = 0; i < SHIM_MAX_ALARMS; i++) {
+        if (g_alarms[i].active && g_alarms[i].id == id) {
+            g_alarms[i].active = false;
+            found = true;
+        }
+    }
+    pthread_mutex_unlock(&g_alarm_mutex);
+    return found;
+}
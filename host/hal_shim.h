@@ -0,0 +1,18 @@
+/**
+ * @file hal_shim.h
+ * @brief Entradas simuladas do build host (joystick, temperatura e botões).
+ *
+ * Por padrão o joystick percorre as 9 posições e os botões são pressionados periodicamente,
+ * para que /status, /stream, /ws e /events tenham conteúdo variando. Com HOST_SIM=idle no
+ * ambiente, as entradas ficam paradas (útil para medir só o servidor).
+ */
+
+#ifndef HOST_HAL_SHIM_H
+#define HOST_HAL_SHIM_H
+
+#include <stdint.h>
+
+// Valor bruto (12 bits) do canal 0 (VRy), 1 (VRx) ou 4 (temperatura) neste instante.
+uint16_t host_sim_adc_value(unsigned channel);
+
+#endif /* HOST_HAL_SHIM_H */
@@ -0,0 +1,736 @@
+/**
+ * @file input_replay.c
+ * @brief Reprodução determinística, no Linux, de um trace de entradas gravado na placa
+ * (input_trace.h): passa o ADC e as bordas dos botões pela mesma classificação do firmware
+ * (input_classifier.c), o mais rápido possível, e imprime as mudanças de direção, os eventos de
+ * botão e estatísticas de tempo.
+ *
+ * A direção é calculada duas vezes: com o filtro do firmware (joystick_filter_update, a que vale)
+ * e com a classificação instantânea sem filtro (joystick_classify), para comparação. Uma mudança
+ * é espúria quando a direção a que levou dura menos de REPLAY_SPURIOUS_MS; o relatório dá a taxa
+ * das duas. O alarme de debounce do firmware é simulado: cada janela termina em borda + debounce
+ * e lê o nível que o trace tem naquele instante. Com -z/-H/-m/-i/-C/-X/-Y/-b dá para ver o que
+ * mudaria com outra configuração sem tocar na placa (-X/-Y fixam o centro: sem calibração).
+ *
+ * Com -B, mede também o custo por amostra do filtro e da classificação sem filtro (ns e, em x86,
+ * ciclos do TSC) repetindo as amostras de ADC do trace 'repetições' vezes.
+ *
+ * Com -F, baixa o trace da placa (GET /record) durante -d segundos e grava em 'arquivo'; com -g,
+ * gera um trace sintético (joystick girando pelas 9 posições e parando perto dos limiares, ruído
+ * de amplitude -N com picos isolados, botões com repique e um pulso de ruído) com o mesmo
+ * codificador, para testar sem hardware.
+ *
+ * Uso: input_replay [-q] [-z zona_morta] [-H histerese] [-m mediana] [-i iir_shift] [-C calibração]
+ *                   [-X centro_vrx] [-Y centro_vry] [-b debounce_us] [-B repetições] arquivo
+ *      input_replay -F host[:porta] [-d segundos] arquivo
+ *      input_replay -g segundos [-N ruído] arquivo
+ */
+
+#define _GNU_SOURCE
+
+#include <arpa/inet.h>
+#include <math.h>
+#include <netinet/in.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define REPLAY_HAVE_TSC 1
+#else
+#define REPLAY_HAVE_TSC 0
+#endif
+
+#include "button_events.h"
+#include "input_classifier.h"
+#include "input_trace_codec.h"
+
+#define REPLAY_FETCH_INTERVAL_MS 500
+#define REPLAY_FETCH_BUF (64 * 1024)
+#define SYNTH_EDGE_SPAN_US 2000         // Uma borda com repique cabe antes da próxima amostra
+#define SYNTH_SPIKE_PERIOD 50           // Em média uma amostra com pico a cada 50 (1 s)
+#define SYNTH_SPIKE_LEN 400
+#define REPLAY_SPURIOUS_MS 100          // Direção que dura menos que isso: a mudança foi espúria
+
+static const char *const g_direction_names[] = {
+    [CENTER] = "Centro", [NORTH] = "Norte", [NORTHEAST] = "Nordeste", [EAST] = "Leste",
+    [SOUTHEAST] = "Sudeste", [SOUTH] = "Sul", [SOUTHWEST] = "Sudoeste", [WEST] = "Oeste",
+    [NORTHWEST] = "Noroeste",
+};
+#define REPLAY_DIRECTIONS (sizeof(g_direction_names) / sizeof(g_direction_names[0]))
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+            "Uso: %s [-q] [-z zona_morta] [-H histerese] [-m mediana] [-i iir_shift] [-C calibração]\n"
+            "          [-X centro_vrx] [-Y centro_vry] [-b debounce_us] [-B repetições] arquivo\n"
+            "     %s -F host[:porta] [-d segundos] arquivo\n"
+            "     %s -g segundos [-N ruído] arquivo\n",
+            argv0, argv0, argv0);
+    exit(2);
+}
+
+// --- Gerador (-g) ---
+// Mesma política de blocos do firmware (input_trace.c): fecha ao encher ou após 1 s.
+
+typedef struct {
+    FILE *out;
+    uint8_t block[INPUT_TRACE_BLOCK_LEN];
+    input_trace_writer_t writer;
+    uint32_t sequence;
+    uint64_t block_t0_us;
+    uint32_t blocks;
+} synth_t;
+
+static void synth_rotate(synth_t *s, uint64_t t0_us) {
+    if (s->sequence > 0) {
+        fwrite(s->block, 1, INPUT_TRACE_BLOCK_LEN, s->out);
+        s->blocks++;
+    }
+    uint16_t adc[3];
+    memcpy(adc, s->writer.adc, sizeof(adc));
+    memset(s->block, 0, sizeof(s->block));
+    input_trace_block_start(&s->writer, s->block, ++s->sequence, t0_us, s->writer.buttons, adc);
+    s->block_t0_us = t0_us;
+}
+
+static void synth_edge(synth_t *s, uint64_t t_us, uint8_t button, bool pressed) {
+    if (!input_trace_put_edge(&s->writer, t_us, button, pressed)) {
+        synth_rotate(s, t_us);
+        input_trace_put_edge(&s->writer, t_us, button, pressed);
+    }
+}
+
+// Borda com repique: o nível alterna 'bounces' vezes em ~1 ms antes de firmar.
+static void synth_bouncy_edge(synth_t *s, uint64_t t_us, uint8_t button, bool pressed, unsigned bounces) {
+    for (unsigned i = 0; i < bounces; i++) {
+        synth_edge(s, t_us, button, (i % 2 == 0) ? pressed : !pressed);
+        t_us += 150 + (uint64_t)(rand() % 200);
+    }
+    synth_edge(s, t_us, button, pressed);
+}
+
+// Leitura de um eixo com ruído uniforme de +-'noise' e, de vez em quando, um pico isolado.
+static uint16_t synth_axis(uint16_t position, unsigned noise) {
+    int value = position + (noise > 0 ? rand() % (int)(2 * noise + 1) - (int)noise : 0);
+    if (rand() % SYNTH_SPIKE_PERIOD == 0) {
+        value += (rand() % 2) ? SYNTH_SPIKE_LEN : -SYNTH_SPIKE_LEN;
+    }
+    return (uint16_t)(value < 0 ? 0 : value > INPUT_ADC_MAX_VALUE ? INPUT_ADC_MAX_VALUE : value);
+}
+
+static int run_generator(const char *path, unsigned duration_s, unsigned noise) {
+    // Posições visitadas (VRx, VRy): as 9 na ordem de joystick_direction_t, depois paradas em
+    // cima do limiar do leste e do sul (zona morta padrão), onde a leitura sem filtro oscila
+    static const uint16_t positions[][2] = {
+        { 2047, 2047 }, { 2047, 4000 }, { 4000, 4000 }, { 4000, 2047 }, { 4000, 100 },
+        { 2047, 100 }, { 100, 100 }, { 100, 2047 }, { 100, 4000 },
+        { 2047 + JOYSTICK_DEADZONE_DEFAULT, 2047 }, { 2047, 2047 - JOYSTICK_DEADZONE_DEFAULT },
+    };
+    const uint32_t position_count = sizeof(positions) / sizeof(positions[0]);
+    synth_t s = { .out = fopen(path, "wb") };
+    if (s.out == NULL) {
+        perror(path);
+        return 1;
+    }
+    srand(1);
+    const uint16_t start_adc[3] = { 2047, 2047, 876 };
+    s.writer.buttons = 0;
+    memcpy(s.writer.adc, start_adc, sizeof(start_adc));
+    uint64_t t_us = 1000000;
+    synth_rotate(&s, t_us);
+
+    uint64_t end_us = t_us + duration_s * 1000000ull;
+    uint64_t next_press_us[BUTTON_ID_COUNT] = { t_us + 500000, t_us + 1700000 };
+    uint64_t release_us[BUTTON_ID_COUNT] = { 0, 0 };
+    uint64_t next_glitch_us = t_us + 2300000;
+    uint32_t samples = 0;
+    for (uint32_t i = 0; t_us < end_us; i++) {
+        uint64_t sample_us = t_us + (uint64_t)(rand() % 400); // Jitter do laço de 20 ms
+        uint64_t edges_until_us = sample_us - SYNTH_EDGE_SPAN_US; // Registros em ordem de tempo, como no firmware
+        for (int b = 0; b < BUTTON_ID_COUNT; b++) {
+            if (release_us[b] == 0 && next_press_us[b] <= edges_until_us) {
+                synth_bouncy_edge(&s, next_press_us[b], (uint8_t)b, true, 3);
+                release_us[b] = next_press_us[b] + 80000 + (uint64_t)(rand() % 300) * 1000;
+                next_press_us[b] += (b == BUTTON_ID_A) ? 3000000 : 7000000;
+            } else if (release_us[b] != 0 && release_us[b] <= edges_until_us) {
+                synth_bouncy_edge(&s, release_us[b], (uint8_t)b, false, 2);
+                release_us[b] = 0;
+            }
+        }
+        if (next_glitch_us <= edges_until_us) {
+            // Pulso de 300 µs no botão B (só fora de um pressionamento): o debounce deve descartá-lo
+            if (release_us[BUTTON_ID_B] == 0) {
+                synth_edge(&s, next_glitch_us, BUTTON_ID_B, true);
+                synth_edge(&s, next_glitch_us + 300, BUTTON_ID_B, false);
+            }
+            next_glitch_us += 11000000;
+        }
+
+        const uint16_t *pos = positions[(i / 45) % position_count]; // ~0,9 s em cada posição
+        uint16_t adc[3] = {
+            synth_axis(pos[0], noise),
+            synth_axis(pos[1], noise),
+            (uint16_t)(876 + (i / 3000) % 3),
+        };
+        if (!input_trace_put_adc(&s.writer, sample_us, adc)) {
+            synth_rotate(&s, sample_us);
+            input_trace_put_adc(&s.writer, sample_us, adc);
+        }
+        samples++;
+        if (sample_us - s.block_t0_us >= 1000000) {
+            synth_rotate(&s, sample_us);
+        }
+        t_us += 20000;
+    }
+    if (s.writer.used > 0) {
+        fwrite(s.block, 1, INPUT_TRACE_BLOCK_LEN, s.out);
+        s.blocks++;
+    }
+    fclose(s.out);
+    printf("input_replay: %u amostras em %u blocos (%u bytes) gravadas em %s\n", samples, s.blocks,
+           s.blocks * INPUT_TRACE_BLOCK_LEN, path);
+    return 0;
+}
+
+// --- Download (-F) ---
+
+// GET /record?from=N em HTTP/1.0 (corpo até o fechamento). Retorna o tamanho do corpo ou -1.
+static long fetch_once(const struct sockaddr_in *target, uint32_t from, uint8_t *buf, size_t size) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct timeval timeout = { .tv_sec = 3 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    if (connect(fd, (const struct sockaddr *)target, sizeof(*target)) != 0) {
+        close(fd);
+        return -1;
+    }
+    char request[96];
+    int request_len = snprintf(request, sizeof(request), "GET /record?from=%u HTTP/1.0\r\n\r\n", from);
+    if (send(fd, request, (size_t)request_len, 0) != request_len) {
+        close(fd);
+        return -1;
+    }
+    size_t len = 0;
+    ssize_t n;
+    while (len < size && (n = recv(fd, buf + len, size - len, 0)) > 0) {
+        len += (size_t)n;
+    }
+    close(fd);
+
+    uint8_t *body = memmem(buf, len, "\r\n\r\n", 4);
+    if (body == NULL || len < 12 || memcmp(buf + 9, "200", 3) != 0) {
+        return -1;
+    }
+    body += 4;
+    long body_len = (long)(len - (size_t)(body - buf));
+    memmove(buf, body, (size_t)body_len);
+    return body_len;
+}
+
+static int run_fetch(const char *host_port, unsigned duration_s, const char *path) {
+    char host[64];
+    int port = 80;
+    snprintf(host, sizeof(host), "%s", host_port);
+    char *colon = strchr(host, ':');
+    if (colon != NULL) {
+        *colon = '\0';
+        port = atoi(colon + 1);
+    }
+    struct sockaddr_in target = { .sin_family = AF_INET, .sin_port = htons((uint16_t)port) };
+    if (inet_pton(AF_INET, host, &target.sin_addr) != 1) {
+        fprintf(stderr, "input_replay: endereço IPv4 inválido: %s\n", host);
+        return 2;
+    }
+    FILE *out = fopen(path, "wb");
+    if (out == NULL) {
+        perror(path);
+        return 1;
+    }
+
+    static uint8_t buf[REPLAY_FETCH_BUF];
+    uint32_t next = 0, blocks = 0, gaps = 0, failures = 0, restarts = 0;
+    uint64_t end = now_ns() + duration_s * 1000000000ull;
+    printf("input_replay: baixando /record de %s:%d por %u s\n", host, port, duration_s);
+    while (now_ns() < end) {
+        long len = fetch_once(&target, next, buf, sizeof(buf));
+        if (len < 0 || len % INPUT_TRACE_BLOCK_LEN != 0) {
+            failures++;
+        } else {
+            for (long off = 0; off < len; off += INPUT_TRACE_BLOCK_LEN) {
+                input_trace_reader_t reader;
+                uint32_t sequence;
+                uint8_t buttons;
+                if (!input_trace_block_open(&reader, buf + off, &sequence, &buttons)) {
+                    failures++;
+                    continue;
+                }
+                if (next != 0 && sequence < next) {
+                    restarts++; // A placa reiniciou: a sequência recomeçou
+                    printf("input_replay: sequência voltou de %u para %u (reinício da placa)\n", next, sequence);
+                } else if (next != 0 && sequence > next) {
+                    gaps += sequence - next; // O anel da placa descartou blocos antes do download
+                }
+                fwrite(buf + off, 1, INPUT_TRACE_BLOCK_LEN, out);
+                blocks++;
+                next = sequence + 1;
+            }
+        }
+        usleep(REPLAY_FETCH_INTERVAL_MS * 1000);
+    }
+    fclose(out);
+    printf("input_replay: %u blocos gravados em %s, %u perdidos (lacunas), %u reinícios, %u falhas de download\n",
+           blocks, path, gaps, restarts, failures);
+    return blocks > 0 ? 0 : 1;
+}
+
+// --- Reprodução ---
+
+typedef struct {
+    button_debounce_t debounce;
+    bool raw_pressed;             // Nível do pino segundo o trace
+    uint64_t deadline_us;         // Fim da janela aberta (o "alarme" do firmware)
+    uint32_t edges;
+    uint32_t bounces;             // Bordas dentro de uma janela já aberta
+    uint32_t glitches;            // Janelas que terminaram sem mudança de nível
+    uint32_t presses;
+    uint32_t releases;
+    uint64_t hold_sum_us;
+    uint32_t hold_min_us;
+    uint32_t hold_max_us;
+} replay_button_t;
+
+// Sequência de direções de um classificador, com as mudanças espúrias.
+typedef struct {
+    joystick_direction_t direction;
+    uint64_t since_us;
+    uint32_t changes;
+    uint32_t spurious;            // Mudanças para uma direção que durou menos de REPLAY_SPURIOUS_MS
+} replay_track_t;
+
+typedef struct {
+    joystick_config_t joystick;
+    uint32_t debounce_us;
+    bool quiet;
+    unsigned bench_reps;
+
+    joystick_filter_t filter;
+    replay_track_t raw;           // joystick_classify, sem filtro
+    uint16_t *bench_vrx;          // Amostras de ADC guardadas para -B
+    uint16_t *bench_vry;
+    size_t bench_len;
+    size_t bench_cap;
+
+    uint64_t t0_us;
+    bool started;
+    replay_button_t buttons[BUTTON_ID_COUNT];
+    replay_track_t filtered;      // joystick_filter_update, a direção do firmware
+    uint64_t dwell_us[REPLAY_DIRECTIONS];
+
+    uint32_t blocks;
+    uint32_t invalid_blocks;
+    uint32_t gaps;                // Blocos faltando (lacunas na sequência)
+    uint32_t corrupt;             // Registros truncados/inválidos
+    uint32_t restarts;
+    uint32_t next_sequence;
+
+    uint64_t samples;
+    uint64_t last_sample_us;
+    uint64_t first_sample_us;
+    uint64_t interval_sum_us;
+    double interval_sq_sum;
+    uint32_t interval_min_us;
+    uint32_t interval_max_us;
+    uint64_t intervals;
+    uint64_t time_reversals;
+} replay_t;
+
+static double replay_seconds(const replay_t *r, uint64_t t_us) {
+    return (double)(t_us - r->t0_us) / 1e6;
+}
+
+// O alarme de debounce do botão 'b' dispara em 'deadline_us': confirma o nível e, como o
+// button_rearm_irq do firmware, abre outra janela se o pino já não está no nível confirmado.
+static void replay_settle(replay_t *r, int b) {
+    replay_button_t *button = &r->buttons[b];
+    uint64_t at_us = button->deadline_us;
+    button_debounce_event_t event;
+    if (!button_debounce_settle(&button->debounce, button->raw_pressed, &event)) {
+        button->glitches++;
+    } else if (event.pressed) {
+        button->presses++;
+        if (!r->quiet) {
+            printf("%12.6f  botão %c pressionado\n", replay_seconds(r, event.timestamp_us), 'A' + b);
+        }
+    } else {
+        button->releases++;
+        button->hold_sum_us += event.duration_us;
+        if (button->releases == 1 || event.duration_us < button->hold_min_us) button->hold_min_us = event.duration_us;
+        if (event.duration_us > button->hold_max_us) button->hold_max_us = event.duration_us;
+        if (!r->quiet) {
+            printf("%12.6f  botão %c solto (%.1f ms)\n", replay_seconds(r, event.timestamp_us), 'A' + b,
+                   event.duration_us / 1000.0);
+        }
+    }
+    if (button->raw_pressed != button->debounce.stable_pressed && button_debounce_edge(&button->debounce, at_us)) {
+        button->deadline_us = at_us + r->debounce_us;
+    }
+}
+
+// Dispara, em ordem, os alarmes com prazo até 'until_us'.
+static void replay_advance(replay_t *r, uint64_t until_us) {
+    while (true) {
+        int next = -1;
+        for (int b = 0; b < BUTTON_ID_COUNT; b++) {
+            const replay_button_t *button = &r->buttons[b];
+            if (button->debounce.debouncing && button->deadline_us <= until_us &&
+                (next < 0 || button->deadline_us < r->buttons[next].deadline_us)) {
+                next = b;
+            }
+        }
+        if (next < 0) {
+            return;
+        }
+        replay_settle(r, next);
+    }
+}
+
+static void replay_edge(replay_t *r, const input_trace_record_t *rec) {
+    if (rec->button >= BUTTON_ID_COUNT) {
+        r->corrupt++;
+        return;
+    }
+    replay_button_t *button = &r->buttons[rec->button];
+    button->raw_pressed = rec->pressed;
+    button->edges++;
+    if (button_debounce_edge(&button->debounce, rec->timestamp_us)) {
+        button->deadline_us = rec->timestamp_us + r->debounce_us;
+    } else {
+        button->bounces++;
+    }
+}
+
+// Registra a direção do instante 't_us'. Retorna true se mudou.
+static bool replay_track(replay_track_t *track, joystick_direction_t direction, uint64_t t_us) {
+    if (direction == track->direction) {
+        return false;
+    }
+    if (track->changes > 0 && t_us - track->since_us < REPLAY_SPURIOUS_MS * 1000ull) {
+        track->spurious++; // A direção anterior não durou: a mudança que levou a ela foi ruído
+    }
+    track->direction = direction;
+    track->since_us = t_us;
+    track->changes++;
+    return true;
+}
+
+static void replay_bench_keep(replay_t *r, uint16_t vrx, uint16_t vry) {
+    if (r->bench_len == r->bench_cap) {
+        r->bench_cap = r->bench_cap ? r->bench_cap * 2 : 4096;
+        r->bench_vrx = realloc(r->bench_vrx, r->bench_cap * sizeof(uint16_t));
+        r->bench_vry = realloc(r->bench_vry, r->bench_cap * sizeof(uint16_t));
+        if (r->bench_vrx == NULL || r->bench_vry == NULL) {
+            fprintf(stderr, "input_replay: sem memória para -B\n");
+            exit(1);
+        }
+    }
+    r->bench_vrx[r->bench_len] = vrx;
+    r->bench_vry[r->bench_len] = vry;
+    r->bench_len++;
+}
+
+static void replay_sample(replay_t *r, const input_trace_record_t *rec) {
+    if (r->samples > 0) {
+        if (rec->timestamp_us < r->last_sample_us) {
+            r->time_reversals++;
+        } else {
+            uint32_t interval = (uint32_t)(rec->timestamp_us - r->last_sample_us);
+            if (r->intervals == 0 || interval < r->interval_min_us) r->interval_min_us = interval;
+            if (interval > r->interval_max_us) r->interval_max_us = interval;
+            r->interval_sum_us += interval;
+            r->interval_sq_sum += (double)interval * interval;
+            r->intervals++;
+        }
+    } else {
+        r->first_sample_us = rec->timestamp_us;
+        r->filtered.since_us = rec->timestamp_us;
+        r->raw.since_us = rec->timestamp_us;
+    }
+    r->samples++;
+    r->last_sample_us = rec->timestamp_us;
+
+    if (r->bench_reps > 0) {
+        replay_bench_keep(r, rec->vrx, rec->vry);
+    }
+
+    bool was_calibrated = r->filter.calibrated;
+    uint16_t vrx, vry;
+    joystick_direction_t direction = joystick_filter_update(&r->filter, rec->vrx, rec->vry, &vrx, &vry);
+    if (!was_calibrated && r->filter.calibrated && !r->quiet) {
+        bool gave_up = r->filter.calib_restarts >= JOYSTICK_CALIB_MAX_RESTARTS;
+        printf("%12.6f  %s: centro VRx=%u VRy=%u (%u recomeços)\n", replay_seconds(r, rec->timestamp_us),
+               gave_up ? "sem repouso, centro configurado" : "calibrado",
+               r->filter.axis[0].center, r->filter.axis[1].center, r->filter.calib_restarts);
+    }
+    joystick_direction_t previous = r->filtered.direction;
+    uint64_t previous_since_us = r->filtered.since_us;
+    if (replay_track(&r->filtered, direction, rec->timestamp_us)) {
+        r->dwell_us[previous] += rec->timestamp_us - previous_since_us;
+        if (!r->quiet) {
+            printf("%12.6f  direção %s -> %s (VRx=%u VRy=%u, filtrado %u/%u)\n", replay_seconds(r, rec->timestamp_us),
+                   g_direction_names[previous], g_direction_names[direction], rec->vrx, rec->vry, vrx, vry);
+        }
+    }
+    replay_track(&r->raw, joystick_classify(&r->joystick, rec->vrx, rec->vry), rec->timestamp_us);
+}
+
+static void replay_block(replay_t *r, const uint8_t *block) {
+    input_trace_reader_t reader;
+    uint32_t sequence;
+    uint8_t buttons;
+    if (!input_trace_block_open(&reader, block, &sequence, &buttons)) {
+        r->invalid_blocks++;
+        return;
+    }
+    r->blocks++;
+    if (!r->started || sequence != r->next_sequence) {
+        if (r->started && sequence > r->next_sequence) {
+            r->gaps += sequence - r->next_sequence;
+        } else if (r->started) {
+            r->restarts++; // Sequência recomeçou: outro boot da placa no mesmo arquivo
+            joystick_filter_init(&r->filter, &r->joystick); // O firmware recalibra no boot
+        }
+        // Início ou lacuna: o nível dos pinos vem do cabeçalho do bloco
+        for (int b = 0; b < BUTTON_ID_COUNT; b++) {
+            bool pressed = (buttons >> b) & 1;
+            r->buttons[b].raw_pressed = pressed;
+            if (!r->started) {
+                button_debounce_init(&r->buttons[b].debounce, pressed);
+            }
+        }
+        if (!r->started) {
+            r->t0_us = reader.last_us;
+            r->started = true;
+        }
+    }
+    r->next_sequence = sequence + 1;
+
+    input_trace_record_t rec;
+    int status;
+    while ((status = input_trace_next(&reader, &rec)) == 1) {
+        replay_advance(r, rec.timestamp_us);
+        if (rec.kind == INPUT_TRACE_GPIO) {
+            replay_edge(r, &rec);
+        } else {
+            replay_sample(r, &rec);
+        }
+    }
+    if (status < 0) {
+        r->corrupt++;
+    }
+}
+
+static void replay_report(const replay_t *r, uint64_t elapsed_ns, long bytes) {
+    double trace_s = r->samples > 1 ? (double)(r->last_sample_us - r->first_sample_us) / 1e6 : 0;
+    double wall_s = (double)elapsed_ns / 1e9;
+    printf("\ntrace: %u blocos (%ld bytes), %u inválidos, %u perdidos, %u reinícios, %u registros corrompidos\n",
+           r->blocks, bytes, r->invalid_blocks, r->gaps, r->restarts, r->corrupt);
+    printf("reprodução: %.3f s de trace em %.3f ms (%.0fx o tempo real)\n", trace_s, wall_s * 1e3,
+           wall_s > 0 ? trace_s / wall_s : 0);
+
+    if (r->intervals > 0) {
+        double mean = (double)r->interval_sum_us / (double)r->intervals;
+        double variance = r->interval_sq_sum / (double)r->intervals - mean * mean;
+        printf("amostras: %llu, intervalo min/média/máx %u/%.0f/%u us, desvio %.0f us, timestamps recuando: %llu\n",
+               (unsigned long long)r->samples, r->interval_min_us, mean, r->interval_max_us,
+               variance > 0 ? sqrt(variance) : 0, (unsigned long long)r->time_reversals);
+    }
+
+    double minutes = trace_s / 60.0;
+    const replay_track_t *tracks[] = { &r->filtered, &r->raw };
+    const char *const track_names[] = { "com filtro", "sem filtro" };
+    for (int i = 0; i < 2; i++) {
+        printf("direção %s: %u mudanças, %u espúrias (< %u ms): %.1f/min, %.1f%%\n", track_names[i],
+               tracks[i]->changes, tracks[i]->spurious, REPLAY_SPURIOUS_MS,
+               minutes > 0 ? tracks[i]->spurious / minutes : 0,
+               tracks[i]->changes > 0 ? 100.0 * tracks[i]->spurious / tracks[i]->changes : 0);
+    }
+    if (r->joystick.calib_samples > 0) {
+        printf("calibração: %s, centro VRx=%u VRy=%u, %u recomeços; curso VRx -%u/+%u VRy -%u/+%u\n",
+               !r->filter.calibrated ? "incompleta"
+                   : (r->filter.calib_restarts >= JOYSTICK_CALIB_MAX_RESTARTS) ? "desistiu (centro configurado)"
+                   : "concluída",
+               r->filter.axis[0].center,
+               r->filter.axis[1].center, r->filter.calib_restarts, r->filter.axis[0].travel_low,
+               r->filter.axis[0].travel_high, r->filter.axis[1].travel_low, r->filter.axis[1].travel_high);
+    }
+
+    printf("tempo em cada direção (com filtro):");
+    uint64_t dwell[REPLAY_DIRECTIONS];
+    memcpy(dwell, r->dwell_us, sizeof(dwell));
+    if (r->samples > 0) {
+        dwell[r->filtered.direction] += r->last_sample_us - r->filtered.since_us;
+    }
+    for (size_t d = 0; d < REPLAY_DIRECTIONS; d++) {
+        if (dwell[d] > 0) {
+            printf(" %s %.2f s", g_direction_names[d], (double)dwell[d] / 1e6);
+        }
+    }
+    printf("\n");
+
+    for (int b = 0; b < BUTTON_ID_COUNT; b++) {
+        const replay_button_t *button = &r->buttons[b];
+        printf("botão %c: %u pressionamentos, %u solturas", 'A' + b, button->presses, button->releases);
+        if (button->releases > 0) {
+            printf(" (segurado min/média/máx %.1f/%.1f/%.1f ms)", button->hold_min_us / 1000.0,
+                   (double)button->hold_sum_us / button->releases / 1000.0, button->hold_max_us / 1000.0);
+        }
+        printf("; %u bordas, %u de repique ignoradas, %u janelas sem mudança (ruído)\n", button->edges,
+               button->bounces, button->glitches);
+    }
+}
+
+static uint64_t bench_ticks(void) {
+#if REPLAY_HAVE_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// Custo por amostra do filtro e da classificação sem filtro sobre as amostras do trace.
+static void replay_bench(const replay_t *r) {
+    if (r->bench_len == 0) {
+        return;
+    }
+    volatile uint32_t sink = 0; // Impede que o compilador descarte as chamadas
+    uint64_t total = (uint64_t)r->bench_len * r->bench_reps;
+
+    joystick_filter_t filter;
+    joystick_filter_init(&filter, &r->joystick);
+    uint64_t start_ns = now_ns(), start_ticks = bench_ticks();
+    for (unsigned rep = 0; rep < r->bench_reps; rep++) {
+        for (size_t i = 0; i < r->bench_len; i++) {
+            uint16_t vrx, vry;
+            sink += joystick_filter_update(&filter, r->bench_vrx[i], r->bench_vry[i], &vrx, &vry);
+        }
+    }
+    uint64_t filter_ticks = bench_ticks() - start_ticks, filter_ns = now_ns() - start_ns;
+
+    start_ns = now_ns();
+    start_ticks = bench_ticks();
+    for (unsigned rep = 0; rep < r->bench_reps; rep++) {
+        for (size_t i = 0; i < r->bench_len; i++) {
+            sink += joystick_classify(&r->joystick, r->bench_vrx[i], r->bench_vry[i]);
+        }
+    }
+    uint64_t raw_ticks = bench_ticks() - start_ticks, raw_ns = now_ns() - start_ns;
+    (void)sink;
+
+    printf("bench: %llu amostras (%zu x %u)\n", (unsigned long long)total, r->bench_len, r->bench_reps);
+    printf("bench: com filtro %.1f ns/amostra", (double)filter_ns / (double)total);
+    if (REPLAY_HAVE_TSC) printf(", %.1f ciclos TSC/amostra", (double)filter_ticks / (double)total);
+    printf("\nbench: sem filtro %.1f ns/amostra", (double)raw_ns / (double)total);
+    if (REPLAY_HAVE_TSC) printf(", %.1f ciclos TSC/amostra", (double)raw_ticks / (double)total);
+    printf("\n");
+}
+
+static int run_replay(replay_t *r, const char *path) {
+    FILE *in = fopen(path, "rb");
+    if (in == NULL) {
+        perror(path);
+        return 1;
+    }
+    // O arquivo inteiro em memória: a medida de velocidade não inclui a leitura do disco
+    fseek(in, 0, SEEK_END);
+    long size = ftell(in);
+    fseek(in, 0, SEEK_SET);
+    uint8_t *data = malloc(size > 0 ? (size_t)size : 1);
+    if (data == NULL || fread(data, 1, (size_t)size, in) != (size_t)size) {
+        fprintf(stderr, "input_replay: falha ao ler %s\n", path);
+        fclose(in);
+        free(data);
+        return 1;
+    }
+    fclose(in);
+    if (size % INPUT_TRACE_BLOCK_LEN != 0) {
+        fprintf(stderr, "input_replay: %s tem %ld bytes, não é múltiplo de %d (último bloco truncado?)\n",
+                path, size, INPUT_TRACE_BLOCK_LEN);
+    }
+
+    uint64_t start = now_ns();
+    for (long off = 0; off + INPUT_TRACE_BLOCK_LEN <= size; off += INPUT_TRACE_BLOCK_LEN) {
+        replay_block(r, data + off);
+    }
+    replay_advance(r, UINT64_MAX); // Janelas que ficaram abertas no fim do trace
+    uint64_t elapsed = now_ns() - start;
+
+    replay_report(r, elapsed, size);
+    if (r->bench_reps > 0) {
+        replay_bench(r);
+    }
+    free(data);
+    free(r->bench_vrx);
+    free(r->bench_vry);
+    return r->blocks > 0 ? 0 : 1;
+}
+
+int main(int argc, char **argv) {
+    replay_t replay = {
+        .joystick = JOYSTICK_CONFIG_DEFAULT,
+        .debounce_us = BUTTON_DEBOUNCE_US,
+        .filtered = { .direction = CENTER },
+        .raw = { .direction = CENTER },
+    };
+    const char *fetch_host = NULL;
+    unsigned duration_s = 10;
+    unsigned generate_s = 0;
+    unsigned noise = 8;
+    bool fixed_center = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "qz:H:m:i:C:X:Y:b:B:F:d:g:N:")) != -1) {
+        switch (opt) {
+            case 'q': replay.quiet = true; break;
+            case 'z': replay.joystick.deadzone = (uint16_t)atoi(optarg); break;
+            case 'H': replay.joystick.hysteresis = (uint16_t)atoi(optarg); break;
+            case 'm': replay.joystick.median_len = (uint8_t)atoi(optarg); break;
+            case 'i': replay.joystick.iir_shift = (uint8_t)atoi(optarg); break;
+            case 'C': replay.joystick.calib_samples = (uint16_t)atoi(optarg); break;
+            case 'X': replay.joystick.center_vrx = (uint16_t)atoi(optarg); fixed_center = true; break;
+            case 'Y': replay.joystick.center_vry = (uint16_t)atoi(optarg); fixed_center = true; break;
+            case 'b': replay.debounce_us = (uint32_t)atoi(optarg); break;
+            case 'B': replay.bench_reps = (unsigned)atoi(optarg); break;
+            case 'N': noise = (unsigned)atoi(optarg); break;
+            case 'F': fetch_host = optarg; break;
+            case 'd': duration_s = (unsigned)atoi(optarg); break;
+            case 'g': generate_s = (unsigned)atoi(optarg); break;
+            default: usage(argv[0]);
+        }
+    }
+    if (optind != argc - 1 || duration_s == 0) {
+        usage(argv[0]);
+    }
+    const char *path = argv[optind];
+    if (generate_s > 0) {
+        return run_generator(path, generate_s, noise);
+    }
+    if (fetch_host != NULL) {
+        return run_fetch(fetch_host, duration_s, path);
+    }
+    if (fixed_center) {
+        replay.joystick.calib_samples = 0; // Centro dado: o filtro não o mede
+    }
+    joystick_filter_init(&replay.filter, &replay.joystick);
+    return run_replay(&replay, path);
+}
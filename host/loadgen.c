@@ -0,0 +1,464 @@
+/**
+ * @file loadgen.c
+ * @brief Gerador de carga HTTP para o servidor (build host via TUN ou a própria placa).
+ *
+ * Mantém N conexões simultâneas num único epoll, cada uma repetindo GET (keep-alive por padrão)
+ * durante o tempo pedido, e ao final imprime vazão, percentis de latência e as falhas vistas
+ * pelo cliente. Reset na conexão (o servidor aborta quando o pool de conexões/PCBs está cheio)
+ * e timeouts (SYN ou resposta perdidos, p.ex. pbufs esgotados) são contados à parte.
+ *
+ * Uso: loadgen [-c conexões] [-d segundos] [-p caminho]... [-t timeout_ms] [-K] [-f enxurrada] [host [porta]]
+ *   -K  fecha a conexão após cada resposta (Connection: close) em vez de keep-alive
+ *   -p  pode ser repetido; as conexões alternam entre os caminhos
+ *   -f  abre também N conexões que nunca mandam requisição (como um scanner de portas ou abas
+ *       esquecidas) e as reabre sempre que o servidor as fecha; as -c conexões fazem o papel dos
+ *       visualizadores já conectados, cuja latência deve continuar limitada durante a enxurrada
+ */
+
+#define _GNU_SOURCE
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#define LOADGEN_MAX_CONNECTIONS 256
+#define LOADGEN_MAX_PATHS 8
+#define LOADGEN_HEADER_BUF 4096
+#define LOADGEN_REQUEST_BUF 256
+#define LOADGEN_RETRY_DELAY_NS 10000000ull  // Espera antes de reconectar após uma falha
+
+typedef enum {
+    CONN_IDLE = 0,      // Sem socket; será (re)conectada
+    CONN_CONNECTING,
+    CONN_READING,       // Requisição enviada, aguardando/consumindo a resposta
+} conn_state_t;
+
+typedef struct {
+    int fd;
+    conn_state_t state;
+    unsigned path_index;
+    uint64_t request_start_ns;
+    uint64_t next_attempt_ns;
+    char header[LOADGEN_HEADER_BUF];
+    size_t header_len;
+    bool header_done;
+    int status;
+    long content_length;    // -1 = até o fechamento
+    long body_received;
+    bool server_closes;
+    bool flood;             // Conexão da enxurrada (-f): conecta e só espera o servidor
+} conn_t;
+
+typedef struct {
+    uint64_t completed;
+    uint64_t bytes;
+    uint64_t status_class[6];   // Índice = status / 100
+    uint64_t status_503;
+    uint64_t refused;
+    uint64_t resets;
+    uint64_t timeouts;
+    uint32_t *latency_us;
+    size_t latency_count;
+    size_t latency_capacity;
+} loadgen_stats_t;
+
+static struct sockaddr_in g_target;
+static const char *g_paths[LOADGEN_MAX_PATHS];
+static unsigned g_path_count = 0;
+static bool g_keep_alive = true;
+static unsigned g_timeout_ms = 2000;
+static int g_epoll_fd;
+static conn_t g_conns[LOADGEN_MAX_CONNECTIONS];
+static loadgen_stats_t g_stats;
+static conn_t g_flood[LOADGEN_MAX_CONNECTIONS];
+
+static struct {
+    uint64_t connects;      // Conexões da enxurrada estabelecidas
+    uint64_t status_503;    // Recusadas pelo servidor com 503
+    uint64_t closed;        // Fechadas sem resposta (cederam a vaga ou expiraram por ociosidade)
+    uint64_t failures;      // Reset, recusa no connect ou SYN sem resposta
+} g_flood_stats;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void record_latency(uint64_t ns) {
+    if (g_stats.latency_count == g_stats.latency_capacity) {
+        g_stats.latency_capacity = g_stats.latency_capacity ? g_stats.latency_capacity * 2 : 4096;
+        g_stats.latency_us = realloc(g_stats.latency_us, g_stats.latency_capacity * sizeof(uint32_t));
+        if (!g_stats.latency_us) {
+            perror("loadgen: realloc");
+            exit(1);
+        }
+    }
+    g_stats.latency_us[g_stats.latency_count++] = (uint32_t)(ns / 1000);
+}
+
+static void conn_close(conn_t *conn) {
+    if (conn->fd >= 0) {
+        close(conn->fd); // Também remove do epoll
+    }
+    conn->fd = -1;
+    conn->state = CONN_IDLE;
+}
+
+static void conn_fail(conn_t *conn, int error) {
+    if (error == ECONNREFUSED) {
+        g_stats.refused++;
+    } else {
+        g_stats.resets++; // ECONNRESET, EPIPE ou fechamento antes do fim da resposta
+    }
+    conn_close(conn);
+    conn->next_attempt_ns = now_ns() + LOADGEN_RETRY_DELAY_NS;
+}
+
+static bool conn_send_request(conn_t *conn) {
+    char request[LOADGEN_REQUEST_BUF];
+    const char *path = g_paths[conn->path_index];
+    conn->path_index = (conn->path_index + 1) % g_path_count;
+    int len = snprintf(request, sizeof(request), "GET %s HTTP/1.1\r\nHost: %s\r\nConnection: %s\r\n\r\n",
+                       path, inet_ntoa(g_target.sin_addr), g_keep_alive ? "keep-alive" : "close");
+
+    conn->header_len = 0;
+    conn->header_done = false;
+    conn->status = 0;
+    conn->content_length = -1;
+    conn->body_received = 0;
+    conn->server_closes = !g_keep_alive;
+    conn->request_start_ns = now_ns();
+
+    // A requisição é pequena e o buffer do socket está vazio: um send() basta
+    if (send(conn->fd, request, (size_t)len, MSG_NOSIGNAL) != len) {
+        conn_fail(conn, errno);
+        return false;
+    }
+    conn->state = CONN_READING;
+    struct epoll_event event = { .events = EPOLLIN, .data.ptr = conn };
+    epoll_ctl(g_epoll_fd, EPOLL_CTL_MOD, conn->fd, &event);
+    return true;
+}
+
+static void conn_start(conn_t *conn) {
+    conn->fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (conn->fd < 0) {
+        perror("loadgen: socket");
+        exit(1);
+    }
+    int one = 1;
+    setsockopt(conn->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    conn->request_start_ns = now_ns(); // Também cronometra o connect() para o timeout
+    conn->state = CONN_CONNECTING;
+    struct epoll_event event = { .events = EPOLLOUT, .data.ptr = conn };
+    epoll_ctl(g_epoll_fd, EPOLL_CTL_ADD, conn->fd, &event);
+    if (connect(conn->fd, (struct sockaddr *)&g_target, sizeof(g_target)) != 0 && errno != EINPROGRESS) {
+        conn_fail(conn, errno);
+    }
+}
+
+static void conn_response_complete(conn_t *conn) {
+    record_latency(now_ns() - conn->request_start_ns);
+    g_stats.completed++;
+    g_stats.status_class[conn->status / 100 < 6 ? conn->status / 100 : 0]++;
+    if (conn->status == 503) {
+        g_stats.status_503++;
+    }
+    if (conn->server_closes) {
+        conn_close(conn);
+    } else {
+        conn_send_request(conn);
+    }
+}
+
+// Analisa o cabeçalho acumulado; retorna quantos bytes de corpo vieram junto, ou -1 se incompleto.
+static long conn_parse_header(conn_t *conn) {
+    char *end = memmem(conn->header, conn->header_len, "\r\n\r\n", 4);
+    if (!end) {
+        return -1;
+    }
+    *end = '\0';
+    conn->header_done = true;
+    conn->status = atoi(conn->header + 9); // "HTTP/1.1 200 OK"
+    for (char *line = strstr(conn->header, "\r\n"); line; line = strstr(line + 2, "\r\n")) {
+        char *name = line + 2;
+        if (strncasecmp(name, "Content-Length:", 15) == 0) {
+            conn->content_length = strtol(name + 15, NULL, 10);
+        } else if (strncasecmp(name, "Connection:", 11) == 0 && strstr(name + 11, "close")) {
+            conn->server_closes = true;
+        }
+    }
+    if (conn->status == 304 || conn->status == 204 || conn->status == 101) {
+        conn->content_length = 0;
+    }
+    if (conn->content_length < 0) {
+        conn->server_closes = true; // Sem Content-Length: o corpo vai até o fechamento
+    }
+    return (long)(conn->header_len - (size_t)(end + 4 - conn->header));
+}
+
+static void conn_on_readable(conn_t *conn) {
+    char buf[8192];
+    for (;;) {
+        ssize_t n;
+        if (!conn->header_done) {
+            n = recv(conn->fd, conn->header + conn->header_len, sizeof(conn->header) - 1 - conn->header_len, 0);
+        } else {
+            n = recv(conn->fd, buf, sizeof(buf), 0);
+        }
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return;
+            }
+            conn_fail(conn, errno);
+            return;
+        }
+        if (n == 0) {
+            if (conn->header_done && conn->content_length < 0) {
+                conn_response_complete(conn); // Corpo delimitado pelo fechamento
+            } else {
+                conn_fail(conn, ECONNRESET);
+            }
+            return;
+        }
+        g_stats.bytes += (uint64_t)n;
+
+        if (!conn->header_done) {
+            conn->header_len += (size_t)n;
+            long extra = conn_parse_header(conn);
+            if (extra < 0) {
+                if (conn->header_len >= sizeof(conn->header) - 1) {
+                    conn_fail(conn, EMSGSIZE);
+                    return;
+                }
+                continue;
+            }
+            conn->body_received = extra;
+        } else {
+            conn->body_received += n;
+        }
+
+        if (conn->content_length >= 0 && conn->body_received >= conn->content_length) {
+            conn_response_complete(conn);
+            return; // Nova requisição enviada (ou conexão fechada): volta ao epoll
+        }
+    }
+}
+
+// Conexão da enxurrada: conta o que o servidor fez com ela e a reabre depois de LOADGEN_RETRY_DELAY_NS.
+static void flood_restart(conn_t *conn) {
+    conn_close(conn);
+    conn->next_attempt_ns = now_ns() + LOADGEN_RETRY_DELAY_NS;
+}
+
+static void flood_on_event(conn_t *conn) {
+    if (conn->state == CONN_CONNECTING) {
+        int error = 0;
+        socklen_t len = sizeof(error);
+        getsockopt(conn->fd, SOL_SOCKET, SO_ERROR, &error, &len);
+        if (error != 0) {
+            g_flood_stats.failures++;
+            flood_restart(conn);
+            return;
+        }
+        g_flood_stats.connects++;
+        conn->state = CONN_READING;
+        conn->header_len = 0;
+        struct epoll_event event = { .events = EPOLLIN, .data.ptr = conn };
+        epoll_ctl(g_epoll_fd, EPOLL_CTL_MOD, conn->fd, &event);
+        return;
+    }
+    for (;;) {
+        ssize_t n = recv(conn->fd, conn->header + conn->header_len, sizeof(conn->header) - 1 - conn->header_len, 0);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return;
+            }
+            g_flood_stats.failures++;
+            flood_restart(conn);
+            return;
+        }
+        if (n == 0) {
+            if (conn->header_len >= 12 && memcmp(conn->header + 9, "503", 3) == 0) {
+                g_flood_stats.status_503++;
+            } else {
+                g_flood_stats.closed++;
+            }
+            flood_restart(conn);
+            return;
+        }
+        if (conn->header_len + (size_t)n < sizeof(conn->header) - 1) {
+            conn->header_len += (size_t)n;
+        }
+    }
+}
+
+static void conn_on_event(conn_t *conn, uint32_t events) {
+    if (conn->flood) {
+        flood_on_event(conn);
+        return;
+    }
+    if (conn->state == CONN_CONNECTING) {
+        int error = 0;
+        socklen_t len = sizeof(error);
+        getsockopt(conn->fd, SOL_SOCKET, SO_ERROR, &error, &len);
+        if (error != 0) {
+            conn_fail(conn, error);
+            return;
+        }
+        conn_send_request(conn);
+        return;
+    }
+    if (conn->state == CONN_READING && (events & (EPOLLIN | EPOLLHUP | EPOLLERR))) {
+        conn_on_readable(conn);
+    }
+}
+
+static void check_timeouts(unsigned conn_count) {
+    uint64_t now = now_ns();
+    for (unsigned i = 0; i < conn_count; i++) {
+        conn_t *conn = &g_conns[i];
+        if (conn->state != CONN_IDLE && now - conn->request_start_ns > g_timeout_ms * 1000000ull) {
+            g_stats.timeouts++;
+            conn_close(conn);
+            conn->next_attempt_ns = now + LOADGEN_RETRY_DELAY_NS;
+        }
+    }
+}
+
+// Na enxurrada só o connect expira; depois de conectada, a conexão espera o servidor indefinidamente.
+static void check_flood_timeouts(unsigned flood_count) {
+    uint64_t now = now_ns();
+    for (unsigned i = 0; i < flood_count; i++) {
+        conn_t *conn = &g_flood[i];
+        if (conn->state == CONN_CONNECTING && now - conn->request_start_ns > g_timeout_ms * 1000000ull) {
+            g_flood_stats.failures++;
+            flood_restart(conn);
+        }
+    }
+}
+
+static int compare_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static double percentile_ms(double p) {
+    if (g_stats.latency_count == 0) {
+        return 0.0;
+    }
+    size_t index = (size_t)(p * (double)(g_stats.latency_count - 1) + 0.5);
+    return g_stats.latency_us[index] / 1000.0;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "Uso: %s [-c conexões] [-d segundos] [-p caminho]... [-t timeout_ms] [-K] [-f enxurrada] [host [porta]]\n", argv0);
+    exit(2);
+}
+
+int main(int argc, char **argv) {
+    unsigned conn_count = 4;
+    unsigned duration_s = 10;
+    unsigned flood_count = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "c:d:p:t:Kf:")) != -1) {
+        switch (opt) {
+            case 'c': conn_count = (unsigned)atoi(optarg); break;
+            case 'f': flood_count = (unsigned)atoi(optarg); break;
+            case 'd': duration_s = (unsigned)atoi(optarg); break;
+            case 't': g_timeout_ms = (unsigned)atoi(optarg); break;
+            case 'K': g_keep_alive = false; break;
+            case 'p':
+                if (g_path_count == LOADGEN_MAX_PATHS) {
+                    usage(argv[0]);
+                }
+                g_paths[g_path_count++] = optarg;
+                break;
+            default: usage(argv[0]);
+        }
+    }
+    if (conn_count == 0 || conn_count > LOADGEN_MAX_CONNECTIONS || flood_count > LOADGEN_MAX_CONNECTIONS || duration_s == 0) {
+        usage(argv[0]);
+    }
+    if (g_path_count == 0) {
+        g_paths[g_path_count++] = "/status";
+    }
+
+    const char *host = optind < argc ? argv[optind] : "192.168.7.2";
+    int port = optind + 1 < argc ? atoi(argv[optind + 1]) : 80;
+    g_target.sin_family = AF_INET;
+    g_target.sin_port = htons((uint16_t)port);
+    if (inet_pton(AF_INET, host, &g_target.sin_addr) != 1) {
+        fprintf(stderr, "loadgen: endereço IPv4 inválido: %s\n", host);
+        return 2;
+    }
+
+    g_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    for (unsigned i = 0; i < conn_count; i++) {
+        g_conns[i].fd = -1;
+        g_conns[i].path_index = i % g_path_count;
+    }
+    for (unsigned i = 0; i < flood_count; i++) {
+        g_flood[i].fd = -1;
+        g_flood[i].flood = true;
+        g_flood[i].next_attempt_ns = now_ns() + 200000000ull; // Os visualizadores conectam primeiro
+    }
+
+    printf("loadgen: %s:%d, %u conexões, %s, %u s", host, port, conn_count,
+           g_keep_alive ? "keep-alive" : "uma requisição por conexão", duration_s);
+    printf(flood_count ? ", enxurrada de %u conexões ociosas\n" : "\n", flood_count);
+
+    uint64_t start = now_ns();
+    uint64_t end = start + duration_s * 1000000000ull;
+    struct epoll_event events[2 * LOADGEN_MAX_CONNECTIONS];
+    while (now_ns() < end) {
+        uint64_t now = now_ns();
+        for (unsigned i = 0; i < conn_count; i++) {
+            if (g_conns[i].state == CONN_IDLE && now >= g_conns[i].next_attempt_ns) {
+                conn_start(&g_conns[i]);
+            }
+        }
+        for (unsigned i = 0; i < flood_count; i++) {
+            if (g_flood[i].state == CONN_IDLE && now >= g_flood[i].next_attempt_ns) {
+                conn_start(&g_flood[i]);
+            }
+        }
+        int n = epoll_wait(g_epoll_fd, events, 2 * LOADGEN_MAX_CONNECTIONS, 10);
+        for (int i = 0; i < n; i++) {
+            conn_on_event((conn_t *)events[i].data.ptr, events[i].events);
+        }
+        check_timeouts(conn_count);
+        check_flood_timeouts(flood_count);
+    }
+    double elapsed_s = (double)(now_ns() - start) / 1e9;
+
+    qsort(g_stats.latency_us, g_stats.latency_count, sizeof(uint32_t), compare_u32);
+    printf("requisições: %llu (%.1f req/s), %.1f KiB recebidos\n", (unsigned long long)g_stats.completed,
+           (double)g_stats.completed / elapsed_s, (double)g_stats.bytes / 1024.0);
+    printf("latência (ms): p50=%.2f p90=%.2f p99=%.2f max=%.2f\n", percentile_ms(0.50), percentile_ms(0.90),
+           percentile_ms(0.99), percentile_ms(1.0));
+    printf("respostas: 2xx=%llu 3xx=%llu 4xx=%llu 5xx=%llu (503=%llu)\n", (unsigned long long)g_stats.status_class[2],
+           (unsigned long long)g_stats.status_class[3], (unsigned long long)g_stats.status_class[4],
+           (unsigned long long)g_stats.status_class[5], (unsigned long long)g_stats.status_503);
+    printf("falhas: recusadas=%llu reset/abortadas=%llu timeouts=%llu\n", (unsigned long long)g_stats.refused,
+           (unsigned long long)g_stats.resets, (unsigned long long)g_stats.timeouts);
+    if (flood_count > 0) {
+        printf("enxurrada: %llu conexões, 503=%llu, fechadas sem resposta=%llu, falhas=%llu\n",
+               (unsigned long long)g_flood_stats.connects, (unsigned long long)g_flood_stats.status_503,
+               (unsigned long long)g_flood_stats.closed, (unsigned long long)g_flood_stats.failures);
+    }
+
+    return g_stats.completed > 0 ? 0 : 1;
+}
@@ -0,0 +1,28 @@
+/**
+ * @file lwipopts.h
+ * @brief Configuração da LwIP para o build host: a mesma do firmware, mais estatísticas.
+ *
+ * Os tamanhos de pools e buffers vêm de ../lwipopts.h sem alteração, para que os limites
+ * observados no teste de carga (PCBs, pbufs, heap) sejam os mesmos da placa.
+ */
+
+#ifndef LWIPOPTS_HOST_H
+#define LWIPOPTS_HOST_H
+
+#include "../lwipopts.h"
+
+// As estatísticas já vêm ligadas de ../lwipopts.h; aqui também o nome de cada pool em
+// lwip_stats, usado no relatório impresso ao encerrar (ver cyw43_arch_host.c).
+#undef LWIP_STATS_DISPLAY
+#define LWIP_STATS_DISPLAY 1
+
+// Toda chamada à LwIP acontece com o mutex de cyw43_arch_lwip_begin() tomado.
+#define SYS_LIGHTWEIGHT_PROT 0
+
+// O IP da interface TUN é estático (HOST_IP): sem DHCP nem AutoIP.
+#undef LWIP_DHCP
+#define LWIP_DHCP 0
+#undef LWIP_AUTOIP
+#define LWIP_AUTOIP 0
+
+#endif /* LWIPOPTS_HOST_H */
@@ -0,0 +1,18 @@
+// mem_usage.h no host: o heap vem do malloc da glibc; as pilhas são threads do sistema, sem
+// tamanho fixo nem padrão pintado, e aparecem zeradas em /metrics.
+
+#include "mem_usage.h"
+
+#include <malloc.h>
+#include <string.h>
+
+void mem_usage_init(void) {
+}
+
+void mem_usage_get(mem_usage_t *out) {
+    memset(out, 0, sizeof(*out));
+    struct mallinfo2 info = mallinfo2();
+    out->heap_used = (uint32_t)info.uordblks;
+    out->heap_peak = (uint32_t)info.arena;
+    out->heap_size = (uint32_t)info.arena;
+}
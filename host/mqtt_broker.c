@@ -0,0 +1,703 @@
+/**
+ * @file mqtt_broker.c
+ * @brief Broker MQTT 3.1.1 mínimo para testar o mqtt_publisher do firmware: aceita a placa (e
+ * assinantes como o mosquitto_sub), guarda as mensagens retidas e mede a publicação.
+ *
+ * Suporta CONNECT (com testamento), PUBLISH QoS 0/1, SUBSCRIBE (filtros com '+' e '#'), PINGREQ e
+ * DISCONNECT; não há sessão persistente nem QoS 2. Queda sem DISCONNECT publica o testamento.
+ *
+ * Nos tópicos de lote (.../joystick, .../buttons, .../temperature: "<seq>\n" e linhas "t_ms,...")
+ * confere lacunas na sequência de cada cliente e estima a latência: para cada mensagem, chegada
+ * (relógio local) menos o 't_ms' da primeira linha, descontado o menor valor já visto nesse
+ * cliente (a diferença entre os relógios). É o atraso além do melhor caso: espera no lote mais
+ * rede, comparável a mqtt_publish_latency_us do /metrics.
+ *
+ * A cada segundo imprime mensagens, bytes e linhas recebidos; ao final, totais por tópico, as
+ * mensagens retidas, lacunas e percentis da latência.
+ *
+ * Com -s, publica lotes sintéticos no formato do firmware (para testar o broker sozinho ou medir
+ * outro broker); -L descarta uma fração dos lotes antes de enviar, para conferir as lacunas.
+ * Com -T, confere sem rede o lote do firmware (mqtt_batch.c): linhas coalescidas e descartadas
+ * com o lote cheio, sem passar de MQTT_BATCH_LEN.
+ *
+ * Uso: mqtt_broker [-p porta] [-d segundos] [-v]
+ *      mqtt_broker -s host [-p porta] [-d segundos] [-r lotes/s] [-n linhas/lote] [-L perda%]
+ *      mqtt_broker -T
+ */
+
+#define _GNU_SOURCE
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "mqtt_batch.h"
+
+#define BROKER_MAX_CLIENTS 8
+#define BROKER_RX_BUF 8192
+#define BROKER_MAX_RETAINED 32
+#define BROKER_MAX_TOPICS 32
+#define BROKER_MAX_SUBS 8
+#define BROKER_TOPIC_LEN 128
+#define BROKER_PAYLOAD_LEN 1024
+#define BROKER_LATENCY_BUCKETS 5000    // Histograma de 1 ms; acima disso conta no último
+
+typedef struct {
+    char topic[BROKER_TOPIC_LEN];
+    uint8_t payload[BROKER_PAYLOAD_LEN];
+    size_t len;
+} broker_message_t;
+
+typedef struct {
+    int fd;                             // -1 = slot livre
+    bool connected;                     // CONNECT recebido
+    char client_id[64];
+    uint8_t rx[BROKER_RX_BUF];
+    size_t rx_len;
+    bool has_will;
+    bool will_retain;
+    broker_message_t will;
+    char subs[BROKER_MAX_SUBS][BROKER_TOPIC_LEN];
+    int sub_count;
+    // Medidas dos lotes deste cliente
+    bool have_seq;
+    uint32_t expected_seq;
+    bool have_offset;
+    int64_t min_offset_ms;              // Menor (chegada - t_ms) já visto
+} broker_client_t;
+
+typedef struct {
+    char topic[BROKER_TOPIC_LEN];
+    uint64_t messages;
+    uint64_t bytes;
+} broker_topic_stats_t;
+
+typedef struct {
+    uint64_t messages;
+    uint64_t bytes;
+    uint64_t lines;
+    uint64_t lost;                      // Lacunas na sequência dos lotes
+    uint64_t connects;
+    uint64_t wills;                     // Testamentos publicados (quedas sem DISCONNECT)
+    uint64_t invalid;
+} broker_stats_t;
+
+static broker_client_t g_clients[BROKER_MAX_CLIENTS];
+static broker_message_t g_retained[BROKER_MAX_RETAINED];
+static int g_retained_count = 0;
+static broker_topic_stats_t g_topics[BROKER_MAX_TOPICS];
+static int g_topic_count = 0;
+static broker_stats_t g_stats;
+static uint32_t g_latency_hist[BROKER_LATENCY_BUCKETS];
+static uint64_t g_latency_count = 0;
+static uint32_t g_latency_max_ms = 0;
+static bool g_verbose = false;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+            "Uso: %s [-p porta] [-d segundos] [-v]\n"
+            "     %s -s host [-p porta] [-d segundos] [-r lotes/s] [-n linhas/lote] [-L perda%%]\n"
+            "     %s -T\n",
+            argv0, argv0, argv0);
+    exit(2);
+}
+
+// --- Codificação MQTT ---
+
+static size_t mqtt_put_remaining(uint8_t *out, size_t remaining) {
+    size_t n = 0;
+    do {
+        uint8_t byte = remaining % 128;
+        remaining /= 128;
+        out[n++] = (uint8_t)(byte | (remaining > 0 ? 0x80 : 0));
+    } while (remaining > 0);
+    return n;
+}
+
+static size_t mqtt_put_string(uint8_t *out, const char *str, size_t len) {
+    out[0] = (uint8_t)(len >> 8);
+    out[1] = (uint8_t)len;
+    memcpy(out + 2, str, len);
+    return len + 2;
+}
+
+// PUBLISH QoS 0 completo em 'out' (tamanho suficiente: tópico + payload + 8).
+static size_t mqtt_build_publish(uint8_t *out, const char *topic, const uint8_t *payload, size_t len, bool retain) {
+    size_t topic_len = strlen(topic);
+    size_t n = 0;
+    out[n++] = (uint8_t)(0x30 | (retain ? 0x01 : 0x00));
+    n += mqtt_put_remaining(out + n, 2 + topic_len + len);
+    n += mqtt_put_string(out + n, topic, topic_len);
+    memcpy(out + n, payload, len);
+    return n + len;
+}
+
+static void send_all(int fd, const uint8_t *data, size_t len) {
+    while (len > 0) {
+        ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;
+            return; // A queda aparece no próximo recv
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+}
+
+// Filtro MQTT: '+' casa um nível, '#' no fim casa o resto.
+static bool topic_matches(const char *filter, const char *topic) {
+    while (*filter != '\0') {
+        if (*filter == '#') {
+            return true;
+        }
+        if (*filter == '+') {
+            while (*topic != '\0' && *topic != '/') topic++;
+            filter++;
+            continue;
+        }
+        if (*filter != *topic) {
+            return false;
+        }
+        filter++;
+        topic++;
+    }
+    return *topic == '\0';
+}
+
+// --- Broker ---
+
+static broker_topic_stats_t *topic_stats(const char *topic) {
+    for (int i = 0; i < g_topic_count; i++) {
+        if (strcmp(g_topics[i].topic, topic) == 0) return &g_topics[i];
+    }
+    if (g_topic_count == BROKER_MAX_TOPICS) return NULL;
+    broker_topic_stats_t *t = &g_topics[g_topic_count++];
+    snprintf(t->topic, sizeof(t->topic), "%s", topic);
+    return t;
+}
+
+static void retain_message(const char *topic, const uint8_t *payload, size_t len) {
+    int i = 0;
+    for (; i < g_retained_count && strcmp(g_retained[i].topic, topic) != 0; i++) {
+    }
+    if (len == 0) { // Payload vazio apaga a retida
+        if (i < g_retained_count) g_retained[i] = g_retained[--g_retained_count];
+        return;
+    }
+    if (i == g_retained_count) {
+        if (g_retained_count == BROKER_MAX_RETAINED) return;
+        g_retained_count++;
+    }
+    snprintf(g_retained[i].topic, sizeof(g_retained[i].topic), "%s", topic);
+    g_retained[i].len = len < BROKER_PAYLOAD_LEN ? len : BROKER_PAYLOAD_LEN;
+    memcpy(g_retained[i].payload, payload, g_retained[i].len);
+}
+
+static bool is_batch_topic(const char *topic) {
+    const char *slash = strrchr(topic, '/');
+    const char *leaf = slash ? slash + 1 : topic;
+    return strcmp(leaf, "joystick") == 0 || strcmp(leaf, "buttons") == 0 || strcmp(leaf, "temperature") == 0;
+}
+
+// Sequência e atraso de um lote "<seq>\n" + linhas "t_ms,...\n".
+static void account_batch(broker_client_t *client, const uint8_t *payload, size_t len, uint64_t arrival_ms) {
+    char text[BROKER_PAYLOAD_LEN + 1];
+    if (len > BROKER_PAYLOAD_LEN) len = BROKER_PAYLOAD_LEN;
+    memcpy(text, payload, len);
+    text[len] = '\0';
+
+    char *line = strchr(text, '\n');
+    if (line == NULL) {
+        g_stats.invalid++;
+        return;
+    }
+    uint32_t seq = (uint32_t)strtoul(text, NULL, 10);
+    if (client->have_seq && seq != client->expected_seq) {
+        int32_t gap = (int32_t)(seq - client->expected_seq);
+        if (gap > 0) g_stats.lost += (uint64_t)gap;
+    }
+    client->have_seq = true;
+    client->expected_seq = seq + 1;
+
+    bool first = true;
+    for (line++; *line != '\0';) {
+        char *end = strchr(line, '\n');
+        if (end == NULL) break;
+        g_stats.lines++;
+        if (first) {
+            int64_t offset = (int64_t)arrival_ms - (int64_t)strtoull(line, NULL, 10);
+            if (!client->have_offset || offset < client->min_offset_ms) {
+                client->min_offset_ms = offset;
+                client->have_offset = true;
+            }
+            uint64_t delay = (uint64_t)(offset - client->min_offset_ms);
+            g_latency_hist[delay < BROKER_LATENCY_BUCKETS ? delay : BROKER_LATENCY_BUCKETS - 1]++;
+            g_latency_count++;
+            if (delay > g_latency_max_ms) g_latency_max_ms = (uint32_t)delay;
+            first = false;
+        }
+        line = end + 1;
+    }
+}
+
+static void route_publish(broker_client_t *from, const char *topic, const uint8_t *payload, size_t len, bool retain) {
+    static uint8_t frame[BROKER_PAYLOAD_LEN + BROKER_TOPIC_LEN + 8];
+    if (len > BROKER_PAYLOAD_LEN) len = BROKER_PAYLOAD_LEN;
+    if (retain) {
+        retain_message(topic, payload, len);
+    }
+    size_t frame_len = mqtt_build_publish(frame, topic, payload, len, false);
+    for (int i = 0; i < BROKER_MAX_CLIENTS; i++) {
+        broker_client_t *c = &g_clients[i];
+        if (c->fd < 0 || !c->connected || c == from) continue;
+        for (int s = 0; s < c->sub_count; s++) {
+            if (topic_matches(c->subs[s], topic)) {
+                send_all(c->fd, frame, frame_len);
+                break;
+            }
+        }
+    }
+}
+
+static void client_close(broker_client_t *client, bool publish_will) {
+    if (publish_will && client->connected && client->has_will) {
+        printf("mqtt_broker: '%s' caiu sem DISCONNECT: testamento em %s\n", client->client_id, client->will.topic);
+        g_stats.wills++;
+        route_publish(client, client->will.topic, client->will.payload, client->will.len, client->will_retain);
+    } else if (client->connected) {
+        printf("mqtt_broker: '%s' desconectou\n", client->client_id);
+    }
+    close(client->fd);
+    client->fd = -1;
+}
+
+static bool read_string(const uint8_t **p, const uint8_t *end, char *out, size_t out_size, size_t *out_len) {
+    if (end - *p < 2) return false;
+    size_t len = ((size_t)(*p)[0] << 8) | (*p)[1];
+    if ((size_t)(end - *p) < 2 + len) return false;
+    size_t copy = len < out_size - 1 ? len : out_size - 1;
+    memcpy(out, *p + 2, copy);
+    out[copy] = '\0';
+    if (out_len) *out_len = copy;
+    *p += 2 + len;
+    return true;
+}
+
+static bool handle_connect(broker_client_t *client, const uint8_t *p, const uint8_t *end) {
+    char protocol[8];
+    if (!read_string(&p, end, protocol, sizeof(protocol), NULL) || end - p < 4) return false;
+    uint8_t level = p[0], flags = p[1];
+    p += 4; // Nível, flags e keep-alive
+    if (strcmp(protocol, "MQTT") != 0 || level != 4) {
+        static const uint8_t refused[] = { 0x20, 0x02, 0x00, 0x01 }; // Versão não suportada
+        send_all(client->fd, refused, sizeof(refused));
+        return false;
+    }
+    if (!read_string(&p, end, client->client_id, sizeof(client->client_id), NULL)) return false;
+    client->has_will = (flags & 0x04) != 0;
+    client->will_retain = (flags & 0x20) != 0;
+    if (client->has_will) {
+        char will_payload[BROKER_PAYLOAD_LEN];
+        if (!read_string(&p, end, client->will.topic, sizeof(client->will.topic), NULL) ||
+            !read_string(&p, end, will_payload, sizeof(will_payload), &client->will.len)) {
+            return false;
+        }
+        memcpy(client->will.payload, will_payload, client->will.len);
+    }
+    client->connected = true;
+    g_stats.connects++;
+    static const uint8_t accepted[] = { 0x20, 0x02, 0x00, 0x00 };
+    send_all(client->fd, accepted, sizeof(accepted));
+    printf("mqtt_broker: '%s' conectado%s\n", client->client_id, client->has_will ? " (com testamento)" : "");
+    return true;
+}
+
+static bool handle_publish(broker_client_t *client, uint8_t header, const uint8_t *p, const uint8_t *end,
+                           size_t packet_len) {
+    char topic[BROKER_TOPIC_LEN];
+    if (!read_string(&p, end, topic, sizeof(topic), NULL)) return false;
+    int qos = (header >> 1) & 0x03;
+    bool retain = (header & 0x01) != 0;
+    if (qos == 2) return false;
+    if (qos == 1) {
+        if (end - p < 2) return false;
+        uint8_t ack[] = { 0x40, 0x02, p[0], p[1] };
+        send_all(client->fd, ack, sizeof(ack));
+        p += 2;
+    }
+    size_t len = (size_t)(end - p);
+    uint64_t arrival_ms = now_ns() / 1000000ull;
+
+    g_stats.messages++;
+    g_stats.bytes += packet_len;
+    broker_topic_stats_t *t = topic_stats(topic);
+    if (t != NULL) {
+        t->messages++;
+        t->bytes += packet_len;
+    }
+    if (g_verbose) {
+        printf("%s%s (%zu B): %.*s%s", topic, retain ? " [retida]" : "", len, (int)len, (const char *)p,
+               (len > 0 && p[len - 1] == '\n') ? "" : "\n");
+    }
+    if (is_batch_topic(topic)) {
+        account_batch(client, p, len, arrival_ms);
+    }
+    route_publish(client, topic, p, len, retain);
+    return true;
+}
+
+static bool handle_subscribe(broker_client_t *client, const uint8_t *p, const uint8_t *end) {
+    if (end - p < 2) return false;
+    uint8_t ack[4 + BROKER_MAX_SUBS + 8] = { 0x90, 0, p[0], p[1] };
+    size_t n = 4;
+    p += 2;
+    while (p < end) {
+        char filter[BROKER_TOPIC_LEN];
+        if (!read_string(&p, end, filter, sizeof(filter), NULL) || p >= end) return false;
+        p++; // QoS pedida: sempre concede 0
+        if (client->sub_count < BROKER_MAX_SUBS) {
+            snprintf(client->subs[client->sub_count++], BROKER_TOPIC_LEN, "%s", filter);
+            ack[n++] = 0x00;
+        } else {
+            ack[n++] = 0x80;
+        }
+        if (n == sizeof(ack)) break;
+    }
+    ack[1] = (uint8_t)(n - 2);
+    send_all(client->fd, ack, n);
+
+    // Retidas que casam com os filtros novos
+    static uint8_t frame[BROKER_PAYLOAD_LEN + BROKER_TOPIC_LEN + 8];
+    for (int r = 0; r < g_retained_count; r++) {
+        for (int s = 0; s < client->sub_count; s++) {
+            if (topic_matches(client->subs[s], g_retained[r].topic)) {
+                size_t len = mqtt_build_publish(frame, g_retained[r].topic, g_retained[r].payload, g_retained[r].len, true);
+                send_all(client->fd, frame, len);
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+// Processa os pacotes completos do buffer. Retorna false para fechar a conexão.
+static bool client_process(broker_client_t *client) {
+    size_t pos = 0;
+    while (client->rx_len - pos >= 2) {
+        const uint8_t *base = client->rx + pos;
+        size_t remaining = 0, header_len = 1;
+        int shift = 0;
+        uint8_t byte;
+        do {
+            if (pos + header_len >= client->rx_len) goto incomplete;
+            byte = base[header_len++];
+            remaining |= (size_t)(byte & 0x7F) << shift;
+            shift += 7;
+        } while ((byte & 0x80) && shift < 28);
+        if (header_len + remaining > BROKER_RX_BUF) return false;
+        if (pos + header_len + remaining > client->rx_len) goto incomplete;
+
+        uint8_t type = base[0] >> 4;
+        const uint8_t *p = base + header_len, *end = p + remaining;
+        if (!client->connected && type != 1) return false;
+        bool ok = true;
+        switch (type) {
+            case 1: ok = handle_connect(client, p, end); break;
+            case 3: ok = handle_publish(client, base[0], p, end, header_len + remaining); break;
+            case 8: ok = handle_subscribe(client, p, end); break;
+            case 12: { // PINGREQ
+                static const uint8_t pong[] = { 0xD0, 0x00 };
+                send_all(client->fd, pong, sizeof(pong));
+                break;
+            }
+            case 14: client->has_will = false; ok = false; break; // DISCONNECT: sem testamento
+            case 4: case 10: break; // PUBACK e UNSUBSCRIBE ignorados
+            default: g_stats.invalid++; ok = false; break;
+        }
+        if (!ok) {
+            return false;
+        }
+        pos += header_len + remaining;
+    }
+incomplete:
+    memmove(client->rx, client->rx + pos, client->rx_len - pos);
+    client->rx_len -= pos;
+    return true;
+}
+
+static uint32_t latency_percentile(double fraction) {
+    uint64_t target = (uint64_t)(fraction * (double)g_latency_count), seen = 0;
+    for (uint32_t i = 0; i < BROKER_LATENCY_BUCKETS; i++) {
+        seen += g_latency_hist[i];
+        if (seen > target) return i;
+    }
+    return BROKER_LATENCY_BUCKETS - 1;
+}
+
+static int run_broker(int port, unsigned duration_s) {
+    int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    struct sockaddr_in local = { .sin_family = AF_INET, .sin_port = htons((uint16_t)port), .sin_addr.s_addr = htonl(INADDR_ANY) };
+    if (bind(listen_fd, (struct sockaddr *)&local, sizeof(local)) != 0 || listen(listen_fd, 4) != 0) {
+        perror("mqtt_broker: bind/listen");
+        return 1;
+    }
+    for (int i = 0; i < BROKER_MAX_CLIENTS; i++) g_clients[i].fd = -1;
+    printf("mqtt_broker: escutando TCP %d por %u s\n", port, duration_s);
+
+    broker_stats_t last_report = {0};
+    uint64_t start = now_ns();
+    uint64_t end = start + duration_s * 1000000000ull;
+    uint64_t next_report = start + 1000000000ull;
+    uint64_t first_rx = 0, last_rx = 0;
+    while (now_ns() < end) {
+        struct pollfd pfds[BROKER_MAX_CLIENTS + 1];
+        int map[BROKER_MAX_CLIENTS + 1];
+        int n = 0;
+        pfds[n] = (struct pollfd){ .fd = listen_fd, .events = POLLIN };
+        map[n++] = -1;
+        for (int i = 0; i < BROKER_MAX_CLIENTS; i++) {
+            if (g_clients[i].fd >= 0) {
+                pfds[n] = (struct pollfd){ .fd = g_clients[i].fd, .events = POLLIN };
+                map[n++] = i;
+            }
+        }
+        if (poll(pfds, (nfds_t)n, 100) > 0) {
+            for (int k = 0; k < n; k++) {
+                if (!(pfds[k].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+                if (map[k] < 0) {
+                    int fd = accept(listen_fd, NULL, NULL);
+                    int slot = 0;
+                    for (; slot < BROKER_MAX_CLIENTS && g_clients[slot].fd >= 0; slot++) {
+                    }
+                    if (fd >= 0 && slot == BROKER_MAX_CLIENTS) {
+                        close(fd); // Sem slot
+                    } else if (fd >= 0) {
+                        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                        memset(&g_clients[slot], 0, sizeof(g_clients[slot]));
+                        g_clients[slot].fd = fd;
+                    }
+                    continue;
+                }
+                broker_client_t *client = &g_clients[map[k]];
+                ssize_t len = recv(client->fd, client->rx + client->rx_len, BROKER_RX_BUF - client->rx_len, 0);
+                if (len <= 0) {
+                    client_close(client, true);
+                    continue;
+                }
+                client->rx_len += (size_t)len;
+                uint64_t messages = g_stats.messages;
+                if (!client_process(client)) {
+                    client_close(client, client->has_will);
+                }
+                if (g_stats.messages != messages) {
+                    last_rx = now_ns();
+                    if (first_rx == 0) first_rx = last_rx;
+                }
+            }
+        }
+        if (now_ns() >= next_report) {
+            printf("+1s: %llu mensagens, %llu bytes, %llu linhas, perdidas=%llu\n",
+                   (unsigned long long)(g_stats.messages - last_report.messages),
+                   (unsigned long long)(g_stats.bytes - last_report.bytes),
+                   (unsigned long long)(g_stats.lines - last_report.lines), (unsigned long long)g_stats.lost);
+            last_report = g_stats;
+            next_report += 1000000000ull;
+        }
+    }
+
+    double window_s = (last_rx > first_rx) ? (double)(last_rx - first_rx) / 1e9 : 0;
+    printf("mensagens: %llu (%.1f/s), %.1f KiB, linhas de lote: %llu (%.1f por mensagem de lote)\n",
+           (unsigned long long)g_stats.messages, window_s > 0 ? (double)g_stats.messages / window_s : 0,
+           (double)g_stats.bytes / 1024.0, (unsigned long long)g_stats.lines,
+           g_latency_count ? (double)g_stats.lines / (double)g_latency_count : 0);
+    for (int i = 0; i < g_topic_count; i++) {
+        printf("  %-32s %8llu mensagens %10llu bytes\n", g_topics[i].topic, (unsigned long long)g_topics[i].messages,
+               (unsigned long long)g_topics[i].bytes);
+    }
+    for (int i = 0; i < g_retained_count; i++) {
+        printf("  retida %s: %.*s\n", g_retained[i].topic, (int)g_retained[i].len, (const char *)g_retained[i].payload);
+    }
+    printf("perdidas (lacunas na sequência): %llu, conexões: %llu, testamentos: %llu, inválidos: %llu\n",
+           (unsigned long long)g_stats.lost, (unsigned long long)g_stats.connects, (unsigned long long)g_stats.wills,
+           (unsigned long long)g_stats.invalid);
+    if (g_latency_count > 0) {
+        printf("latência além do melhor caso (ms): p50=%u p90=%u p99=%u max=%u\n", latency_percentile(0.50),
+               latency_percentile(0.90), latency_percentile(0.99), g_latency_max_ms);
+    }
+    for (int i = 0; i < BROKER_MAX_CLIENTS; i++) {
+        if (g_clients[i].fd >= 0) close(g_clients[i].fd);
+    }
+    close(listen_fd);
+    return g_stats.messages > 0 ? 0 : 1;
+}
+
+// --- Gerador (-s) ---
+
+static int run_sender(const char *host, int port, unsigned duration_s, unsigned rate, unsigned lines,
+                      unsigned loss_percent) {
+    struct sockaddr_in target = { .sin_family = AF_INET, .sin_port = htons((uint16_t)port) };
+    if (inet_pton(AF_INET, host, &target.sin_addr) != 1) {
+        fprintf(stderr, "mqtt_broker: endereço IPv4 inválido: %s\n", host);
+        return 2;
+    }
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (connect(fd, (struct sockaddr *)&target, sizeof(target)) != 0) {
+        perror("mqtt_broker: connect");
+        return 1;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    // CONNECT com sessão limpa, keep-alive de 30 s e testamento retido "offline"
+    static const char client_id[] = "mqtt_broker-s", will_topic[] = "teste/status", will_msg[] = "offline";
+    uint8_t frame[BROKER_PAYLOAD_LEN + BROKER_TOPIC_LEN + 8];
+    uint8_t body[128];
+    size_t b = mqtt_put_string(body, "MQTT", 4);
+    body[b++] = 4;
+    body[b++] = 0x02 | 0x04 | 0x20;
+    body[b++] = 0;
+    body[b++] = 30;
+    b += mqtt_put_string(body + b, client_id, sizeof(client_id) - 1);
+    b += mqtt_put_string(body + b, will_topic, sizeof(will_topic) - 1);
+    b += mqtt_put_string(body + b, will_msg, sizeof(will_msg) - 1);
+    size_t n = 0;
+    frame[n++] = 0x10;
+    n += mqtt_put_remaining(frame + n, b);
+    memcpy(frame + n, body, b);
+    send_all(fd, frame, n + b);
+    uint8_t connack[4];
+    if (recv(fd, connack, sizeof(connack), MSG_WAITALL) != 4 || connack[0] != 0x20 || connack[3] != 0) {
+        fprintf(stderr, "mqtt_broker: CONNECT recusado\n");
+        close(fd);
+        return 1;
+    }
+    n = mqtt_build_publish(frame, "teste/status", (const uint8_t *)"online", 6, true);
+    send_all(fd, frame, n);
+
+    uint32_t sequence = 0;
+    uint64_t sent = 0, dropped = 0;
+    uint64_t period_ns = 1000000000ull / rate;
+    uint64_t start = now_ns();
+    uint64_t end = start + duration_s * 1000000000ull;
+    for (uint64_t i = 0, next = start; next < end; i++, next += period_ns) {
+        while (now_ns() < next) {
+            usleep(200);
+        }
+        // Lote como o do firmware: linhas espaçadas de 5 ms até o instante do envio
+        char payload[BROKER_PAYLOAD_LEN];
+        int len = snprintf(payload, sizeof(payload), "%u\n", sequence);
+        uint64_t t_ms = (next - start) / 1000000ull;
+        for (unsigned l = 0; l < lines; l++) {
+            uint64_t line_ms = t_ms - (t_ms >= (lines - 1 - l) * 5 ? (lines - 1 - l) * 5 : t_ms);
+            len += snprintf(payload + len, sizeof(payload) - (size_t)len, "%llu,%u,%u,2047\n",
+                            (unsigned long long)line_ms, (unsigned)(i % 9), (unsigned)(2048 + (i * 37) % 1500));
+        }
+        if ((unsigned)(rand() % 100) < loss_percent) {
+            dropped++;
+        } else {
+            n = mqtt_build_publish(frame, "teste/joystick", (const uint8_t *)payload, (size_t)len, false);
+            send_all(fd, frame, n);
+            sent++;
+        }
+        sequence++;
+    }
+    static const uint8_t disconnect[] = { 0xE0, 0x00 };
+    send_all(fd, disconnect, sizeof(disconnect));
+    printf("mqtt_broker: %llu lotes enviados para %s:%d, %llu descartados de propósito (-L)\n",
+           (unsigned long long)sent, host, port, (unsigned long long)dropped);
+    close(fd);
+    return 0;
+}
+
+// Enche um lote com linhas de 'fill_len' bytes e acrescenta uma de 'line_len': confere o resultado,
+// o tamanho e que o conteúdo e os campos depois de 'data' ficaram intactos.
+static bool batch_case(const char *name, size_t fill_len, size_t line_len, mqtt_batch_result_t expected) {
+    static const char digits[] = "0123456789012345678901234567890123456789";
+    mqtt_batch_t batch;
+    memset(&batch, 0, sizeof(batch));
+    char fill[64], line[64];
+    memset(fill, 'a', fill_len - 1);
+    fill[fill_len - 1] = '\n';
+    memcpy(line, digits, line_len - 1);
+    line[line_len - 1] = '\n';
+
+    uint64_t t_us = 1000;
+    while (mqtt_batch_append(&batch, fill, fill_len, t_us) == MQTT_BATCH_APPENDED) {
+        t_us += 1000;
+    }
+    mqtt_batch_t before = batch;
+    mqtt_batch_result_t result = mqtt_batch_append(&batch, line, line_len, t_us);
+
+    bool ok = result == expected && batch.len <= MQTT_BATCH_LEN && batch.first_us == 1000;
+    if (expected == MQTT_BATCH_DROPPED) {
+        ok = ok && memcmp(&batch, &before, sizeof(batch)) == 0;
+    } else {
+        ok = ok && batch.len == before.last_line + line_len &&
+             memcmp(batch.data + batch.last_line, line, line_len) == 0 &&
+             memcmp(batch.data, before.data, before.last_line) == 0;
+    }
+    printf("mqtt_broker: lote %s: resultado %d (esperado %d), %u bytes: %s\n", name, (int)result,
+           (int)expected, (unsigned)batch.len, ok ? "ok" : "FALHOU");
+    return ok;
+}
+
+static int run_batch_test(void) {
+    int failures = 0;
+    failures += !batch_case("cheio, linha do mesmo tamanho", 16, 16, MQTT_BATCH_COALESCED);
+    failures += !batch_case("cheio com folga, linha maior", 22, 24, MQTT_BATCH_COALESCED);
+    failures += !batch_case("cheio, linha maior que a última", 16, 30, MQTT_BATCH_DROPPED);
+    failures += !batch_case("cheio com folga, linha bem maior", 10, 32, MQTT_BATCH_DROPPED);
+    return failures == 0 ? 0 : 1;
+}
+
+int main(int argc, char **argv) {
+    int port = 1883;
+    unsigned duration_s = 60;
+    unsigned rate = 10;
+    unsigned lines = 5;
+    unsigned loss_percent = 0;
+    const char *send_host = NULL;
+    bool batch_test = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "p:d:s:r:n:L:Tv")) != -1) {
+        switch (opt) {
+            case 'p': port = atoi(optarg); break;
+            case 'd': duration_s = (unsigned)atoi(optarg); break;
+            case 's': send_host = optarg; break;
+            case 'r': rate = (unsigned)atoi(optarg); break;
+            case 'n': lines = (unsigned)atoi(optarg); break;
+            case 'L': loss_percent = (unsigned)atoi(optarg); break;
+            case 'T': batch_test = true; break;
+            case 'v': g_verbose = true; break;
+            default: usage(argv[0]);
+        }
+    }
+    if (batch_test) {
+        return run_batch_test();
+    }
+    if (duration_s == 0 || rate == 0 || lines == 0 || lines > 40) {
+        usage(argv[0]);
+    }
+    if (send_host != NULL) {
+        return run_sender(send_host, port, duration_s, rate, lines, loss_percent);
+    }
+    return run_broker(port, duration_s);
+}
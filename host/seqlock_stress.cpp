@@ -0,0 +1,178 @@
+/**
+ * @file seqlock_stress.cpp
+ * @brief Teste de estresse do seqlock de input_state.c (o mesmo arquivo do firmware): um escritor
+ * publica snapshots sem pausa enquanto vários leitores copiam e conferem cada cópia.
+ *
+ * O escritor publica o snapshot i com todos os campos derivados de i (timestamp_us = i, VRx, VRy,
+ * temperatura, direção, botões...). Como input_state_publish() numera as publicações, uma cópia
+ * consistente tem generation == timestamp_us e cada campo igual à função de i; qualquer diferença
+ * é uma leitura rasgada. Cada leitor confere também que generation nunca recua. A direção muda a
+ * cada publicação, então change_generation deve acompanhar generation.
+ *
+ * Com -n, escritor e leitores usam uma cópia simples (byte a byte, sem seqlock) de um snapshot local:
+ * serve para mostrar que o teste detecta rasgos quando não há proteção.
+ *
+ * Uso: seqlock_stress [-d segundos] [-r leitores] [-n]
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+extern "C" {
+#include "input_state.h"
+}
+
+namespace {
+
+std::atomic<bool> g_stop{false};
+std::atomic<uint64_t> g_published{0};
+bool g_naive = false;
+volatile input_snapshot_t g_naive_snapshot;    // Só no modo -n
+
+// Cópia byte a byte por ponteiro volatile: o compilador não a elimina nem a tira do laço.
+void volatile_copy(volatile void *dst, const volatile void *src, size_t len) {
+    auto *d = static_cast<volatile uint8_t *>(dst);
+    auto *s = static_cast<const volatile uint8_t *>(src);
+    for (size_t i = 0; i < len; i++) {
+        d[i] = s[i];
+    }
+}
+
+struct reader_stats_t {
+    uint64_t reads = 0;
+    uint64_t torn = 0;
+    uint64_t backwards = 0;                     // generation menor que a da leitura anterior
+    uint64_t distinct = 0;                      // Gerações diferentes vistas
+};
+
+input_snapshot_t make_snapshot(uint32_t i) {
+    input_snapshot_t s;
+    std::memset(&s, 0, sizeof(s));
+    s.timestamp_us = i;
+    s.vrx = static_cast<uint16_t>(i & 0xFFF);
+    s.vry = static_cast<uint16_t>((i * 7u) & 0xFFF);
+    s.temp_raw = static_cast<uint16_t>((i * 13u) & 0xFFF);
+    s.direction = static_cast<joystick_direction_t>(i % 9);
+    s.last_button = static_cast<button_event_type_t>(i % 3);
+    s.button_event_count = i;
+    s.button_state_bits = static_cast<uint8_t>(i & 0x3);
+    return s;
+}
+
+// A cópia é a publicação número 'generation', com todos os campos coerentes?
+bool consistent(const input_snapshot_t &s) {
+    if (s.generation == 0) {
+        return true; // Nada publicado ainda
+    }
+    input_snapshot_t expected = make_snapshot(static_cast<uint32_t>(s.timestamp_us));
+    return s.generation == s.timestamp_us
+        && (g_naive || s.change_generation == s.generation)
+        && s.vrx == expected.vrx && s.vry == expected.vry && s.temp_raw == expected.temp_raw
+        && s.direction == expected.direction && s.last_button == expected.last_button
+        && s.button_event_count == expected.button_event_count
+        && s.button_state_bits == expected.button_state_bits;
+}
+
+void writer() {
+    for (uint32_t i = 1; !g_stop.load(std::memory_order_relaxed); i++) {
+        input_snapshot_t s = make_snapshot(i);
+        if (g_naive) {
+            s.generation = i;
+            s.change_generation = i;
+            volatile_copy(&g_naive_snapshot, &s, sizeof(s));
+        } else {
+            input_state_publish(&s);
+        }
+        g_published.store(i, std::memory_order_relaxed);
+    }
+}
+
+void reader(reader_stats_t *stats) {
+    uint32_t last_generation = 0;
+    while (!g_stop.load(std::memory_order_relaxed)) {
+        input_snapshot_t s;
+        if (g_naive) {
+            volatile_copy(&s, &g_naive_snapshot, sizeof(s));
+        } else {
+            input_state_read(&s);
+        }
+        stats->reads++;
+        if (!consistent(s)) {
+            if (stats->torn++ == 0) {
+                std::printf("seqlock_stress: leitura rasgada: generation=%u timestamp=%llu vrx=%u vry=%u direção=%d\n",
+                            s.generation, static_cast<unsigned long long>(s.timestamp_us), s.vrx, s.vry,
+                            static_cast<int>(s.direction));
+            }
+            continue;
+        }
+        if (s.generation < last_generation) {
+            stats->backwards++;
+        } else if (s.generation != last_generation) {
+            stats->distinct++;
+        }
+        last_generation = s.generation;
+    }
+}
+
+void usage(const char *argv0) {
+    std::fprintf(stderr, "Uso: %s [-d segundos] [-r leitores] [-n]\n", argv0);
+    std::exit(2);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    unsigned duration_s = 5;
+    unsigned hw = std::thread::hardware_concurrency();
+    unsigned readers = hw > 2 ? hw - 1 : 2;
+    int opt;
+    while ((opt = getopt(argc, argv, "d:r:n")) != -1) {
+        switch (opt) {
+            case 'd': duration_s = static_cast<unsigned>(std::atoi(optarg)); break;
+            case 'r': readers = static_cast<unsigned>(std::atoi(optarg)); break;
+            case 'n': g_naive = true; break;
+            default: usage(argv[0]);
+        }
+    }
+    if (duration_s == 0 || readers == 0) {
+        usage(argv[0]);
+    }
+    std::printf("seqlock_stress: 1 escritor, %u leitores, %u s%s\n", readers, duration_s,
+                g_naive ? " (cópia simples, sem seqlock)" : "");
+
+    std::vector<reader_stats_t> stats(readers);
+    std::vector<std::thread> threads;
+    threads.emplace_back(writer);
+    for (unsigned r = 0; r < readers; r++) {
+        threads.emplace_back(reader, &stats[r]);
+    }
+    std::this_thread::sleep_for(std::chrono::seconds(duration_s));
+    g_stop.store(true);
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    reader_stats_t total;
+    for (const auto &s : stats) {
+        total.reads += s.reads;
+        total.torn += s.torn;
+        total.backwards += s.backwards;
+        total.distinct += s.distinct;
+    }
+    uint64_t published = g_published.load();
+    std::printf("publicações: %llu (%.2f M/s), leituras: %llu (%.2f M/s), gerações distintas vistas por leitor: %.0f\n",
+                static_cast<unsigned long long>(published), published / 1e6 / duration_s,
+                static_cast<unsigned long long>(total.reads), total.reads / 1e6 / duration_s,
+                static_cast<double>(total.distinct) / readers);
+    std::printf("leituras rasgadas: %llu, gerações recuando: %llu\n", static_cast<unsigned long long>(total.torn),
+                static_cast<unsigned long long>(total.backwards));
+    return (total.torn == 0 && total.backwards == 0 && total.reads > 0) ? 0 : 1;
+}
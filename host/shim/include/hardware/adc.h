@@ -0,0 +1,18 @@
+/**
+ * @file adc.h
+ * @brief Shim de "hardware/adc.h": as leituras vêm do gerador de entradas simuladas.
+ */
+
+#ifndef HOST_SHIM_HARDWARE_ADC_H
+#define HOST_SHIM_HARDWARE_ADC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+void adc_init(void);
+void adc_gpio_init(unsigned gpio);
+void adc_select_input(unsigned input);
+uint16_t adc_read(void);
+void adc_set_temp_sensor_enabled(bool enable);
+
+#endif /* HOST_SHIM_HARDWARE_ADC_H */
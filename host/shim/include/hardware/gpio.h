@@ -0,0 +1,32 @@
+/**
+ * @file gpio.h
+ * @brief Shim de "hardware/gpio.h": níveis e IRQs de borda dos botões simulados.
+ */
+
+#ifndef HOST_SHIM_HARDWARE_GPIO_H
+#define HOST_SHIM_HARDWARE_GPIO_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define GPIO_IN false
+#define GPIO_OUT true
+
+enum gpio_irq_level {
+    GPIO_IRQ_LEVEL_LOW = 0x1u,
+    GPIO_IRQ_LEVEL_HIGH = 0x2u,
+    GPIO_IRQ_EDGE_FALL = 0x4u,
+    GPIO_IRQ_EDGE_RISE = 0x8u,
+};
+
+typedef void (*gpio_irq_callback_t)(unsigned gpio, uint32_t event_mask);
+
+void gpio_init(unsigned gpio);
+void gpio_set_dir(unsigned gpio, bool out);
+void gpio_pull_up(unsigned gpio);
+bool gpio_get(unsigned gpio);
+void gpio_set_irq_enabled(unsigned gpio, uint32_t events, bool enabled);
+void gpio_set_irq_enabled_with_callback(unsigned gpio, uint32_t events, bool enabled, gpio_irq_callback_t callback);
+void gpio_acknowledge_irq(unsigned gpio, uint32_t events);
+
+#endif /* HOST_SHIM_HARDWARE_GPIO_H */
@@ -0,0 +1,15 @@
+/**
+ * @file sync.h
+ * @brief Shim de "hardware/sync.h".
+ */
+
+#ifndef HOST_SHIM_HARDWARE_SYNC_H
+#define HOST_SHIM_HARDWARE_SYNC_H
+
+#include <stdint.h>
+
+void __wfe(void); // Dorme um pouco: o laço principal do host só espera
+static inline void __sev(void) {}
+static inline void __dmb(void) { __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+
+#endif /* HOST_SHIM_HARDWARE_SYNC_H */
@@ -0,0 +1,42 @@
+/**
+ * @file async_context.h
+ * @brief Shim de "pico/async_context.h" com os mesmos tipos de worker do SDK.
+ *
+ * Há um único contexto, executado pela thread de rede do build host (cyw43_arch_host.c),
+ * que também processa a LwIP: o mesmo modelo do pico_cyw43_arch_lwip_threadsafe_background.
+ */
+
+#ifndef HOST_SHIM_PICO_ASYNC_CONTEXT_H
+#define HOST_SHIM_PICO_ASYNC_CONTEXT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "pico/time.h"
+
+typedef struct async_context async_context_t;
+
+typedef struct async_when_pending_worker {
+    struct async_when_pending_worker *next;
+    void (*do_work)(async_context_t *context, struct async_when_pending_worker *worker);
+    volatile bool work_pending;
+    void *user_data;
+} async_when_pending_worker_t;
+
+typedef struct async_work_on_timeout {
+    struct async_work_on_timeout *next;
+    void (*do_work)(async_context_t *context, struct async_work_on_timeout *timeout);
+    absolute_time_t next_time;
+    void *user_data;
+} async_at_time_worker_t;
+
+bool async_context_add_when_pending_worker(async_context_t *context, async_when_pending_worker_t *worker);
+bool async_context_remove_when_pending_worker(async_context_t *context, async_when_pending_worker_t *worker);
+void async_context_set_work_pending(async_context_t *context, async_when_pending_worker_t *worker);
+bool async_context_add_at_time_worker_at(async_context_t *context, async_at_time_worker_t *worker, absolute_time_t at);
+bool async_context_add_at_time_worker_in_ms(async_context_t *context, async_at_time_worker_t *worker, uint32_t ms);
+bool async_context_remove_at_time_worker(async_context_t *context, async_at_time_worker_t *worker);
+void async_context_acquire_lock_blocking(async_context_t *context);
+void async_context_release_lock(async_context_t *context);
+
+#endif /* HOST_SHIM_PICO_ASYNC_CONTEXT_H */
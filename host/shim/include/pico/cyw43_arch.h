@@ -0,0 +1,49 @@
+/**
+ * @file cyw43_arch.h
+ * @brief Shim de "pico/cyw43_arch.h": em vez do rádio, uma interface TUN do Linux.
+ *
+ * cyw43_arch_init() inicializa a LwIP, abre a TUN (HOST_TUN_DEV, padrão "tun0") e inicia a
+ * thread de rede. A "conexão Wi-Fi" apenas sobe a netif com o IP estático HOST_IP; SIGUSR1 derruba
+ * o enlace, para exercitar a reconexão (wifi_link.c).
+ */
+
+#ifndef HOST_SHIM_PICO_CYW43_ARCH_H
+#define HOST_SHIM_PICO_CYW43_ARCH_H
+
+#include <stdint.h>
+
+#include "pico/async_context.h"
+
+#define CYW43_AUTH_OPEN 0
+#define CYW43_AUTH_WPA2_AES_PSK 0x00400004
+
+#define CYW43_ITF_STA 0
+
+#define CYW43_LINK_DOWN 0
+#define CYW43_LINK_JOIN 1
+#define CYW43_LINK_NOIP 2
+#define CYW43_LINK_UP 3
+#define CYW43_LINK_FAIL (-1)
+#define CYW43_LINK_NONET (-2)
+#define CYW43_LINK_BADAUTH (-3)
+
+typedef struct {
+    int link_status;
+} cyw43_t;
+
+extern cyw43_t cyw43_state;
+
+int cyw43_arch_init(void);
+void cyw43_arch_deinit(void);
+void cyw43_arch_enable_sta_mode(void);
+void cyw43_arch_poll(void);
+int cyw43_arch_wifi_connect_timeout_ms(const char *ssid, const char *pw, uint32_t auth, uint32_t timeout_ms);
+int cyw43_arch_wifi_connect_async(const char *ssid, const char *pw, uint32_t auth);
+int cyw43_tcpip_link_status(cyw43_t *self, int itf);
+int cyw43_wifi_link_status(cyw43_t *self, int itf);
+int cyw43_wifi_leave(cyw43_t *self, int itf);
+void cyw43_arch_lwip_begin(void);
+void cyw43_arch_lwip_end(void);
+async_context_t *cyw43_arch_async_context(void);
+
+#endif /* HOST_SHIM_PICO_CYW43_ARCH_H */
@@ -0,0 +1,11 @@
+/**
+ * @file multicore.h
+ * @brief Shim de "pico/multicore.h": o núcleo 1 vira uma pthread.
+ */
+
+#ifndef HOST_SHIM_PICO_MULTICORE_H
+#define HOST_SHIM_PICO_MULTICORE_H
+
+void multicore_launch_core1(void (*entry)(void));
+
+#endif /* HOST_SHIM_PICO_MULTICORE_H */
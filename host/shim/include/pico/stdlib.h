@@ -0,0 +1,18 @@
+/**
+ * @file stdlib.h
+ * @brief Shim de "pico/stdlib.h" para o build host (Linux). Ver host/hal_shim.c.
+ */
+
+#ifndef HOST_SHIM_PICO_STDLIB_H
+#define HOST_SHIM_PICO_STDLIB_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "pico/time.h"
+
+void stdio_init_all(void);
+static inline void tight_loop_contents(void) {}
+
+#endif /* HOST_SHIM_PICO_STDLIB_H */
@@ -0,0 +1,46 @@
+/**
+ * @file time.h
+ * @brief Shim de "pico/time.h": relógio monotônico em µs, sleeps e pools de alarmes.
+ */
+
+#ifndef HOST_SHIM_PICO_TIME_H
+#define HOST_SHIM_PICO_TIME_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef uint64_t absolute_time_t; // µs desde o início do processo
+
+uint64_t time_us_64(void);
+static inline uint32_t time_us_32(void) { return (uint32_t)time_us_64(); }
+static inline absolute_time_t get_absolute_time(void) { return time_us_64(); }
+static inline uint32_t to_ms_since_boot(absolute_time_t t) { return (uint32_t)(t / 1000); }
+static inline uint64_t to_us_since_boot(absolute_time_t t) { return t; }
+static inline absolute_time_t delayed_by_us(absolute_time_t t, uint64_t us) { return t + us; }
+static inline absolute_time_t delayed_by_ms(absolute_time_t t, uint32_t ms) { return t + 1000ull * ms; }
+static inline absolute_time_t make_timeout_time_ms(uint32_t ms) { return time_us_64() + 1000ull * ms; }
+static inline int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to) { return (int64_t)(to - from); }
+static inline bool time_reached(absolute_time_t t) { return time_us_64() >= t; }
+
+void sleep_us(uint64_t us);
+void sleep_ms(uint32_t ms);
+void sleep_until(absolute_time_t target);
+// Sem WFE no host: dorme no máximo SHIM_WFE_SLICE_US e retorna true se o prazo chegou, para o
+// chamador conferir suas condições de despertar como faria após uma interrupção.
+bool best_effort_wfe_or_timeout(absolute_time_t timeout_timestamp);
+
+// Alarmes: todos rodam na thread que simula as IRQs do "núcleo 1" (ver hal_shim.c).
+typedef int32_t alarm_id_t;
+typedef int64_t (*alarm_callback_t)(alarm_id_t id, void *user_data);
+typedef struct alarm_pool alarm_pool_t;
+
+alarm_pool_t *alarm_pool_create_with_unused_hardware_alarm(unsigned max_timers);
+alarm_id_t alarm_pool_add_alarm_in_us(alarm_pool_t *pool, uint64_t us, alarm_callback_t callback,
+                                      void *user_data, bool fire_if_past);
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void *user_data, bool fire_if_past);
+static inline alarm_id_t add_alarm_in_ms(uint32_t ms, alarm_callback_t callback, void *user_data, bool fire_if_past) {
+    return add_alarm_in_us(1000ull * ms, callback, user_data, fire_if_past);
+}
+bool cancel_alarm(alarm_id_t id);
+
+#endif /* HOST_SHIM_PICO_TIME_H */
@@ -0,0 +1,239 @@
+/**
+ * @file telemetry_rx.c
+ * @brief Receptor da telemetria UDP do firmware (telemetry_codec.h): decodifica os datagramas e
+ * mede vazão e perdas.
+ *
+ * A cada segundo imprime datagramas, amostras e bytes recebidos; ao final, o total, as perdas
+ * (lacunas na sequência), datagramas fora de ordem/duplicados, inválidos e amostras com timestamp
+ * voltando no tempo. Uma sequência que recua muito é tratada como reinício da placa.
+ *
+ * Com -s, gera o próprio tráfego (amostras sintéticas com o mesmo codificador do firmware) para
+ * testar o receptor contra um listener local; -L descarta uma fração dos datagramas antes de
+ * enviar, para conferir a contagem de perdas.
+ *
+ * Uso: telemetry_rx [-p porta] [-d segundos] [-v]
+ *      telemetry_rx -s host [-p porta] [-d segundos] [-r amostras/s] [-n amostras/datagrama] [-L perda%]
+ */
+
+#define _GNU_SOURCE
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "telemetry_codec.h"
+
+#define TELEMETRY_RX_RESTART_GAP 10000 // Sequência recuando mais que isso: a placa reiniciou
+
+typedef struct {
+    uint64_t datagrams;
+    uint64_t samples;
+    uint64_t bytes;
+    uint64_t lost;
+    uint64_t out_of_order;      // Chegaram depois de um número maior (ou repetidos)
+    uint64_t invalid;
+    uint64_t time_reversals;    // Amostra com timestamp menor que a anterior
+    uint64_t restarts;
+} rx_stats_t;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+            "Uso: %s [-p porta] [-d segundos] [-v]\n"
+            "     %s -s host [-p porta] [-d segundos] [-r amostras/s] [-n amostras/datagrama] [-L perda%%]\n",
+            argv0, argv0);
+    exit(2);
+}
+
+// --- Gerador (-s) ---
+
+static int run_sender(const char *host, int port, unsigned duration_s, unsigned rate, unsigned batch_samples,
+                      unsigned loss_percent) {
+    struct sockaddr_in target = { .sin_family = AF_INET, .sin_port = htons((uint16_t)port) };
+    if (inet_pton(AF_INET, host, &target.sin_addr) != 1) {
+        fprintf(stderr, "telemetry_rx: endereço IPv4 inválido: %s\n", host);
+        return 2;
+    }
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_BROADCAST, &one, sizeof(one));
+
+    static telemetry_batch_t batch;
+    uint32_t sequence = 0;
+    uint64_t sent = 0, dropped = 0;
+    uint64_t period_ns = 1000000000ull / rate;
+    uint64_t start = now_ns();
+    uint64_t end = start + duration_s * 1000000000ull;
+    batch.count = 0;
+
+    for (uint64_t i = 0, next = start; next < end; i++, next += period_ns) {
+        while (now_ns() < next) {
+            usleep(200);
+        }
+        // Joystick varrendo os eixos devagar, com um salto de vez em quando (força lote novo)
+        telemetry_sample_t sample = {
+            .timestamp_us = (next - start) / 1000,
+            .vrx = (uint16_t)(2048 + ((i % 200) < 100 ? (i % 100) * 3 : 300 - (i % 100) * 3)),
+            .vry = (uint16_t)((i % 97 == 0) ? 4095 : 2047),
+            .temp_raw = (uint16_t)(876 + (i / 500) % 3),
+            .buttons = (uint8_t)((i / 150) & 0x3),
+        };
+        bool full = batch.count >= batch_samples;
+        if (batch.count > 0 && (full || !telemetry_batch_append(&batch, &sample))) {
+            if ((unsigned)(rand() % 100) < loss_percent) {
+                dropped++;
+            } else {
+                sendto(fd, batch.data, batch.len, 0, (struct sockaddr *)&target, sizeof(target));
+                sent++;
+            }
+            sequence++;
+            batch.count = 0;
+        }
+        if (batch.count == 0) {
+            telemetry_batch_start(&batch, sequence, &sample);
+        }
+    }
+    printf("telemetry_rx: %llu datagramas enviados para %s:%d, %llu descartados de propósito (-L)\n",
+           (unsigned long long)sent, host, port, (unsigned long long)dropped);
+    close(fd);
+    return 0;
+}
+
+// --- Receptor ---
+
+static void rx_account_sequence(rx_stats_t *stats, bool *have_expected, uint32_t *expected, uint32_t sequence) {
+    int32_t gap = (int32_t)(sequence - *expected);
+    if (!*have_expected || gap < -TELEMETRY_RX_RESTART_GAP) {
+        if (*have_expected) {
+            stats->restarts++;
+        }
+        *have_expected = true;
+    } else if (gap > 0) {
+        stats->lost += (uint64_t)gap;
+    } else if (gap < 0) {
+        stats->out_of_order++;
+        if (stats->lost > 0) {
+            stats->lost--; // Contado como perdido quando o seguinte chegou antes
+        }
+        return;
+    }
+    *expected = sequence + 1;
+}
+
+int main(int argc, char **argv) {
+    int port = 5005;
+    unsigned duration_s = 10;
+    unsigned rate = 50;
+    unsigned batch_samples = 25;
+    unsigned loss_percent = 0;
+    const char *send_host = NULL;
+    bool verbose = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "p:d:s:r:n:L:v")) != -1) {
+        switch (opt) {
+            case 'p': port = atoi(optarg); break;
+            case 'd': duration_s = (unsigned)atoi(optarg); break;
+            case 's': send_host = optarg; break;
+            case 'r': rate = (unsigned)atoi(optarg); break;
+            case 'n': batch_samples = (unsigned)atoi(optarg); break;
+            case 'L': loss_percent = (unsigned)atoi(optarg); break;
+            case 'v': verbose = true; break;
+            default: usage(argv[0]);
+        }
+    }
+    if (duration_s == 0 || rate == 0 || batch_samples == 0 || batch_samples > TELEMETRY_MAX_SAMPLES) {
+        usage(argv[0]);
+    }
+    if (send_host != NULL) {
+        return run_sender(send_host, port, duration_s, rate, batch_samples, loss_percent);
+    }
+
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    struct sockaddr_in local = { .sin_family = AF_INET, .sin_port = htons((uint16_t)port), .sin_addr.s_addr = htonl(INADDR_ANY) };
+    if (bind(fd, (struct sockaddr *)&local, sizeof(local)) != 0) {
+        perror("telemetry_rx: bind");
+        return 1;
+    }
+    printf("telemetry_rx: escutando UDP %d por %u s\n", port, duration_s);
+
+    rx_stats_t stats = {0}, last_report = {0};
+    bool have_expected = false;
+    uint32_t expected = 0;
+    uint64_t last_timestamp_us = 0;
+    uint8_t data[2048];
+    telemetry_sample_t samples[TELEMETRY_MAX_SAMPLES];
+
+    uint64_t start = now_ns();
+    uint64_t end = start + duration_s * 1000000000ull;
+    uint64_t next_report = start + 1000000000ull;
+    uint64_t first_rx = 0, last_rx = 0;
+    while (now_ns() < end) {
+        struct pollfd pfd = { .fd = fd, .events = POLLIN };
+        if (poll(&pfd, 1, 100) > 0) {
+            ssize_t len = recv(fd, data, sizeof(data), 0);
+            uint32_t sequence;
+            int count = len > 0 ? telemetry_decode(data, (size_t)len, &sequence, samples, TELEMETRY_MAX_SAMPLES) : -1;
+            if (count < 0) {
+                stats.invalid++;
+            } else {
+                last_rx = now_ns();
+                if (first_rx == 0) first_rx = last_rx;
+                uint64_t restarts = stats.restarts;
+                rx_account_sequence(&stats, &have_expected, &expected, sequence);
+                if (stats.restarts != restarts) {
+                    last_timestamp_us = 0;
+                }
+                stats.datagrams++;
+                stats.samples += (uint64_t)count;
+                stats.bytes += (uint64_t)len;
+                for (int i = 0; i < count; i++) {
+                    if (samples[i].timestamp_us < last_timestamp_us) {
+                        stats.time_reversals++;
+                    }
+                    last_timestamp_us = samples[i].timestamp_us;
+                    if (verbose) {
+                        printf("seq=%u t=%llu vrx=%u vry=%u temp=%u botoes=%u\n", sequence,
+                               (unsigned long long)samples[i].timestamp_us, samples[i].vrx, samples[i].vry,
+                               samples[i].temp_raw, samples[i].buttons);
+                    }
+                }
+            }
+        }
+        if (now_ns() >= next_report) {
+            printf("+1s: %llu datagramas, %llu amostras, %llu bytes, perdidos=%llu\n",
+                   (unsigned long long)(stats.datagrams - last_report.datagrams),
+                   (unsigned long long)(stats.samples - last_report.samples),
+                   (unsigned long long)(stats.bytes - last_report.bytes), (unsigned long long)stats.lost);
+            last_report = stats;
+            next_report += 1000000000ull;
+        }
+    }
+
+    double window_s = (last_rx > first_rx) ? (double)(last_rx - first_rx) / 1e9 : 0;
+    uint64_t expected_total = stats.datagrams + stats.lost;
+    printf("datagramas: %llu (%.1f/s), amostras: %llu (%.1f/s), %.1f KiB (%.0f B/datagrama)\n",
+           (unsigned long long)stats.datagrams, window_s > 0 ? (double)stats.datagrams / window_s : 0,
+           (unsigned long long)stats.samples, window_s > 0 ? (double)stats.samples / window_s : 0,
+           (double)stats.bytes / 1024.0, stats.datagrams ? (double)stats.bytes / (double)stats.datagrams : 0);
+    printf("perdidos: %llu (%.2f%%), fora de ordem: %llu, inválidos: %llu, timestamps recuando: %llu, reinícios: %llu\n",
+           (unsigned long long)stats.lost, expected_total ? 100.0 * (double)stats.lost / (double)expected_total : 0,
+           (unsigned long long)stats.out_of_order, (unsigned long long)stats.invalid,
+           (unsigned long long)stats.time_reversals, (unsigned long long)stats.restarts);
+    close(fd);
+    return stats.datagrams > 0 ? 0 : 1;
+}
@@ -0,0 +1,76 @@
+#define _GNU_SOURCE
+
+#include "tunif.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/if.h>
+#include <linux/if_tun.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include "lwip/ip4.h"
+#include "lwip/pbuf.h"
+
+#define TUNIF_MTU 1500
+
+int tunif_open(const char *dev) {
+    int fd = open("/dev/net/tun", O_RDWR | O_NONBLOCK);
+    if (fd < 0) {
+        perror("tunif: /dev/net/tun");
+        return -1;
+    }
+    struct ifreq ifr;
+    memset(&ifr, 0, sizeof(ifr));
+    ifr.ifr_flags = IFF_TUN | IFF_NO_PI;
+    strncpy(ifr.ifr_name, dev, IFNAMSIZ - 1);
+    if (ioctl(fd, TUNSETIFF, &ifr) < 0) {
+        perror("tunif: TUNSETIFF");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static err_t tunif_output(struct netif *netif, struct pbuf *p, const ip4_addr_t *ipaddr) {
+    int fd = *(int *)netif->state;
+    u8_t frame[TUNIF_MTU];
+    u16_t len = pbuf_copy_partial(p, frame, sizeof(frame), 0);
+    if (write(fd, frame, len) != (ssize_t)len) {
+        return ERR_IF; // Fila da TUN cheia: a LwIP retransmite como numa perda de rádio
+    }
+    return ERR_OK;
+}
+
+err_t tunif_init(struct netif *netif) {
+    netif->name[0] = 't';
+    netif->name[1] = 'u';
+    netif->output = tunif_output;
+    netif->mtu = TUNIF_MTU;
+    netif->flags = NETIF_FLAG_LINK_UP;
+    return ERR_OK;
+}
+
+unsigned tunif_input_pending(struct netif *netif) {
+    int fd = *(int *)netif->state;
+    unsigned dropped = 0;
+    u8_t frame[TUNIF_MTU];
+    for (;;) {
+        ssize_t len = read(fd, frame, sizeof(frame));
+        if (len <= 0) {
+            break; // EAGAIN: nada mais pendente
+        }
+        struct pbuf *p = pbuf_alloc(PBUF_RAW, (u16_t)len, PBUF_POOL);
+        if (!p) {
+            dropped++; // Pool de pbufs esgotado: o pacote é perdido
+            continue;
+        }
+        pbuf_take(p, frame, (u16_t)len);
+        if (netif->input(p, netif) != ERR_OK) {
+            pbuf_free(p);
+        }
+    }
+    return dropped;
+}
@@ -0,0 +1,22 @@
+/**
+ * @file tunif.h
+ * @brief netif da LwIP sobre uma interface TUN do Linux (pacotes IPv4 puros).
+ */
+
+#ifndef HOST_TUNIF_H
+#define HOST_TUNIF_H
+
+#include "lwip/netif.h"
+
+// Abre /dev/net/tun e associa à interface 'dev' (que já deve existir, criada com
+// "ip tuntap add dev <dev> mode tun"). Retorna o descritor (não bloqueante) ou -1.
+int tunif_open(const char *dev);
+
+// Função de init para netif_add(); netif->state deve apontar para o descritor (int).
+err_t tunif_init(struct netif *netif);
+
+// Lê e entrega à LwIP todos os pacotes pendentes. Chamar com o lock da LwIP tomado.
+// Retorna quantos pacotes foram descartados por falta de pbuf.
+unsigned tunif_input_pending(struct netif *netif);
+
+#endif /* HOST_TUNIF_H */
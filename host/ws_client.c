@@ -0,0 +1,587 @@
+/**
+ * @file ws_client.c
+ * @brief Cliente de teste do /ws (WebSocket, RFC 6455): confere o protocolo do servidor e mede a
+ * latência das amostras (build host via TUN ou a própria placa).
+ *
+ * Handshake: confere o status 101, os cabeçalhos Upgrade/Connection e o Sec-WebSocket-Accept,
+ * calculado aqui com um SHA-1 próprio (não o de websocket.c, para não validar o servidor contra
+ * ele mesmo).
+ *
+ * Quadros recebidos: FIN ligado (o servidor não fragmenta), RSV zerados, sem máscara, opcode
+ * conhecido, tamanho na codificação mínima, controle com payload <= 125 e amostra binária de 12
+ * bytes com campos no intervalo (VRx/VRy <= 4095, direção <= 8, botões <= 3). Cada violação é
+ * contada e a primeira de cada tipo é impressa.
+ *
+ * Quadros enviados (sempre mascarados, máscara aleatória por quadro): logo após o handshake, uma
+ * mensagem binária fragmentada em três partes com um PING entre elas (controle no meio de uma
+ * mensagem fragmentada, seção 5.4) e um quadro de texto; o servidor deve responder o PING e manter
+ * a conexão. Depois, um PING a cada -P ms com o instante local no payload: o PONG precisa ecoá-lo e
+ * dá o tempo de ida e volta. No fim, CLOSE 1000: o servidor deve ecoar o código e fechar o TCP.
+ *
+ * Latência das amostras: chegada (relógio local) menos o timestamp da placa, descontado o menor
+ * valor visto (a diferença entre os relógios): é o atraso além do melhor caso, como no
+ * mqtt_broker. Lacunas na sequência são amostras descartadas pelo backpressure do servidor.
+ *
+ * Com -L, antes do teste normal, abre uma conexão por cabeçalho de tamanho inválido e confere que o
+ * servidor responde CLOSE com o código certo e fecha o TCP: tamanho de 64 bits com o bit mais
+ * significativo ligado (2^64 - 14, que somado ao cabeçalho dá a volta para 0: 1002), 2^32 e 65535
+ * (maiores que o buffer de recepção: 1009).
+ *
+ * Uso: ws_client [-d segundos] [-P ping_ms] [-L] [-v] [host [porta]]
+ */
+
+#define _GNU_SOURCE
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#define WS_CLIENT_RX_BUF 65536
+#define WS_CLIENT_SAMPLE_LEN 12
+#define WS_CLIENT_LATENCY_BUCKETS 2000      // Histograma de 0,1 ms (até 200 ms); acima conta no último
+#define WS_CLIENT_CLOSE_TIMEOUT_NS 2000000000ull
+
+static const char *const g_ws_guid = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+typedef enum {
+    CHECK_FIN,
+    CHECK_RSV,
+    CHECK_MASKED,
+    CHECK_OPCODE,
+    CHECK_LENGTH_ENCODING,
+    CHECK_CONTROL_LEN,
+    CHECK_SAMPLE_LEN,
+    CHECK_SAMPLE_RANGE,
+    CHECK_PONG_PAYLOAD,
+    CHECK_CLOSE,
+    CHECK_COUNT
+} check_t;
+
+static const char *const g_check_names[CHECK_COUNT] = {
+    "quadro fragmentado (FIN = 0)",
+    "bits RSV ligados",
+    "quadro do servidor mascarado",
+    "opcode desconhecido",
+    "tamanho fora da codificação mínima",
+    "controle com payload > 125",
+    "amostra com tamanho diferente de 12",
+    "amostra com campo fora do intervalo",
+    "PONG sem o payload do PING",
+    "CLOSE sem eco do código 1000",
+};
+
+typedef struct {
+    uint64_t frames;
+    uint64_t samples;
+    uint64_t bytes;
+    uint64_t lost;                      // Lacunas na sequência (backpressure)
+    uint64_t pings;
+    uint64_t pongs;
+    uint64_t time_reversals;
+    uint64_t violations[CHECK_COUNT];
+} ws_stats_t;
+
+static ws_stats_t g_stats;
+static uint32_t g_latency_hist[WS_CLIENT_LATENCY_BUCKETS];
+static uint64_t g_latency_count = 0;
+static uint32_t g_latency_max_us = 0;
+static uint32_t g_rtt_hist[WS_CLIENT_LATENCY_BUCKETS];
+static uint64_t g_rtt_count = 0;
+static uint32_t g_rtt_max_us = 0;
+static bool g_verbose = false;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "Uso: %s [-d segundos] [-P ping_ms] [-L] [-v] [host [porta]]\n", argv0);
+    exit(2);
+}
+
+static void violation(check_t check, const char *detail) {
+    if (g_stats.violations[check]++ == 0) {
+        printf("ws_client: VIOLAÇÃO: %s%s%s\n", g_check_names[check], detail ? " - " : "", detail ? detail : "");
+    }
+}
+
+// --- SHA-1 (FIPS 180-4) e base64, só para conferir o Sec-WebSocket-Accept ---
+
+static uint32_t rol32(uint32_t x, int n) {
+    return (x << n) | (x >> (32 - n));
+}
+
+static void sha1(const uint8_t *data, size_t len, uint8_t out[20]) {
+    uint32_t h[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+    uint8_t block[64];
+    uint64_t bits = (uint64_t)len * 8;
+    size_t total = ((len + 8) / 64 + 1) * 64;
+    for (size_t offset = 0; offset < total; offset += 64) {
+        for (size_t i = 0; i < 64; i++) {
+            size_t pos = offset + i;
+            block[i] = pos < len ? data[pos] : pos == len ? 0x80 : 0;
+        }
+        if (offset + 64 == total) {
+            for (int i = 0; i < 8; i++) block[56 + i] = (uint8_t)(bits >> (56 - 8 * i));
+        }
+        uint32_t w[80];
+        for (int i = 0; i < 16; i++) {
+            w[i] = (uint32_t)block[4 * i] << 24 | (uint32_t)block[4 * i + 1] << 16 | (uint32_t)block[4 * i + 2] << 8 | block[4 * i + 3];
+        }
+        for (int i = 16; i < 80; i++) w[i] = rol32(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+        for (int i = 0; i < 80; i++) {
+            uint32_t f, k;
+            if (i < 20) { f = (b & c) | (~b & d); k = 0x5A827999; }
+            else if (i < 40) { f = b ^ c ^ d; k = 0x6ED9EBA1; }
+            else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+            else { f = b ^ c ^ d; k = 0xCA62C1D6; }
+            uint32_t t = rol32(a, 5) + f + e + k + w[i];
+            e = d; d = c; c = rol32(b, 30); b = a; a = t;
+        }
+        h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+    }
+    for (int i = 0; i < 20; i++) out[i] = (uint8_t)(h[i / 4] >> (24 - 8 * (i % 4)));
+}
+
+static void base64(const uint8_t *data, size_t len, char *out) {
+    static const char table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t o = 0;
+    for (size_t i = 0; i < len; i += 3) {
+        uint32_t v = (uint32_t)data[i] << 16 | (i + 1 < len ? (uint32_t)data[i + 1] << 8 : 0) | (i + 2 < len ? data[i + 2] : 0);
+        out[o++] = table[(v >> 18) & 63];
+        out[o++] = table[(v >> 12) & 63];
+        out[o++] = i + 1 < len ? table[(v >> 6) & 63] : '=';
+        out[o++] = i + 2 < len ? table[v & 63] : '=';
+    }
+    out[o] = '\0';
+}
+
+// --- Envio ---
+
+static bool send_all(int fd, const uint8_t *data, size_t len) {
+    while (len > 0) {
+        ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        data += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+// Quadro cliente->servidor, sempre mascarado (payload <= 125 basta para este teste).
+static bool send_frame(int fd, bool fin, uint8_t opcode, const uint8_t *payload, size_t len) {
+    uint8_t frame[2 + 4 + 125];
+    if (len > 125) return false;
+    uint32_t mask = (uint32_t)rand();
+    frame[0] = (uint8_t)((fin ? 0x80 : 0x00) | opcode);
+    frame[1] = (uint8_t)(0x80 | len);
+    memcpy(frame + 2, &mask, 4);
+    for (size_t i = 0; i < len; i++) frame[6 + i] = payload[i] ^ frame[2 + (i & 3)];
+    return send_all(fd, frame, 6 + len);
+}
+
+static bool send_ping(int fd) {
+    uint64_t sent_ns = now_ns();
+    g_stats.pings++;
+    return send_frame(fd, true, 0x9, (const uint8_t *)&sent_ns, sizeof(sent_ns));
+}
+
+// --- Handshake ---
+
+static int ws_connect(const char *host, int port) {
+    struct sockaddr_in target = { .sin_family = AF_INET, .sin_port = htons((uint16_t)port) };
+    if (inet_pton(AF_INET, host, &target.sin_addr) != 1) {
+        fprintf(stderr, "ws_client: endereço IPv4 inválido: %s\n", host);
+        return -1;
+    }
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (connect(fd, (struct sockaddr *)&target, sizeof(target)) != 0) {
+        perror("ws_client: connect");
+        close(fd);
+        return -1;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    uint8_t nonce[16];
+    for (int i = 0; i < 16; i++) nonce[i] = (uint8_t)rand();
+    char key[25];
+    base64(nonce, sizeof(nonce), key);
+    char request[256];
+    int len = snprintf(request, sizeof(request),
+                       "GET /ws HTTP/1.1\r\nHost: %s\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                       "Sec-WebSocket-Key: %s\r\nSec-WebSocket-Version: 13\r\n\r\n",
+                       host, key);
+    send_all(fd, (const uint8_t *)request, (size_t)len);
+
+    // Lê só até o fim do cabeçalho, byte a byte: o que vier depois já é quadro
+    char response[1024];
+    size_t got = 0;
+    while (got + 1 < sizeof(response) && (got < 4 || memcmp(response + got - 4, "\r\n\r\n", 4) != 0)) {
+        ssize_t n = recv(fd, response + got, 1, 0);
+        if (n <= 0) {
+            fprintf(stderr, "ws_client: conexão fechada durante o handshake\n");
+            close(fd);
+            return -1;
+        }
+        got++;
+    }
+    response[got] = '\0';
+
+    char accept_src[64];
+    uint8_t digest[20];
+    char expected[29];
+    snprintf(accept_src, sizeof(accept_src), "%s%s", key, g_ws_guid);
+    sha1((const uint8_t *)accept_src, strlen(accept_src), digest);
+    base64(digest, sizeof(digest), expected);
+
+    bool ok_status = strncmp(response, "HTTP/1.1 101", 12) == 0;
+    bool ok_upgrade = strcasestr(response, "\r\nUpgrade: websocket\r\n") != NULL;
+    bool ok_connection = strcasestr(response, "\r\nConnection: Upgrade\r\n") != NULL;
+    const char *accept = strcasestr(response, "\r\nSec-WebSocket-Accept: ");
+    bool ok_accept = accept != NULL && strncmp(accept + 24, expected, 28) == 0 && accept[24 + 28] == '\r';
+    if (!ok_status || !ok_upgrade || !ok_connection || !ok_accept) {
+        fprintf(stderr, "ws_client: handshake inválido (status %s, Upgrade %s, Connection %s, Accept %s)\n%s",
+                ok_status ? "ok" : "ERRADO", ok_upgrade ? "ok" : "ERRADO", ok_connection ? "ok" : "ERRADO",
+                ok_accept ? "ok" : "ERRADO", response);
+        close(fd);
+        return -1;
+    }
+    printf("ws_client: handshake ok (Sec-WebSocket-Accept %s)\n", expected);
+    return fd;
+}
+
+// --- Recepção ---
+
+static void record(uint32_t *hist, uint64_t *count, uint32_t *max, uint64_t value_us) {
+    uint64_t bucket = value_us / 100;
+    hist[bucket < WS_CLIENT_LATENCY_BUCKETS ? bucket : WS_CLIENT_LATENCY_BUCKETS - 1]++;
+    (*count)++;
+    if (value_us > *max) *max = (uint32_t)value_us;
+}
+
+static double percentile_ms(const uint32_t *hist, uint64_t count, double fraction) {
+    uint64_t target = (uint64_t)(fraction * (double)count), seen = 0;
+    for (int i = 0; i < WS_CLIENT_LATENCY_BUCKETS; i++) {
+        seen += hist[i];
+        if (seen > target) return (double)i / 10.0;
+    }
+    return (double)WS_CLIENT_LATENCY_BUCKETS / 10.0;
+}
+
+typedef struct {
+    bool have_seq;
+    uint16_t expected_seq;
+    bool have_timestamp;
+    uint32_t last_timestamp_us;
+    bool have_offset;
+    int64_t min_offset_us;              // Menor (chegada - timestamp da placa)
+    bool close_received;
+} ws_session_t;
+
+static void handle_sample(ws_session_t *s, const uint8_t *p, uint64_t arrival_ns) {
+    uint32_t timestamp_us = (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+    uint16_t vrx = (uint16_t)(p[4] | p[5] << 8), vry = (uint16_t)(p[6] | p[7] << 8);
+    uint8_t direction = p[8], buttons = p[9];
+    uint16_t seq = (uint16_t)(p[10] | p[11] << 8);
+    if (vrx > 4095 || vry > 4095 || direction > 8 || buttons > 3) {
+        char detail[64];
+        snprintf(detail, sizeof(detail), "VRx=%u VRy=%u direção=%u botões=%u", vrx, vry, direction, buttons);
+        violation(CHECK_SAMPLE_RANGE, detail);
+    }
+    if (s->have_seq && seq != s->expected_seq) {
+        g_stats.lost += (uint16_t)(seq - s->expected_seq);
+    }
+    s->have_seq = true;
+    s->expected_seq = (uint16_t)(seq + 1);
+    if (s->have_timestamp && (int32_t)(timestamp_us - s->last_timestamp_us) < 0) {
+        g_stats.time_reversals++;
+    }
+    s->have_timestamp = true;
+    s->last_timestamp_us = timestamp_us;
+
+    // O timestamp da placa tem 32 bits (volta a cada ~71 min): a diferença é feita em 32 bits
+    int64_t offset = (int64_t)(int32_t)((uint32_t)(arrival_ns / 1000) - timestamp_us);
+    if (!s->have_offset || offset < s->min_offset_us) {
+        s->min_offset_us = offset;
+        s->have_offset = true;
+    }
+    record(g_latency_hist, &g_latency_count, &g_latency_max_us, (uint64_t)(offset - s->min_offset_us));
+    g_stats.samples++;
+    if (g_verbose) {
+        printf("seq=%u t=%u vrx=%u vry=%u dir=%u botoes=%u\n", seq, timestamp_us, vrx, vry, direction, buttons);
+    }
+}
+
+// Confere e consome os quadros completos de 'buf'. Retorna os bytes consumidos.
+static size_t handle_frames(ws_session_t *s, const uint8_t *buf, size_t len, uint64_t arrival_ns) {
+    size_t pos = 0;
+    while (len - pos >= 2) {
+        const uint8_t *f = buf + pos;
+        bool fin = (f[0] & 0x80) != 0, masked = (f[1] & 0x80) != 0;
+        uint8_t opcode = f[0] & 0x0F;
+        uint64_t payload_len = f[1] & 0x7F;
+        size_t header_len = 2;
+        if (payload_len == 126) {
+            if (len - pos < 4) break;
+            payload_len = (uint64_t)f[2] << 8 | f[3];
+            header_len = 4;
+            if (payload_len < 126) violation(CHECK_LENGTH_ENCODING, NULL);
+        } else if (payload_len == 127) {
+            if (len - pos < 10) break;
+            payload_len = 0;
+            for (int i = 0; i < 8; i++) payload_len = payload_len << 8 | f[2 + i];
+            header_len = 10;
+            if (payload_len <= 0xFFFF) violation(CHECK_LENGTH_ENCODING, NULL);
+        }
+        if (masked) header_len += 4;
+        if (payload_len > WS_CLIENT_RX_BUF || len - pos < header_len + payload_len) break;
+        const uint8_t *payload = f + header_len;
+
+        g_stats.frames++;
+        if (!fin) violation(CHECK_FIN, NULL);
+        if (f[0] & 0x70) violation(CHECK_RSV, NULL);
+        if (masked) violation(CHECK_MASKED, NULL);
+        if ((opcode & 0x8) && payload_len > 125) violation(CHECK_CONTROL_LEN, NULL);
+        switch (opcode) {
+            case 0x2:
+                if (payload_len != WS_CLIENT_SAMPLE_LEN) {
+                    violation(CHECK_SAMPLE_LEN, NULL);
+                } else {
+                    handle_sample(s, payload, arrival_ns);
+                }
+                break;
+            case 0xA: {
+                uint64_t sent_ns;
+                if (payload_len != sizeof(sent_ns)) {
+                    violation(CHECK_PONG_PAYLOAD, NULL);
+                    break;
+                }
+                memcpy(&sent_ns, payload, sizeof(sent_ns));
+                if (sent_ns > arrival_ns || arrival_ns - sent_ns > 60000000000ull) {
+                    violation(CHECK_PONG_PAYLOAD, NULL);
+                    break;
+                }
+                g_stats.pongs++;
+                record(g_rtt_hist, &g_rtt_count, &g_rtt_max_us, (arrival_ns - sent_ns) / 1000);
+                break;
+            }
+            case 0x8:
+                if (payload_len != 2 || payload[0] != 0x03 || payload[1] != 0xE8) {
+                    violation(CHECK_CLOSE, NULL);
+                }
+                s->close_received = true;
+                break;
+            case 0x9:
+            case 0x1:
+                break; // O servidor não manda, mas seriam válidos
+            default:
+                violation(CHECK_OPCODE, NULL);
+                break;
+        }
+        pos += header_len + (size_t)payload_len;
+    }
+    return pos;
+}
+
+// --- Tamanhos inválidos (-L) ---
+
+typedef struct {
+    const char *name;
+    uint8_t header[14];                 // Cabeçalho mascarado, sem payload
+    size_t header_len;
+    uint16_t expected_code;
+} length_case_t;
+
+static const length_case_t g_length_cases[] = {
+    { "127 + 2^64-14 (bit 63 ligado)", { 0x82, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF2, 1, 2, 3, 4 }, 14, 1002 },
+    { "127 + 2^32", { 0x82, 0xFF, 0, 0, 0, 1, 0, 0, 0, 0, 1, 2, 3, 4 }, 14, 1009 },
+    { "126 + 65535", { 0x82, 0xFE, 0xFF, 0xFF, 1, 2, 3, 4 }, 8, 1009 },
+};
+
+// Manda o cabeçalho e espera, ignorando as amostras, o CLOSE com o código esperado e o fim do TCP.
+static bool run_length_case(const char *host, int port, const length_case_t *c) {
+    int fd = ws_connect(host, port);
+    if (fd < 0) {
+        return false;
+    }
+    send_all(fd, c->header, c->header_len);
+    uint8_t rx[4096];
+    size_t rx_len = 0;
+    int close_code = -1;
+    bool tcp_closed = false;
+    uint64_t deadline = now_ns() + WS_CLIENT_CLOSE_TIMEOUT_NS;
+    while (!tcp_closed && now_ns() < deadline) {
+        struct pollfd pfd = { .fd = fd, .events = POLLIN };
+        if (poll(&pfd, 1, 10) <= 0) continue;
+        ssize_t n = recv(fd, rx + rx_len, sizeof(rx) - rx_len, 0);
+        if (n <= 0) {
+            tcp_closed = true;
+            break;
+        }
+        rx_len += (size_t)n;
+        // Quadros do servidor: sem máscara e curtos (amostras e controle)
+        size_t pos = 0;
+        while (rx_len - pos >= 2 && (rx[pos + 1] & 0x7F) <= 125 && rx_len - pos >= 2u + (rx[pos + 1] & 0x7F)) {
+            size_t len = rx[pos + 1] & 0x7F;
+            if ((rx[pos] & 0x0F) == 0x8 && close_code < 0) {
+                close_code = len >= 2 ? (rx[pos + 2] << 8 | rx[pos + 3]) : 0;
+            }
+            pos += 2 + len;
+        }
+        memmove(rx, rx + pos, rx_len - pos);
+        rx_len -= pos;
+    }
+    close(fd);
+    bool ok = close_code == c->expected_code && tcp_closed;
+    printf("ws_client: tamanho inválido %s: CLOSE %d (esperado %u), TCP %s - %s\n", c->name, close_code,
+           c->expected_code, tcp_closed ? "fechado" : "aberto", ok ? "ok" : "FALHOU");
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    unsigned duration_s = 10;
+    unsigned ping_ms = 200;
+    bool length_checks = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "d:P:Lv")) != -1) {
+        switch (opt) {
+            case 'd': duration_s = (unsigned)atoi(optarg); break;
+            case 'P': ping_ms = (unsigned)atoi(optarg); break;
+            case 'L': length_checks = true; break;
+            case 'v': g_verbose = true; break;
+            default: usage(argv[0]);
+        }
+    }
+    const char *host = optind < argc ? argv[optind] : "192.168.7.2";
+    int port = optind + 1 < argc ? atoi(argv[optind + 1]) : 80;
+    if (duration_s == 0 || ping_ms == 0) {
+        usage(argv[0]);
+    }
+    srand((unsigned)now_ns());
+
+    unsigned length_failures = 0;
+    if (length_checks) {
+        for (size_t i = 0; i < sizeof(g_length_cases) / sizeof(g_length_cases[0]); i++) {
+            length_failures += run_length_case(host, port, &g_length_cases[i]) ? 0 : 1;
+        }
+    }
+
+    int fd = ws_connect(host, port);
+    if (fd < 0) {
+        return 1;
+    }
+
+    // Mensagem fragmentada com um PING no meio, e um quadro de texto: o servidor as ignora, mas
+    // precisa responder o PING e continuar com a conexão aberta
+    static const uint8_t part[] = { 1, 2, 3, 4 };
+    send_frame(fd, false, 0x2, part, sizeof(part));
+    send_ping(fd);
+    send_frame(fd, false, 0x0, part, sizeof(part));
+    send_frame(fd, true, 0x0, part, sizeof(part));
+    send_frame(fd, true, 0x1, (const uint8_t *)"ola", 3);
+
+    static uint8_t rx[WS_CLIENT_RX_BUF];
+    size_t rx_len = 0;
+    ws_session_t session = {0};
+    ws_stats_t last_report = {0};
+    uint64_t start = now_ns();
+    uint64_t end = start + duration_s * 1000000000ull;
+    uint64_t next_report = start + 1000000000ull;
+    uint64_t next_ping = start + ping_ms * 1000000ull;
+    uint64_t close_deadline = 0;
+    bool close_sent = false, tcp_closed = false;
+
+    while (!tcp_closed) {
+        uint64_t now = now_ns();
+        if (!close_sent && now >= end) {
+            static const uint8_t code[] = { 0x03, 0xE8 }; // 1000
+            send_frame(fd, true, 0x8, code, sizeof(code));
+            close_sent = true;
+            close_deadline = now + WS_CLIENT_CLOSE_TIMEOUT_NS;
+        }
+        if (close_sent && now >= close_deadline) {
+            break;
+        }
+        if (!close_sent && now >= next_ping) {
+            send_ping(fd);
+            next_ping += ping_ms * 1000000ull;
+        }
+        struct pollfd pfd = { .fd = fd, .events = POLLIN };
+        if (poll(&pfd, 1, 10) > 0) {
+            ssize_t n = recv(fd, rx + rx_len, sizeof(rx) - rx_len, 0);
+            if (n <= 0) {
+                tcp_closed = true;
+            } else {
+                g_stats.bytes += (uint64_t)n;
+                rx_len += (size_t)n;
+                size_t used = handle_frames(&session, rx, rx_len, now_ns());
+                memmove(rx, rx + used, rx_len - used);
+                rx_len -= used;
+            }
+        }
+        if (now_ns() >= next_report && !close_sent) {
+            printf("+1s: %llu amostras, %llu bytes, perdidas=%llu, pongs=%llu\n",
+                   (unsigned long long)(g_stats.samples - last_report.samples),
+                   (unsigned long long)(g_stats.bytes - last_report.bytes), (unsigned long long)g_stats.lost,
+                   (unsigned long long)(g_stats.pongs - last_report.pongs));
+            last_report = g_stats;
+            next_report += 1000000000ull;
+        }
+    }
+    close(fd);
+
+    if (!close_sent) {
+        printf("ws_client: o servidor fechou a conexão antes do fim do teste\n");
+    } else if (!session.close_received) {
+        violation(CHECK_CLOSE, tcp_closed ? "TCP fechado sem CLOSE" : "sem resposta ao CLOSE");
+    } else if (!tcp_closed) {
+        violation(CHECK_CLOSE, "TCP não foi fechado depois do CLOSE");
+    }
+
+    uint64_t total_violations = 0;
+    for (int i = 0; i < CHECK_COUNT; i++) total_violations += g_stats.violations[i];
+    printf("quadros: %llu, amostras: %llu (%.1f/s), perdidas (backpressure): %llu, timestamps recuando: %llu\n",
+           (unsigned long long)g_stats.frames, (unsigned long long)g_stats.samples,
+           (double)g_stats.samples / (double)duration_s, (unsigned long long)g_stats.lost,
+           (unsigned long long)g_stats.time_reversals);
+    printf("pings: %llu, pongs: %llu", (unsigned long long)g_stats.pings, (unsigned long long)g_stats.pongs);
+    if (g_rtt_count > 0) {
+        printf(", ida e volta (ms): p50=%.1f p99=%.1f max=%.1f", percentile_ms(g_rtt_hist, g_rtt_count, 0.50),
+               percentile_ms(g_rtt_hist, g_rtt_count, 0.99), g_rtt_max_us / 1000.0);
+    }
+    printf("\n");
+    if (g_latency_count > 0) {
+        printf("latência das amostras além do melhor caso (ms): p50=%.1f p90=%.1f p99=%.1f max=%.1f\n",
+               percentile_ms(g_latency_hist, g_latency_count, 0.50), percentile_ms(g_latency_hist, g_latency_count, 0.90),
+               percentile_ms(g_latency_hist, g_latency_count, 0.99), g_latency_max_us / 1000.0);
+    }
+    printf("violações do protocolo: %llu\n", (unsigned long long)total_violations);
+    for (int i = 0; i < CHECK_COUNT; i++) {
+        if (g_stats.violations[i] > 0) {
+            printf("  %s: %llu\n", g_check_names[i], (unsigned long long)g_stats.violations[i]);
+        }
+    }
+    bool pings_answered = g_stats.pongs > 0;
+    if (length_checks) {
+        printf("tamanhos inválidos recusados: %u de %zu\n",
+               (unsigned)(sizeof(g_length_cases) / sizeof(g_length_cases[0])) - length_failures,
+               sizeof(g_length_cases) / sizeof(g_length_cases[0]));
+    }
+    return (total_violations == 0 && length_failures == 0 && pings_answered && g_stats.samples > 0) ? 0 : 1;
+}
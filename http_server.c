@@ -0,0 +1,1174 @@
+#include "http_server.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "pico/time.h"
+#include "lwip/memp.h"
+#include "lwip/stats.h"
+
+#include "fmt.h"
+#include "latency_trace.h"
+
+#if MEMP_NUM_TCP_PCB <= HTTP_CONN_BUDGET
+#error "MEMP_NUM_TCP_PCB deve passar de HTTP_CONN_BUDGET: os PCBs extras respondem o 503 de sobrecarga"
+#endif
+#if !LWIP_STATS || !MEM_STATS || !MEMP_STATS
+#error "http_tx_mem_available() requer LWIP_STATS, MEM_STATS e MEMP_STATS em lwipopts.h"
+#endif
+
+// --- Estado de cada conexão ---
+
+typedef enum {
+    HTTP_STATE_METHOD,
+    HTTP_STATE_PATH,
+    HTTP_STATE_QUERY,
+    HTTP_STATE_VERSION,
+    HTTP_STATE_HEADER_NAME,
+    HTTP_STATE_HEADER_VALUE,
+    HTTP_STATE_BODY,
+    HTTP_STATE_COMPLETE      // Requisição completa aguardando o envio da resposta
+} http_parse_state_t;
+
+struct http_conn {
+    bool in_use;
+    struct tcp_pcb *pcb;            // NULL depois de http_conn_detach()
+    http_parse_state_t state;
+    http_request_t request;
+    char header_name[HTTP_MAX_HEADER_NAME_LEN + 1];
+    char token[HTTP_MAX_TOKEN_LEN + 1];
+    u16_t token_len;
+    u16_t method_len, path_len, query_len, header_name_len;
+    u32_t header_bytes;
+    u32_t body_remaining;
+    int error_status;               // != 0: responder com este erro em vez de rotear
+    bool close_after_response;
+    struct pbuf *rx;                // Dados recebidos ainda não processados (cadeia)
+    u16_t rx_offset;                // Quantos bytes de 'rx' já passaram pelo parser
+    u8_t idle_ticks;                // Incrementado pelo tcp_poll; zerado a cada atividade
+    uint64_t last_active_us;        // Última atividade (aceite, dados ou ACK): ordem do LRU
+    bool closing;                   // tcp_close() feito; o slot espera o ACK das respostas compartilhadas
+    u32_t tx_queued;                // Bytes escritos com tcp_write desde a abertura
+    u32_t tx_acked;                 // Bytes confirmados (soma dos 'len' do tcp_sent)
+    struct {
+        http_shared_response_t *response;
+        u32_t end;                  // Valor de tx_queued após o último byte desta resposta
+    } held[HTTP_MAX_HELD_RESPONSES]; // Em ordem de envio
+    u8_t held_count;
+    struct {
+        bool active;                // Corpo em andamento; a próxima requisição espera
+        bool chunked;
+        bool finished;              // O produtor não tem mais trechos (falta só o terminador)
+        http_stream_fn producer;
+        http_stream_done_fn done;   // NULL depois de chamado
+        u32_t index;                // Próximo trecho a pedir ao produtor
+        http_piece_t piece;         // Trecho atual e quanto dele já foi escrito
+        u16_t piece_offset;
+        bool has_piece;
+        u32_t state[HTTP_STREAM_STATE_LEN / sizeof(u32_t)];
+    } stream;
+    char scratch[HTTP_STREAM_SCRATCH_LEN];
+#if LATENCY_TRACE_ENABLED
+    struct {
+        uint64_t accepted_us;
+        uint64_t request_us;        // Início do parse da requisição atual (0 = nenhuma)
+        uint64_t rendered_us;       // Fim do handler da resposta ainda sendo enfileirada (0 = nenhuma)
+        uint64_t rendered_request_us;
+        uint64_t queued_us;         // Resposta totalmente enfileirada, aguardando o ACK
+        uint64_t queued_request_us;
+        u32_t ack_end;              // tx_queued ao fim dessa resposta (0 = nenhuma)
+        bool seen_first_byte;
+    } trace;
+#endif
+};
+
+static http_conn_t g_http_conns[HTTP_MAX_CONNECTIONS];
+static const http_route_t *g_http_routes = NULL;
+static size_t g_http_route_count = 0;
+static struct tcp_pcb *g_http_listen_pcb = NULL; // NULL enquanto suspenso
+static u16_t g_http_port;
+static u8_t g_http_backlog;
+static http_server_stats_t g_http_stats;
+static http_server_counters_t g_http_counters;
+static u16_t g_http_detached = 0;                // Conexões destacadas ainda abertas (orçamento)
+
+// Resposta às conexões acima do orçamento: em flash, enviada por referência (sem heap da LwIP).
+static const char g_http_overload_503[] =
+    "HTTP/1.1 503 Service Unavailable\r\n"
+    "Retry-After: 2\r\n"
+    "Content-Length: 0\r\n"
+    "Connection: close\r\n\r\n";
+
+// --- Protótipos ---
+static err_t http_recv_callback(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t err);
+static err_t http_sent_callback(void *arg, struct tcp_pcb *tpcb, u16_t len);
+static err_t http_poll_callback(void *arg, struct tcp_pcb *tpcb);
+static void http_error_callback(void *arg, err_t err);
+static err_t http_accept_callback(void *arg, struct tcp_pcb *newpcb, err_t err);
+static err_t http_stream_continue(http_conn_t *conn);
+
+static const char *http_status_text(int status) {
+    switch (status) {
+        case 101: return "Switching Protocols";
+        case 200: return "OK";
+        case 304: return "Not Modified";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 414: return "URI Too Long";
+        case 431: return "Request Header Fields Too Large";
+        case 500: return "Internal Server Error";
+        case 501: return "Not Implemented";
+        case 503: return "Service Unavailable";
+        default:  return "Unknown";
+    }
+}
+
+// Verifica se uma lista separada por vírgulas (ex.: "keep-alive, Upgrade") contém 'token'.
+static bool http_header_has_token(const char *value, const char *token) {
+    size_t token_len = strlen(token);
+    while (*value) {
+        while (*value == ' ' || *value == ',') value++;
+        size_t item_len = strcspn(value, ",");
+        size_t trimmed = item_len;
+        while (trimmed > 0 && value[trimmed - 1] == ' ') trimmed--;
+        if (trimmed == token_len && strncasecmp(value, token, token_len) == 0) {
+            return true;
+        }
+        value += item_len;
+    }
+    return false;
+}
+
+// Accept-Encoding: "gzip, deflate, br" ou com pesos ("gzip;q=0.8"). q=0 significa recusado.
+static bool http_accepts_gzip(const char *value) {
+    while (*value) {
+        while (*value == ' ' || *value == ',') value++;
+        size_t item_len = strcspn(value, ",");
+        size_t name_len = strcspn(value, ";, ");
+        if (name_len > item_len) name_len = item_len;
+        if ((name_len == 4 && strncasecmp(value, "gzip", 4) == 0) || (name_len == 1 && value[0] == '*')) {
+            const char *q = strstr(value, "q=");
+            bool refused = q != NULL && q < value + item_len && strtod(q + 2, NULL) == 0.0;
+            return !refused;
+        }
+        value += item_len;
+    }
+    return false;
+}
+
+static void http_parser_reset(http_conn_t *conn) {
+    conn->state = HTTP_STATE_METHOD;
+    memset(&conn->request, 0, sizeof(conn->request));
+    conn->token_len = 0;
+    conn->method_len = conn->path_len = conn->query_len = conn->header_name_len = 0;
+    conn->header_bytes = 0;
+    conn->body_remaining = 0;
+    conn->error_status = 0;
+}
+
+static void http_fail(http_conn_t *conn, int status, bool fatal) {
+    if (conn->error_status == 0) {
+        conn->error_status = status;
+    }
+    if (fatal) {
+        // O fluxo não pode ser ressincronizado: responde e fecha.
+        conn->close_after_response = true;
+        conn->state = HTTP_STATE_COMPLETE;
+    }
+}
+
+static void http_apply_header(http_conn_t *conn) {
+    http_request_t *req = &conn->request;
+    const char *name = conn->header_name;
+    const char *value = conn->token;
+
+    if (strcmp(name, "connection") == 0) {
+        if (http_header_has_token(value, "close")) req->keep_alive = false;
+        else if (http_header_has_token(value, "keep-alive")) req->keep_alive = true;
+    } else if (strcmp(name, "content-length") == 0) {
+        req->content_length = (u32_t)strtoul(value, NULL, 10);
+    } else if (strcmp(name, "transfer-encoding") == 0) {
+        http_fail(conn, 501, true); // Corpo chunked na requisição não é suportado
+    } else if (strcmp(name, "if-none-match") == 0) {
+        strncpy(req->if_none_match, value, sizeof(req->if_none_match) - 1);
+    } else if (strcmp(name, "sec-websocket-key") == 0) {
+        strncpy(req->websocket_key, value, sizeof(req->websocket_key) - 1);
+    } else if (strcmp(name, "accept-encoding") == 0) {
+        req->accept_gzip = http_accepts_gzip(value);
+    } else if (strcmp(name, "upgrade") == 0) {
+        req->websocket_upgrade = http_header_has_token(value, "websocket");
+    }
+}
+
+// Alimenta o parser com um byte. Retorna true quando a requisição está completa.
+static bool http_parse_byte(http_conn_t *conn, char c) {
+    http_request_t *req = &conn->request;
+
+    if (conn->state == HTTP_STATE_BODY) {
+        // O corpo é descartado: nenhuma rota atual usa corpo de requisição.
+        if (--conn->body_remaining == 0) conn->state = HTTP_STATE_COMPLETE;
+        return conn->state == HTTP_STATE_COMPLETE;
+    }
+
+    if (conn->state == HTTP_STATE_METHOD && conn->method_len == 0 && (c == '\r' || c == '\n')) {
+        return false; // Linhas vazias antes da requisição são toleradas (RFC 7230, 3.5)
+    }
+    if (++conn->header_bytes > HTTP_MAX_HEADER_BYTES) {
+        http_fail(conn, 431, true);
+        return true;
+    }
+
+    switch (conn->state) {
+        case HTTP_STATE_METHOD:
+            if (c == ' ') {
+                req->method[conn->method_len] = '\0';
+                req->head = (strcmp(req->method, "HEAD") == 0);
+                conn->state = HTTP_STATE_PATH;
+            } else if (conn->method_len < sizeof(req->method) - 1) {
+                req->method[conn->method_len++] = c;
+            } else {
+                http_fail(conn, 400, true);
+                return true;
+            }
+            break;
+
+        case HTTP_STATE_PATH:
+        case HTTP_STATE_QUERY:
+            if (c == ' ') {
+                conn->state = HTTP_STATE_VERSION;
+                conn->token_len = 0;
+            } else if (c == '\r' || c == '\n') {
+                http_fail(conn, 400, true); // Requisição HTTP/0.9 ou malformada
+                return true;
+            } else if (c == '?' && conn->state == HTTP_STATE_PATH) {
+                conn->state = HTTP_STATE_QUERY;
+            } else if (conn->state == HTTP_STATE_PATH) {
+                if (conn->path_len < HTTP_MAX_PATH_LEN) req->path[conn->path_len++] = c;
+                else http_fail(conn, 414, false);
+            } else {
+                if (conn->query_len < HTTP_MAX_QUERY_LEN) req->query[conn->query_len++] = c;
+                else http_fail(conn, 414, false);
+            }
+            break;
+
+        case HTTP_STATE_VERSION:
+            if (c == '\n') {
+                conn->token[conn->token_len] = '\0';
+                // HTTP/1.1 é persistente por padrão; HTTP/1.0 só com "Connection: keep-alive"
+                req->http_1_1 = (strcmp(conn->token, "HTTP/1.1") == 0);
+                req->keep_alive = req->http_1_1;
+                conn->token_len = 0;
+                conn->header_name_len = 0;
+                conn->state = HTTP_STATE_HEADER_NAME;
+            } else if (c != '\r' && conn->token_len < HTTP_MAX_TOKEN_LEN) {
+                conn->token[conn->token_len++] = c;
+            }
+            break;
+
+        case HTTP_STATE_HEADER_NAME:
+            if (c == '\r') {
+                break;
+            }
+            if (c == '\n') {
+                if (conn->header_name_len == 0) { // Linha vazia: fim dos cabeçalhos
+                    if (req->content_length > 0) {
+                        conn->body_remaining = req->content_length;
+                        conn->state = HTTP_STATE_BODY;
+                        return false;
+                    }
+                    conn->state = HTTP_STATE_COMPLETE;
+                    return true;
+                }
+                conn->header_name_len = 0; // Linha sem ':' é ignorada
+            } else if (c == ':') {
+                conn->header_name[conn->header_name_len] = '\0';
+                conn->token_len = 0;
+                conn->state = HTTP_STATE_HEADER_VALUE;
+            } else if (conn->header_name_len < HTTP_MAX_HEADER_NAME_LEN) {
+                // Nomes de cabeçalho não diferenciam maiúsculas: guarda em minúsculas
+                conn->header_name[conn->header_name_len++] = (c >= 'A' && c <= 'Z') ? (char)(c + 32) : c;
+            }
+            break;
+
+        case HTTP_STATE_HEADER_VALUE:
+            if (c == '\n') {
+                while (conn->token_len > 0 && conn->token[conn->token_len - 1] == ' ') conn->token_len--;
+                conn->token[conn->token_len] = '\0';
+                http_apply_header(conn);
+                if (conn->state == HTTP_STATE_COMPLETE) {
+                    return true; // Cabeçalho inválido e fatal
+                }
+                conn->header_name_len = 0;
+                conn->state = HTTP_STATE_HEADER_NAME;
+            } else if (c == '\r' || ((c == ' ' || c == '\t') && conn->token_len == 0)) {
+                // Ignora espaços iniciais e o CR
+            } else if (conn->token_len < HTTP_MAX_TOKEN_LEN) {
+                conn->token[conn->token_len++] = c;
+            }
+            break;
+
+        default:
+            break;
+    }
+    return false;
+}
+
+// --- Rastreamento de latência (latency_trace.h) ---
+// Com pipeline, só a última resposta enfileirada em cada passagem é medida até o ACK. Conexões
+// fechadas após a resposta só têm o ACK medido se ainda retêm uma resposta compartilhada.
+
+#if LATENCY_TRACE_ENABLED
+static void http_trace_parse_start(http_conn_t *conn) {
+    if (conn->trace.request_us != 0) {
+        return;
+    }
+    uint64_t now_us = time_us_64();
+    conn->trace.request_us = now_us;
+    if (!conn->trace.seen_first_byte) {
+        conn->trace.seen_first_byte = true;
+        latency_trace_record(LATENCY_ACCEPT_TO_FIRST_BYTE, (uint32_t)(now_us - conn->trace.accepted_us));
+    }
+}
+
+static void http_trace_parsed(http_conn_t *conn) {
+    latency_trace_record(LATENCY_PARSE, (uint32_t)(time_us_64() - conn->trace.request_us));
+}
+
+static uint64_t http_trace_now(void) {
+    return time_us_64();
+}
+
+static void http_trace_rendered(http_conn_t *conn, uint64_t start_us) {
+    uint64_t now_us = time_us_64();
+    latency_trace_record(LATENCY_RENDER, (uint32_t)(now_us - start_us));
+    conn->trace.rendered_us = now_us;
+    conn->trace.rendered_request_us = conn->trace.request_us;
+    conn->trace.request_us = 0;
+}
+
+// Chamado após o tcp_output: se a resposta já saiu inteira do handler/stream, passa a esperar o ACK.
+static void http_trace_queued(http_conn_t *conn) {
+    if (conn->trace.rendered_us == 0 || conn->stream.active) {
+        return;
+    }
+    uint64_t now_us = time_us_64();
+    latency_trace_record(LATENCY_WRITE, (uint32_t)(now_us - conn->trace.rendered_us));
+    conn->trace.queued_us = now_us;
+    conn->trace.queued_request_us = conn->trace.rendered_request_us;
+    conn->trace.ack_end = conn->tx_queued;
+    conn->trace.rendered_us = 0;
+}
+
+static void http_trace_acked(http_conn_t *conn) {
+    if (conn->trace.ack_end == 0 || (s32_t)(conn->tx_acked - conn->trace.ack_end) < 0) {
+        return;
+    }
+    uint64_t now_us = time_us_64();
+    latency_trace_record(LATENCY_LAST_ACK, (uint32_t)(now_us - conn->trace.queued_us));
+    latency_trace_record(LATENCY_TOTAL, (uint32_t)(now_us - conn->trace.queued_request_us));
+    conn->trace.ack_end = 0;
+}
+#else
+static inline void http_trace_parse_start(http_conn_t *conn) {}
+static inline void http_trace_parsed(http_conn_t *conn) {}
+static inline uint64_t http_trace_now(void) { return 0; }
+static inline void http_trace_rendered(http_conn_t *conn, uint64_t start_us) {}
+static inline void http_trace_queued(http_conn_t *conn) {}
+static inline void http_trace_acked(http_conn_t *conn) {}
+#endif
+
+// --- Ciclo de vida da conexão ---
+
+// Devolve as referências das respostas compartilhadas já confirmadas (ou todas, se 'all').
+static void http_conn_release_held(http_conn_t *conn, bool all) {
+    u8_t released = 0;
+    while (released < conn->held_count &&
+           (all || (s32_t)(conn->held[released].end - conn->tx_acked) <= 0)) {
+        conn->held[released].response->refs--;
+        released++;
+    }
+    if (released > 0) {
+        conn->held_count -= released;
+        memmove(&conn->held[0], &conn->held[released], conn->held_count * sizeof(conn->held[0]));
+    }
+}
+
+// Avisa o dono do stream (uma vez) que o produtor não será mais chamado.
+static void http_stream_done(http_conn_t *conn) {
+    http_stream_done_fn done = conn->stream.done;
+    conn->stream.done = NULL;
+    if (done != NULL) {
+        done(conn->stream.state);
+    }
+}
+
+// Só é chamada quando a LwIP não guarda mais segmentos desta conexão (abortada, erro, ou tudo
+// confirmado), então as respostas compartilhadas ainda retidas podem ser liberadas.
+static void http_conn_release(http_conn_t *conn) {
+    http_stream_done(conn); // Stream interrompido no meio
+    http_conn_release_held(conn, true);
+    if (conn->rx != NULL) {
+        pbuf_free(conn->rx);
+    }
+    memset(conn, 0, sizeof(*conn));
+}
+
+// Todo RST enviado pelo firmware passa por aqui: sem callbacks, a LwIP não chama mais ninguém
+// com o ponteiro do slot ou do cliente que está sendo liberado.
+static void http_pcb_abort(struct tcp_pcb *tpcb) {
+    tcp_arg(tpcb, NULL); tcp_recv(tpcb, NULL); tcp_sent(tpcb, NULL); tcp_poll(tpcb, NULL, 0); tcp_err(tpcb, NULL);
+    tcp_abort(tpcb);
+}
+
+// Fecha com FIN um PCB que já não tem dono; se não houver memória para o FIN, aborta.
+static err_t http_pcb_close(struct tcp_pcb *tpcb) {
+    tcp_arg(tpcb, NULL); tcp_recv(tpcb, NULL); tcp_sent(tpcb, NULL); tcp_poll(tpcb, NULL, 0); tcp_err(tpcb, NULL);
+    err_t close_err = tcp_close(tpcb);
+    if (close_err != ERR_OK) {
+        printf("ERRO TCP: Falha ao fechar conexão (tcp_close) - código %d. Abortando.\n", close_err);
+        g_http_counters.write_errors++;
+        tcp_abort(tpcb);
+        return ERR_ABRT;
+    }
+    return ERR_OK;
+}
+
+static void http_conn_abort(http_conn_t *conn) {
+    struct tcp_pcb *tpcb = conn->pcb;
+    g_http_counters.aborts++;
+    http_conn_release(conn);
+    http_pcb_abort(tpcb);
+}
+
+// Falha de tcp_write/tcp_output: o fluxo da resposta ficou incompleto e a conexão é abortada.
+static err_t http_conn_write_failed(http_conn_t *conn, const char *call, err_t err) {
+    printf("ERRO TCP: Falha ao enviar dados (%s) - código %d\n", call, err);
+    g_http_counters.write_errors++;
+    http_conn_abort(conn);
+    return ERR_ABRT;
+}
+
+static err_t http_conn_close(http_conn_t *conn) {
+    struct tcp_pcb *tpcb = conn->pcb;
+    if (conn->rx != NULL) {
+        tcp_recved(tpcb, conn->rx->tot_len); // Janela cheia: o tcp_close() fecha com FIN, sem RST
+        pbuf_free(conn->rx);
+        conn->rx = NULL;
+    }
+    tcp_recv(tpcb, NULL); tcp_poll(tpcb, NULL, 0);
+    if (conn->held_count > 0) {
+        // Os segmentos em voo apontam para respostas compartilhadas: mantém tcp_sent/tcp_err até
+        // o ACK (ou o erro) para só então devolver as referências e o slot.
+        conn->closing = true;
+    } else {
+        http_conn_release(conn);
+        tcp_arg(tpcb, NULL); tcp_sent(tpcb, NULL); tcp_err(tpcb, NULL);
+    }
+    err_t close_err = tcp_close(tpcb);
+    if (close_err != ERR_OK) {
+        printf("ERRO TCP: Falha ao fechar conexão (tcp_close) - código %d. Abortando.\n", close_err);
+        g_http_counters.write_errors++;
+        g_http_counters.aborts++;
+        tcp_abort(tpcb); // Se o slot ainda estiver em uso, o tcp_err o libera
+        return ERR_ABRT;
+    }
+    return ERR_OK;
+}
+
+struct tcp_pcb *http_conn_detach(http_conn_t *conn) {
+    struct tcp_pcb *tpcb = conn->pcb;
+    if (conn->held_count > 0) {
+        return NULL; // O tcp_sent ainda precisa devolver as referências
+    }
+    tcp_arg(tpcb, NULL); tcp_recv(tpcb, NULL); tcp_sent(tpcb, NULL); tcp_poll(tpcb, NULL, 0); tcp_err(tpcb, NULL);
+    conn->pcb = NULL; // http_conn_process() libera o slot ao perceber
+    g_http_detached++; // O slot volta ao pool, mas a vaga no orçamento segue com o novo dono
+    return tpcb;
+}
+
+static void http_detached_release(void) {
+    if (g_http_detached > 0) {
+        g_http_detached--;
+    }
+}
+
+err_t http_detached_close(struct tcp_pcb *tpcb) {
+    http_detached_release();
+    return http_pcb_close(tpcb);
+}
+
+void http_detached_abort(struct tcp_pcb *tpcb) {
+    http_detached_release();
+    http_pcb_abort(tpcb);
+}
+
+void http_detached_lost(void) {
+    http_detached_release();
+}
+
+bool http_tx_mem_available(u16_t copy_len) {
+    const struct stats_mem *segs = lwip_stats.memp[MEMP_TCP_SEG];
+    bool heap_ok = (u32_t)lwip_stats.mem.used + copy_len + HTTP_TX_MEM_RESERVE <= lwip_stats.mem.avail;
+    bool segs_ok = segs == NULL || (u32_t)segs->used + HTTP_TX_MIN_FREE_SEGS <= segs->avail;
+    if (heap_ok && segs_ok) {
+        return true;
+    }
+    g_http_counters.mem_pressure++;
+    return false;
+}
+
+// Roteia a requisição completa para o handler correspondente.
+static err_t http_conn_dispatch(http_conn_t *conn) {
+    const http_request_t *req = &conn->request;
+    g_http_stats.requests++;
+    g_http_counters.other_requests++; // Desfeito abaixo se a requisição casar com uma rota
+    if (conn->error_status != 0) {
+        conn->close_after_response = true;
+        return http_send_response(conn, conn->error_status, NULL, NULL, 0, false);
+    }
+    if (strcmp(req->method, "GET") != 0 && !req->head) {
+        return http_send_response(conn, 405, "Allow: GET, HEAD\r\n", NULL, 0, false);
+    }
+    for (size_t i = 0; i < g_http_route_count; i++) {
+        if (strcmp(req->path, g_http_routes[i].path) == 0) {
+            g_http_counters.other_requests--;
+            g_http_counters.route_requests[i]++;
+            return g_http_routes[i].handler(conn, req);
+        }
+    }
+    return http_send_response(conn, 404, NULL, NULL, 0, false);
+}
+
+// Passa os dados pendentes pelo parser e responde a cada requisição completa (pipeline).
+// Para quando os dados acabam ou quando não há espaço para a próxima resposta; neste caso,
+// os bytes restantes ficam em conn->rx e o processamento continua no tcp_sent/tcp_poll.
+static err_t http_conn_process_pending(http_conn_t *conn) {
+    struct tcp_pcb *tpcb = conn->pcb;
+    bool wrote = false;
+
+    while (true) {
+        if (conn->stream.active) {
+            err_t stream_err = http_stream_continue(conn);
+            if (stream_err == ERR_ABRT) {
+                return ERR_ABRT;
+            }
+            wrote = true;
+            if (stream_err == ERR_INPROGRESS) {
+                break; // Buffer de envio cheio: o corpo continua no próximo tcp_sent
+            }
+            if (conn->close_after_response) {
+                tcp_output(tpcb);
+                http_trace_queued(conn);
+                return http_conn_close(conn);
+            }
+            http_parser_reset(conn);
+        } else if (conn->state == HTTP_STATE_COMPLETE) {
+            uint64_t render_start_us = http_trace_now();
+            err_t dispatch_err = http_conn_dispatch(conn);
+            if (dispatch_err == ERR_MEM) {
+                g_http_counters.sndbuf_full++;
+                break; // Sem espaço no buffer de envio: tenta de novo quando chegar ACK
+            }
+            if (dispatch_err != ERR_OK) {
+                // A conexão já foi abortada (por nós ou pelo handler que a assumiu)
+                if (conn->in_use) http_conn_release(conn);
+                return ERR_ABRT;
+            }
+            if (conn->pcb == NULL) { // Handler assumiu a conexão (SSE/WebSocket)
+                if (conn->rx != NULL) tcp_recved(tpcb, conn->rx->tot_len);
+                http_conn_release(conn);
+                return ERR_OK;
+            }
+            wrote = true;
+            http_trace_rendered(conn, render_start_us);
+            if (conn->stream.active) {
+                continue; // Corpo em partes: segue no ramo acima
+            }
+            if (conn->close_after_response) {
+                tcp_output(tpcb);
+                http_trace_queued(conn);
+                return http_conn_close(conn);
+            }
+            http_parser_reset(conn);
+        }
+
+        if (conn->rx == NULL) {
+            break;
+        }
+
+        // Localiza o segmento da cadeia onde o parser parou
+        struct pbuf *q = conn->rx;
+        u16_t offset = conn->rx_offset;
+        while (q != NULL && offset >= q->len) {
+            offset -= q->len;
+            q = q->next;
+        }
+
+        http_trace_parse_start(conn);
+        bool complete = false;
+        for (; q != NULL && !complete; q = q->next, offset = 0) {
+            const char *data = (const char *)q->payload;
+            while (offset < q->len) {
+                conn->rx_offset++;
+                if (http_parse_byte(conn, data[offset++])) {
+                    complete = true;
+                    break;
+                }
+            }
+        }
+
+        if (conn->rx_offset >= conn->rx->tot_len) {
+            // Cadeia inteira consumida: libera e abre a janela de recepção
+            tcp_recved(tpcb, conn->rx->tot_len);
+            pbuf_free(conn->rx);
+            conn->rx = NULL;
+            conn->rx_offset = 0;
+        }
+        if (!complete) {
+            break;
+        }
+        http_trace_parsed(conn);
+    }
+
+    if (wrote) {
+        err_t output_err = tcp_output(tpcb);
+        if (output_err != ERR_OK) {
+            return http_conn_write_failed(conn, "tcp_output", output_err);
+        }
+        http_trace_queued(conn);
+    }
+    return ERR_OK;
+}
+
+// Mede o tempo de CPU de cada passagem pelo parser/handlers (instrumentação de latência).
+static err_t http_conn_process(http_conn_t *conn) {
+    uint64_t start_us = time_us_64();
+    err_t result = http_conn_process_pending(conn);
+    uint32_t elapsed_us = (uint32_t)(time_us_64() - start_us);
+    g_http_stats.busy_us += elapsed_us;
+    if (elapsed_us > g_http_stats.max_handling_us) {
+        g_http_stats.max_handling_us = elapsed_us;
+    }
+    return result;
+}
+
+void http_server_get_stats(http_server_stats_t *out, bool reset) {
+    *out = g_http_stats;
+    if (reset) {
+        memset(&g_http_stats, 0, sizeof(g_http_stats));
+    }
+}
+
+void http_server_get_counters(http_server_counters_t *out) {
+    *out = g_http_counters;
+}
+
+const http_route_t *http_server_get_routes(size_t *count) {
+    *count = g_http_route_count;
+    return g_http_routes;
+}
+
+// Formata linha de status e cabeçalhos. 'framing' é a linha de Content-Length/Transfer-Encoding
+// (ou ""). Se não couber em 'header', formata no lugar um 500 sem corpo que fecha a conexão e
+// marca '*overflow' (o chamador não envia o corpo). Retorna o tamanho.
+static int http_format_header(http_conn_t *conn, char *header, size_t size, int status,
+                              const char *extra_headers, const char *framing, bool *overflow) {
+    fmt_buf_t out;
+    fmt_init(&out, header, size);
+    FMT_LIT(&out, "HTTP/1.1 ");
+    fmt_u32(&out, (uint32_t)status);
+    fmt_char(&out, ' ');
+    fmt_str(&out, http_status_text(status));
+    FMT_LIT(&out, "\r\n");
+    if (extra_headers != NULL) {
+        fmt_str(&out, extra_headers);
+    }
+    fmt_str(&out, framing);
+    if (conn->close_after_response) {
+        FMT_LIT(&out, "Connection: close\r\n\r\n");
+    } else {
+        FMT_LIT(&out, "Connection: keep-alive\r\n\r\n");
+    }
+    *overflow = out.overflow;
+    if (*overflow) {
+        printf("ERRO HTTP: Cabeçalho de resposta não cabe no buffer (%u bytes). Respondendo 500.\n", (unsigned)size);
+        g_http_counters.overflow_500++;
+        conn->close_after_response = true;
+        fmt_init(&out, header, size);
+        FMT_LIT(&out, "HTTP/1.1 500 Internal Server Error\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+    }
+    return (int)out.len;
+}
+
+// "Content-Length: N\r\n" em 'line' (32 bytes bastam).
+static const char *http_format_content_length(char *line, size_t size, uint32_t length) {
+    fmt_buf_t out;
+    fmt_init(&out, line, size);
+    FMT_LIT(&out, "Content-Length: ");
+    fmt_u32(&out, length);
+    FMT_LIT(&out, "\r\n");
+    return fmt_cstr(&out);
+}
+
+err_t http_send_response(http_conn_t *conn, int status, const char *extra_headers,
+                         const char *body, u16_t body_len, bool body_is_static) {
+    struct tcp_pcb *tpcb = conn->pcb;
+    if (!conn->request.keep_alive) {
+        conn->close_after_response = true;
+    }
+    if (conn->request.head) {
+        // HEAD: mesmos cabeçalhos (inclusive Content-Length), sem corpo
+        body = NULL;
+    }
+
+    char length_line[32];
+    const char *framing = "";
+    if (status != 304 && status != 101) {
+        framing = http_format_content_length(length_line, sizeof(length_line), body_len);
+    }
+    char header[256];
+    bool overflow;
+    int header_len = http_format_header(conn, header, sizeof(header), status, extra_headers, framing, &overflow);
+
+    u16_t send_body_len = (body != NULL && !overflow) ? body_len : 0;
+    if (tcp_sndbuf(tpcb) < header_len + send_body_len || tcp_sndqueuelen(tpcb) + 4 > TCP_SND_QUEUELEN ||
+        !http_tx_mem_available((u16_t)(header_len + (body_is_static ? 0 : send_body_len)))) {
+        return ERR_MEM; // Nada foi escrito; a resposta será gerada de novo quando houver espaço
+    }
+
+    err_t write_err = tcp_write(tpcb, header, (u16_t)header_len, TCP_WRITE_FLAG_COPY | (send_body_len ? TCP_WRITE_FLAG_MORE : 0));
+    if (write_err == ERR_OK && send_body_len > 0) {
+        write_err = tcp_write(tpcb, body, send_body_len, body_is_static ? 0 : TCP_WRITE_FLAG_COPY);
+    }
+    if (write_err != ERR_OK) {
+        return http_conn_write_failed(conn, "tcp_write", write_err);
+    }
+    conn->tx_queued += (u32_t)header_len + send_body_len;
+    return ERR_OK;
+}
+
+err_t http_send_stream(http_conn_t *conn, int status, const char *extra_headers, s32_t content_length,
+                       http_stream_fn producer, http_stream_done_fn done, const void *state, size_t state_len) {
+    struct tcp_pcb *tpcb = conn->pcb;
+    if (!conn->request.keep_alive) {
+        conn->close_after_response = true;
+    }
+    char length_line[32];
+    const char *framing = "";
+    bool chunked = false;
+    if (content_length >= 0) {
+        framing = http_format_content_length(length_line, sizeof(length_line), (uint32_t)content_length);
+    } else if (conn->request.http_1_1) {
+        framing = "Transfer-Encoding: chunked\r\n";
+        chunked = true;
+    } else {
+        conn->close_after_response = true; // HTTP/1.0: o fim do corpo é o fechamento
+    }
+
+    char header[256];
+    bool overflow;
+    int header_len = http_format_header(conn, header, sizeof(header), status, extra_headers, framing, &overflow);
+    if (tcp_sndbuf(tpcb) < header_len || tcp_sndqueuelen(tpcb) + 4 > TCP_SND_QUEUELEN ||
+        !http_tx_mem_available((u16_t)header_len)) {
+        return ERR_MEM;
+    }
+    err_t write_err = tcp_write(tpcb, header, (u16_t)header_len, TCP_WRITE_FLAG_COPY | TCP_WRITE_FLAG_MORE);
+    if (write_err != ERR_OK) {
+        return http_conn_write_failed(conn, "tcp_write", write_err);
+    }
+    conn->tx_queued += (u32_t)header_len;
+
+    memset(&conn->stream, 0, sizeof(conn->stream));
+    if (state != NULL) {
+        memcpy(conn->stream.state, state, state_len < sizeof(conn->stream.state) ? state_len : sizeof(conn->stream.state));
+    }
+    conn->stream.done = done;
+    if (conn->request.head || overflow) {
+        http_stream_done(conn);
+        return ERR_OK; // HEAD (ou 500 por estouro): só os cabeçalhos
+    }
+    conn->stream.active = true;
+    conn->stream.chunked = chunked;
+    conn->stream.producer = producer;
+    return ERR_OK; // O corpo é escrito por http_stream_continue(), chamado logo em seguida
+}
+
+// Escreve trechos do stream enquanto houver espaço no buffer de envio. Retorna ERR_OK quando o
+// corpo terminou, ERR_INPROGRESS se precisa esperar ACKs, ou ERR_ABRT (conexão abortada).
+static err_t http_stream_continue(http_conn_t *conn) {
+    static const char crlf[] = "\r\n";
+    static const char last_chunk[] = "0\r\n\r\n";
+    struct tcp_pcb *tpcb = conn->pcb;
+    u16_t overhead = conn->stream.chunked ? 6 + 2 : 0; // "ffff\r\n" + "\r\n" por trecho
+
+    while (!conn->stream.finished) {
+        if (!conn->stream.has_piece) {
+            if (!conn->stream.producer(conn->stream.state, conn->stream.index, conn->scratch, &conn->stream.piece)) {
+                conn->stream.finished = true;
+                http_stream_done(conn);
+                break;
+            }
+            conn->stream.index++;
+            conn->stream.piece_offset = 0;
+            conn->stream.has_piece = conn->stream.piece.len > 0;
+            continue;
+        }
+
+        u16_t space = tcp_sndbuf(tpcb);
+        if (space <= overhead || tcp_sndqueuelen(tpcb) + 3 > TCP_SND_QUEUELEN) {
+            return ERR_INPROGRESS;
+        }
+        const http_piece_t *piece = &conn->stream.piece;
+        u16_t len = piece->len - conn->stream.piece_offset;
+        if (len > space - overhead) {
+            len = space - overhead; // O trecho vai em partes; o restante sai após o ACK
+        }
+        // Trechos formatados na área de rascunho são copiados; os demais vão por referência
+        bool is_scratch = piece->data >= conn->scratch && piece->data < conn->scratch + sizeof(conn->scratch);
+        if (!http_tx_mem_available((u16_t)((is_scratch ? len : 0) + (conn->stream.chunked ? 8 : 0)))) {
+            return ERR_INPROGRESS; // Retomado no próximo tcp_sent ou tcp_poll
+        }
+        err_t write_err = ERR_OK;
+        if (conn->stream.chunked) {
+            char size_line[8];
+            fmt_buf_t out;
+            fmt_init(&out, size_line, sizeof(size_line));
+            fmt_hex(&out, len);
+            FMT_LIT(&out, "\r\n");
+            u16_t size_len = (u16_t)out.len;
+            write_err = tcp_write(tpcb, size_line, (u16_t)size_len, TCP_WRITE_FLAG_COPY | TCP_WRITE_FLAG_MORE);
+            conn->tx_queued += (u32_t)size_len + 2;
+        }
+        if (write_err == ERR_OK) {
+            write_err = tcp_write(tpcb, piece->data + conn->stream.piece_offset, len,
+                                  (is_scratch ? TCP_WRITE_FLAG_COPY : 0) | TCP_WRITE_FLAG_MORE);
+        }
+        if (write_err == ERR_OK && conn->stream.chunked) {
+            write_err = tcp_write(tpcb, crlf, 2, TCP_WRITE_FLAG_MORE);
+        }
+        if (write_err != ERR_OK) {
+            return http_conn_write_failed(conn, "tcp_write", write_err);
+        }
+        conn->tx_queued += len;
+        conn->stream.piece_offset += len;
+        conn->stream.has_piece = conn->stream.piece_offset < piece->len;
+    }
+
+    if (conn->stream.chunked) {
+        if (tcp_sndbuf(tpcb) < sizeof(last_chunk) - 1 || tcp_sndqueuelen(tpcb) + 1 > TCP_SND_QUEUELEN) {
+            return ERR_INPROGRESS;
+        }
+        err_t write_err = tcp_write(tpcb, last_chunk, sizeof(last_chunk) - 1, 0);
+        if (write_err != ERR_OK) {
+            return http_conn_write_failed(conn, "tcp_write", write_err);
+        }
+        conn->tx_queued += sizeof(last_chunk) - 1;
+    }
+    conn->stream.active = false;
+    return ERR_OK;
+}
+
+err_t http_send_shared_response(http_conn_t *conn, http_shared_response_t *response) {
+    static const char keep_alive_end[] = "Connection: keep-alive\r\n\r\n";
+    static const char close_end[] = "Connection: close\r\n\r\n";
+    struct tcp_pcb *tpcb = conn->pcb;
+    if (!conn->request.keep_alive) {
+        conn->close_after_response = true;
+    }
+    const char *end = conn->close_after_response ? close_end : keep_alive_end;
+    u16_t end_len = (u16_t)strlen(end);
+    u16_t body_len = conn->request.head ? 0 : response->body_len;
+
+    if (conn->held_count == HTTP_MAX_HELD_RESPONSES ||
+        tcp_sndbuf(tpcb) < response->head_len + end_len + body_len ||
+        tcp_sndqueuelen(tpcb) + 4 > TCP_SND_QUEUELEN || !http_tx_mem_available(0)) {
+        return ERR_MEM;
+    }
+
+    // Três escritas por referência: nenhum byte é copiado para o heap da LwIP
+    err_t write_err = tcp_write(tpcb, response->data, response->head_len, TCP_WRITE_FLAG_MORE);
+    if (write_err == ERR_OK) {
+        write_err = tcp_write(tpcb, end, end_len, body_len ? TCP_WRITE_FLAG_MORE : 0);
+    }
+    if (write_err == ERR_OK && body_len > 0) {
+        write_err = tcp_write(tpcb, response->data + response->head_len, body_len, 0);
+    }
+    if (write_err != ERR_OK) {
+        return http_conn_write_failed(conn, "tcp_write", write_err);
+    }
+    conn->tx_queued += (u32_t)response->head_len + end_len + body_len;
+    response->refs++;
+    conn->held[conn->held_count].response = response;
+    conn->held[conn->held_count].end = conn->tx_queued;
+    conn->held_count++;
+    return ERR_OK;
+}
+
+// --- Callbacks da LwIP ---
+
+static err_t http_recv_callback(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t err) {
+    http_conn_t *conn = (http_conn_t *)arg;
+    if (err != ERR_OK && err != ERR_ABRT) {
+        printf("ERRO TCP: Falha na recepção de dados - código %d\n", err);
+        if (p != NULL) {
+            tcp_recved(tpcb, p->tot_len);
+            pbuf_free(p);
+        }
+        http_conn_abort(conn);
+        return ERR_ABRT;
+    }
+
+    // Se p == NULL, o cliente fechou a conexão
+    if (p == NULL) {
+        return http_conn_close(conn);
+    }
+
+    conn->idle_ticks = 0;
+    conn->last_active_us = time_us_64();
+    if (conn->rx == NULL) {
+        conn->rx = p;
+        conn->rx_offset = 0;
+    } else {
+        pbuf_cat(conn->rx, p); // Ainda há dados pendentes (esperando espaço de envio)
+    }
+    return http_conn_process(conn);
+}
+
+static err_t http_sent_callback(void *arg, struct tcp_pcb *tpcb, u16_t len) {
+    http_conn_t *conn = (http_conn_t *)arg;
+    conn->tx_acked += len;
+    http_trace_acked(conn);
+    http_conn_release_held(conn, false);
+    if (conn->closing) {
+        if (conn->held_count == 0) {
+            tcp_arg(tpcb, NULL); tcp_sent(tpcb, NULL); tcp_err(tpcb, NULL);
+            http_conn_release(conn);
+        }
+        return ERR_OK;
+    }
+    conn->idle_ticks = 0;
+    conn->last_active_us = time_us_64();
+    if (conn->state == HTTP_STATE_COMPLETE || conn->rx != NULL) {
+        return http_conn_process(conn); // Retoma respostas que estavam esperando espaço
+    }
+    return ERR_OK;
+}
+
+static err_t http_poll_callback(void *arg, struct tcp_pcb *tpcb) {
+    http_conn_t *conn = (http_conn_t *)arg;
+    if (conn->state == HTTP_STATE_COMPLETE || conn->rx != NULL) {
+        return http_conn_process(conn);
+    }
+    // Cada tick do poll vale HTTP_POLL_INTERVAL * 500 ms
+    if (++conn->idle_ticks * HTTP_POLL_INTERVAL / 2 >= HTTP_IDLE_TIMEOUT_S) {
+        g_http_counters.idle_closes++;
+        return http_conn_close(conn); // Libera o PCB de clientes keep-alive inativos
+    }
+    return ERR_OK;
+}
+
+static void http_error_callback(void *arg, err_t err) {
+    // ERR_ABRT é comum quando abortamos a conexão intencionalmente ou o cliente fecha abruptamente.
+    if (err != ERR_ABRT) {
+        printf("ERRO TCP: Callback de erro TCP - código %d\n", err);
+        g_http_counters.conn_errors++;
+    }
+    if (arg != NULL) {
+        http_conn_release((http_conn_t *)arg); // O PCB já foi liberado pela LwIP
+    }
+}
+
+// --- Admissão ---
+
+// Conexões do pool que contam no orçamento (as em 'closing' só esperam o ACK final).
+static u16_t http_conn_open_count(void) {
+    u16_t count = 0;
+    for (int i = 0; i < HTTP_MAX_CONNECTIONS; i++) {
+        const http_conn_t *conn = &g_http_conns[i];
+        if (conn->in_use && conn->pcb != NULL && !conn->closing) count++;
+    }
+    return count;
+}
+
+void http_server_get_open(u16_t *pooled, u16_t *detached) {
+    *pooled = http_conn_open_count();
+    *detached = g_http_detached;
+}
+
+static http_conn_t *http_conn_free_slot(void) {
+    for (int i = 0; i < HTTP_MAX_CONNECTIONS; i++) {
+        if (!g_http_conns[i].in_use) return &g_http_conns[i];
+    }
+    return NULL;
+}
+
+// Ociosa: entre requisições, sem nada recebido, pendente ou aguardando ACK.
+static bool http_conn_is_idle(const http_conn_t *conn) {
+    return conn->in_use && conn->pcb != NULL && !conn->closing && conn->state == HTTP_STATE_METHOD &&
+           conn->method_len == 0 && conn->rx == NULL && !conn->stream.active && conn->held_count == 0 &&
+           conn->tx_acked == conn->tx_queued;
+}
+
+// Fecha (FIN) a conexão ociosa há mais tempo, se passou de HTTP_EVICT_MIN_IDLE_MS. Uma conexão
+// recém-aceita que ainda não mandou a requisição também parece ociosa: o tempo mínimo a protege.
+static bool http_conn_evict_lru(void) {
+    uint64_t now_us = time_us_64();
+    http_conn_t *victim = NULL;
+    for (int i = 0; i < HTTP_MAX_CONNECTIONS; i++) {
+        http_conn_t *conn = &g_http_conns[i];
+        if (http_conn_is_idle(conn) && now_us - conn->last_active_us >= HTTP_EVICT_MIN_IDLE_MS * 1000ull &&
+            (victim == NULL || conn->last_active_us < victim->last_active_us)) {
+            victim = conn;
+        }
+    }
+    if (victim == NULL) {
+        return false;
+    }
+    g_http_counters.evictions++;
+    http_conn_close(victim); // Sem respostas retidas: o slot é liberado já (mesmo se abortar)
+    return true;
+}
+
+// Slot para uma conexão nova dentro do orçamento, cedendo se preciso a vaga da ociosa há mais
+// tempo. NULL se não houver como atender agora.
+static http_conn_t *http_conn_admit(void) {
+    if (http_conn_open_count() + g_http_detached >= HTTP_CONN_BUDGET || http_conn_free_slot() == NULL) {
+        if (!http_conn_evict_lru()) {
+            return NULL;
+        }
+    }
+    return http_conn_free_slot();
+}
+
+static err_t http_reject_recv(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t err) {
+    if (p == NULL) {
+        return http_pcb_close(tpcb); // O cliente leu o 503 e fechou
+    }
+    tcp_recved(tpcb, p->tot_len); // A requisição é descartada: o 503 já foi enviado
+    pbuf_free(p);
+    return ERR_OK;
+}
+
+static err_t http_reject_poll(void *arg, struct tcp_pcb *tpcb) {
+    g_http_counters.aborts++;
+    http_pcb_abort(tpcb); // O cliente não fechou a tempo: o PCB volta para a reserva
+    return ERR_ABRT;
+}
+
+// Conexão acima do orçamento: 503 com Retry-After e FIN logo em seguida. A recepção segue aberta
+// (tcp_shutdown só do envio) para que a requisição que chega depois do 503 seja descartada sem RST,
+// que faria o cliente perder a resposta. Sem slot e sem printf por conexão: numa enxurrada o custo
+// fica em uma escrita por referência.
+static err_t http_reject(struct tcp_pcb *newpcb) {
+    g_http_counters.rejected_503++;
+    tcp_setprio(newpcb, TCP_PRIO_MIN); // A primeira que a LwIP recicla se faltar PCB para um SYN
+    tcp_arg(newpcb, NULL);
+    tcp_recv(newpcb, http_reject_recv);
+    tcp_poll(newpcb, http_reject_poll, HTTP_REJECT_LINGER);
+    err_t write_err = tcp_write(newpcb, g_http_overload_503, sizeof(g_http_overload_503) - 1, 0);
+    if (write_err == ERR_OK) {
+        write_err = tcp_shutdown(newpcb, 0, 1); // Envia o 503 e o FIN
+    }
+    if (write_err != ERR_OK) {
+        g_http_counters.aborts++;
+        http_pcb_abort(newpcb);
+        return ERR_ABRT;
+    }
+    return ERR_OK;
+}
+
+// Callback para quando uma nova conexão TCP é aceita pelo servidor
+static err_t http_accept_callback(void *arg, struct tcp_pcb *newpcb, err_t err) {
+    if (err != ERR_OK || newpcb == NULL) {
+        printf("ERRO TCP: Falha ao aceitar nova conexão - código %d\n", err);
+        g_http_counters.accept_failures++;
+        return ERR_VAL; // Indica um erro
+    }
+
+    http_conn_t *conn = http_conn_admit();
+    if (conn == NULL) {
+        return http_reject(newpcb);
+    }
+
+    memset(conn, 0, sizeof(*conn));
+    conn->in_use = true;
+    conn->pcb = newpcb;
+    conn->last_active_us = time_us_64();
+    g_http_counters.accepted++;
+#if LATENCY_TRACE_ENABLED
+    conn->trace.accepted_us = time_us_64();
+#endif
+    http_parser_reset(conn);
+
+    tcp_setprio(newpcb, TCP_PRIO_NORMAL); // Define prioridade da conexão
+    tcp_arg(newpcb, conn); // Argumento para os callbacks: o slot da conexão
+    tcp_recv(newpcb, http_recv_callback); // Define callback para dados recebidos
+    tcp_sent(newpcb, http_sent_callback); // Retoma respostas pendentes quando chegam ACKs
+    tcp_poll(newpcb, http_poll_callback, HTTP_POLL_INTERVAL); // Timeout de ociosidade
+    tcp_err(newpcb, http_error_callback); // Define callback para erros na conexão
+
+    return ERR_OK; // Sucesso
+}
+
+static bool http_server_listen(void) {
+    struct tcp_pcb *pcb_listen = tcp_new_ip_type(IPADDR_TYPE_ANY);
+    if (!pcb_listen) {
+        printf("ERRO FATAL: Falha ao criar PCB para escuta TCP.\n");
+        return false;
+    }
+
+    err_t bind_err = tcp_bind(pcb_listen, IP_ANY_TYPE, g_http_port);
+    if (bind_err != ERR_OK) {
+        printf("ERRO FATAL: Falha ao associar (bind) servidor TCP à porta %d - código %d\n", g_http_port, bind_err);
+        tcp_close(pcb_listen);
+        return false;
+    }
+
+    pcb_listen = tcp_listen_with_backlog(pcb_listen, g_http_backlog);
+    if (!pcb_listen) {
+        printf("ERRO FATAL: Falha ao colocar servidor TCP em modo de escuta.\n");
+        // O PCB original pode ter sido desalocado em caso de erro aqui
+        return false;
+    }
+
+    tcp_accept(pcb_listen, http_accept_callback);
+    g_http_listen_pcb = pcb_listen;
+    printf("INFO: Servidor TCP ouvindo na porta %d.\n", g_http_port);
+    return true;
+}
+
+// Inicializa os componentes do servidor TCP
+bool http_server_init(u16_t port, u8_t backlog, const http_route_t *routes, size_t route_count) {
+    printf("INFO: Configurando servidor TCP...\n");
+    if (route_count > HTTP_MAX_ROUTES) {
+        printf("ERRO FATAL: %u rotas registradas; o limite é HTTP_MAX_ROUTES (%d).\n", (unsigned)route_count, HTTP_MAX_ROUTES);
+        return false;
+    }
+    g_http_routes = routes;
+    g_http_route_count = route_count;
+    g_http_port = port;
+    g_http_backlog = backlog;
+    return http_server_listen();
+}
+
+void http_server_suspend(void) {
+    if (g_http_listen_pcb != NULL) {
+        tcp_close(g_http_listen_pcb); // PCB de escuta: não falha
+        g_http_listen_pcb = NULL;
+    }
+    unsigned aborted = 0;
+    for (int i = 0; i < HTTP_MAX_CONNECTIONS; i++) {
+        if (g_http_conns[i].in_use && g_http_conns[i].pcb != NULL) {
+            http_conn_abort(&g_http_conns[i]);
+            aborted++;
+        }
+    }
+    printf("INFO: Servidor TCP suspenso (%u conexões abortadas).\n", aborted);
+}
+
+bool http_server_resume(void) {
+    return g_http_listen_pcb != NULL || http_server_listen();
+}
@@ -0,0 +1,194 @@
+/**
+ * @file http_server.h
+ * @brief Servidor HTTP/1.1 sobre a API raw da LwIP (callbacks), usado por main.c.
+ *
+ * Cada conexão aceita recebe um slot de um pool fixo (HTTP_MAX_CONNECTIONS), associado ao PCB
+ * via tcp_arg. Um parser incremental lê a requisição byte a byte através da cadeia de pbufs,
+ * então requisições divididas em vários segmentos funcionam. Conexões persistentes (keep-alive)
+ * e requisições em pipeline são suportadas; conexões ociosas são fechadas pelo tcp_poll.
+ *
+ * Admissão: no máximo HTTP_CONN_BUDGET conexões são atendidas ao mesmo tempo, contando as do pool
+ * e as destacadas (SSE, WebSocket). Com o orçamento cheio, uma conexão nova toma o lugar da
+ * keep-alive ociosa há mais tempo (LRU); se nenhuma estiver ociosa, recebe um 503 pré-renderizado
+ * com Retry-After e é fechada, sem slot e sem cópia. Os PCBs além do orçamento (lwipopts.h)
+ * existem para esse 503: as conexões recusadas têm a prioridade mínima, então a LwIP recicla os
+ * PCBs delas antes de qualquer outro quando chega um SYN novo, e os clientes já atendidos nunca
+ * perdem o PCB para uma enxurrada de conexões.
+ *
+ * As rotas são registradas em http_server_init(). Handlers que assumem a conexão de forma
+ * permanente (SSE, WebSocket) chamam http_conn_detach() e passam a instalar seus próprios callbacks.
+ */
+
+#ifndef HTTP_SERVER_H
+#define HTTP_SERVER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "lwip/tcp.h"
+
+// --- Limites (todos estáticos; nada é alocado dinamicamente) ---
+#define HTTP_CONN_BUDGET 4            // Conexões atendidas ao mesmo tempo (pool + destacadas)
+#define HTTP_MAX_CONNECTIONS HTTP_CONN_BUDGET // Slots do pool
+#define HTTP_EVICT_MIN_IDLE_MS 1000   // Keep-alive ociosa há mais que isso pode ceder a vaga (LRU)
+#define HTTP_REJECT_LINGER 4          // Conexão recusada que não fecha em 4 x 500 ms é abortada
+#define HTTP_TX_MEM_RESERVE 1024      // Heap da LwIP que as escritas copiadas deixam livre (bytes)
+#define HTTP_TX_MIN_FREE_SEGS 4       // Segmentos TCP (MEMP_TCP_SEG) livres exigidos antes de escrever
+#define HTTP_MAX_PATH_LEN 63
+#define HTTP_MAX_QUERY_LEN 63
+#define HTTP_MAX_TOKEN_LEN 63         // Valor de cabeçalho guardado (valores maiores são truncados)
+#define HTTP_MAX_HEADER_NAME_LEN 23
+#define HTTP_MAX_HEADER_BYTES 4096    // Linha de requisição + cabeçalhos; acima disso responde 431
+#define HTTP_POLL_INTERVAL 2          // Intervalo do tcp_poll, em unidades de 500 ms (= 1 s)
+#define HTTP_IDLE_TIMEOUT_S 10        // Conexão keep-alive ociosa por mais que isso é fechada
+#define HTTP_MAX_HELD_RESPONSES 4     // Respostas compartilhadas aguardando ACK por conexão (pipeline)
+#define HTTP_STREAM_SCRATCH_LEN 128   // Área onde cada trecho dinâmico de um stream é formatado
+#define HTTP_STREAM_STATE_LEN 16      // Estado do produtor de um stream, guardado na conexão
+#define HTTP_MAX_ROUTES 12            // Rotas com contador próprio de requisições
+
+typedef struct {
+    char method[8];
+    char path[HTTP_MAX_PATH_LEN + 1];
+    char query[HTTP_MAX_QUERY_LEN + 1];     // Sem o '?'
+    char if_none_match[40];
+    char websocket_key[32];
+    bool websocket_upgrade;                 // "Upgrade: websocket"
+    bool keep_alive;                        // Padrão do HTTP/1.1, ou "Connection: keep-alive" no 1.0
+    bool http_1_1;                          // Só clientes HTTP/1.1 recebem corpo chunked
+    bool accept_gzip;                       // "Accept-Encoding" inclui gzip (sem q=0)
+    bool head;                              // Método HEAD: a resposta não leva corpo
+    u32_t content_length;
+} http_request_t;
+
+typedef struct http_conn http_conn_t;
+
+// Resposta pré-renderizada (cabeçalhos + corpo) enviada por referência, sem cópia, a vários
+// clientes. 'data' contém a linha de status e os cabeçalhos (cada um terminado em "\r\n", sem
+// Connection e sem a linha em branco final), seguidos do corpo. O servidor insere o cabeçalho
+// Connection entre as duas partes. Enquanto 'refs' > 0 há bytes dela em voo em alguma conexão
+// e 'data' não pode ser alterado; as referências são devolvidas no tcp_sent (ACK) ou quando a
+// conexão é abortada.
+typedef struct {
+    const char *data;
+    u16_t head_len;
+    u16_t body_len;
+    u16_t refs;
+    u32_t version;              // Livre para o dono do cache (ex.: geração do snapshot)
+} http_shared_response_t;
+
+// Instrumentação: tempo gasto processando requisições desde o último reset.
+typedef struct {
+    uint32_t requests;          // Requisições despachadas
+    uint32_t max_handling_us;   // Pior tempo de uma passagem (recv/sent/poll -> respostas escritas)
+    uint64_t busy_us;           // Soma dos tempos de processamento
+} http_server_stats_t;
+
+// Contadores cumulativos (nunca zerados, para /metrics). 'route_requests' segue a ordem do vetor
+// de rotas; 404, 405 e requisições inválidas contam em 'other_requests'.
+typedef struct {
+    uint32_t route_requests[HTTP_MAX_ROUTES];
+    uint32_t other_requests;
+    uint32_t accepted;          // Conexões aceitas
+    uint32_t accept_failures;   // Erro no accept
+    uint32_t rejected_503;      // Orçamento cheio e nenhuma ociosa: respondido 503 e fechado
+    uint32_t evictions;         // Keep-alive ociosa fechada para dar a vaga a uma conexão nova
+    uint32_t aborts;            // Conexões abortadas pelo servidor (tcp_abort)
+    uint32_t conn_errors;       // tcp_err: conexão resetada ou perdida
+    uint32_t write_errors;      // tcp_write/tcp_output/tcp_close falharam
+    uint32_t sndbuf_full;       // Respostas adiadas por falta de espaço no buffer de envio (ou de memória)
+    uint32_t mem_pressure;      // Escritas adiadas por pouca memória livre na LwIP (heap ou segmentos)
+    uint32_t overflow_500;      // Cabeçalhos não couberam no buffer: respondido 500
+    uint32_t idle_closes;       // Conexões keep-alive fechadas por ociosidade
+} http_server_counters_t;
+
+// Handler de uma rota. Deve escrever exatamente uma resposta com http_send_response() (ou assumir
+// a conexão com http_conn_detach()). Retornar ERR_MEM, sem ter escrito nada, faz o servidor tentar
+// de novo quando houver espaço no buffer de envio.
+typedef err_t (*http_handler_fn)(http_conn_t *conn, const http_request_t *request);
+
+typedef struct {
+    const char *path;
+    http_handler_fn handler;
+} http_route_t;
+
+// Cria o PCB de escuta e registra as rotas (o vetor deve permanecer válido; no máximo
+// HTTP_MAX_ROUTES).
+bool http_server_init(u16_t port, u8_t backlog, const http_route_t *routes, size_t route_count);
+
+// Fecha o PCB de escuta e aborta as conexões ainda no pool (as já destacadas com
+// http_conn_detach() ficam com o dono). Usado quando o enlace cai: com outro IP depois do DHCP,
+// essas conexões só terminariam nos timeouts de retransmissão, ocupando slots e PCBs.
+void http_server_suspend(void);
+
+// Recria o PCB de escuta (com a porta e o backlog de http_server_init) se estiver suspenso.
+bool http_server_resume(void);
+
+// Escreve uma resposta completa. 'extra_headers' (pode ser NULL) contém linhas terminadas em "\r\n".
+// Content-Length e Connection são adicionados aqui. Se 'body_is_static' for verdadeiro, o corpo é
+// enviado por referência e deve viver em flash/memória estática.
+// Retorna ERR_MEM (sem escrever nada) se a resposta não couber agora no buffer de envio.
+err_t http_send_response(http_conn_t *conn, int status, const char *extra_headers,
+                         const char *body, u16_t body_len, bool body_is_static);
+
+// Um trecho do corpo de uma resposta em partes (ver http_send_stream).
+typedef struct {
+    const char *data;
+    u16_t len;
+} http_piece_t;
+
+// Produz o trecho 'index' (0, 1, 2...) do corpo. Trechos em memória estática/flash são enviados
+// por referência; trechos dinâmicos são formatados em 'scratch' (HTTP_STREAM_SCRATCH_LEN bytes) e
+// copiados. 'state' é a cópia, na conexão, do estado passado a http_send_stream().
+// Retorna false quando não há mais trechos.
+typedef bool (*http_stream_fn)(void *state, u32_t index, char *scratch, http_piece_t *out);
+
+// Fim de um stream, chamado uma vez com o 'state' da conexão: corpo escrito por inteiro ou
+// conexão fechada/abortada no meio. Depois dele o produtor não é mais chamado (trechos enviados
+// por referência podem ainda estar em voo).
+typedef void (*http_stream_done_fn)(void *state);
+
+// Inicia uma resposta cujo corpo é gerado trecho a trecho pelo 'producer' e enviado conforme
+// houver espaço (o restante segue a partir do tcp_sent), então o corpo pode ser maior que o
+// TCP_SND_BUF. Com 'content_length' < 0 o tamanho é desconhecido: o corpo vai em chunked
+// (HTTP/1.1) ou delimitado pelo fechamento da conexão (HTTP/1.0). 'state' (até
+// HTTP_STREAM_STATE_LEN bytes) é copiado para a conexão. 'done' (pode ser NULL) só é chamado se
+// o retorno for ERR_OK; sem corpo (HEAD), antes de retornar.
+// Retorna ERR_MEM (sem escrever nada) se nem os cabeçalhos couberem agora.
+err_t http_send_stream(http_conn_t *conn, int status, const char *extra_headers, s32_t content_length,
+                       http_stream_fn producer, http_stream_done_fn done, const void *state, size_t state_len);
+
+// Envia uma resposta compartilhada (ver http_shared_response_t), sem copiar nada para o heap
+// da LwIP. Retorna ERR_MEM (sem escrever nada) se não houver espaço agora.
+err_t http_send_shared_response(http_conn_t *conn, http_shared_response_t *response);
+
+// Copia as estatísticas; com 'reset', zera a janela de medição.
+void http_server_get_stats(http_server_stats_t *out, bool reset);
+
+void http_server_get_counters(http_server_counters_t *out);
+
+// Rotas registradas em http_server_init() (mesma ordem de route_requests).
+const http_route_t *http_server_get_routes(size_t *count);
+
+// Retira a conexão do servidor HTTP e devolve o PCB, sem callbacks instalados, para o chamador.
+// Retorna NULL se respostas compartilhadas anteriores ainda aguardam ACK; o handler deve então
+// retornar ERR_MEM para ser chamado de novo quando elas forem confirmadas.
+// A conexão continua contando no orçamento até o dono encerrá-la com uma das funções abaixo.
+struct tcp_pcb *http_conn_detach(http_conn_t *conn);
+
+// Encerramento de conexões destacadas: removem os callbacks, fecham (FIN; aborta se o tcp_close
+// falhar, retornando ERR_ABRT) ou abortam (RST) o PCB e devolvem a vaga do orçamento. No tcp_err
+// o PCB já foi liberado pela LwIP: o dono só chama http_detached_lost().
+err_t http_detached_close(struct tcp_pcb *tpcb);
+void http_detached_abort(struct tcp_pcb *tpcb);
+void http_detached_lost(void);
+
+// Conexões atendidas agora (pool e destacadas), para /metrics e para limitar os streams.
+void http_server_get_open(u16_t *pooled, u16_t *detached);
+
+// Verdadeiro se a LwIP tem memória para uma escrita que copia 'copy_len' bytes, mantendo
+// HTTP_TX_MEM_RESERVE do heap e HTTP_TX_MIN_FREE_SEGS segmentos livres. Com pouca memória, adiar
+// a escrita (e tentar de novo no ACK ou no poll) evita que o tcp_write falhe no meio de uma
+// resposta e a conexão precise ser abortada.
+bool http_tx_mem_available(u16_t copy_len);
+
+#endif /* HTTP_SERVER_H */
@@ -0,0 +1,201 @@
+#include "input_classifier.h"
+
+#include <string.h>
+
+// Direção a partir da zona de cada eixo (-1, 0, +1). VRy cresce para o norte, VRx para o leste.
+static joystick_direction_t joystick_direction_from_zones(int x_zone, int y_zone) {
+    static const joystick_direction_t directions[3][3] = {
+        //            oeste       centro   leste
+        [0] = { SOUTHWEST, SOUTH,  SOUTHEAST },   // sul
+        [1] = { WEST,      CENTER, EAST },
+        [2] = { NORTHWEST, NORTH,  NORTHEAST },   // norte
+    };
+    return directions[y_zone + 1][x_zone + 1];
+}
+
+static int joystick_zone(int32_t offset, int32_t deadzone) {
+    return (offset > deadzone) ? 1 : (offset < -deadzone) ? -1 : 0;
+}
+
+joystick_direction_t joystick_classify(const joystick_config_t *config, uint16_t vrx, uint16_t vry) {
+    return joystick_direction_from_zones(joystick_zone((int32_t)vrx - config->center_vrx, config->deadzone),
+                                         joystick_zone((int32_t)vry - config->center_vry, config->deadzone));
+}
+
+static void joystick_axis_init(joystick_axis_t *axis, uint16_t center) {
+    memset(axis, 0, sizeof(*axis));
+    axis->center = center;
+    axis->value = center;
+    axis->travel_low = JOYSTICK_TRAVEL_MIN;
+    axis->travel_high = JOYSTICK_TRAVEL_MIN;
+    axis->calib_min = UINT16_MAX;
+}
+
+void joystick_filter_init(joystick_filter_t *filter, const joystick_config_t *config) {
+    filter->config = *config;
+    if (filter->config.median_len > JOYSTICK_MEDIAN_MAX) {
+        filter->config.median_len = JOYSTICK_MEDIAN_MAX;
+    }
+    joystick_axis_init(&filter->axis[0], config->center_vrx);
+    joystick_axis_init(&filter->axis[1], config->center_vry);
+    filter->calib_count = 0;
+    filter->calibrated = (config->calib_samples == 0);
+    filter->calib_restarts = 0;
+}
+
+// Mediana das últimas 'len' leituras (ordenação por inserção de no máximo 5 valores).
+static uint16_t joystick_axis_median(joystick_axis_t *axis, uint16_t raw, uint8_t len) {
+    if (len <= 1) {
+        return raw;
+    }
+    axis->window[axis->window_next] = raw;
+    axis->window_next = (uint8_t)((axis->window_next + 1) % len);
+    if (axis->window_count < len) {
+        axis->window_count++;
+    }
+    uint16_t sorted[JOYSTICK_MEDIAN_MAX];
+    uint8_t n = axis->window_count;
+    for (uint8_t i = 0; i < n; i++) {
+        uint16_t v = axis->window[i];
+        uint8_t j = i;
+        for (; j > 0 && sorted[j - 1] > v; j--) {
+            sorted[j] = sorted[j - 1];
+        }
+        sorted[j] = v;
+    }
+    return sorted[n / 2];
+}
+
+static uint16_t joystick_axis_filter(joystick_axis_t *axis, const joystick_config_t *config, uint16_t raw) {
+    uint16_t x = joystick_axis_median(axis, raw, config->median_len);
+    if (config->iir_shift == 0) {
+        return x;
+    }
+    int32_t x_q8 = (int32_t)x << 8;
+    if (!axis->iir_primed) {
+        axis->iir_q8 = x_q8;
+        axis->iir_primed = true;
+    } else {
+        axis->iir_q8 += (x_q8 - axis->iir_q8) >> config->iir_shift; // Deslocamento aritmético (GCC/ARM)
+    }
+    return (uint16_t)((axis->iir_q8 + 128) >> 8);
+}
+
+// Zona do eixo com histerese: para mudar, a leitura precisa cruzar o limiar com folga de
+// 'hysteresis' (os dois proporcionais ao curso daquele lado).
+static int joystick_axis_zone(joystick_axis_t *axis, const joystick_config_t *config, bool learn_travel) {
+    int32_t offset = (int32_t)axis->value - axis->center;
+    if (learn_travel) {
+        if (offset > axis->travel_high) axis->travel_high = (uint16_t)offset;
+        if (-offset > axis->travel_low) axis->travel_low = (uint16_t)-offset;
+    }
+    // Com o curso ainda curto (JOYSTICK_TRAVEL_MIN), o limiar de entrada escalado ficaria abaixo da
+    // própria zona morta; ele nunca entra antes dela.
+    int32_t enter_high = (int32_t)(((uint32_t)config->deadzone + config->hysteresis) * axis->travel_high / JOYSTICK_TRAVEL_NOMINAL);
+    if (enter_high < config->deadzone) enter_high = config->deadzone;
+    int32_t leave_high = (int32_t)config->deadzone - config->hysteresis;
+    leave_high = leave_high * axis->travel_high / JOYSTICK_TRAVEL_NOMINAL;
+    int32_t enter_low = (int32_t)(((uint32_t)config->deadzone + config->hysteresis) * axis->travel_low / JOYSTICK_TRAVEL_NOMINAL);
+    if (enter_low < config->deadzone) enter_low = config->deadzone;
+    int32_t leave_low = (int32_t)config->deadzone - config->hysteresis;
+    leave_low = leave_low * axis->travel_low / JOYSTICK_TRAVEL_NOMINAL;
+
+    if (offset > enter_high) {
+        axis->zone = 1;
+    } else if (offset < -enter_low) {
+        axis->zone = -1;
+    } else if ((axis->zone > 0 && offset < leave_high) || (axis->zone < 0 && offset > -leave_low)) {
+        axis->zone = 0;
+    }
+    return axis->zone;
+}
+
+// Acumula o centro enquanto o joystick está em repouso; movimento demais recomeça a contagem.
+// Depois de JOYSTICK_CALIB_MAX_RESTARTS recomeços desiste e fica com o centro configurado, para
+// que um joystick mexido (ou travado fora do centro) no boot não deixe a calibração aberta.
+static void joystick_filter_calibrate(joystick_filter_t *filter) {
+    bool moved = false;
+    for (int i = 0; i < 2; i++) {
+        joystick_axis_t *axis = &filter->axis[i];
+        axis->calib_sum += axis->value;
+        if (axis->value < axis->calib_min) axis->calib_min = axis->value;
+        if (axis->value > axis->calib_max) axis->calib_max = axis->value;
+        moved |= (axis->calib_max - axis->calib_min) > JOYSTICK_CALIB_MAX_SPREAD;
+    }
+    if (moved) {
+        for (int i = 0; i < 2; i++) {
+            filter->axis[i].calib_sum = 0;
+            filter->axis[i].calib_min = UINT16_MAX;
+            filter->axis[i].calib_max = 0;
+        }
+        filter->calib_count = 0;
+        if (++filter->calib_restarts >= JOYSTICK_CALIB_MAX_RESTARTS) {
+            filter->calibrated = true; // axis[].center continua o de config
+        }
+        return;
+    }
+    if (++filter->calib_count >= filter->config.calib_samples) {
+        for (int i = 0; i < 2; i++) {
+            filter->axis[i].center = (uint16_t)(filter->axis[i].calib_sum / filter->calib_count);
+        }
+        filter->calibrated = true;
+    }
+}
+
+joystick_direction_t joystick_filter_update(joystick_filter_t *filter, uint16_t vrx, uint16_t vry,
+                                            uint16_t *vrx_out, uint16_t *vry_out) {
+    filter->axis[0].value = joystick_axis_filter(&filter->axis[0], &filter->config, vrx);
+    filter->axis[1].value = joystick_axis_filter(&filter->axis[1], &filter->config, vry);
+    if (!filter->calibrated) {
+        joystick_filter_calibrate(filter);
+    }
+    *vrx_out = filter->axis[0].value;
+    *vry_out = filter->axis[1].value;
+    return joystick_direction_from_zones(joystick_axis_zone(&filter->axis[0], &filter->config, filter->calibrated),
+                                         joystick_axis_zone(&filter->axis[1], &filter->config, filter->calibrated));
+}
+
+uint16_t joystick_filter_wake_radius(const joystick_filter_t *filter) {
+    const joystick_config_t *config = &filter->config;
+    int32_t band = (int32_t)config->deadzone - config->hysteresis;
+    uint16_t travel = JOYSTICK_TRAVEL_NOMINAL;
+    for (int i = 0; i < 2; i++) {
+        if (filter->axis[i].travel_low < travel) travel = filter->axis[i].travel_low;
+        if (filter->axis[i].travel_high < travel) travel = filter->axis[i].travel_high;
+    }
+    int32_t radius = band * travel / JOYSTICK_TRAVEL_NOMINAL;
+    return (uint16_t)(radius > 1 ? radius : 1);
+}
+
+void button_debounce_init(button_debounce_t *debounce, bool pressed) {
+    debounce->stable_pressed = pressed;
+    debounce->debouncing = false;
+    debounce->edge_time_us = 0;
+    debounce->pressed_at_us = 0;
+}
+
+bool button_debounce_edge(button_debounce_t *debounce, uint64_t now_us) {
+    if (debounce->debouncing) {
+        return false;
+    }
+    debounce->debouncing = true;
+    debounce->edge_time_us = now_us;
+    return true;
+}
+
+bool button_debounce_settle(button_debounce_t *debounce, bool pressed, button_debounce_event_t *event) {
+    debounce->debouncing = false;
+    if (pressed == debounce->stable_pressed) {
+        return false;
+    }
+    debounce->stable_pressed = pressed;
+    event->pressed = pressed;
+    event->timestamp_us = debounce->edge_time_us;
+    if (pressed) {
+        debounce->pressed_at_us = debounce->edge_time_us;
+        event->duration_us = 0;
+    } else {
+        event->duration_us = (uint32_t)(debounce->edge_time_us - debounce->pressed_at_us);
+    }
+    return true;
+}
@@ -0,0 +1,119 @@
+/**
+ * @file input_classifier.h
+ * @brief Lógica pura de classificação das entradas: direção do joystick a partir das leituras do
+ * ADC e debounce dos botões a partir das bordas no pino.
+ *
+ * Não depende do SDK nem do relógio: quem chama informa as leituras e os instantes. O firmware
+ * usa estas funções no núcleo 1 (main.c e button_events.c) e o host/input_replay.c as usa para
+ * reprocessar um trace gravado na placa (input_trace.h) com exatamente as mesmas decisões.
+ *
+ * O firmware classifica com o condicionamento de joystick_filter_update(): por eixo, mediana
+ * (descarta picos isolados) e IIR de 1ª ordem em ponto fixo (suaviza o ruído), centro medido no
+ * boot com o joystick em repouso, curso de cada lado aprendido com o uso e limiares com histerese,
+ * para que uma leitura parada perto do limiar não fique alternando de direção. A média das
+ * conversões (oversampling) vem antes, em adc_sampler_take_mean(). joystick_classify() é a
+ * classificação instantânea, sem estado, usada como referência pelo input_replay.
+ */
+
+#ifndef INPUT_CLASSIFIER_H
+#define INPUT_CLASSIFIER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "input_state.h"
+
+#define INPUT_ADC_MAX_VALUE 4095
+#define JOYSTICK_CENTER_DEFAULT (INPUT_ADC_MAX_VALUE / 2)
+#define JOYSTICK_DEADZONE_DEFAULT 300
+#define JOYSTICK_HYSTERESIS_DEFAULT 40     // Entra em zona morta + 40 e sai em zona morta - 40
+#define JOYSTICK_MEDIAN_DEFAULT 3
+#define JOYSTICK_IIR_SHIFT_DEFAULT 2       // y += (x - y) / 4: constante de tempo de ~4 amostras
+#define JOYSTICK_CALIB_DEFAULT 100         // 0,5 s no modo rajada (200 Hz, sample_scheduler.h)
+
+#define JOYSTICK_MEDIAN_MAX 5
+#define JOYSTICK_TRAVEL_NOMINAL 2047       // Curso de cada lado a que zona morta e histerese se referem
+#define JOYSTICK_TRAVEL_MIN 1536           // Curso assumido até o joystick ser levado mais longe
+#define JOYSTICK_CALIB_MAX_SPREAD 96       // Variação acima disso na calibração: joystick em uso, recomeça
+#define JOYSTICK_CALIB_MAX_RESTARTS 50     // Recomeços até desistir e ficar com o centro configurado
+
+typedef struct {
+    uint16_t center_vrx;       // Centro até a calibração terminar (e sempre, com calib_samples = 0)
+    uint16_t center_vry;
+    uint16_t deadzone;         // Distância do centro abaixo da qual o eixo conta como parado
+    uint16_t hysteresis;       // Meia-largura da banda em torno do limiar
+    uint8_t median_len;        // 1 (desligada), 3 ou 5 amostras
+    uint8_t iir_shift;         // 0 = IIR desligado
+    uint16_t calib_samples;    // Amostras em repouso para medir o centro no boot; 0 = centro fixo
+} joystick_config_t;
+
+#define JOYSTICK_CONFIG_DEFAULT { JOYSTICK_CENTER_DEFAULT, JOYSTICK_CENTER_DEFAULT, JOYSTICK_DEADZONE_DEFAULT, \
+                                  JOYSTICK_HYSTERESIS_DEFAULT, JOYSTICK_MEDIAN_DEFAULT, JOYSTICK_IIR_SHIFT_DEFAULT, \
+                                  JOYSTICK_CALIB_DEFAULT }
+
+// Direção (8 pontos ou CENTER) de uma leitura isolada, com o centro e a zona morta fixos de
+// 'config' (sem filtro, calibração nem histerese).
+joystick_direction_t joystick_classify(const joystick_config_t *config, uint16_t vrx, uint16_t vry);
+
+// Estado de um eixo no condicionamento.
+typedef struct {
+    uint16_t window[JOYSTICK_MEDIAN_MAX];  // Últimas leituras, para a mediana
+    uint8_t window_count;
+    uint8_t window_next;
+    bool iir_primed;
+    int32_t iir_q8;            // Saída do IIR em 1/256 de contagem
+    uint16_t value;            // Última saída filtrada
+    uint16_t center;
+    uint16_t travel_low;       // Maior distância já vista abaixo do centro (>= JOYSTICK_TRAVEL_MIN)
+    uint16_t travel_high;      // Idem, acima
+    int8_t zone;               // -1, 0 ou +1 (com histerese)
+    uint32_t calib_sum;
+    uint16_t calib_min;
+    uint16_t calib_max;
+} joystick_axis_t;
+
+typedef struct {
+    joystick_config_t config;
+    joystick_axis_t axis[2];   // VRx, VRy
+    uint16_t calib_count;
+    bool calibrated;           // Centro medido (ou fixo, com calib_samples = 0)
+    uint32_t calib_restarts;   // Calibrações recomeçadas por movimento do joystick (até JOYSTICK_CALIB_MAX_RESTARTS)
+} joystick_filter_t;
+
+void joystick_filter_init(joystick_filter_t *filter, const joystick_config_t *config);
+
+// Condiciona uma leitura e devolve a direção. '*vrx_out'/'*vry_out' recebem os valores filtrados.
+joystick_direction_t joystick_filter_update(joystick_filter_t *filter, uint16_t vrx, uint16_t vry,
+                                            uint16_t *vrx_out, uint16_t *vry_out);
+
+// Distância do centro abaixo da qual nenhum eixo sai do CENTER, com folga (limiar menor da
+// histerese e o menor curso aprendido). Raio para adc_sampler_watch().
+uint16_t joystick_filter_wake_radius(const joystick_filter_t *filter);
+
+// Debounce de um botão. Uma borda abre uma janela de 'debounce_us'; as bordas seguintes dentro
+// dela são repique e não mudam nada. No fim da janela o nível lido é comparado com o último
+// confirmado: se mudou, vira um evento com o instante da primeira borda.
+typedef struct {
+    bool stable_pressed;       // Último nível confirmado
+    bool debouncing;           // Janela aberta (o chamador tem um prazo pendente para settle)
+    uint64_t edge_time_us;     // Primeira borda da janela
+    uint64_t pressed_at_us;    // Para calcular a duração na soltura
+} button_debounce_t;
+
+typedef struct {
+    bool pressed;
+    uint64_t timestamp_us;     // Instante da borda que originou o evento
+    uint32_t duration_us;      // Na soltura: quanto tempo o botão ficou pressionado
+} button_debounce_event_t;
+
+void button_debounce_init(button_debounce_t *debounce, bool pressed);
+
+// Borda em 'now_us'. Retorna true se abriu uma janela: o chamador deve chamar
+// button_debounce_settle() com o nível do pino em now_us + debounce. False = repique ignorado.
+bool button_debounce_edge(button_debounce_t *debounce, uint64_t now_us);
+
+// Fim da janela com o nível atual do pino. Retorna true (e preenche 'event') se o nível
+// confirmado mudou; se voltou ao anterior dentro da janela, foi só ruído.
+bool button_debounce_settle(button_debounce_t *debounce, bool pressed, button_debounce_event_t *event);
+
+#endif /* INPUT_CLASSIFIER_H */
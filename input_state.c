@@ -0,0 +1,43 @@
+#include "input_state.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+// Barreira de memória completa (DMB no Cortex-M0+). Também impede o compilador de reordenar
+// os acessos ao snapshot em torno do contador.
+#define INPUT_STATE_BARRIER() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+static volatile uint32_t g_sequence = 0; // Ímpar = escrita em andamento
+static input_snapshot_t g_snapshot;
+
+// Direção ou botões diferentes do snapshot anterior (só o escritor chama, sem corrida).
+static bool input_state_changed(const input_snapshot_t *previous, const input_snapshot_t *next) {
+    return previous->direction != next->direction
+        || previous->button_state_bits != next->button_state_bits
+        || previous->button_event_count != next->button_event_count
+        || previous->last_button != next->last_button;
+}
+
+void input_state_publish(const input_snapshot_t *snapshot) {
+    uint32_t seq = g_sequence;
+    g_sequence = seq + 1;
+    INPUT_STATE_BARRIER();
+    uint32_t generation = g_snapshot.generation + 1;
+    uint32_t change_generation = g_snapshot.change_generation + (input_state_changed(&g_snapshot, snapshot) ? 1 : 0);
+    memcpy(&g_snapshot, snapshot, sizeof(g_snapshot));
+    g_snapshot.generation = generation;
+    g_snapshot.change_generation = change_generation;
+    INPUT_STATE_BARRIER();
+    g_sequence = seq + 2;
+}
+
+void input_state_read(input_snapshot_t *out) {
+    uint32_t seq_before, seq_after;
+    do {
+        seq_before = g_sequence;
+        INPUT_STATE_BARRIER();
+        memcpy(out, &g_snapshot, sizeof(*out));
+        INPUT_STATE_BARRIER();
+        seq_after = g_sequence;
+    } while ((seq_before & 1u) != 0 || seq_before != seq_after);
+}
@@ -0,0 +1,46 @@
+/**
+ * @file input_state.h
+ * @brief Estado das entradas (joystick, botões, temperatura) compartilhado entre os dois núcleos.
+ *
+ * O núcleo 1 amostra e classifica as entradas e publica um snapshot versionado; o núcleo 0
+ * (LwIP/HTTP) apenas lê. A troca usa um seqlock: o escritor torna o contador ímpar durante a
+ * escrita e o leitor repete a cópia se o contador mudou ou estava ímpar. Nenhum lado bloqueia o
+ * outro e o leitor nunca vê um snapshot "rasgado" (ex.: VRx novo com direção antiga).
+ *
+ * Há um único escritor (núcleo 1). Qualquer contexto pode ler, inclusive callbacks da LwIP.
+ */
+
+#ifndef INPUT_STATE_H
+#define INPUT_STATE_H
+
+#include <stdint.h>
+
+typedef enum {
+    CENTER, NORTH, NORTHEAST, EAST, SOUTHEAST, SOUTH, SOUTHWEST, WEST, NORTHWEST
+} joystick_direction_t;
+
+typedef enum {
+    NO_BUTTON_PRESSED_YET, BUTTON_A_EVENT, BUTTON_B_EVENT
+} button_event_type_t;
+
+typedef struct {
+    uint32_t generation;                // Incrementado a cada publicação
+    uint32_t change_generation;         // Incrementado quando direção ou botões mudam (não os eixos)
+    uint64_t timestamp_us;              // Momento da amostra (time_us_64)
+    uint16_t vrx;
+    uint16_t vry;
+    uint16_t temp_raw;                  // Leitura bruta do ADC4 (sensor interno)
+    joystick_direction_t direction;
+    button_event_type_t last_button;
+    uint32_t button_event_count;        // Incrementado a cada pressionamento (A ou B)
+    uint8_t button_state_bits;          // Nível atual: bit0 = A pressionado, bit1 = B pressionado
+} input_snapshot_t;
+
+// Publica um novo snapshot (somente o núcleo de aquisição). 'generation' e 'change_generation'
+// são preenchidos aqui: quem só reage a mudanças discretas compara 'change_generation'.
+void input_state_publish(const input_snapshot_t *snapshot);
+
+// Copia o snapshot mais recente, sem travas.
+void input_state_read(input_snapshot_t *out);
+
+#endif /* INPUT_STATE_H */
@@ -0,0 +1,164 @@
+#include "input_trace.h"
+
+#if INPUT_TRACE_ENABLED
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "button_events.h"
+#include "input_trace_codec.h"
+
+#define INPUT_TRACE_BARRIER() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define INPUT_TRACE_MASK (INPUT_TRACE_BLOCKS - 1)
+#define INPUT_TRACE_EDGE_BATCH 8
+
+_Static_assert(INPUT_TRACE_BLOCK_LEN <= HTTP_STREAM_SCRATCH_LEN, "um bloco por trecho de /record");
+
+static uint8_t g_blocks[INPUT_TRACE_BLOCKS][INPUT_TRACE_BLOCK_LEN];
+static volatile uint32_t g_latest_seq = 0;       // Último bloco fechado (0 = nenhum)
+static volatile input_trace_stats_t g_stats;
+
+// Bloco aberto (só o núcleo 1 acessa).
+static input_trace_writer_t g_writer;
+static uint64_t g_block_t0_us;
+static bool g_started = false;
+static uint32_t g_edge_cursor = 0;
+
+static uint32_t input_trace_block_seq(const uint8_t *block) {
+    return block[4] | ((uint32_t)block[5] << 8) | ((uint32_t)block[6] << 16) | ((uint32_t)block[7] << 24);
+}
+
+// Abre o bloco seguinte ao último fechado. A sequência do slot é zerada antes de qualquer outra
+// escrita, para que um leitor copiando o bloco antigo perceba a reescrita.
+static void input_trace_open_block(uint64_t t0_us, uint8_t buttons, const uint16_t adc[3]) {
+    uint32_t seq = g_latest_seq + 1;
+    uint8_t *block = g_blocks[seq & INPUT_TRACE_MASK];
+    memset(block + 4, 0, 4);
+    INPUT_TRACE_BARRIER();
+    input_trace_block_start(&g_writer, block, seq, t0_us, buttons, adc);
+    INPUT_TRACE_BARRIER();
+    g_block_t0_us = t0_us;
+}
+
+// Publica o bloco aberto e abre o próximo a partir do estado atual do escritor.
+static void input_trace_rotate(uint64_t t0_us) {
+    INPUT_TRACE_BARRIER();
+    g_latest_seq = g_latest_seq + 1;
+    g_stats.blocks++;
+    input_trace_open_block(t0_us, g_writer.buttons, g_writer.adc);
+}
+
+static void input_trace_put_edge_record(const button_event_t *edge) {
+    if (!input_trace_put_edge(&g_writer, edge->timestamp_us, edge->button, edge->pressed)) {
+        input_trace_rotate(edge->timestamp_us);
+        input_trace_put_edge(&g_writer, edge->timestamp_us, edge->button, edge->pressed);
+    }
+    g_stats.edges++;
+}
+
+// Bordas com timestamp até 'until_us', em ordem; as posteriores ficam para o próximo ciclo.
+static void input_trace_drain_edges(uint64_t until_us) {
+    button_event_t edges[INPUT_TRACE_EDGE_BATCH];
+    size_t count;
+    while ((count = button_events_read_edges_since(g_edge_cursor, edges, INPUT_TRACE_EDGE_BATCH)) > 0) {
+        for (size_t i = 0; i < count; i++) {
+            if (edges[i].timestamp_us > until_us) {
+                return;
+            }
+            if (edges[i].seq != g_edge_cursor + 1) {
+                g_stats.edges_lost += edges[i].seq - g_edge_cursor - 1;
+            }
+            g_edge_cursor = edges[i].seq;
+            input_trace_put_edge_record(&edges[i]);
+        }
+        if (count < INPUT_TRACE_EDGE_BATCH) break;
+    }
+}
+
+void input_trace_init(void) {
+    button_events_capture_edges(true);
+}
+
+void input_trace_add(uint64_t timestamp_us, const adc_sampler_values_t *adc_values) {
+    const uint16_t adc[3] = { adc_values->vrx, adc_values->vry, adc_values->temp_raw };
+    if (!g_started) {
+        // Nível dos pinos antes da primeira borda gravada; as anteriores já estão nele
+        g_edge_cursor = button_events_latest_edge_seq();
+        input_trace_open_block(timestamp_us, button_events_raw_levels(), adc);
+        g_started = true;
+    }
+
+    input_trace_drain_edges(timestamp_us);
+    if (!input_trace_put_adc(&g_writer, timestamp_us, adc)) {
+        input_trace_rotate(timestamp_us);
+        input_trace_put_adc(&g_writer, timestamp_us, adc);
+    }
+    g_stats.samples++;
+
+    if (timestamp_us - g_block_t0_us >= INPUT_TRACE_FLUSH_MS * 1000ull) {
+        input_trace_rotate(timestamp_us);
+    }
+}
+
+void input_trace_get_stats(input_trace_stats_t *out) {
+    out->blocks = g_stats.blocks;
+    out->samples = g_stats.samples;
+    out->edges = g_stats.edges;
+    out->edges_lost = g_stats.edges_lost;
+}
+
+// Copia o bloco 'seq'. Retorna false se ele já foi sobrescrito (ou ainda não foi fechado).
+static bool input_trace_read(uint32_t seq, uint8_t *out) {
+    if (seq == 0 || seq > g_latest_seq) {
+        return false;
+    }
+    const uint8_t *block = g_blocks[seq & INPUT_TRACE_MASK];
+    uint32_t seq_before = input_trace_block_seq(block);
+    INPUT_TRACE_BARRIER();
+    memcpy(out, block, INPUT_TRACE_BLOCK_LEN);
+    INPUT_TRACE_BARRIER();
+    return seq_before == seq && input_trace_block_seq(block) == seq;
+}
+
+// --- GET /record ---
+
+typedef struct {
+    uint32_t next;       // Próximo bloco a enviar
+    uint32_t last;       // Último bloco desta resposta (fixado na requisição)
+} input_trace_stream_state_t;
+
+// Um bloco por trecho; os sobrescritos desde a requisição são pulados.
+static bool input_trace_stream_piece(void *state, u32_t index, char *scratch, http_piece_t *out) {
+    input_trace_stream_state_t *st = (input_trace_stream_state_t *)state;
+    while (st->next <= st->last) {
+        if (input_trace_read(st->next++, (uint8_t *)scratch)) {
+            out->data = scratch;
+            out->len = INPUT_TRACE_BLOCK_LEN;
+            return true;
+        }
+    }
+    return false;
+}
+
+err_t input_trace_serve(http_conn_t *conn, const http_request_t *request) {
+    uint32_t from = 0;
+    const char *from_param = strstr(request->query, "from=");
+    if (from_param != NULL) {
+        from = (uint32_t)strtoul(from_param + 5, NULL, 10);
+    }
+
+    // Fixa o intervalo da resposta: o que for fechado depois fica para o próximo 'from'
+    input_trace_stream_state_t state = { .next = from, .last = g_latest_seq };
+    // O bloco aberto ocupa o slot do mais antigo: restam INPUT_TRACE_BLOCKS - 1 fechados
+    uint32_t oldest = (state.last >= INPUT_TRACE_BLOCKS) ? state.last - INPUT_TRACE_BLOCKS + 2 : 1;
+    // 'from' à frente do próximo bloco: o cliente vem de antes de um reinício da placa
+    if (state.next < oldest || state.next > state.last + 1) {
+        state.next = oldest;
+    }
+    return http_send_stream(conn, 200,
+                            "Content-Type: application/octet-stream\r\nCache-Control: no-store\r\n"
+                            "Access-Control-Allow-Origin: *\r\n",
+                            -1, input_trace_stream_piece, NULL, &state, sizeof(state));
+}
+
+#endif /* INPUT_TRACE_ENABLED */
@@ -0,0 +1,67 @@
+/**
+ * @file input_trace.h
+ * @brief Gravação das entradas brutas (ADC e bordas dos botões) num trace binário compacto, para
+ * reprodução determinística no host (host/input_replay.c).
+ *
+ * A cada ciclo o núcleo 1 grava as médias do ADC que entram no filtro do joystick (antes da
+ * mediana, do IIR e da calibração, que o host refaz com input_classifier.c) e as bordas brutas
+ * dos botões vistas pela IRQ até aquele instante (button_events_capture_edges), no formato de
+ * input_trace_codec.h. O bloco aberto é fechado quando enche ou após INPUT_TRACE_FLUSH_MS e entra
+ * num anel de INPUT_TRACE_BLOCKS blocos com um único produtor e leitores não destrutivos, como o
+ * de history.c: o bloco é invalidado antes de ser reescrito e o leitor descarta a cópia se a
+ * sequência mudou durante a leitura.
+ *
+ * GET /record?from=<sequência> devolve (application/octet-stream) os blocos fechados com
+ * sequência >= 'from', do mais antigo ao mais novo. Para continuar, use a sequência do último
+ * bloco + 1; uma lacuna na sequência é um trecho que o anel já descartou. Um 'from' além do
+ * próximo bloco (a placa reiniciou) recomeça do mais antigo.
+ *
+ * Com INPUT_TRACE_ENABLED = 0 (ver CMakeLists.txt) as chamadas viram nada, a captura de bordas
+ * fica desligada e a rota /record não é registrada.
+ */
+
+#ifndef INPUT_TRACE_H
+#define INPUT_TRACE_H
+
+#ifndef INPUT_TRACE_ENABLED
+#define INPUT_TRACE_ENABLED 1
+#endif
+
+#include <stdint.h>
+
+// 64 blocos de 128 bytes (8 KB): ~1 min com as entradas paradas (amostragem ociosa, um bloco por
+// INPUT_TRACE_FLUSH_MS), ~5 s em uso (rajada de 200 Hz).
+#define INPUT_TRACE_BLOCKS 64          // Potência de 2
+#define INPUT_TRACE_FLUSH_MS 1000      // Atraso máximo até um registro aparecer em /record
+
+typedef struct {
+    uint32_t blocks;           // Blocos fechados
+    uint32_t samples;          // Registros de ADC
+    uint32_t edges;            // Registros de borda
+    uint32_t edges_lost;       // Bordas sobrescritas no anel de button_events.c antes da gravação
+} input_trace_stats_t;
+
+#if INPUT_TRACE_ENABLED
+
+#include "adc_sampler.h"
+#include "http_server.h"
+
+// Liga a captura de bordas. Chamar no núcleo 1, depois de button_events_init().
+void input_trace_init(void);
+
+// Grava as bordas até 'timestamp_us' e depois a amostra de ADC (somente o núcleo 1).
+void input_trace_add(uint64_t timestamp_us, const adc_sampler_values_t *adc);
+
+void input_trace_get_stats(input_trace_stats_t *out);
+
+// Handler da rota /record.
+err_t input_trace_serve(http_conn_t *conn, const http_request_t *request);
+
+#else
+
+#define input_trace_init() ((void)0)
+#define input_trace_add(timestamp_us, adc) ((void)0)
+
+#endif /* INPUT_TRACE_ENABLED */
+
+#endif /* INPUT_TRACE_H */
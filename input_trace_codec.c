@@ -0,0 +1,178 @@
+#include "input_trace_codec.h"
+
+#include <string.h>
+
+static void put_u16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    put_u16(p, (uint16_t)v);
+    put_u16(p + 2, (uint16_t)(v >> 16));
+}
+
+static uint16_t get_u16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    return get_u16(p) | ((uint32_t)get_u16(p + 2) << 16);
+}
+
+static uint8_t put_varint(uint8_t *p, uint32_t v) {
+    uint8_t n = 0;
+    while (v >= 0x80) {
+        p[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    p[n++] = (uint8_t)v;
+    return n;
+}
+
+// Lê um varint de até 4 bytes sem passar de 'end'. Retorna false se truncado ou longo demais.
+static bool get_varint(const uint8_t *block, uint8_t *pos, uint8_t end, uint32_t *out) {
+    uint32_t v = 0;
+    for (int shift = 0; shift < 28; shift += 7) {
+        if (*pos >= end) {
+            return false;
+        }
+        uint8_t byte = block[(*pos)++];
+        v |= (uint32_t)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            *out = v;
+            return true;
+        }
+    }
+    return false;
+}
+
+static uint32_t zigzag(int32_t v) {
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static int32_t unzigzag(uint32_t v) {
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+// Cabeçalho do registro (dt e tipo). Retorna 0 se o tempo recua ou salta demais.
+static uint8_t put_record_head(input_trace_writer_t *writer, uint8_t *p, uint64_t timestamp_us, input_trace_kind_t kind) {
+    if (timestamp_us < writer->last_us || timestamp_us - writer->last_us >= INPUT_TRACE_MAX_DT_US) {
+        return 0;
+    }
+    return put_varint(p, ((uint32_t)(timestamp_us - writer->last_us) << 1) | (uint32_t)kind);
+}
+
+void input_trace_block_start(input_trace_writer_t *writer, uint8_t *block, uint32_t sequence,
+                             uint64_t t0_us, uint8_t buttons, const uint16_t adc[3]) {
+    block[0] = 'I';
+    block[1] = 'T';
+    block[2] = INPUT_TRACE_VERSION;
+    block[3] = buttons;
+    put_u32(block + 4, sequence);
+    put_u32(block + 8, (uint32_t)t0_us);
+    put_u32(block + 12, (uint32_t)(t0_us >> 32));
+    block[16] = 0;
+    block[17] = 0;
+    for (int ch = 0; ch < 3; ch++) {
+        put_u16(block + 18 + 2 * ch, adc[ch]);
+        writer->adc[ch] = adc[ch];
+    }
+    writer->block = block;
+    writer->used = 0;
+    writer->last_us = t0_us;
+    writer->buttons = buttons;
+}
+
+bool input_trace_put_adc(input_trace_writer_t *writer, uint64_t timestamp_us, const uint16_t adc[3]) {
+    if (INPUT_TRACE_HEADER_LEN + writer->used + INPUT_TRACE_RECORD_MAX > INPUT_TRACE_BLOCK_LEN) {
+        return false;
+    }
+    uint8_t *p = writer->block + INPUT_TRACE_HEADER_LEN + writer->used;
+    uint8_t n = put_record_head(writer, p, timestamp_us, INPUT_TRACE_ADC);
+    if (n == 0) {
+        return false;
+    }
+    for (int ch = 0; ch < 3; ch++) {
+        n += put_varint(p + n, zigzag((int32_t)adc[ch] - writer->adc[ch]));
+        writer->adc[ch] = adc[ch];
+    }
+    writer->used += n;
+    writer->block[16] = writer->used;
+    writer->last_us = timestamp_us;
+    return true;
+}
+
+bool input_trace_put_edge(input_trace_writer_t *writer, uint64_t timestamp_us, uint8_t button, bool pressed) {
+    if (INPUT_TRACE_HEADER_LEN + writer->used + INPUT_TRACE_RECORD_MAX > INPUT_TRACE_BLOCK_LEN) {
+        return false;
+    }
+    uint8_t *p = writer->block + INPUT_TRACE_HEADER_LEN + writer->used;
+    uint8_t n = put_record_head(writer, p, timestamp_us, INPUT_TRACE_GPIO);
+    if (n == 0) {
+        return false;
+    }
+    p[n++] = (uint8_t)((button << 1) | (pressed ? 1 : 0));
+    writer->used += n;
+    writer->block[16] = writer->used;
+    writer->last_us = timestamp_us;
+    if (pressed) {
+        writer->buttons |= (uint8_t)(1u << button);
+    } else {
+        writer->buttons &= (uint8_t)~(1u << button);
+    }
+    return true;
+}
+
+bool input_trace_block_open(input_trace_reader_t *reader, const uint8_t *block, uint32_t *sequence,
+                            uint8_t *buttons) {
+    if (block[0] != 'I' || block[1] != 'T' || block[2] != INPUT_TRACE_VERSION ||
+        block[16] > INPUT_TRACE_BLOCK_LEN - INPUT_TRACE_HEADER_LEN) {
+        return false;
+    }
+    *sequence = get_u32(block + 4);
+    *buttons = block[3];
+    reader->block = block;
+    reader->pos = INPUT_TRACE_HEADER_LEN;
+    reader->end = (uint8_t)(INPUT_TRACE_HEADER_LEN + block[16]);
+    reader->last_us = get_u32(block + 8) | ((uint64_t)get_u32(block + 12) << 32);
+    for (int ch = 0; ch < 3; ch++) {
+        reader->adc[ch] = get_u16(block + 18 + 2 * ch);
+    }
+    return true;
+}
+
+int input_trace_next(input_trace_reader_t *reader, input_trace_record_t *out) {
+    if (reader->pos >= reader->end) {
+        return 0;
+    }
+    uint32_t head;
+    if (!get_varint(reader->block, &reader->pos, reader->end, &head)) {
+        return -1;
+    }
+    memset(out, 0, sizeof(*out));
+    reader->last_us += head >> 1;
+    out->timestamp_us = reader->last_us;
+    out->kind = (input_trace_kind_t)(head & 1);
+
+    if (out->kind == INPUT_TRACE_GPIO) {
+        if (reader->pos >= reader->end) {
+            return -1;
+        }
+        uint8_t value = reader->block[reader->pos++];
+        out->button = value >> 1;
+        out->pressed = (value & 1) != 0;
+        return 1;
+    }
+    for (int ch = 0; ch < 3; ch++) {
+        uint32_t delta;
+        if (!get_varint(reader->block, &reader->pos, reader->end, &delta)) {
+            return -1;
+        }
+        reader->adc[ch] = (uint16_t)(reader->adc[ch] + unzigzag(delta));
+    }
+    out->vrx = reader->adc[0];
+    out->vry = reader->adc[1];
+    out->temp_raw = reader->adc[2];
+    return 1;
+}
@@ -0,0 +1,86 @@
+/**
+ * @file input_trace_codec.h
+ * @brief Formato do trace de entradas (versão 1), compartilhado entre o firmware (input_trace.c)
+ * e o reprodutor do host (host/input_replay.c).
+ *
+ * O trace é uma sequência de blocos de INPUT_TRACE_BLOCK_LEN bytes, cada um decodificável sozinho
+ * (um bloco perdido não invalida os seguintes). Layout do bloco, little-endian:
+ *
+ *   0  'I' 'T'          magic
+ *   2  u8  versão       INPUT_TRACE_VERSION
+ *   3  u8  botões       nível bruto dos pinos no início do bloco (bit0 = A, bit1 = B pressionado)
+ *   4  u32 sequência    1, 2, 3...: lacunas = blocos perdidos
+ *   8  u64 t0           referência de tempo do 1º registro (µs desde o boot)
+ *  16  u8  usados       bytes de registros a partir do offset 24
+ *  17  u8  reservado
+ *  18  u16 VRx, u16 VRy, u16 temperatura: referência dos deltas do 1º registro de ADC
+ *  24  registros, cada um começando com o varint (dt << 1) | tipo, dt em µs desde o registro
+ *      anterior (ou t0):
+ *        tipo 0, ADC:  três varints zigzag com dVRx, dVRy e dTemp (ADC bruto)
+ *        tipo 1, GPIO: u8 (botão << 1) | nível, uma borda vista pela IRQ (inclusive repique)
+ *
+ * Varints têm 7 bits por byte, o bit 7 indica continuação. A 50 Hz, com o joystick parado, uma
+ * amostra de ADC ocupa 6 bytes. A codificação é sem perdas.
+ */
+
+#ifndef INPUT_TRACE_CODEC_H
+#define INPUT_TRACE_CODEC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define INPUT_TRACE_VERSION 1
+#define INPUT_TRACE_BLOCK_LEN 128
+#define INPUT_TRACE_HEADER_LEN 24
+#define INPUT_TRACE_RECORD_MAX 10          // varint de 4 bytes + 3 deltas de 2 bytes
+#define INPUT_TRACE_MAX_DT_US (1u << 26)   // ~67 s: acima disso o registro abre outro bloco
+
+typedef enum {
+    INPUT_TRACE_ADC = 0,
+    INPUT_TRACE_GPIO = 1
+} input_trace_kind_t;
+
+typedef struct {
+    input_trace_kind_t kind;
+    uint64_t timestamp_us;
+    uint16_t vrx;              // ADC: valores absolutos (reconstruídos dos deltas)
+    uint16_t vry;
+    uint16_t temp_raw;
+    uint8_t button;            // GPIO: button_id_t
+    bool pressed;              // GPIO: nível após a borda
+} input_trace_record_t;
+
+// Bloco em montagem.
+typedef struct {
+    uint8_t *block;
+    uint8_t used;
+    uint64_t last_us;
+    uint16_t adc[3];           // Última leitura (VRx, VRy, temperatura), referência do próximo delta
+    uint8_t buttons;           // Nível bruto após a última borda
+} input_trace_writer_t;
+
+typedef struct {
+    const uint8_t *block;
+    uint8_t pos;
+    uint8_t end;
+    uint64_t last_us;
+    uint16_t adc[3];
+} input_trace_reader_t;
+
+// Começa um bloco em 'block' (INPUT_TRACE_BLOCK_LEN bytes). 'adc' é a referência dos deltas.
+void input_trace_block_start(input_trace_writer_t *writer, uint8_t *block, uint32_t sequence,
+                             uint64_t t0_us, uint8_t buttons, const uint16_t adc[3]);
+
+// Acrescentam um registro. Retornam false (sem alterar o bloco) se ele não cabe ou se o tempo
+// recua ou salta mais que INPUT_TRACE_MAX_DT_US: o chamador fecha o bloco e começa outro.
+bool input_trace_put_adc(input_trace_writer_t *writer, uint64_t timestamp_us, const uint16_t adc[3]);
+bool input_trace_put_edge(input_trace_writer_t *writer, uint64_t timestamp_us, uint8_t button, bool pressed);
+
+// Valida o cabeçalho e prepara a leitura. Retorna false se o bloco é inválido.
+bool input_trace_block_open(input_trace_reader_t *reader, const uint8_t *block, uint32_t *sequence,
+                            uint8_t *buttons);
+
+// Próximo registro: 1 = escrito em 'out', 0 = fim do bloco, -1 = registro truncado/inválido.
+int input_trace_next(input_trace_reader_t *reader, input_trace_record_t *out);
+
+#endif /* INPUT_TRACE_CODEC_H */
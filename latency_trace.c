@@ -0,0 +1,196 @@
+#include "latency_trace.h"
+
+#if LATENCY_TRACE_ENABLED
+
+#include <stdio.h>
+#include <string.h>
+
+#include "pico/time.h"
+
+#include "fmt.h"
+
+typedef struct {
+    uint32_t buckets[LATENCY_TRACE_BUCKETS]; // Último bucket: acima de 2^(N-2) µs (+Inf)
+    uint32_t count;
+    uint32_t max_us;
+    uint64_t sum_us;
+} latency_histogram_t;
+
+static const char *const g_stage_names[LATENCY_STAGE_COUNT] = {
+    "accept_to_first_byte", "parse", "render", "write", "last_ack", "total"
+};
+
+static latency_histogram_t g_histograms[LATENCY_STAGE_COUNT];
+
+// Cópia servida por /trace: o corpo sai em vários tcp_sent e precisa ser consistente. Há uma só:
+// um /trace que chega com outro em andamento lê a mesma, se ela tiver menos de
+// LATENCY_SNAPSHOT_SHARE_US (senão recebe 503). 'g_snapshot_refs' volta a zero no fim de cada
+// stream, inclusive com a conexão abortada (latency_stream_done).
+static latency_histogram_t g_snapshot[LATENCY_STAGE_COUNT];
+static uint16_t g_snapshot_refs;
+static uint64_t g_snapshot_taken_us;
+
+#define LATENCY_SNAPSHOT_SHARE_US 1000000u
+
+// Bucket k guarda as durações em (2^(k-1), 2^k] µs; o bucket 0, as de até 1 µs.
+static inline uint32_t latency_bucket(uint32_t duration_us) {
+    if (duration_us <= 1) {
+        return 0;
+    }
+    uint32_t k = 32 - (uint32_t)__builtin_clz(duration_us - 1);
+    return k < LATENCY_TRACE_BUCKETS ? k : LATENCY_TRACE_BUCKETS - 1;
+}
+
+void latency_trace_record(latency_stage_t stage, uint32_t duration_us) {
+    latency_histogram_t *h = &g_histograms[stage];
+    h->buckets[latency_bucket(duration_us)]++;
+    h->count++;
+    h->sum_us += duration_us;
+    if (duration_us > h->max_us) {
+        h->max_us = duration_us;
+    }
+}
+
+// Limite superior (µs) do bucket onde cai o quantil 'permille' (0 se não há amostras).
+static uint32_t latency_quantile_us(const latency_histogram_t *h, uint32_t permille) {
+    uint64_t target = ((uint64_t)h->count * permille + 999) / 1000;
+    uint32_t seen = 0;
+    for (uint32_t k = 0; k < LATENCY_TRACE_BUCKETS; k++) {
+        seen += h->buckets[k];
+        if (seen >= target && seen > 0) {
+            return (k == LATENCY_TRACE_BUCKETS - 1) ? h->max_us : (1u << k);
+        }
+    }
+    return 0;
+}
+
+void latency_trace_print(void) {
+    for (int stage = 0; stage < LATENCY_STAGE_COUNT; stage++) {
+        const latency_histogram_t *h = &g_histograms[stage];
+        if (h->count == 0) {
+            continue;
+        }
+        printf("TRACE: %-20s n=%lu p50<=%lu p90<=%lu p99<=%lu max=%lu us\n", g_stage_names[stage],
+               (unsigned long)h->count, (unsigned long)latency_quantile_us(h, 500),
+               (unsigned long)latency_quantile_us(h, 900), (unsigned long)latency_quantile_us(h, 990),
+               (unsigned long)h->max_us);
+    }
+}
+
+// --- GET /trace ---
+// Um histograma do Prometheus por etapa (rótulo 'stage'), seguido do máximo de cada etapa.
+
+typedef struct {
+    uint8_t part;               // 0 = cabeçalho do histograma, 1 = linhas dos histogramas,
+                                // 2 = cabeçalho do máximo, 3 = linhas do máximo
+    uint8_t stage;
+    uint8_t line;               // Buckets, depois +Inf, _sum e _count
+} latency_stream_state_t;
+
+static bool latency_stream_piece(void *state, u32_t index, char *scratch, http_piece_t *out) {
+    static const char hist_header[] =
+        "# HELP http_latency_us Duração de cada etapa das requisições HTTP (µs).\n"
+        "# TYPE http_latency_us histogram\n";
+    static const char max_header[] =
+        "# HELP http_latency_max_us Maior duração de cada etapa (µs).\n"
+        "# TYPE http_latency_max_us gauge\n";
+    latency_stream_state_t *s = (latency_stream_state_t *)state;
+    fmt_buf_t text;
+    fmt_init(&text, scratch, HTTP_STREAM_SCRATCH_LEN);
+
+    switch (s->part) {
+    case 0:
+        s->part = 1;
+        out->data = hist_header;
+        out->len = sizeof(hist_header) - 1;
+        return true;
+    case 1: {
+        const latency_histogram_t *h = &g_snapshot[s->stage];
+        const char *name = g_stage_names[s->stage];
+        if (s->line < LATENCY_TRACE_BUCKETS) {
+            FMT_LIT(&text, "http_latency_us_bucket{stage=\"");
+        } else if (s->line == LATENCY_TRACE_BUCKETS) {
+            FMT_LIT(&text, "http_latency_us_sum{stage=\"");
+        } else {
+            FMT_LIT(&text, "http_latency_us_count{stage=\"");
+        }
+        fmt_str(&text, name);
+        if (s->line < LATENCY_TRACE_BUCKETS - 1) {
+            uint32_t cumulative = 0;
+            for (uint32_t k = 0; k <= s->line; k++) {
+                cumulative += h->buckets[k];
+            }
+            FMT_LIT(&text, "\",le=\"");
+            fmt_u32(&text, 1u << s->line);
+            FMT_LIT(&text, "\"} ");
+            fmt_u32(&text, cumulative);
+        } else if (s->line == LATENCY_TRACE_BUCKETS - 1) {
+            FMT_LIT(&text, "\",le=\"+Inf\"} ");
+            fmt_u32(&text, h->count);
+        } else if (s->line == LATENCY_TRACE_BUCKETS) {
+            FMT_LIT(&text, "\"} ");
+            fmt_u64(&text, h->sum_us);
+        } else {
+            FMT_LIT(&text, "\"} ");
+            fmt_u32(&text, h->count);
+        }
+        fmt_char(&text, '\n');
+        if (++s->line > LATENCY_TRACE_BUCKETS + 1) {
+            s->line = 0;
+            if (++s->stage == LATENCY_STAGE_COUNT) {
+                s->stage = 0;
+                s->part = 2;
+            }
+        }
+        break;
+    }
+    case 2:
+        s->part = 3;
+        out->data = max_header;
+        out->len = sizeof(max_header) - 1;
+        return true;
+    case 3:
+        if (s->stage == LATENCY_STAGE_COUNT) {
+            return false;
+        }
+        FMT_LIT(&text, "http_latency_max_us{stage=\"");
+        fmt_str(&text, g_stage_names[s->stage]);
+        FMT_LIT(&text, "\"} ");
+        fmt_u32(&text, g_snapshot[s->stage].max_us);
+        fmt_char(&text, '\n');
+        s->stage++;
+        break;
+    default:
+        return false;
+    }
+    out->data = scratch;
+    out->len = (u16_t)text.len;
+    return true;
+}
+
+static void latency_stream_done(void *state) {
+    g_snapshot_refs--;
+}
+
+err_t latency_trace_serve(http_conn_t *conn, const http_request_t *request) {
+    uint64_t now_us = time_us_64();
+    if (g_snapshot_refs == 0) {
+        memcpy(g_snapshot, g_histograms, sizeof(g_snapshot));
+        g_snapshot_taken_us = now_us;
+    } else if (now_us - g_snapshot_taken_us >= LATENCY_SNAPSHOT_SHARE_US) {
+        // Um stream lento segura a cópia: não serve números tão velhos
+        return http_send_response(conn, 503, "Retry-After: 1\r\n", NULL, 0, false);
+    }
+    latency_stream_state_t state = { 0, 0, 0 };
+    g_snapshot_refs++; // Devolvida em latency_stream_done (com HEAD, já dentro de http_send_stream)
+    err_t err = http_send_stream(conn, 200,
+                                 "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                                 "Cache-Control: no-store\r\n",
+                                 -1, latency_stream_piece, latency_stream_done, &state, sizeof(state));
+    if (err != ERR_OK) {
+        g_snapshot_refs--; // Sem stream (ERR_MEM: a requisição volta depois)
+    }
+    return err;
+}
+
+#endif /* LATENCY_TRACE_ENABLED */
@@ -0,0 +1,56 @@
+/**
+ * @file latency_trace.h
+ * @brief Rastreamento de latência por requisição HTTP, agregado em histogramas (µs).
+ *
+ * O servidor HTTP marca instantes com time_us_64() em cada etapa do ciclo de vida de uma
+ * requisição e registra as durações aqui. Cada etapa tem um histograma de buckets fixos em escala
+ * log2 (1, 2, 4 ... µs), mais soma, contagem e máximo; nada é alocado e registrar é O(1).
+ * Os histogramas são servidos em /trace (formato do Prometheus) e resumidos na USB pelo relatório
+ * periódico.
+ *
+ * Com LATENCY_TRACE_ENABLED = 0 (ver CMakeLists.txt) as chamadas viram nada, os campos por conexão
+ * somem de http_server.c e a rota /trace não é registrada.
+ */
+
+#ifndef LATENCY_TRACE_H
+#define LATENCY_TRACE_H
+
+#ifndef LATENCY_TRACE_ENABLED
+#define LATENCY_TRACE_ENABLED 1
+#endif
+
+#include <stdint.h>
+
+typedef enum {
+    LATENCY_ACCEPT_TO_FIRST_BYTE,   // tcp_accept -> primeiro byte da primeira requisição
+    LATENCY_PARSE,                  // Primeiro byte -> requisição completa
+    LATENCY_RENDER,                 // Handler da rota (formatação + tcp_write)
+    LATENCY_WRITE,                  // Fim do handler -> último byte enfileirado e tcp_output
+    LATENCY_LAST_ACK,               // Último byte enfileirado -> ACK do último byte
+    LATENCY_TOTAL,                  // Primeiro byte da requisição -> ACK do último byte
+    LATENCY_STAGE_COUNT
+} latency_stage_t;
+
+#define LATENCY_TRACE_BUCKETS 24    // le = 1, 2, 4 ... 2^22 µs (~4,2 s) e +Inf
+
+#if LATENCY_TRACE_ENABLED
+
+#include "http_server.h"
+
+// Soma 'duration_us' ao histograma da etapa. Só o contexto da LwIP (núcleo 0) chama.
+void latency_trace_record(latency_stage_t stage, uint32_t duration_us);
+
+// Imprime na USB uma linha por etapa: contagem, p50/p90/p99 (limite do bucket) e máximo.
+void latency_trace_print(void);
+
+// Handler da rota /trace: histogramas no formato texto do Prometheus.
+err_t latency_trace_serve(http_conn_t *conn, const http_request_t *request);
+
+#else
+
+#define latency_trace_record(stage, duration_us) ((void)0)
+#define latency_trace_print() ((void)0)
+
+#endif /* LATENCY_TRACE_ENABLED */
+
+#endif /* LATENCY_TRACE_H */
@@ -104,8 +104,10 @@
 // MEMP_NUM_TCP_PCB: Número de PCBs para TCP.
 // Cada conexão TCP (seja de escuta ou ativa) consome um TCP PCB.
 // Este valor limita o número de conexões TCP simultâneas que o sistema pode ter.
-// '4' é um valor baixo, adequado para um servidor simples com poucas conexões.
-#define MEMP_NUM_TCP_PCB 4
+// O servidor atende HTTP_CONN_BUDGET (4) conexões; as 2 a mais respondem o 503 de sobrecarga e
+// absorvem conexões em TIME_WAIT, então uma enxurrada de clientes recebe resposta em vez de ter o
+// SYN ignorado (cada PCB custa ~200 bytes de RAM). Mais 1 para o cliente MQTT (mqtt_publisher.c).
+#define MEMP_NUM_TCP_PCB 7
 
 // MEMP_NUM_TCP_SEG: Número de segmentos TCP que podem ser enfileirados para transmissão
 // ou retransmissão. Relacionado ao buffer de envio (TCP_SND_BUF) e ao controle de fluxo.
@@ -113,6 +115,24 @@
 // mas consome mais RAM. '32' é um valor razoável para a configuração de TCP_SND_BUF.
 #define MEMP_NUM_TCP_SEG 64
 
+// --- Estatísticas (expostas em /metrics, ver metrics.c) ---
+
+// LWIP_STATS: mantém contadores em 'lwip_stats'. Só os grupos usados por /metrics ficam ligados:
+// heap (MEM_STATS), pools (MEMP_STATS: total, em uso, máximo e falhas de cada um) e TCP.
+// O custo é um incremento por evento e alguns bytes de RAM por pool.
+#define LWIP_STATS 1
+#define MEM_STATS 1
+#define MEMP_STATS 1
+#define TCP_STATS 1
+#define LINK_STATS 0
+#define ETHARP_STATS 0
+#define IP_STATS 0
+#define IPFRAG_STATS 0
+#define ICMP_STATS 0
+#define UDP_STATS 0
+#define SYS_STATS 0
+#define LWIP_STATS_DISPLAY 0
+
 // --- Configuração de Protocolos de Rede (Nível IP e outros) ---
 
 // LWIP_IPV4: Habilita (1) ou desabilita (0) o suporte ao protocolo IPv4.
@@ -182,6 +202,20 @@
 // geram conteúdo dinâmico internamente (como seu `main.c` faz, ou via SSI).
 #define LWIP_HTTPD_CGI 0
 
+// --- Cliente MQTT da LwIP (mqtt_publisher.c) ---
+
+// MEMP_NUM_SYS_TIMEOUT: o cliente MQTT mantém um timer cíclico (keep-alive e timeout das
+// requisições) enquanto conectado, além dos timers internos da pilha.
+#define MEMP_NUM_SYS_TIMEOUT (LWIP_NUM_SYS_TIMEOUT_INTERNAL + 1)
+
+// MQTT_OUTPUT_RINGBUF_SIZE: buffer onde mqtt_publish copia as mensagens até o TCP aceitá-las.
+// Cabe uma janela inteira de lotes (3 x MQTT_BATCH_LEN) mais o estado retido e cabeçalhos; com
+// ele cheio, mqtt_publish devolve ERR_MEM e o lote espera a próxima janela.
+#define MQTT_OUTPUT_RINGBUF_SIZE 1024
+
+// MQTT_REQ_MAX_IN_FLIGHT: mensagens aguardando o ACK (cada uma ocupa um slot até o callback).
+#define MQTT_REQ_MAX_IN_FLIGHT 8
+
 // --- Outras Configurações de Rede ---
 
 // LWIP_NETIF_HOSTNAME: Habilita (1) ou desabilita (0) o suporte a nome de host para
@@ -1,7 +1,10 @@
 #include "pico/stdlib.h"
 #include "hardware/adc.h"
 #include "hardware/gpio.h"
+#include "hardware/sync.h"
 #include "pico/cyw43_arch.h"
+#include "pico/multicore.h"
+#include "pico/async_context.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
@@ -11,6 +14,24 @@
 #include "lwip/netif.h"
 #include "lwip/opt.h"
 
+#include "adc_sampler.h"
+#include "button_events.h"
+#include "fmt.h"
+#include "history.h"
+#include "http_server.h"
+#include "input_classifier.h"
+#include "input_state.h"
+#include "input_trace.h"
+#include "latency_trace.h"
+#include "mem_usage.h"
+#include "metrics.h"
+#include "mqtt_publisher.h"
+#include "sample_scheduler.h"
+#include "udp_telemetry.h"
+#include "web_assets.h"
+#include "websocket.h"
+#include "wifi_link.h"
+
 // --- Configurações ---
 #define WIFI_SSID "@thilinhares"    //  <--- COLOQUE AQUI O NOME DA SUA REDE WIFI
 #define WIFI_PASSWORD "mafredzudo18" //  <--- COLOQUE AQUI A SENHA DA SUA REDE WIFI
@@ -20,314 +41,1119 @@
 #define BUTTON_A_PIN 5
 #define BUTTON_B_PIN 6
 
-// --- Tipos e Variáveis Globais ---
-typedef enum {
-    CENTER, NORTH, NORTHEAST, EAST, SOUTHEAST, SOUTH, SOUTHWEST, WEST, NORTHWEST
-} joystick_direction_t;
+// Telemetria binária por UDP (udp_telemetry.h); receptor: host/telemetry_rx.c
+#define TELEMETRY_HOST ""                // IPv4 do coletor (ou "255.255.255.255"); "" desativa
+#define TELEMETRY_PORT 5005
+#define TELEMETRY_BATCH_SAMPLES 25       // Amostras por datagrama
+#define TELEMETRY_INTERVAL_MS 20         // No máximo uma amostra a cada N ms (múltiplo de SAMPLE_BURST_PERIOD_US)
 
-typedef enum {
-    NO_BUTTON_PRESSED_YET, BUTTON_A_EVENT, BUTTON_B_EVENT
-} button_event_type_t;
+// Publicação MQTT das mudanças (mqtt_publisher.h); broker de teste: host/mqtt_broker.c
+#define MQTT_BROKER_HOST ""              // IPv4 do broker; "" desativa
+#define MQTT_BROKER_PORT 1883
+#define MQTT_CLIENT_ID "bitdoglab-01"
+#define MQTT_TOPIC_PREFIX "bitdoglab/01"
+#define MQTT_MAX_RATE_HZ 10              // Lotes por segundo, no máximo
 
-volatile uint16_t g_joystick_vrx_value = 0;
-volatile uint16_t g_joystick_vry_value = 0;
-volatile joystick_direction_t g_joystick_direction = CENTER;
-volatile button_event_type_t g_last_button_type = NO_BUTTON_PRESSED_YET;
+// --- Tipos e Variáveis Globais ---
+// O estado das entradas é produzido no núcleo 1 e lido no núcleo 0 via input_state.h (seqlock).
 
-#define ADC_MAX_VALUE 4095
-#define ADC_CENTER_VALUE (ADC_MAX_VALUE / 2)
-#define JOYSTICK_DEADZONE 300
-#define JOYSTICK_LOW_THRESHOLD  (ADC_CENTER_VALUE - JOYSTICK_DEADZONE)
-#define JOYSTICK_HIGH_THRESHOLD (ADC_CENTER_VALUE + JOYSTICK_DEADZONE)
+// Condicionamento do joystick (input_classifier.h; o host/input_replay.c usa a mesma configuração)
+static const joystick_config_t g_joystick_config = JOYSTICK_CONFIG_DEFAULT;
+static joystick_filter_t g_joystick_filter; // Só o núcleo 1
 
 #define TCP_PORT 80
 #define HTTP_SERVER_BACKLOG 5 // Número de conexões TCP pendentes que o servidor pode enfileirar
 
+// --- Server-Sent Events (/stream) ---
+#define SSE_MAX_CLIENTS 3       // Slots de /stream (o limite conjunto com /ws é STREAM_MAX_CLIENTS)
+#define SSE_HEARTBEAT_MS 5000   // Reenvia o estado (e atualiza a temperatura) mesmo sem mudanças
+#define SSE_MAX_INFLIGHT 512    // Bytes enviados e ainda não confirmados (ACK) por cliente
+#define SSE_AXIS_DELTA 32       // Variação mínima de VRx/VRy que conta como mudança de estado
+
+// --- WebSocket (/ws) ---
+#define WS_MAX_CLIENTS 2
+#define WS_SAMPLE_LEN 12        // Payload binário de cada amostra (ver ws_broadcast_sample)
+#define WS_MAX_INFLIGHT 256     // Acima disso o cliente é considerado lento e perde amostras
+#define WS_RX_BUF_SIZE 128      // Suficiente para quadros de controle (payload <= 125)
+
+// /stream e /ws ocupam vagas do mesmo orçamento (HTTP_CONN_BUDGET = 4): juntos deixam ao menos 1
+// para /, /status etc.
+#define STREAM_MAX_CLIENTS (HTTP_CONN_BUDGET - 1)
+
+// --- Cache da resposta de /status ---
+#define STATUS_CACHE_SLOTS 3    // Versões que podem estar aguardando ACK ao mesmo tempo
+#define STATUS_RESPONSE_MAX 224 // Linha de status + cabeçalhos + JSON
+#define STATUS_AXIS_SHIFT 4      // VRx/VRy dentro do mesmo degrau de 16 contagens reaproveitam a resposta
+
+// --- Histórico de botões (/events) ---
+#define EVENTS_MAX_PER_RESPONSE 16 // O cliente repete com since=<next> se houver mais ("more")
+
+#define STATS_REPORT_INTERVAL_MS 10000 // Relatório de ociosidade/latência pela USB
+
 // --- Protótipos ---
-static err_t tcp_server_recv_callback(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t err);
-static err_t tcp_server_accept_callback(void *arg, struct tcp_pcb *newpcb, err_t err);
-static void tcp_server_error_callback(void *arg, err_t err);
 const char* joystick_direction_to_string(joystick_direction_t dir);
 const char* joystick_direction_to_css_class(joystick_direction_t dir);
-static bool initialize_tcp_server(void);
-static void read_inputs_and_update_state(void);
+static void read_inputs_and_update_state(input_snapshot_t *state);
+static void core1_acquisition_entry(void);
+static void publish_worker_do_work(async_context_t *context, async_when_pending_worker_t *worker);
+static void stats_worker_do_work(async_context_t *context, async_at_time_worker_t *worker);
+static err_t sse_accept_client(http_conn_t *conn, const http_request_t *request);
+static void sse_broadcast_state(const input_snapshot_t *state);
+static err_t ws_accept_client(http_conn_t *conn, const http_request_t *request);
+static void ws_broadcast_sample(const input_snapshot_t *state);
 
 // --- Implementações ---
 
-static void tcp_server_error_callback(void *arg, err_t err) {
-    // ERR_ABRT é comum quando abortamos a conexão intencionalmente ou o cliente fecha abruptamente.
-    if (err != ERR_ABRT) {
-        printf("ERRO TCP: Callback de erro TCP - código %d no PCB %p\n", err, arg);
+// Nome e classe CSS de cada direção, na ordem de joystick_direction_t.
+static const struct {
+    const char *name;
+    const char *css_class;
+} g_direction_info[] = {
+    [CENTER]    = { "Centro",   "dir-center" },
+    [NORTH]     = { "Norte",    "dir-n" },
+    [NORTHEAST] = { "Nordeste", "dir-ne" },
+    [EAST]      = { "Leste",    "dir-e" },
+    [SOUTHEAST] = { "Sudeste",  "dir-se" },
+    [SOUTH]     = { "Sul",      "dir-s" },
+    [SOUTHWEST] = { "Sudoeste", "dir-sw" },
+    [WEST]      = { "Oeste",    "dir-w" },
+    [NORTHWEST] = { "Noroeste", "dir-nw" },
+};
+
+#define DIRECTION_COUNT (sizeof(g_direction_info) / sizeof(g_direction_info[0]))
+
+const char* joystick_direction_to_string(joystick_direction_t dir) {
+    return (unsigned)dir < DIRECTION_COUNT ? g_direction_info[dir].name : "Desconhecido";
+}
+
+const char* joystick_direction_to_css_class(joystick_direction_t dir) {
+    return (unsigned)dir < DIRECTION_COUNT ? g_direction_info[dir].css_class : "dir-unknown";
+}
+
+// --- Arquivos estáticos (web/) ---
+// Gerados no build (web_assets.c): minificados, em flash, com versão gzip, tamanho e ETag
+// prontos. São enviados por referência; os valores dinâmicos chegam via /stream ou /status.
+
+typedef struct {
+    const uint8_t *data;
+    uint32_t len;
+} asset_stream_state_t;
+
+static bool asset_stream_piece(void *state, u32_t index, char *scratch, http_piece_t *out) {
+    const asset_stream_state_t *st = (const asset_stream_state_t *)state;
+    uint32_t offset = index * 0xFFFFu; // Trechos limitados a u16_t
+    if (offset >= st->len) {
+        return false;
     }
+    uint32_t len = st->len - offset;
+    out->data = (const char *)st->data + offset;
+    out->len = (u16_t)(len > 0xFFFFu ? 0xFFFFu : len);
+    return true;
 }
 
-const char* joystick_direction_to_string(joystick_direction_t dir) {
-    switch (dir) {
-        case NORTH:     return "Norte";
-        case NORTHEAST: return "Nordeste";
-        case EAST:      return "Leste";
-        case SOUTHEAST: return "Sudeste";
-        case SOUTH:     return "Sul";
-        case SOUTHWEST: return "Sudoeste";
-        case WEST:      return "Oeste";
-        case NORTHWEST: return "Noroeste";
-        case CENTER:    return "Centro";
-        default:        return "Desconhecido";
+// GET / e demais arquivos de web/: versão gzip se o cliente aceitar, ou 304 se o navegador já
+// tiver a versão atual (o ETag muda a cada firmware, então sempre revalida).
+static err_t serve_asset(http_conn_t *conn, const http_request_t *request) {
+    const char *path = strcmp(request->path, "/") == 0 ? "/index.html" : request->path;
+    const web_asset_t *asset = NULL;
+    for (size_t i = 0; i < web_asset_count; i++) {
+        if (strcmp(web_assets[i].path, path) == 0) {
+            asset = &web_assets[i];
+            break;
+        }
+    }
+    if (asset == NULL) {
+        return http_send_response(conn, 404, NULL, NULL, 0, false);
     }
+
+    bool gzip = request->accept_gzip;
+    const char *etag = gzip ? asset->etag_gzip : asset->etag;
+    char headers[160];
+    fmt_buf_t out;
+    fmt_init(&out, headers, sizeof(headers));
+    FMT_LIT(&out, "ETag: ");
+    fmt_str(&out, etag);
+    FMT_LIT(&out, "\r\nCache-Control: no-cache\r\nVary: Accept-Encoding\r\n");
+    if (strstr(request->if_none_match, etag) != NULL) {
+        return http_send_response(conn, 304, fmt_cstr(&out), NULL, 0, false);
+    }
+    FMT_LIT(&out, "Content-Type: ");
+    fmt_str(&out, asset->content_type);
+    FMT_LIT(&out, "\r\n");
+    if (gzip) {
+        FMT_LIT(&out, "Content-Encoding: gzip\r\n");
+    }
+    fmt_cstr(&out);
+
+    asset_stream_state_t state = {
+        .data = gzip ? asset->gzip_data : asset->data,
+        .len = gzip ? asset->gzip_len : asset->len,
+    };
+    return http_send_stream(conn, 200, headers, (s32_t)state.len, asset_stream_piece, NULL, &state, sizeof(state));
 }
 
-const char* joystick_direction_to_css_class(joystick_direction_t dir) {
-    switch (dir) {
-        case NORTH:     return "dir-n";
-        case NORTHEAST: return "dir-ne";
-        case EAST:      return "dir-e";
-        case SOUTHEAST: return "dir-se";
-        case SOUTH:     return "dir-s";
-        case SOUTHWEST: return "dir-sw";
-        case WEST:      return "dir-w";
-        case NORTHWEST: return "dir-nw";
-        case CENTER:    return "dir-center";
-        default:        return "dir-unknown";
-    }
-}
-
-// Callback para quando dados são recebidos em uma conexão TCP
-static err_t tcp_server_recv_callback(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t err) {
-    if (err != ERR_OK && err != ERR_ABRT) {
-        printf("ERRO TCP: Falha na recepção de dados - código %d\n", err);
-        if (p != NULL) {
-            tcp_recved(tpcb, p->tot_len);
-            pbuf_free(p);
+// Sensor de temperatura interno (ADC4): T = 27 - (V - 0,706) / 0,001721, com V = raw * 3,3 / 4096.
+// Em centésimos de °C e ponto fixo Q12: T = (K0 - K1 * raw) / 4096, sem ponto flutuante (o M0+
+// não tem FPU). Difere da conta em float em no máximo 0,01 °C.
+#define TEMP_CENTI_K0 179088020 // (2700 + 70,6 / 0,001721) * 4096
+#define TEMP_CENTI_K1 191749    // 330 / (4096 * 0,001721) * 4096
+
+static int32_t read_temperature_centi(const input_snapshot_t *state) {
+    int32_t scaled = TEMP_CENTI_K0 - TEMP_CENTI_K1 * (int32_t)state->temp_raw; // Cabe em 32 bits até raw = 4095
+    return (scaled + 2048) >> 12; // Deslocamento aritmético (GCC): arredonda também abaixo de zero
+}
+
+// Formata o estado atual como JSON compacto (< 100 bytes). Usado por /status e /stream.
+static int format_status_json(char *buf, size_t size, const input_snapshot_t *state, int32_t temperature_centi) {
+    fmt_buf_t out;
+    fmt_init(&out, buf, size);
+    FMT_LIT(&out, "{\"t\":");
+    fmt_centi(&out, temperature_centi);
+    FMT_LIT(&out, ",\"x\":");
+    fmt_u32(&out, state->vrx);
+    FMT_LIT(&out, ",\"y\":");
+    fmt_u32(&out, state->vry);
+    FMT_LIT(&out, ",\"d\":");
+    fmt_u32(&out, (uint32_t)state->direction);
+    FMT_LIT(&out, ",\"b\":");
+    fmt_u32(&out, (uint32_t)state->last_button);
+    fmt_char(&out, '}');
+    return (int)out.len;
+}
+
+#if FMT_BENCHMARK
+#include "hardware/structs/systick.h"
+
+#define FMT_BENCHMARK_RUNS 1000
+
+// Caminho anterior (float + snprintf com "%.2f"), mantido só para a comparação.
+static int format_status_json_snprintf(char *buf, size_t size, const input_snapshot_t *state) {
+    const float conversion_factor = 3.3f / (1 << 12);
+    float temperature = 27.0f - ((state->temp_raw * conversion_factor) - 0.706f) / 0.001721f;
+    return snprintf(buf, size, "{\"t\":%.2f,\"x\":%u,\"y\":%u,\"d\":%d,\"b\":%d}",
+                    temperature, state->vrx, state->vry,
+                    (int)state->direction, (int)state->last_button);
+}
+
+// Mede, com o SysTick no clock do processador, os ciclos médios para converter a temperatura e
+// renderizar o JSON de /status nos dois caminhos, e quantas saídas divergem.
+static void fmt_benchmark_run(void) {
+    systick_hw->rvr = 0x00FFFFFF;
+    systick_hw->cvr = 0;
+    systick_hw->csr = 0x5; // ENABLE | CLKSOURCE (clk_sys), sem interrupção
+
+    input_snapshot_t state = { .direction = NORTHEAST, .last_button = BUTTON_A_EVENT };
+    char fixed[STATUS_RESPONSE_MAX], legacy[STATUS_RESPONSE_MAX];
+    uint32_t cycles_fixed = 0, cycles_legacy = 0, mismatches = 0;
+    for (uint32_t i = 0; i < FMT_BENCHMARK_RUNS; i++) {
+        state.vrx = (uint16_t)((i * 37) & 0xFFF);
+        state.vry = (uint16_t)((i * 91) & 0xFFF);
+        state.temp_raw = (uint16_t)(700 + i % 300); // ~ -20 °C a 80 °C
+
+        uint32_t start = systick_hw->cvr; // Contador decrescente de 24 bits
+        int fixed_len = format_status_json(fixed, sizeof(fixed), &state, read_temperature_centi(&state));
+        cycles_fixed += (start - systick_hw->cvr) & 0x00FFFFFF;
+
+        start = systick_hw->cvr;
+        int legacy_len = format_status_json_snprintf(legacy, sizeof(legacy), &state);
+        cycles_legacy += (start - systick_hw->cvr) & 0x00FFFFFF;
+
+        if (fixed_len != legacy_len || memcmp(fixed, legacy, (size_t)fixed_len) != 0) {
+            mismatches++; // Arredondamento diferente no último dígito (no máximo 0,01 °C)
         }
-        tcp_arg(tpcb, NULL); tcp_recv(tpcb, NULL); tcp_sent(tpcb, NULL); tcp_poll(tpcb, NULL, 0); tcp_err(tpcb, NULL);
-        tcp_abort(tpcb); // Aborta a conexão problemática
-        return ERR_ABRT;
     }
+    printf("BENCH: JSON de /status: %lu ciclos/render (ponto fixo + fmt) vs %lu (float + snprintf); %lu de %d diferem.\n",
+           (unsigned long)(cycles_fixed / FMT_BENCHMARK_RUNS), (unsigned long)(cycles_legacy / FMT_BENCHMARK_RUNS),
+           (unsigned long)mismatches, FMT_BENCHMARK_RUNS);
+}
+#endif
+
+// GET /status : estado atual em JSON compacto (< 100 bytes).
+static char g_status_cache_data[STATUS_CACHE_SLOTS][STATUS_RESPONSE_MAX];
+static http_shared_response_t g_status_cache[STATUS_CACHE_SLOTS];
+static http_shared_response_t *g_status_current = NULL; // Versão mais recente (pode ter refs > 0)
+
+// O que a resposta mostra: 'generation' avança a cada amostra (até 200 Hz), então a chave é a
+// mudança discreta mais os valores renderizados, com os eixos em degraus (ruído não invalida).
+typedef struct {
+    uint32_t change_generation;
+    uint16_t vrx_step;
+    uint16_t vry_step;
+    int32_t temperature_centi;
+} status_cache_key_t;
 
-    // Se p == NULL, o cliente fechou a conexão
-    if (p == NULL) {
-        // printf("INFO: Conexão TCP fechada pelo cliente.\n"); 
-        return ERR_OK; // Indica que lidamos com o fechamento
+static status_cache_key_t g_status_cache_keys[STATUS_CACHE_SLOTS];
+
+static bool status_cache_key_equal(const status_cache_key_t *a, const status_cache_key_t *b) {
+    return a->change_generation == b->change_generation && a->vrx_step == b->vrx_step
+        && a->vry_step == b->vry_step && a->temperature_centi == b->temperature_centi;
+}
+
+// Renderiza (só quando a chave muda) a resposta completa de /status num slot sem referências em
+// voo. Retorna NULL se todos os slots ainda estão sendo enviados.
+static http_shared_response_t *status_cache_get(const input_snapshot_t *state) {
+    int32_t temperature_centi = read_temperature_centi(state);
+    const status_cache_key_t key = {
+        .change_generation = state->change_generation,
+        .vrx_step = (uint16_t)(state->vrx >> STATUS_AXIS_SHIFT),
+        .vry_step = (uint16_t)(state->vry >> STATUS_AXIS_SHIFT),
+        .temperature_centi = temperature_centi,
+    };
+    if (g_status_current != NULL &&
+        status_cache_key_equal(&g_status_cache_keys[g_status_current - g_status_cache], &key)) {
+        return g_status_current;
+    }
+    http_shared_response_t *slot = NULL;
+    for (int i = 0; i < STATUS_CACHE_SLOTS; i++) {
+        if (g_status_cache[i].refs == 0) {
+            slot = &g_status_cache[i];
+            break;
+        }
+    }
+    if (slot == NULL) {
+        return NULL;
     }
 
-    tcp_recved(tpcb, p->tot_len); // Informa à LwIP que processamos os dados
+    char body[96];
+    int body_len = format_status_json(body, sizeof(body), state, temperature_centi);
+    char *data = g_status_cache_data[slot - g_status_cache];
+    fmt_buf_t out;
+    fmt_init(&out, data, STATUS_RESPONSE_MAX);
+    FMT_LIT(&out, "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nCache-Control: no-store\r\nContent-Length: ");
+    fmt_u32(&out, (uint32_t)body_len);
+    FMT_LIT(&out, "\r\n");
+    int head_len = (int)out.len;
+    memcpy(data + head_len, body, (size_t)body_len);
+    slot->data = data;
+    slot->head_len = (u16_t)head_len;
+    slot->body_len = (u16_t)body_len;
+    slot->version = state->generation;
+    g_status_cache_keys[slot - g_status_cache] = key;
+    g_status_current = slot;
+    return slot;
+}
+
+static err_t serve_status(http_conn_t *conn, const http_request_t *request) {
+    input_snapshot_t state;
+    input_state_read(&state);
 
-    bool serve_page = false;
-    if (p->len >= 3 && strncmp((char*)p->payload, "GET", 3) == 0) {
-        serve_page = true;
+    http_shared_response_t *cached = status_cache_get(&state);
+    if (cached != NULL) {
+        return http_send_shared_response(conn, cached);
     }
-    pbuf_free(p); // Libera o buffer da requisição, não precisamos mais dele
 
-    if (!serve_page) {
-        err_t close_err = tcp_close(tpcb);
-        if (close_err != ERR_OK) {
-            printf("ERRO TCP: Falha ao fechar conexão não-GET - código %d. Abortando.\n", close_err);
-            tcp_arg(tpcb, NULL); tcp_recv(tpcb, NULL); tcp_sent(tpcb, NULL); tcp_poll(tpcb, NULL, 0); tcp_err(tpcb, NULL);
-            tcp_abort(tpcb);
-            return ERR_ABRT;
+    // Todas as versões do cache ainda em voo: renderiza só para esta conexão
+    char body[96];
+    int body_len = format_status_json(body, sizeof(body), &state, read_temperature_centi(&state));
+    return http_send_response(conn, 200, "Content-Type: application/json\r\nCache-Control: no-store\r\n",
+                              body, (u16_t)body_len, false);
+}
+
+// Estado do stream de /events (copiado para a conexão por http_send_stream).
+typedef struct {
+    uint32_t cursor;    // Último evento já escrito
+    uint32_t next;      // Último evento desta resposta
+    uint32_t written;   // Eventos escritos (para a vírgula)
+    uint32_t closed;    // "]}" já emitido
+} events_stream_state_t;
+
+// Trecho 0: cabeçalho do JSON; depois um evento por trecho e, por fim, "]}".
+static bool events_stream_piece(void *state, u32_t index, char *scratch, http_piece_t *out) {
+    events_stream_state_t *st = (events_stream_state_t *)state;
+    fmt_buf_t text;
+    fmt_init(&text, scratch, HTTP_STREAM_SCRATCH_LEN);
+    if (index == 0) {
+        button_event_stats_t stats;
+        button_events_get_stats(&stats);
+        FMT_LIT(&text, "{\"next\":");
+        fmt_u32(&text, st->next);
+        if (button_events_latest_seq() > st->next) {
+            FMT_LIT(&text, ",\"more\":true,\"count\":{\"A\":");
+        } else {
+            FMT_LIT(&text, ",\"more\":false,\"count\":{\"A\":");
         }
+        fmt_u32(&text, stats.press_count[BUTTON_ID_A]);
+        FMT_LIT(&text, ",\"B\":");
+        fmt_u32(&text, stats.press_count[BUTTON_ID_B]);
+        FMT_LIT(&text, "},\"events\":[");
+    } else {
+        button_event_t ev;
+        if (st->cursor < st->next && button_events_read_since(st->cursor, &ev, 1) == 1 && ev.seq <= st->next) {
+            st->cursor = ev.seq;
+            if (st->written++) {
+                fmt_char(&text, ',');
+            }
+            FMT_LIT(&text, "{\"seq\":");
+            fmt_u32(&text, ev.seq);
+            FMT_LIT(&text, ",\"t\":");
+            fmt_u64(&text, ev.timestamp_us);
+            FMT_LIT(&text, ",\"btn\":\"");
+            fmt_char(&text, ev.button == BUTTON_ID_A ? 'A' : 'B');
+            if (ev.pressed) {
+                FMT_LIT(&text, "\",\"type\":\"press\",\"dur\":");
+            } else {
+                FMT_LIT(&text, "\",\"type\":\"release\",\"dur\":");
+            }
+            fmt_u32(&text, ev.duration_us);
+            fmt_char(&text, '}');
+        } else if (!st->closed) {
+            st->closed = 1;
+            out->data = "]}";
+            out->len = 2;
+            return true;
+        } else {
+            return false;
+        }
+    }
+    out->data = scratch;
+    out->len = (u16_t)text.len;
+    return true;
+}
+
+// GET /events?since=<seq> : eventos de botão (pressionamento/soltura) posteriores a 'since',
+// com timestamp em µs e duração na soltura, mais os contadores por botão. O corpo é gerado
+// evento a evento (chunked), sem montar a resposta inteira em memória.
+static err_t serve_button_events(http_conn_t *conn, const http_request_t *request) {
+    uint32_t since = 0;
+    const char *since_param = strstr(request->query, "since=");
+    if (since_param != NULL) {
+        since = (uint32_t)strtoul(since_param + 6, NULL, 10);
+    }
+
+    // Fixa o último evento desta resposta: até EVENTS_MAX_PER_RESPONSE após 'since'
+    events_stream_state_t state = { .cursor = since };
+    button_event_t ev;
+    uint32_t cursor = since;
+    for (int i = 0; i < EVENTS_MAX_PER_RESPONSE && button_events_read_since(cursor, &ev, 1) == 1; i++) {
+        cursor = ev.seq;
+    }
+    uint32_t latest = button_events_latest_seq();
+    state.next = (cursor != since) ? cursor : (since < latest ? since : latest);
+
+    return http_send_stream(conn, 200, "Content-Type: application/json\r\nCache-Control: no-store\r\n", -1,
+                            events_stream_piece, NULL, &state, sizeof(state));
+}
+
+// --- Server-Sent Events ---
+// Cada visualizador mantém uma única conexão aberta em /stream. O loop principal envia um evento
+// apenas quando o estado muda (ou a cada SSE_HEARTBEAT_MS). Se um cliente ainda tiver mais de
+// SSE_MAX_INFLIGHT bytes sem ACK, o evento fica pendente e só o estado mais recente é enviado
+// quando o tcp_sent liberar espaço, sem acumular eventos antigos.
+
+typedef struct {
+    struct tcp_pcb *pcb;  // NULL = slot livre
+    u32_t unacked;        // Bytes escritos e ainda não confirmados
+    bool pending;         // Há um estado mais novo que não pôde ser enviado
+} sse_client_t;
+
+static sse_client_t g_sse_clients[SSE_MAX_CLIENTS];
+
+// Último evento formatado ("data: {...}\n\n"), reenviado aos clientes com envio pendente.
+static char g_sse_last_event[112];
+static u16_t g_sse_last_event_len = 0;
+
+static void sse_release_client(sse_client_t *client) {
+    client->pcb = NULL;
+    client->unacked = 0;
+    client->pending = false;
+}
+
+static void sse_abort_client(sse_client_t *client) {
+    struct tcp_pcb *tpcb = client->pcb;
+    metrics_count(METRICS_SSE_ABORTS);
+    sse_release_client(client);
+    http_detached_abort(tpcb);
+}
+
+// Escreve um evento para o cliente, respeitando o limite de bytes em trânsito.
+// Retorna ERR_ABRT se a conexão precisou ser abortada.
+static err_t sse_send_to_client(sse_client_t *client, const char *data, u16_t len) {
+    if (client->unacked + len > SSE_MAX_INFLIGHT || tcp_sndbuf(client->pcb) < len || !http_tx_mem_available(len)) {
+        client->pending = true; // Cliente lento (ou LwIP sem memória): envia só o estado mais recente depois
         return ERR_OK;
     }
 
-    // --- Preparar dados para a página HTML ---
-    adc_select_input(4); // Sensor de temperatura interno
-    uint16_t raw_temp_value = adc_read();
-    const float conversion_factor = 3.3f / (1 << 12);
-    float temperature = 27.0f - ((raw_temp_value * conversion_factor) - 0.706f) / 0.001721f;
-
-    char temp_color_str[10];
-    if (temperature < 55.0f) strcpy(temp_color_str, "green");
-    else if (temperature <= 70.0f) strcpy(temp_color_str, "orange");
-    else strcpy(temp_color_str, "red");
-
-    char joystick_direction_text_str[60];
-    char joystick_values_str[70];
-    char joystick_css_class_str[20];
-
-    snprintf(joystick_direction_text_str, sizeof(joystick_direction_text_str), "Direção: %s", joystick_direction_to_string(g_joystick_direction));
-    strncpy(joystick_css_class_str, joystick_direction_to_css_class(g_joystick_direction), sizeof(joystick_css_class_str) -1);
-    joystick_css_class_str[sizeof(joystick_css_class_str)-1] = '\0';
-    snprintf(joystick_values_str, sizeof(joystick_values_str), "Valores: VRx=%d, VRy=%d", g_joystick_vrx_value, g_joystick_vry_value);
-
-    char button_str[80];
-    if (g_last_button_type == BUTTON_A_EVENT) snprintf(button_str, sizeof(button_str), "Ultimo botão pressionado: A");
-    else if (g_last_button_type == BUTTON_B_EVENT) snprintf(button_str, sizeof(button_str), "Ultimo botão pressionado: B");
-    else snprintf(button_str, sizeof(button_str), "Ultimo botão pressionado: Nenhum");
-
-    // Buffer para o HTML. Ajuste conforme necessário.
-    char html[3072]; 
-    int len = snprintf(html, sizeof(html),
-        "HTTP/1.1 200 OK\r\n"
-        "Content-Type: text/html; charset=UTF-8\r\n"
-        "Connection: close\r\n"
-        "Cache-Control: no-cache, no-store, must-revalidate\r\nPragma: no-cache\r\nExpires: 0\r\n\r\n"
-        "<!DOCTYPE html>"
-        "<html><head><title>RP2040 Status</title>" // Título da aba do navegador
-        "<style>"
-        "body { text-align: center; font-family: Arial, sans-serif; margin-top: 20px; background-color: #f4f4f4; color: #333; }"
-        "h1 { font-size: 2em; margin-bottom: 25px; color: #0056b3; }"
-        "p { font-size: 1.4em; margin: 15px 0; line-height: 1.6; }"
-        ".joystick-details { font-size: 0.9em; color: #555; margin-top: 5px; margin-bottom: 15px; }"
-        "hr { width: 70%%; margin: 25px auto; border: 0; height: 1px; background-color: #cccccc; }"
-        ".container { background-color: #fff; padding: 20px; border-radius: 8px; box-shadow: 0 0 10px rgba(0,0,0,0.1); display: inline-block; }"
-        ".compass { width: 100px; height: 100px; border: 2px solid #aaa; border-radius: 50%%; position: relative; margin: 20px auto 10px auto; background-color: #e9e9e9; }"
-        ".compass-arrow { width: 0; height: 0; border-left: 10px solid transparent; border-right: 10px solid transparent; border-bottom: 35px solid #d9534f; position: absolute; top: 15px; left: 50%%; transform-origin: 50%% 80%%; transform: translateX(-50%%) rotate(0deg); transition: transform 0.3s ease-out; }"
-        ".compass-center-dot { width: 10px; height: 10px; background-color: #333; border-radius: 50%%; position: absolute; top: 50%%; left: 50%%; transform: translate(-50%%, -50%%); display: none; }"
-        ".compass.dir-n .compass-arrow { display: block; transform: translateX(-50%%) rotate(0deg); }"
-        ".compass.dir-ne .compass-arrow { display: block; transform: translateX(-50%%) rotate(45deg); }"
-        ".compass.dir-e .compass-arrow { display: block; transform: translateX(-50%%) rotate(90deg); }"
-        ".compass.dir-se .compass-arrow { display: block; transform: translateX(-50%%) rotate(135deg); }"
-        ".compass.dir-s .compass-arrow { display: block; transform: translateX(-50%%) rotate(180deg); }"
-        ".compass.dir-sw .compass-arrow { display: block; transform: translateX(-50%%) rotate(225deg); }"
-        ".compass.dir-w .compass-arrow { display: block; transform: translateX(-50%%) rotate(270deg); }"
-        ".compass.dir-nw .compass-arrow { display: block; transform: translateX(-50%%) rotate(315deg); }"
-        ".compass.dir-center .compass-arrow { display: none; }" 
-        ".compass.dir-center .compass-center-dot { display: block; }"
-        "</style>"
-        "</head><body>"
-        "<div class='container'>"
-        "<h1>RP 2040 - BitDogLab</h1>" // Título principal da página 
-        "<p style=\"color: %s;\">Temperatura interna: %.2f °C</p>"
-        "<hr>"
-        "<p>%s</p>"
-        "<hr>"
-        "<div class=\"compass %s\"><div class=\"compass-arrow\"></div><div class=\"compass-center-dot\"></div></div>"
-        "<p style=\"margin-top: 0px;\">%s</p>"
-        "<p class='joystick-details'>%s</p>"
-        "</div>"
-        "<script>setTimeout(function(){ window.location.reload(true); }, 1000);</script>"
-        "</body></html>",
-        temp_color_str, temperature, button_str, joystick_css_class_str, joystick_direction_text_str, joystick_values_str
-    );
-
-    if (len < 0 || len >= sizeof(html)) {
-        printf("ERRO FATAL: Overflow do buffer HTML! len: %d, size: %u\n", len, sizeof(html));
-        // Em caso de overflow, envia uma resposta de erro mínima.
-        const char *error_msg = "HTTP/1.1 500 Internal Server Error\r\nContent-Length:0\r\nConnection:close\r\n\r\n";
-        tcp_write(tpcb, error_msg, strlen(error_msg), TCP_WRITE_FLAG_COPY);
-        tcp_arg(tpcb, NULL); tcp_recv(tpcb, NULL); tcp_sent(tpcb, NULL); tcp_poll(tpcb, NULL, 0); tcp_err(tpcb, NULL);
-        tcp_abort(tpcb);
+    err_t write_err = tcp_write(client->pcb, data, len, TCP_WRITE_FLAG_COPY);
+    if (write_err == ERR_MEM) {
+        client->pending = true; // Sem memória agora; tenta de novo no próximo tcp_sent
+        return ERR_OK;
+    }
+    if (write_err != ERR_OK) {
+        printf("ERRO SSE: Falha ao enviar evento (tcp_write) - código %d\n", write_err);
+        sse_abort_client(client);
         return ERR_ABRT;
     }
-   
+    client->unacked += len;
+    client->pending = false;
+
+    err_t output_err = tcp_output(client->pcb);
+    if (output_err != ERR_OK) {
+        printf("ERRO SSE: Falha ao despachar evento (tcp_output) - código %d\n", output_err);
+        sse_abort_client(client);
+        return ERR_ABRT;
+    }
+    return ERR_OK;
+}
+
+static err_t sse_sent_callback(void *arg, struct tcp_pcb *tpcb, u16_t len) {
+    sse_client_t *client = (sse_client_t *)arg;
+    client->unacked = (len >= client->unacked) ? 0 : client->unacked - len;
+    if (client->pending && g_sse_last_event_len > 0) {
+        return sse_send_to_client(client, g_sse_last_event, g_sse_last_event_len);
+    }
+    return ERR_OK;
+}
+
+static err_t sse_recv_callback(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t err) {
+    sse_client_t *client = (sse_client_t *)arg;
+    if (p == NULL) { // Cliente fechou a conexão
+        sse_release_client(client);
+        return http_detached_close(tpcb);
+    }
+    // O cliente não deve mandar nada depois da requisição; dados extras são descartados.
+    tcp_recved(tpcb, p->tot_len);
+    pbuf_free(p);
+    return ERR_OK;
+}
+
+static void sse_error_callback(void *arg, err_t err) {
+    // O PCB já foi liberado pela LwIP; apenas libera o slot e a vaga no orçamento.
+    sse_release_client((sse_client_t *)arg);
+    http_detached_lost();
+    if (err != ERR_ABRT && err != ERR_RST) {
+        printf("ERRO SSE: Callback de erro TCP - código %d\n", err);
+    }
+}
+
+// Há vaga para mais um stream (/stream ou /ws) sem tomar a reservada às requisições comuns?
+static bool stream_slot_available(void) {
+    u16_t pooled, detached;
+    http_server_get_open(&pooled, &detached);
+    return detached < STREAM_MAX_CLIENTS;
+}
+
+// GET /stream : assume a conexão como cliente SSE e envia o estado atual.
+static err_t sse_accept_client(http_conn_t *conn, const http_request_t *request) {
+    sse_client_t *client = NULL;
+    for (int i = 0; i < SSE_MAX_CLIENTS; i++) {
+        if (g_sse_clients[i].pcb == NULL) {
+            client = &g_sse_clients[i];
+            break;
+        }
+    }
+    if (client == NULL || !stream_slot_available()) {
+        metrics_count(METRICS_SSE_REJECTED);
+        return http_send_response(conn, 503, "Retry-After: 5\r\n", NULL, 0, false);
+    }
 
-    err_t write_err = tcp_write(tpcb, html, len, TCP_WRITE_FLAG_COPY);
+    struct tcp_pcb *tpcb = http_conn_detach(conn); // A conexão passa a ser do stream
+    if (tpcb == NULL) {
+        return ERR_MEM; // Respostas anteriores ainda em voo; tenta de novo após o ACK
+    }
+    static const char header[] =
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: text/event-stream\r\n"
+        "Cache-Control: no-store\r\n"
+        "Connection: keep-alive\r\n\r\n"
+        "retry: 2000\n\n";
+    err_t write_err = tcp_write(tpcb, header, sizeof(header) - 1, 0);
     if (write_err != ERR_OK) {
-        printf("ERRO TCP: Falha ao enviar dados (tcp_write) - código %d\n", write_err);
-        tcp_arg(tpcb, NULL); tcp_recv(tpcb, NULL); tcp_sent(tpcb, NULL); tcp_poll(tpcb, NULL, 0); tcp_err(tpcb, NULL);
-        tcp_abort(tpcb);
+        printf("ERRO SSE: Falha ao enviar cabeçalho (tcp_write) - código %d\n", write_err);
+        metrics_count(METRICS_SSE_ABORTS);
+        http_detached_abort(tpcb);
         return ERR_ABRT;
     }
 
+    client->pcb = tpcb;
+    client->unacked = sizeof(header) - 1;
+    client->pending = false;
+    tcp_arg(tpcb, client);
+    tcp_recv(tpcb, sse_recv_callback);
+    tcp_sent(tpcb, sse_sent_callback);
+    tcp_err(tpcb, sse_error_callback);
+    tcp_nagle_disable(tpcb); // Eventos pequenos devem sair imediatamente
+
+    if (g_sse_last_event_len > 0) {
+        return sse_send_to_client(client, g_sse_last_event, g_sse_last_event_len);
+    }
     err_t output_err = tcp_output(tpcb);
     if (output_err != ERR_OK) {
-        printf("ERRO TCP: Falha ao despachar dados (tcp_output) - código %d\n", output_err);
-        tcp_arg(tpcb, NULL); tcp_recv(tpcb, NULL); tcp_sent(tpcb, NULL); tcp_poll(tpcb, NULL, 0); tcp_err(tpcb, NULL);
-        tcp_abort(tpcb);
+        printf("ERRO SSE: Falha ao despachar cabeçalho (tcp_output) - código %d\n", output_err);
+        sse_abort_client(client);
         return ERR_ABRT;
     }
-    
-    err_t close_err = tcp_close(tpcb);
-    if (close_err != ERR_OK) {
-        printf("ERRO TCP: Falha ao fechar conexão (tcp_close) - código %d. Abortando.\n", close_err);
-        tcp_arg(tpcb, NULL); tcp_recv(tpcb, NULL); tcp_sent(tpcb, NULL); tcp_poll(tpcb, NULL, 0); tcp_err(tpcb, NULL);
-        tcp_abort(tpcb);
-        return ERR_ABRT;
+    return ERR_OK;
+}
+
+// Chamado pelo loop de rede a cada snapshot novo: envia um evento se o estado mudou
+// (change_generation, ou eixo além de SSE_AXIS_DELTA) ou se o heartbeat venceu.
+static void sse_broadcast_state(const input_snapshot_t *state) {
+    static uint16_t last_vrx = 0, last_vry = 0;
+    static uint32_t last_change_generation = 0;
+    static uint32_t last_event_ms = 0;
+    static int32_t temperature_centi = 0;
+
+    bool any_client = false;
+    for (int i = 0; i < SSE_MAX_CLIENTS; i++) {
+        if (g_sse_clients[i].pcb != NULL) any_client = true;
+    }
+
+    uint32_t now_ms = to_ms_since_boot(get_absolute_time());
+    bool heartbeat = (now_ms - last_event_ms) >= SSE_HEARTBEAT_MS || g_sse_last_event_len == 0;
+    bool changed = state->change_generation != last_change_generation
+                || abs((int)state->vrx - (int)last_vrx) >= SSE_AXIS_DELTA
+                || abs((int)state->vry - (int)last_vry) >= SSE_AXIS_DELTA;
+    if (!changed && !heartbeat) {
+        return;
+    }
+
+    if (heartbeat) {
+        temperature_centi = read_temperature_centi(state); // A temperatura varia devagar: só no heartbeat
+    }
+    last_vrx = state->vrx;
+    last_vry = state->vry;
+    last_change_generation = state->change_generation;
+    last_event_ms = now_ms;
+
+    // "data: {...}\n\n": o JSON é formatado direto no lugar, depois do prefixo
+    char event[sizeof(g_sse_last_event)];
+    int json_len = format_status_json(event + 6, sizeof(event) - 8, state, temperature_centi);
+    memcpy(event, "data: ", 6);
+    memcpy(event + 6 + json_len, "\n\n", 2);
+
+    cyw43_arch_lwip_begin(); // Callbacks da LwIP rodam em segundo plano; protege o acesso
+    g_sse_last_event_len = (u16_t)(json_len + 8);
+    memcpy(g_sse_last_event, event, g_sse_last_event_len);
+    if (any_client) {
+        for (int i = 0; i < SSE_MAX_CLIENTS; i++) {
+            if (g_sse_clients[i].pcb != NULL) {
+                sse_send_to_client(&g_sse_clients[i], g_sse_last_event, g_sse_last_event_len);
+            }
+        }
+    }
+    cyw43_arch_lwip_end();
+}
+
+// --- WebSocket (/ws) ---
+// Transmite cada amostra do loop principal como um quadro binário de WS_SAMPLE_LEN bytes
+// (little-endian): timestamp_us (u32), VRx (u16), VRy (u16), direção (u8), botões (u8, bit0 = A,
+// bit1 = B pressionado), sequência (u16). Clientes lentos perdem amostras intermediárias
+// (contadas em 'dropped'); o loop de amostragem nunca espera pela rede.
+
+typedef struct {
+    struct tcp_pcb *pcb;               // NULL = slot livre
+    u32_t unacked;                     // Bytes escritos e ainda não confirmados
+    u32_t dropped;                     // Amostras descartadas por falta de espaço de envio
+    bool closing;                      // Quadro de fechamento já enviado
+    u16_t rx_len;
+    uint8_t rx[WS_RX_BUF_SIZE];        // Quadros de controle recebidos (ping/close) ainda incompletos
+} ws_client_t;
+
+static ws_client_t g_ws_clients[WS_MAX_CLIENTS];
+static uint16_t g_ws_sample_seq = 0;
+// Algum cliente de /ws conectado: o núcleo 1 conta como atividade e fica na rajada (200 Hz),
+// senão o ocioso derrubaria o /ws para 2 amostras por segundo.
+static volatile bool g_ws_connected = false;
+
+static void ws_update_connected(void) {
+    bool connected = false;
+    for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+        connected |= g_ws_clients[i].pcb != NULL;
+    }
+    g_ws_connected = connected;
+}
+
+static void ws_release_client(ws_client_t *client) {
+    client->pcb = NULL;
+    client->unacked = 0;
+    client->dropped = 0;
+    client->closing = false;
+    client->rx_len = 0;
+    ws_update_connected();
+}
+
+static void ws_abort_client(ws_client_t *client) {
+    struct tcp_pcb *tpcb = client->pcb;
+    metrics_count(METRICS_WS_ABORTS);
+    ws_release_client(client);
+    http_detached_abort(tpcb);
+}
+
+// Fecha a conexão TCP (após o handshake de fechamento ou quando o cliente desconecta).
+static err_t ws_close_client(ws_client_t *client) {
+    struct tcp_pcb *tpcb = client->pcb;
+    ws_release_client(client);
+    return http_detached_close(tpcb);
+}
+
+// Envia um quadro completo (cabeçalho + payload). Retorna ERR_MEM se não houver espaço agora.
+static err_t ws_send_frame(ws_client_t *client, ws_opcode_t opcode, const uint8_t *payload, u16_t len) {
+    uint8_t frame[WS_MAX_HEADER_LEN + WS_RX_BUF_SIZE];
+    if (len > WS_RX_BUF_SIZE) {
+        return ERR_VAL;
+    }
+    size_t header_len = ws_encode_frame_header(frame, opcode, len);
+    memcpy(frame + header_len, payload, len);
+    u16_t frame_len = (u16_t)(header_len + len);
+
+    if (tcp_sndbuf(client->pcb) < frame_len || !http_tx_mem_available(frame_len)) {
+        return ERR_MEM;
+    }
+    err_t write_err = tcp_write(client->pcb, frame, frame_len, TCP_WRITE_FLAG_COPY);
+    if (write_err != ERR_OK) {
+        return write_err;
+    }
+    client->unacked += frame_len;
+    return tcp_output(client->pcb);
+}
+
+// Inicia o fechamento: envia o quadro CLOSE com o código e aguarda o CLOSE do cliente.
+static err_t ws_start_close(ws_client_t *client, uint16_t code) {
+    if (client->closing) {
+        return ws_close_client(client); // Cliente insiste depois do CLOSE: encerra de vez
+    }
+    uint8_t payload[2] = { (uint8_t)(code >> 8), (uint8_t)code };
+    client->closing = true;
+    err_t send_err = ws_send_frame(client, WS_OPCODE_CLOSE, payload, sizeof(payload));
+    if (send_err != ERR_OK) {
+        return ws_close_client(client);
+    }
+    return ERR_OK;
+}
+
+// Processa os quadros completos acumulados em client->rx.
+static err_t ws_process_frames(ws_client_t *client) {
+    while (client->rx_len > 0) {
+        ws_frame_info_t frame;
+        int parsed = ws_parse_frame_header(client->rx, client->rx_len, WS_RX_BUF_SIZE, &frame);
+        if (parsed == WS_PARSE_INVALID) {
+            return ws_start_close(client, WS_CLOSE_PROTOCOL_ERROR);
+        }
+        if (parsed == WS_PARSE_TOO_BIG) {
+            return ws_start_close(client, WS_CLOSE_TOO_BIG);
+        }
+        if (parsed == 0) {
+            return ERR_OK; // Cabeçalho incompleto: espera mais dados
+        }
+        if (!frame.masked) {
+            return ws_start_close(client, WS_CLOSE_PROTOCOL_ERROR); // Cliente deve sempre mascarar
+        }
+        // Subtração, não soma: header_len + payload_len poderia dar a volta em 64 bits
+        if (frame.payload_len > WS_RX_BUF_SIZE - frame.header_len) {
+            return ws_start_close(client, WS_CLOSE_TOO_BIG);
+        }
+        u16_t frame_len = (u16_t)(frame.header_len + frame.payload_len);
+        if (client->rx_len < frame_len) {
+            return ERR_OK; // Payload incompleto
+        }
+
+        uint8_t *payload = client->rx + frame.header_len;
+        u16_t payload_len = (u16_t)frame.payload_len;
+        ws_apply_mask(payload, payload_len, frame.mask);
+
+        err_t result = ERR_OK;
+        switch (frame.opcode) {
+            case WS_OPCODE_PING:
+                result = ws_send_frame(client, WS_OPCODE_PONG, payload, payload_len);
+                if (result == ERR_MEM) result = ERR_OK; // Pong perdido não é fatal: o cliente tenta de novo
+                break;
+            case WS_OPCODE_CLOSE:
+                if (!client->closing) {
+                    // Ecoa o código recebido (ou nenhum) e encerra
+                    client->closing = true;
+                    ws_send_frame(client, WS_OPCODE_CLOSE, payload, payload_len >= 2 ? 2 : 0);
+                }
+                return ws_close_client(client);
+            case WS_OPCODE_PONG:
+            case WS_OPCODE_TEXT:
+            case WS_OPCODE_BINARY:
+            case WS_OPCODE_CONTINUATION:
+                break; // O stream é só de saída; dados do cliente são ignorados
+            default:
+                return ws_start_close(client, WS_CLOSE_PROTOCOL_ERROR);
+        }
+        if (result != ERR_OK) {
+            printf("ERRO WS: Falha ao responder quadro de controle - código %d\n", result);
+            ws_abort_client(client);
+            return ERR_ABRT;
+        }
+
+        memmove(client->rx, client->rx + frame_len, client->rx_len - frame_len);
+        client->rx_len -= frame_len;
     }
-    
     return ERR_OK;
 }
 
-// Callback para quando uma nova conexão TCP é aceita pelo servidor
-static err_t tcp_server_accept_callback(void *arg, struct tcp_pcb *newpcb, err_t err) {
-    if (err != ERR_OK || newpcb == NULL) {
-        printf("ERRO TCP: Falha ao aceitar nova conexão - código %d\n", err);
-        return ERR_VAL; // Indica um erro
+static err_t ws_recv_callback(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t err) {
+    ws_client_t *client = (ws_client_t *)arg;
+    if (p == NULL) { // Cliente fechou a conexão TCP
+        return ws_close_client(client);
     }
 
-    tcp_setprio(newpcb, TCP_PRIO_NORMAL); // Define prioridade da conexão
-    tcp_arg(newpcb, newpcb); // Argumento para os callbacks (geralmente o próprio PCB)
-    tcp_recv(newpcb, tcp_server_recv_callback); // Define callback para dados recebidos
-    tcp_err(newpcb, tcp_server_error_callback); // Define callback para erros na conexão
-    
-    return ERR_OK; // Sucesso
+    tcp_recved(tpcb, p->tot_len);
+    u16_t space = WS_RX_BUF_SIZE - client->rx_len;
+    if (p->tot_len > space) {
+        pbuf_free(p);
+        return ws_start_close(client, WS_CLOSE_TOO_BIG);
+    }
+    client->rx_len += pbuf_copy_partial(p, client->rx + client->rx_len, p->tot_len, 0);
+    pbuf_free(p);
+    return ws_process_frames(client);
 }
 
-// Inicializa os componentes do servidor TCP
-static bool initialize_tcp_server(void) {
-    printf("INFO: Configurando servidor TCP...\n");
-    struct tcp_pcb *pcb_listen = tcp_new_ip_type(IPADDR_TYPE_ANY);
-    if (!pcb_listen) {
-        printf("ERRO FATAL: Falha ao criar PCB para escuta TCP.\n");
-        return false;
+static err_t ws_sent_callback(void *arg, struct tcp_pcb *tpcb, u16_t len) {
+    ws_client_t *client = (ws_client_t *)arg;
+    client->unacked = (len >= client->unacked) ? 0 : client->unacked - len;
+    return ERR_OK;
+}
+
+static void ws_error_callback(void *arg, err_t err) {
+    ws_release_client((ws_client_t *)arg); // O PCB já foi liberado pela LwIP
+    http_detached_lost();
+    if (err != ERR_ABRT && err != ERR_RST) {
+        printf("ERRO WS: Callback de erro TCP - código %d\n", err);
     }
+}
 
-    err_t bind_err = tcp_bind(pcb_listen, IP_ANY_TYPE, TCP_PORT);
-    if (bind_err != ERR_OK) {
-        printf("ERRO FATAL: Falha ao associar (bind) servidor TCP à porta %d - código %d\n", TCP_PORT, bind_err);
-        tcp_close(pcb_listen);
-        return false;
+// GET /ws com "Upgrade: websocket": responde o handshake e passa a conexão para o stream binário.
+static err_t ws_accept_client(http_conn_t *conn, const http_request_t *request) {
+    size_t key_len = strlen(request->websocket_key);
+    if (!request->websocket_upgrade || key_len != WS_KEY_LEN) {
+        return http_send_response(conn, 400, NULL, NULL, 0, false);
     }
 
-    pcb_listen = tcp_listen_with_backlog(pcb_listen, HTTP_SERVER_BACKLOG);
-    if (!pcb_listen) {
-        printf("ERRO FATAL: Falha ao colocar servidor TCP em modo de escuta.\n");
-        // O PCB original pode ter sido desalocado em caso de erro aqui
-        return false;
+    ws_client_t *client = NULL;
+    for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+        if (g_ws_clients[i].pcb == NULL) {
+            client = &g_ws_clients[i];
+            break;
+        }
+    }
+    if (client == NULL || !stream_slot_available()) {
+        metrics_count(METRICS_WS_REJECTED);
+        return http_send_response(conn, 503, "Retry-After: 5\r\n", NULL, 0, false);
     }
 
-    tcp_accept(pcb_listen, tcp_server_accept_callback);
-    printf("INFO: Servidor TCP ouvindo na porta %d.\n", TCP_PORT);
-    return true;
+    char accept_key[WS_ACCEPT_LEN + 1];
+    ws_compute_accept_key(request->websocket_key, key_len, accept_key);
+    struct tcp_pcb *tpcb = http_conn_detach(conn); // A conexão passa a ser do stream WebSocket
+    if (tpcb == NULL) {
+        return ERR_MEM; // Respostas anteriores ainda em voo; tenta de novo após o ACK
+    }
+
+    char header[160];
+    fmt_buf_t out;
+    fmt_init(&out, header, sizeof(header));
+    FMT_LIT(&out, "HTTP/1.1 101 Switching Protocols\r\n"
+                  "Upgrade: websocket\r\n"
+                  "Connection: Upgrade\r\n"
+                  "Sec-WebSocket-Accept: ");
+    fmt_mem(&out, accept_key, WS_ACCEPT_LEN);
+    FMT_LIT(&out, "\r\n\r\n");
+    int header_len = (int)out.len;
+    err_t write_err = tcp_write(tpcb, header, (u16_t)header_len, TCP_WRITE_FLAG_COPY);
+    if (write_err != ERR_OK) {
+        printf("ERRO WS: Falha ao enviar handshake (tcp_write) - código %d\n", write_err);
+        metrics_count(METRICS_WS_ABORTS);
+        http_detached_abort(tpcb);
+        return ERR_ABRT;
+    }
+
+    ws_release_client(client);
+    client->pcb = tpcb;
+    client->unacked = (u32_t)header_len;
+    ws_update_connected();
+    tcp_arg(tpcb, client);
+    tcp_recv(tpcb, ws_recv_callback);
+    tcp_sent(tpcb, ws_sent_callback);
+    tcp_err(tpcb, ws_error_callback);
+    tcp_nagle_disable(tpcb); // Quadros pequenos devem sair a cada amostra
+
+    err_t output_err = tcp_output(tpcb);
+    if (output_err != ERR_OK) {
+        printf("ERRO WS: Falha ao despachar handshake (tcp_output) - código %d\n", output_err);
+        ws_abort_client(client);
+        return ERR_ABRT;
+    }
+    printf("INFO: Cliente WebSocket conectado.\n");
+    return ERR_OK;
 }
 
-// Lê os pinos de entrada e atualiza o estado global
-static void read_inputs_and_update_state(void) {
-    adc_select_input(0); // ADC0 (GPIO26) para VRY
-    g_joystick_vry_value = adc_read();
-    adc_select_input(1); // ADC1 (GPIO27) para VRX
-    g_joystick_vrx_value = adc_read();
-
-    bool is_south = (g_joystick_vry_value < JOYSTICK_LOW_THRESHOLD);
-    bool is_north = (g_joystick_vry_value > JOYSTICK_HIGH_THRESHOLD);
-    bool is_west  = (g_joystick_vrx_value < JOYSTICK_LOW_THRESHOLD);
-    bool is_east  = (g_joystick_vrx_value > JOYSTICK_HIGH_THRESHOLD);
-
-    if (is_north && is_west) g_joystick_direction = NORTHWEST;
-    else if (is_north && is_east) g_joystick_direction = NORTHEAST;
-    else if (is_south && is_west) g_joystick_direction = SOUTHWEST;
-    else if (is_south && is_east) g_joystick_direction = SOUTHEAST;
-    else if (is_north) g_joystick_direction = NORTH;
-    else if (is_south) g_joystick_direction = SOUTH;
-    else if (is_west) g_joystick_direction = WEST;
-    else if (is_east) g_joystick_direction = EAST;
-    else g_joystick_direction = CENTER;
-    
-    // Detecção de borda de descida para os botões (pressionamento)
-    // Assumindo pull-ups internos, botões são ativos em nível baixo.
-    static bool prev_button_a_state = true; // Inicializa como não pressionado
-    static bool prev_button_b_state = true; // Inicializa como não pressionado
+// Chamado pelo loop de rede a cada snapshot novo: envia o quadro binário para todos os clientes.
+static void ws_broadcast_sample(const input_snapshot_t *state) {
+    uint32_t timestamp_us = (uint32_t)state->timestamp_us;
+    uint16_t vrx = state->vrx;
+    uint16_t vry = state->vry;
+    uint16_t seq = g_ws_sample_seq++;
+    uint8_t sample[WS_SAMPLE_LEN] = {
+        (uint8_t)timestamp_us, (uint8_t)(timestamp_us >> 8), (uint8_t)(timestamp_us >> 16), (uint8_t)(timestamp_us >> 24),
+        (uint8_t)vrx, (uint8_t)(vrx >> 8),
+        (uint8_t)vry, (uint8_t)(vry >> 8),
+        (uint8_t)state->direction,
+        state->button_state_bits,
+        (uint8_t)seq, (uint8_t)(seq >> 8)
+    };
+
+    cyw43_arch_lwip_begin();
+    for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+        ws_client_t *client = &g_ws_clients[i];
+        if (client->pcb == NULL || client->closing) {
+            continue;
+        }
+        if (client->unacked + WS_MAX_HEADER_LEN + WS_SAMPLE_LEN > WS_MAX_INFLIGHT) {
+            client->dropped++; // Backpressure: descarta esta amostra, a próxima leva o estado atual
+            continue;
+        }
+        err_t send_err = ws_send_frame(client, WS_OPCODE_BINARY, sample, sizeof(sample));
+        if (send_err == ERR_MEM) {
+            client->dropped++;
+        } else if (send_err != ERR_OK) {
+            printf("ERRO WS: Falha ao enviar amostra - código %d\n", send_err);
+            ws_abort_client(client);
+        }
+    }
+    cyw43_arch_lwip_end();
+}
+
+// --- Workers do async_context (núcleo 0) ---
+// A LwIP e o CYW43 são atendidos em segundo plano por IRQ (pico_cyw43_arch_lwip_threadsafe_background).
+// O núcleo 1 acorda o worker de publicação a cada snapshot novo; o relatório de estatísticas é um
+// worker agendado. Fora disso o núcleo 0 fica em WFE.
+
+static async_when_pending_worker_t g_publish_worker = { .do_work = publish_worker_do_work };
+static async_at_time_worker_t g_stats_worker = { .do_work = stats_worker_do_work };
+static async_context_t *volatile g_network_context = NULL; // Definido após registrar os workers
 
-    bool current_button_a_state = gpio_get(BUTTON_A_PIN);
-    bool current_button_b_state = gpio_get(BUTTON_B_PIN);
+static struct {
+    uint64_t window_start_us;
+    uint64_t busy_us;                // Tempo gasto no worker de publicação
+    uint32_t pushes;
+    uint32_t max_push_latency_us;    // Da amostra (núcleo 1) até o envio aos clientes
+} g_loop_stats;
 
-    if (!current_button_a_state && prev_button_a_state) {
-        g_last_button_type = BUTTON_A_EVENT;
-         printf("DEBUG: Botão A pressionado.\n"); // Opcional para depuração
+// Envia o snapshot mais recente aos clientes de /stream e /ws, à telemetria UDP e ao MQTT.
+static void publish_worker_do_work(async_context_t *context, async_when_pending_worker_t *worker) {
+    static uint32_t last_generation = 0;
+    uint64_t start_us = time_us_64();
+
+    input_snapshot_t state;
+    input_state_read(&state); // Snapshot consistente publicado pelo núcleo 1
+    if (state.generation == last_generation) {
+        return; // Vários avisos antes de o worker rodar: o snapshot já foi enviado
     }
-    if (!current_button_b_state && prev_button_b_state) {
-        g_last_button_type = BUTTON_B_EVENT;
-         printf("DEBUG: Botão B pressionado.\n"); // Opcional para depuração
+    last_generation = state.generation;
+    sse_broadcast_state(&state); // Notifica os clientes de /stream se algo mudou
+    ws_broadcast_sample(&state); // Envia a amostra aos clientes de /ws
+    udp_telemetry_add(&state); // Acrescenta ao lote de telemetria UDP
+    mqtt_publisher_add(&state, read_temperature_centi(&state)); // Só as mudanças, em lotes
+
+    uint64_t end_us = time_us_64();
+    uint32_t latency_us = (uint32_t)(end_us - state.timestamp_us);
+    if (latency_us > g_loop_stats.max_push_latency_us) {
+        g_loop_stats.max_push_latency_us = latency_us;
+    }
+    g_loop_stats.busy_us += end_us - start_us;
+    g_loop_stats.pushes++;
+}
+
+// Relatório periódico: ociosidade do núcleo 0 e piores latências da janela.
+// A ociosidade considera o tempo medido nos handlers HTTP e no worker de publicação
+// (o driver do CYW43 e a própria LwIP não entram na conta).
+static void stats_worker_do_work(async_context_t *context, async_at_time_worker_t *worker) {
+    http_server_stats_t http_stats;
+    http_server_get_stats(&http_stats, true);
+
+    uint64_t now_us = time_us_64();
+    uint64_t window_us = now_us - g_loop_stats.window_start_us;
+    uint64_t busy_us = g_loop_stats.busy_us + http_stats.busy_us;
+    uint32_t idle_permille = (window_us > 0 && busy_us < window_us) ? (uint32_t)(1000 - busy_us * 1000 / window_us) : 0;
+
+    printf("STATS: ociosidade %lu.%lu%%, %lu requisições (pior %lu us), %lu envios (pior amostra->envio %lu us)\n",
+           (unsigned long)(idle_permille / 10), (unsigned long)(idle_permille % 10),
+           (unsigned long)http_stats.requests, (unsigned long)http_stats.max_handling_us,
+           (unsigned long)g_loop_stats.pushes, (unsigned long)g_loop_stats.max_push_latency_us);
+    latency_trace_print(); // Histogramas acumulados desde o boot, uma linha por etapa
+
+    memset(&g_loop_stats, 0, sizeof(g_loop_stats));
+    g_loop_stats.window_start_us = now_us;
+    async_context_add_at_time_worker_in_ms(context, worker, STATS_REPORT_INTERVAL_MS);
+}
+
+// --- Rotas HTTP ---
+static const http_route_t g_http_routes[] = {
+    { "/",           serve_asset },
+    { "/index.html", serve_asset },
+    { "/status",     serve_status },
+    { "/events",     serve_button_events },
+    { "/stream",     sse_accept_client },
+    { "/ws",         ws_accept_client },
+    { "/history",    history_serve },
+    { "/metrics",    metrics_serve },
+#if LATENCY_TRACE_ENABLED
+    { "/trace",      latency_trace_serve },
+#endif
+#if INPUT_TRACE_ENABLED
+    { "/record",     input_trace_serve },
+#endif
+};
+
+// Lê os pinos de entrada e atualiza o estado (roda no núcleo 1)
+static void read_inputs_and_update_state(input_snapshot_t *state) {
+    // O ADC é amostrado continuamente por DMA (adc_sampler.c); aqui pegamos a média de tudo o
+    // que foi convertido desde o ciclo anterior e a passamos pelo filtro do joystick.
+    adc_sampler_values_t adc_values;
+    adc_sampler_take_mean(&adc_values);
+    state->timestamp_us = time_us_64();
+    input_trace_add(state->timestamp_us, &adc_values); // Entrada do filtro, para reprodução no host (/record)
+
+    bool was_calibrated = g_joystick_filter.calibrated;
+    state->direction = joystick_filter_update(&g_joystick_filter, adc_values.vrx, adc_values.vry,
+                                              &state->vrx, &state->vry); // ADC1 (GPIO27), ADC0 (GPIO26)
+    state->temp_raw = adc_values.temp_raw;
+    if (!was_calibrated && g_joystick_filter.calibrated) {
+        if (g_joystick_filter.calib_restarts >= JOYSTICK_CALIB_MAX_RESTARTS) {
+            printf("AVISO JOYSTICK: Sem repouso após %lu recomeços; usando o centro configurado VRx=%u VRy=%u.\n",
+                   (unsigned long)g_joystick_filter.calib_restarts,
+                   g_joystick_filter.axis[0].center, g_joystick_filter.axis[1].center);
+        } else {
+            printf("INFO: Joystick calibrado: centro VRx=%u VRy=%u (%lu recomeços).\n",
+                   g_joystick_filter.axis[0].center, g_joystick_filter.axis[1].center,
+                   (unsigned long)g_joystick_filter.calib_restarts);
+        }
     }
     
-    prev_button_a_state = current_button_a_state;
-    prev_button_b_state = current_button_b_state;
+    // Botões: os eventos chegam já com debounce pela IRQ do GPIO (button_events.c);
+    // aqui só consumimos os novos desde a última passagem.
+    static uint32_t event_cursor = 0;
+    button_event_t events[8];
+    size_t count;
+    while ((count = button_events_read_since(event_cursor, events, 8)) > 0) {
+        for (size_t i = 0; i < count; i++) {
+            const button_event_t *ev = &events[i];
+            uint8_t bit = (ev->button == BUTTON_ID_A) ? 0x01 : 0x02;
+            event_cursor = ev->seq;
+            if (ev->pressed) {
+                state->last_button = (ev->button == BUTTON_ID_A) ? BUTTON_A_EVENT : BUTTON_B_EVENT;
+                state->button_event_count++;
+                state->button_state_bits |= bit;
+                printf("DEBUG: Botão %c pressionado.\n", ev->button == BUTTON_ID_A ? 'A' : 'B'); // Opcional para depuração
+            } else {
+                state->button_state_bits &= (uint8_t)~bit;
+            }
+        }
+        if (count < 8) break;
+    }
+}
+
+// Houve atividade desde a amostra anterior: joystick fora do centro, botão pressionado ou evento
+// novo, ou calibração em andamento (ela mede o centro na taxa da rajada e termina em no máximo
+// JOYSTICK_CALIB_MAX_RESTARTS recomeços).
+static bool inputs_active(const input_snapshot_t *state) {
+    static uint32_t last_button_count = 0;
+    bool buttons_changed = state->button_event_count != last_button_count;
+    last_button_count = state->button_event_count;
+    return state->direction != CENTER || state->button_state_bits != 0 || buttons_changed
+        || !g_joystick_filter.calibrated;
+}
+
+// Ajusta a taxa do ADC e a vigilância do joystick ao modo de amostragem.
+static void apply_sample_mode(sample_mode_t mode) {
+    if (mode == SAMPLE_MODE_IDLE) {
+        adc_sampler_set_rate(ADC_SAMPLER_IDLE_RATE_HZ);
+        adc_sampler_watch(g_joystick_filter.axis[0].center, g_joystick_filter.axis[1].center,
+                          joystick_filter_wake_radius(&g_joystick_filter));
+    } else {
+        adc_sampler_watch(0, 0, 0);
+        adc_sampler_set_rate(ADC_SAMPLER_RATE_HZ);
+    }
+}
+
+// Dorme até 'target' (WFE, como sleep_until). Cada interrupção deste núcleo (DMA do ADC, GPIO e
+// alarmes dos botões) tira o núcleo do WFE; retorna true, antes do prazo, se uma delas indicou
+// atividade: joystick fora da janela de adc_sampler_watch() ou evento de botão novo.
+static bool wait_next_sample(absolute_time_t target) {
+    uint32_t wake_count = adc_sampler_wake_count();
+    uint32_t button_seq = button_events_latest_seq();
+    while (!best_effort_wfe_or_timeout(target)) {
+        if (adc_sampler_wake_count() != wake_count || button_events_latest_seq() != button_seq) {
+            return true;
+        }
+    }
+    return false;
 }
 
+// Núcleo 1: aquisição e classificação no período de sample_scheduler.h (2 Hz ocioso, 200 Hz em
+// uso), independente da carga de rede. Cada ciclo publica um snapshot completo; o núcleo 0 nunca
+// espera por este laço.
+static void core1_acquisition_entry(void) {
+    adc_sampler_init(ADC_SAMPLER_RATE_HZ); // A IRQ do DMA do ADC fica neste núcleo
+    button_events_init(BUTTON_A_PIN, BUTTON_B_PIN); // IRQs de borda e alarmes de debounce também
+    input_trace_init(); // Bordas brutas dos botões para o trace (/record)
+    joystick_filter_init(&g_joystick_filter, &g_joystick_config); // Mede o centro nos primeiros ciclos
+
+    input_snapshot_t state = {0};
+    state.direction = CENTER;
+    state.last_button = NO_BUTTON_PRESSED_YET;
+
+    sample_scheduler_init(time_us_64());
+    sample_mode_t mode = SAMPLE_MODE_IDLE;
+    apply_sample_mode(mode);
+    bool woken = false;
+
+    absolute_time_t next_sample = get_absolute_time();
+    while (true) {
+        read_inputs_and_update_state(&state);
+        input_state_publish(&state);
+        history_add(&state); // Amostra e agregados de 1 s/1 min (/history)
+
+        // Acorda o núcleo 0 para enviar o snapshot (seguro a partir de outro núcleo)
+        async_context_t *network_context = g_network_context;
+        if (network_context != NULL) {
+            async_context_set_work_pending(network_context, &g_publish_worker);
+        }
+
+        bool active = woken || inputs_active(&state) || g_ws_connected;
+        sample_mode_t next_mode = sample_scheduler_update(state.timestamp_us, active);
+        if (next_mode != mode) {
+            mode = next_mode;
+            apply_sample_mode(mode);
+        }
+        next_sample = delayed_by_us(next_sample, sample_scheduler_period_us(mode));
+        woken = wait_next_sample(next_sample);
+        if (woken) {
+            next_sample = get_absolute_time(); // Amostra já, e a rajada conta o período a partir daqui
+        }
+    }
+}
+
+// Chamado por wifi_link.c (contexto da LwIP) quando o enlace sobe ou cai.
+static void network_link_changed(bool up) {
+    mqtt_publisher_link_changed(up);
+    if (up) {
+        if (http_server_resume()) {
+            printf("      Acesse: http://%s\n", ipaddr_ntoa(netif_ip_addr4(netif_default)));
+        }
+        return;
+    }
+    // Sem enlace, nada mais chega às conexões abertas: libera os slots em vez de esperar os
+    // timeouts de retransmissão. Os clientes se reconectam quando a rede voltar.
+    for (int i = 0; i < SSE_MAX_CLIENTS; i++) {
+        if (g_sse_clients[i].pcb != NULL) sse_abort_client(&g_sse_clients[i]);
+    }
+    for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+        if (g_ws_clients[i].pcb != NULL) ws_abort_client(&g_ws_clients[i]);
+    }
+    http_server_suspend();
+}
 
 int main() {
+    mem_usage_init(); // Antes de tudo: marca as pilhas para medir o uso máximo (/metrics)
     stdio_init_all();
     printf("INFO: Iniciando programa RP2040 - BitDogLab Web Controller...\n");
+#if FMT_BENCHMARK
+    sleep_ms(3000); // Tempo para o terminal abrir a porta USB e não perder o resultado
+    fmt_benchmark_run();
+#endif
 
     printf("INFO: Inicializando GPIOs para botões e ADC...\n");
     gpio_init(BUTTON_A_PIN);
@@ -338,49 +1164,56 @@ int main() {
     gpio_set_dir(BUTTON_B_PIN, GPIO_IN);
     gpio_pull_up(BUTTON_B_PIN);
     
-    adc_init();
     adc_gpio_init(JOYSTICK_VRY_PIN);
     adc_gpio_init(JOYSTICK_VRX_PIN);
-    adc_set_temp_sensor_enabled(true);
     printf("INFO: Periféricos GPIO e ADC inicializados.\n");
 
+    // A amostragem (ADC0/1/4 em round-robin via DMA) e a classificação rodam no núcleo 1
+    multicore_launch_core1(core1_acquisition_entry);
+    printf("INFO: Aquisição iniciada no núcleo 1.\n");
+
     printf("INFO: Inicializando Wi-Fi...\n");
     if (cyw43_arch_init()) {
         printf("ERRO FATAL: Falha ao inicializar arquitetura Wi-Fi (cyw43_arch).\n");
         return -1;
     }
     cyw43_arch_enable_sta_mode();
-    printf("INFO: Modo Wi-Fi Station habilitado. Conectando a '%s'...\n", WIFI_SSID);
 
-    int connect_status = cyw43_arch_wifi_connect_timeout_ms(WIFI_SSID, WIFI_PASSWORD, CYW43_AUTH_WPA2_AES_PSK, 30000);
-    if (connect_status) {
-        printf("ERRO FATAL: Falha ao conectar ao Wi-Fi. Código: %d\n", connect_status);
-        printf("          Verifique SSID, senha e alcance do roteador.\n");
-        cyw43_arch_deinit();
-        return -1;
+    // O servidor escuta em IP_ANY desde já; a associação e o DHCP seguem em segundo plano
+    // (wifi_link.c), com reconexão automática, enquanto o núcleo 1 já amostra.
+    cyw43_arch_lwip_begin();
+    bool server_ok = http_server_init(TCP_PORT, HTTP_SERVER_BACKLOG, g_http_routes, sizeof(g_http_routes) / sizeof(g_http_routes[0]));
+    if (server_ok && TELEMETRY_HOST[0] != '\0') {
+        udp_telemetry_init(TELEMETRY_HOST, TELEMETRY_PORT, TELEMETRY_BATCH_SAMPLES, TELEMETRY_INTERVAL_MS); // Falha não é fatal
     }
-    printf("INFO: Wi-Fi conectado com sucesso!\n");
-    if (netif_default) {
-        printf("INFO: Endereço IP: %s\n", ipaddr_ntoa(netif_ip_addr4(netif_default)));
-    } else {
-        printf("AVISO: Interface de rede padrão não encontrada. IP não disponível.\n");
+    if (server_ok && MQTT_BROKER_HOST[0] != '\0') {
+        const mqtt_publisher_config_t mqtt_config = {
+            .broker = MQTT_BROKER_HOST,
+            .port = MQTT_BROKER_PORT,
+            .client_id = MQTT_CLIENT_ID,
+            .topic_prefix = MQTT_TOPIC_PREFIX,
+            .max_rate_hz = MQTT_MAX_RATE_HZ,
+        };
+        mqtt_publisher_init(&mqtt_config); // Falha não é fatal; conecta quando o enlace subir
     }
-
-    if (!initialize_tcp_server()) {
+    cyw43_arch_lwip_end();
+    if (!server_ok) {
         cyw43_arch_deinit();
         return -1;
     }
-    
-    printf("INFO: Configuração completa. Aguardando interações e conexões HTTP...\n");
-    if (netif_default) { // Mensagem para o usuário acessar
-         printf("      Acesse: http://%s\n", ipaddr_ntoa(netif_ip_addr4(netif_default)));
-    }
+    wifi_link_start(WIFI_SSID, WIFI_PASSWORD, CYW43_AUTH_WPA2_AES_PSK, network_link_changed);
+
+    // Workers do núcleo 0: publicação sob demanda (acordado pelo núcleo 1) e relatório periódico
+    async_context_t *context = cyw43_arch_async_context();
+    async_context_add_when_pending_worker(context, &g_publish_worker);
+    g_loop_stats.window_start_us = time_us_64();
+    async_context_add_at_time_worker_in_ms(context, &g_stats_worker, STATS_REPORT_INTERVAL_MS);
+    g_network_context = context;
 
-    // Loop principal da aplicação
+    // Loop principal da aplicação: rede, amostragem e workers rodam por interrupção;
+    // o núcleo 0 dorme em WFE entre os eventos.
     while (true) {
-        cyw43_arch_poll(); // Processa eventos de rede e outras tarefas da arquitetura cyw43
-        read_inputs_and_update_state(); // Lê sensores e botões
-        sleep_ms(50); // Pequeno delay para reduzir carga da CPU e debounce simples
+        __wfe();
     }
 
     // Código abaixo normalmente não é alcançado em um sistema embarcado
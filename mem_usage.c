@@ -0,0 +1,47 @@
+#include "mem_usage.h"
+
+#include <malloc.h>
+#include <stddef.h>
+
+#define MEM_USAGE_STACK_PATTERN 0xDEADBEEFu
+#define MEM_USAGE_STACK_MARGIN_WORDS 32 // Não pinta o quadro atual da pilha do núcleo 0
+
+// Símbolos do linker script do SDK (memmap_default.ld): o heap vai de 'end' até __StackLimit;
+// a pilha do núcleo 0 fica em SCRATCH_Y e a do núcleo 1 em SCRATCH_X.
+extern uint32_t end;
+extern uint32_t __StackLimit;
+extern uint32_t __StackBottom, __StackTop;
+extern uint32_t __StackOneBottom, __StackOneTop;
+
+static void mem_usage_paint(uint32_t *from, uint32_t *to) {
+    for (uint32_t *p = from; p < to; p++) {
+        *p = MEM_USAGE_STACK_PATTERN;
+    }
+}
+
+// A pilha cresce para baixo: a primeira palavra alterada a partir do fundo marca o máximo.
+static uint32_t mem_usage_stack_peak(const uint32_t *bottom, const uint32_t *top) {
+    const uint32_t *p = bottom;
+    while (p < top && *p == MEM_USAGE_STACK_PATTERN) {
+        p++;
+    }
+    return (uint32_t)((const char *)top - (const char *)p);
+}
+
+void mem_usage_init(void) {
+    uint32_t marker;
+    mem_usage_paint(&__StackBottom, &marker - MEM_USAGE_STACK_MARGIN_WORDS);
+    mem_usage_paint(&__StackOneBottom, &__StackOneTop); // O núcleo 1 ainda não foi iniciado
+}
+
+void mem_usage_get(mem_usage_t *out) {
+    struct mallinfo info = mallinfo();
+    out->heap_size = (uint32_t)((char *)&__StackLimit - (char *)&end);
+    out->heap_used = (uint32_t)info.uordblks;
+    out->heap_peak = (uint32_t)info.arena;
+
+    out->stack_size[0] = (uint32_t)((char *)&__StackTop - (char *)&__StackBottom);
+    out->stack_peak[0] = mem_usage_stack_peak(&__StackBottom, &__StackTop);
+    out->stack_size[1] = (uint32_t)((char *)&__StackOneTop - (char *)&__StackOneBottom);
+    out->stack_peak[1] = mem_usage_stack_peak(&__StackOneBottom, &__StackOneTop);
+}
@@ -0,0 +1,29 @@
+/**
+ * @file mem_usage.h
+ * @brief Uso de RAM fora da LwIP: heap do C (malloc) e pilha de cada núcleo, com máximos.
+ *
+ * As pilhas são "pintadas" com um padrão conhecido antes de serem usadas; o máximo (high-water
+ * mark) é a parte do fim da pilha onde o padrão foi sobrescrito. A leitura só percorre as pilhas
+ * (2 KB cada por padrão), então pode ser feita a cada requisição de /metrics.
+ */
+
+#ifndef MEM_USAGE_H
+#define MEM_USAGE_H
+
+#include <stdint.h>
+
+typedef struct {
+    uint32_t heap_size;         // Espaço entre o fim dos dados estáticos e as pilhas
+    uint32_t heap_used;         // Alocado agora por malloc
+    uint32_t heap_peak;         // Obtido do sistema por malloc (sbrk): só cresce
+    uint32_t stack_size[2];     // Pilha de cada núcleo
+    uint32_t stack_peak[2];     // Maior profundidade já alcançada
+} mem_usage_t;
+
+// Pinta a pilha livre do núcleo 0 (abaixo do chamador) e toda a pilha do núcleo 1.
+// Deve ser chamada no início de main(), antes de multicore_launch_core1().
+void mem_usage_init(void);
+
+void mem_usage_get(mem_usage_t *out);
+
+#endif /* MEM_USAGE_H */
@@ -0,0 +1,441 @@
+#include "metrics.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "pico/time.h"
+#include "lwip/memp.h"
+#include "lwip/stats.h"
+
+#include "fmt.h"
+#include "input_trace.h"
+#include "mem_usage.h"
+#include "mqtt_publisher.h"
+#include "sample_scheduler.h"
+#include "wifi_link.h"
+
+#if !LWIP_STATS || !MEM_STATS || !MEMP_STATS || !TCP_STATS
+#error "metrics.c requer LWIP_STATS, MEM_STATS, MEMP_STATS e TCP_STATS em lwipopts.h"
+#endif
+
+// Nomes dos pools na ordem de lwip_stats.memp[] (o mesmo X-macro que a LwIP usa em memp.c).
+static const char *const g_memp_names[MEMP_MAX] = {
+#define LWIP_MEMPOOL(name, num, size, desc) #name,
+#include "lwip/priv/memp_std.h"
+};
+
+static uint32_t g_app_counters[METRICS_APP_COUNTER_COUNT];
+
+// Fotografia tirada no início de cada resposta: os contadores do servidor são copiados e as
+// pilhas percorridas uma vez só, não a cada linha. lwip_stats é lido diretamente.
+// Há uma fotografia só: um /metrics que chega com outro em andamento usa a mesma, se ela tiver
+// menos de METRICS_SNAPSHOT_SHARE_US (senão recebe 503). 'refs' conta os streams que a leem e
+// volta a zero no fim de cada um, inclusive com a conexão abortada (metrics_stream_done).
+static struct {
+    http_server_counters_t http;
+    u16_t open_pooled, open_detached;
+    mem_usage_t mem;
+    const http_route_t *routes;
+    size_t route_count;
+    u16_t refs;
+    uint64_t taken_us;
+} g_snapshot;
+
+#define METRICS_SNAPSHOT_SHARE_US 1000000u
+
+void metrics_count(metrics_app_counter_t counter) {
+    g_app_counters[counter]++;
+}
+
+// --- Famílias de métricas ---
+// Cada família tem um rótulo opcional e uma função que devolve a amostra 'i' (valor do rótulo e
+// valor), ou false quando acabaram as amostras.
+
+typedef bool (*metrics_value_fn)(u16_t i, const char **label_value, uint32_t *value);
+
+typedef struct {
+    const char *name;
+    const char *type;           // "counter" ou "gauge"
+    const char *help;
+    const char *label;          // NULL: uma única amostra sem rótulo
+    metrics_value_fn value;
+} metrics_family_t;
+
+static bool metrics_lwip_heap_bytes(u16_t i, const char **label_value, uint32_t *value) {
+    static const char *const states[] = { "size", "used", "peak" };
+    if (i >= 3) return false;
+    const struct stats_mem *heap = &lwip_stats.mem;
+    *label_value = states[i];
+    *value = (i == 0) ? heap->avail : (i == 1) ? heap->used : heap->max;
+    return true;
+}
+
+static bool metrics_lwip_heap_failures(u16_t i, const char **label_value, uint32_t *value) {
+    if (i > 0) return false;
+    *value = lwip_stats.mem.err;
+    return true;
+}
+
+// Pools: 'which' escolhe o campo de stats_mem (0 = total, 1 = em uso, 2 = máximo, 3 = falhas).
+static bool metrics_lwip_pool(u16_t i, const char **label_value, uint32_t *value, int which) {
+    if (i >= MEMP_MAX) return false;
+    const struct stats_mem *pool = lwip_stats.memp[i]; // Preenchido por memp_init()
+    *label_value = g_memp_names[i];
+    *value = (pool == NULL) ? 0 : (which == 0) ? pool->avail : (which == 1) ? pool->used : (which == 2) ? pool->max : pool->err;
+    return true;
+}
+
+static bool metrics_lwip_pool_size(u16_t i, const char **l, uint32_t *v) { return metrics_lwip_pool(i, l, v, 0); }
+static bool metrics_lwip_pool_used(u16_t i, const char **l, uint32_t *v) { return metrics_lwip_pool(i, l, v, 1); }
+static bool metrics_lwip_pool_peak(u16_t i, const char **l, uint32_t *v) { return metrics_lwip_pool(i, l, v, 2); }
+static bool metrics_lwip_pool_failures(u16_t i, const char **l, uint32_t *v) { return metrics_lwip_pool(i, l, v, 3); }
+
+static bool metrics_lwip_tcp(u16_t i, const char **label_value, uint32_t *value) {
+    static const char *const events[] = { "xmit", "recv", "drop", "memerr", "rterr", "proterr", "err" };
+    if (i >= sizeof(events) / sizeof(events[0])) return false;
+    const struct stats_proto *tcp = &lwip_stats.tcp;
+    const STAT_COUNTER counts[] = { tcp->xmit, tcp->recv, tcp->drop, tcp->memerr, tcp->rterr, tcp->proterr, tcp->err };
+    *label_value = events[i];
+    *value = counts[i];
+    return true;
+}
+
+static bool metrics_http_requests(u16_t i, const char **label_value, uint32_t *value) {
+    if (i < g_snapshot.route_count) {
+        *label_value = g_snapshot.routes[i].path;
+        *value = g_snapshot.http.route_requests[i];
+        return true;
+    }
+    if (i == g_snapshot.route_count) {
+        *label_value = "other"; // 404, 405 e requisições inválidas
+        *value = g_snapshot.http.other_requests;
+        return true;
+    }
+    return false;
+}
+
+static bool metrics_http_connections(u16_t i, const char **label_value, uint32_t *value) {
+    static const char *const events[] = { "accepted", "accept_failed", "rejected_503", "evicted", "error", "idle_closed" };
+    if (i >= 6) return false;
+    const http_server_counters_t *c = &g_snapshot.http;
+    const uint32_t counts[] = { c->accepted, c->accept_failures, c->rejected_503, c->evictions, c->conn_errors, c->idle_closes };
+    *label_value = events[i];
+    *value = counts[i];
+    return true;
+}
+
+static bool metrics_http_open(u16_t i, const char **label_value, uint32_t *value) {
+    if (i >= 2) return false;
+    *label_value = (i == 0) ? "pooled" : "detached";
+    *value = (i == 0) ? g_snapshot.open_pooled : g_snapshot.open_detached;
+    return true;
+}
+
+static bool metrics_http_aborts(u16_t i, const char **label_value, uint32_t *value) {
+    static const char *const sources[] = { "http", "sse", "ws" };
+    if (i >= 3) return false;
+    const uint32_t counts[] = { g_snapshot.http.aborts, g_app_counters[METRICS_SSE_ABORTS], g_app_counters[METRICS_WS_ABORTS] };
+    *label_value = sources[i];
+    *value = counts[i];
+    return true;
+}
+
+static bool metrics_http_write_errors(u16_t i, const char **label_value, uint32_t *value) {
+    if (i > 0) return false;
+    *value = g_snapshot.http.write_errors;
+    return true;
+}
+
+static bool metrics_http_sndbuf_full(u16_t i, const char **label_value, uint32_t *value) {
+    if (i > 0) return false;
+    *value = g_snapshot.http.sndbuf_full;
+    return true;
+}
+
+static bool metrics_http_mem_pressure(u16_t i, const char **label_value, uint32_t *value) {
+    if (i > 0) return false;
+    *value = g_snapshot.http.mem_pressure;
+    return true;
+}
+
+static bool metrics_http_overflow_500(u16_t i, const char **label_value, uint32_t *value) {
+    if (i > 0) return false;
+    *value = g_snapshot.http.overflow_500;
+    return true;
+}
+
+static bool metrics_stream_rejected(u16_t i, const char **label_value, uint32_t *value) {
+    if (i >= 2) return false;
+    *label_value = (i == 0) ? "/stream" : "/ws";
+    *value = g_app_counters[i == 0 ? METRICS_SSE_REJECTED : METRICS_WS_REJECTED];
+    return true;
+}
+
+static bool metrics_udp_telemetry(u16_t i, const char **label_value, uint32_t *value) {
+    if (i >= 2) return false;
+    *label_value = (i == 0) ? "sent" : "error";
+    *value = g_app_counters[i == 0 ? METRICS_UDP_DATAGRAMS : METRICS_UDP_SEND_ERRORS];
+    return true;
+}
+
+#if INPUT_TRACE_ENABLED
+static bool metrics_input_trace(u16_t i, const char **label_value, uint32_t *value) {
+    static const char *const records[] = { "block", "sample", "edge", "edge_lost" };
+    if (i >= 4) return false;
+    input_trace_stats_t trace;
+    input_trace_get_stats(&trace);
+    const uint32_t counts[] = { trace.blocks, trace.samples, trace.edges, trace.edges_lost };
+    *label_value = records[i];
+    *value = counts[i];
+    return true;
+}
+#endif
+
+// 'which': 0 = entradas no modo, 1 = ms no modo, 2 = amostras no modo.
+static bool metrics_sampler(u16_t i, const char **label_value, uint32_t *value, int which) {
+    if (i >= SAMPLE_MODE_COUNT) return false;
+    sample_scheduler_stats_t sampler;
+    sample_scheduler_get_stats(time_us_64(), &sampler);
+    *label_value = sample_scheduler_mode_name((sample_mode_t)i);
+    *value = (which == 0) ? sampler.entries[i] : (which == 1) ? sampler.time_ms[i] : sampler.samples[i];
+    return true;
+}
+
+static bool metrics_sampler_entries(u16_t i, const char **l, uint32_t *v) { return metrics_sampler(i, l, v, 0); }
+static bool metrics_sampler_time(u16_t i, const char **l, uint32_t *v) { return metrics_sampler(i, l, v, 1); }
+static bool metrics_sampler_samples(u16_t i, const char **l, uint32_t *v) { return metrics_sampler(i, l, v, 2); }
+
+static bool metrics_sampler_burst(u16_t i, const char **label_value, uint32_t *value) {
+    if (i > 0) return false;
+    sample_scheduler_stats_t sampler;
+    sample_scheduler_get_stats(time_us_64(), &sampler);
+    *value = sampler.mode == SAMPLE_MODE_BURST ? 1 : 0;
+    return true;
+}
+
+static bool metrics_wifi_up(u16_t i, const char **label_value, uint32_t *value) {
+    if (i > 0) return false;
+    wifi_link_stats_t wifi;
+    wifi_link_get_stats(&wifi);
+    *value = wifi.up ? 1 : 0;
+    return true;
+}
+
+static bool metrics_wifi_events(u16_t i, const char **label_value, uint32_t *value) {
+    static const char *const events[] = { "attempt", "connect", "failure", "disconnect" };
+    if (i >= 4) return false;
+    wifi_link_stats_t wifi;
+    wifi_link_get_stats(&wifi);
+    *label_value = events[i];
+    *value = (i == 0) ? wifi.attempts : (i == 1) ? wifi.connects : (i == 2) ? wifi.failures : wifi.disconnects;
+    return true;
+}
+
+static bool metrics_mqtt_connected(u16_t i, const char **label_value, uint32_t *value) {
+    if (i > 0) return false;
+    mqtt_publisher_stats_t mqtt;
+    mqtt_publisher_get_stats(&mqtt);
+    *value = mqtt.connected ? 1 : 0;
+    return true;
+}
+
+static bool metrics_mqtt_connections(u16_t i, const char **label_value, uint32_t *value) {
+    static const char *const events[] = { "attempt", "connect", "failure", "disconnect" };
+    if (i >= 4) return false;
+    mqtt_publisher_stats_t mqtt;
+    mqtt_publisher_get_stats(&mqtt);
+    *label_value = events[i];
+    *value = (i == 0) ? mqtt.attempts : (i == 1) ? mqtt.connects : (i == 2) ? mqtt.failures : mqtt.disconnects;
+    return true;
+}
+
+static bool metrics_mqtt_messages(u16_t i, const char **label_value, uint32_t *value) {
+    static const char *const results[] = { "published", "acked", "error", "coalesced", "dropped" };
+    if (i >= 5) return false;
+    mqtt_publisher_stats_t mqtt;
+    mqtt_publisher_get_stats(&mqtt);
+    *label_value = results[i];
+    *value = (i == 0) ? mqtt.published : (i == 1) ? mqtt.acked : (i == 2) ? mqtt.errors :
+             (i == 3) ? mqtt.coalesced : mqtt.dropped;
+    return true;
+}
+
+static bool metrics_mqtt_latency(u16_t i, const char **label_value, uint32_t *value) {
+    static const char *const stats[] = { "last", "mean", "max" };
+    if (i >= 3) return false;
+    mqtt_publisher_stats_t mqtt;
+    mqtt_publisher_get_stats(&mqtt);
+    *label_value = stats[i];
+    *value = (i == 0) ? mqtt.latency_last_us : (i == 1) ? mqtt.latency_mean_us : mqtt.latency_max_us;
+    return true;
+}
+
+static bool metrics_heap_bytes(u16_t i, const char **label_value, uint32_t *value) {
+    static const char *const states[] = { "size", "used", "peak" };
+    if (i >= 3) return false;
+    const mem_usage_t *m = &g_snapshot.mem;
+    *label_value = states[i];
+    *value = (i == 0) ? m->heap_size : (i == 1) ? m->heap_used : m->heap_peak;
+    return true;
+}
+
+static const char *const g_core_labels[] = { "0", "1" };
+
+static bool metrics_stack_size(u16_t i, const char **label_value, uint32_t *value) {
+    if (i >= 2) return false;
+    *label_value = g_core_labels[i];
+    *value = g_snapshot.mem.stack_size[i];
+    return true;
+}
+
+static bool metrics_stack_peak(u16_t i, const char **label_value, uint32_t *value) {
+    if (i >= 2) return false;
+    *label_value = g_core_labels[i];
+    *value = g_snapshot.mem.stack_peak[i];
+    return true;
+}
+
+static bool metrics_uptime(u16_t i, const char **label_value, uint32_t *value) {
+    if (i > 0) return false;
+    *value = (uint32_t)(time_us_64() / 1000000);
+    return true;
+}
+
+static const metrics_family_t g_metrics_families[] = {
+    { "lwip_heap_bytes", "gauge", "Heap da LwIP (MEM_SIZE): total, em uso e máximo.", "state", metrics_lwip_heap_bytes },
+    { "lwip_heap_alloc_failures_total", "counter", "Alocações negadas no heap da LwIP.", NULL, metrics_lwip_heap_failures },
+    { "lwip_pool_size", "gauge", "Elementos de cada pool da LwIP.", "pool", metrics_lwip_pool_size },
+    { "lwip_pool_used", "gauge", "Elementos em uso em cada pool.", "pool", metrics_lwip_pool_used },
+    { "lwip_pool_peak", "gauge", "Máximo de elementos em uso em cada pool.", "pool", metrics_lwip_pool_peak },
+    { "lwip_pool_alloc_failures_total", "counter", "Alocações negadas (pool esgotado).", "pool", metrics_lwip_pool_failures },
+    { "lwip_tcp_events_total", "counter", "Contadores TCP da LwIP (TCP_STATS).", "event", metrics_lwip_tcp },
+    { "http_requests_total", "counter", "Requisições HTTP por rota.", "path", metrics_http_requests },
+    { "http_connections_total", "counter", "Eventos de conexão do servidor HTTP.", "event", metrics_http_connections },
+    { "http_connections_open", "gauge", "Conexões no orçamento (HTTP_CONN_BUDGET): no pool e destacadas (SSE/WS).", "kind", metrics_http_open },
+    { "http_aborts_total", "counter", "Conexões abortadas pelo firmware.", "source", metrics_http_aborts },
+    { "http_write_errors_total", "counter", "Falhas de tcp_write/tcp_output/tcp_close.", NULL, metrics_http_write_errors },
+    { "http_sndbuf_full_total", "counter", "Respostas adiadas por buffer de envio cheio.", NULL, metrics_http_sndbuf_full },
+    { "http_mem_pressure_total", "counter", "Escritas adiadas por pouca memória livre na LwIP.", NULL, metrics_http_mem_pressure },
+    { "http_overflow_500_total", "counter", "Respostas 500 por cabeçalho maior que o buffer.", NULL, metrics_http_overflow_500 },
+    { "http_stream_rejected_total", "counter", "Clientes recusados (503) por falta de slot.", "path", metrics_stream_rejected },
+    { "telemetry_datagrams_total", "counter", "Datagramas de telemetria UDP.", "result", metrics_udp_telemetry },
+#if INPUT_TRACE_ENABLED
+    { "input_trace_records_total", "counter", "Trace de entradas (/record): blocos fechados, amostras, bordas e bordas perdidas.", "record", metrics_input_trace },
+#endif
+    { "input_sampler_mode_entries_total", "counter", "Transições da amostragem para cada modo (idle 2 Hz, burst 200 Hz).", "mode", metrics_sampler_entries },
+    { "input_sampler_mode_milliseconds_total", "counter", "Tempo da amostragem em cada modo.", "mode", metrics_sampler_time },
+    { "input_sampler_samples_total", "counter", "Amostras publicadas em cada modo.", "mode", metrics_sampler_samples },
+    { "input_sampler_burst", "gauge", "1 com a amostragem no modo burst.", NULL, metrics_sampler_burst },
+    { "wifi_link_up", "gauge", "1 com o Wi-Fi conectado e com IP.", NULL, metrics_wifi_up },
+    { "wifi_link_events_total", "counter", "Tentativas de conexão, conexões, falhas e quedas do Wi-Fi.", "event", metrics_wifi_events },
+    { "mqtt_connected", "gauge", "1 com o cliente MQTT conectado ao broker.", NULL, metrics_mqtt_connected },
+    { "mqtt_connections_total", "counter", "Tentativas de conexão, conexões, falhas e quedas do MQTT.", "event", metrics_mqtt_connections },
+    { "mqtt_messages_total", "counter", "Mensagens MQTT publicadas, confirmadas (ACK TCP), recusadas, linhas coalescidas e descartadas.", "result", metrics_mqtt_messages },
+    { "mqtt_publish_latency_us", "gauge", "Da amostra mais antiga do lote até o ACK do broker.", "stat", metrics_mqtt_latency },
+    { "pico_heap_bytes", "gauge", "Heap do C (malloc): total, em uso e máximo.", "state", metrics_heap_bytes },
+    { "pico_stack_size_bytes", "gauge", "Tamanho da pilha de cada núcleo.", "core", metrics_stack_size },
+    { "pico_stack_peak_bytes", "gauge", "Maior uso já medido da pilha de cada núcleo.", "core", metrics_stack_peak },
+    { "pico_uptime_seconds", "gauge", "Tempo desde o boot.", NULL, metrics_uptime },
+};
+
+#define METRICS_FAMILY_COUNT (sizeof(g_metrics_families) / sizeof(g_metrics_families[0]))
+
+// --- Resposta ---
+
+// Posição no stream: família atual e trecho dentro dela (os METRICS_HEADER_PIECES primeiros são
+// HELP/TYPE, depois uma amostra por trecho).
+typedef struct {
+    u16_t family;
+    u16_t line;
+} metrics_stream_state_t;
+
+// "# HELP <nome> ", o texto de ajuda e o "\n" (estes dois por referência: a ajuda pode ter qualquer
+// tamanho) e "# TYPE <nome> <tipo>\n".
+#define METRICS_HEADER_PIECES 4
+
+static bool metrics_stream_piece(void *state, u32_t index, char *scratch, http_piece_t *out) {
+    metrics_stream_state_t *s = (metrics_stream_state_t *)state;
+    while (s->family < METRICS_FAMILY_COUNT) {
+        const metrics_family_t *family = &g_metrics_families[s->family];
+        fmt_buf_t text;
+        fmt_init(&text, scratch, HTTP_STREAM_SCRATCH_LEN);
+        if (s->line == 1 || s->line == 2) {
+            out->data = (s->line == 1) ? family->help : "\n";
+            out->len = (u16_t)strlen(out->data);
+            s->line++;
+            return true;
+        }
+        if (s->line == 0) {
+            FMT_LIT(&text, "# HELP ");
+            fmt_str(&text, family->name);
+            fmt_char(&text, ' ');
+        } else if (s->line == 3) {
+            FMT_LIT(&text, "# TYPE ");
+            fmt_str(&text, family->name);
+            fmt_char(&text, ' ');
+            fmt_str(&text, family->type);
+            fmt_char(&text, '\n');
+        } else {
+            const char *label_value = NULL;
+            uint32_t value;
+            if (family->value(s->line - METRICS_HEADER_PIECES, &label_value, &value)) {
+                fmt_str(&text, family->name);
+                if (family->label != NULL) {
+                    fmt_char(&text, '{');
+                    fmt_str(&text, family->label);
+                    FMT_LIT(&text, "=\"");
+                    fmt_str(&text, label_value);
+                    FMT_LIT(&text, "\"}");
+                }
+                fmt_char(&text, ' ');
+                fmt_u32(&text, value);
+                fmt_char(&text, '\n');
+            }
+        }
+        if (text.overflow) {
+            // Linha cortada invalidaria a página inteira para o coletor: omite a linha inteira
+            // (no HELP, também a ajuda e o "\n" que vêm por referência)
+            printf("ERRO METRICS: Linha de '%s' maior que HTTP_STREAM_SCRATCH_LEN; omitida.\n", family->name);
+            s->line = (s->line == 0) ? 3 : (u16_t)(s->line + 1);
+            continue;
+        }
+        if (text.len > 0) {
+            s->line++;
+            out->data = scratch;
+            out->len = (u16_t)text.len;
+            return true;
+        }
+        s->family++;
+        s->line = 0;
+    }
+    return false;
+}
+
+static void metrics_stream_done(void *state) {
+    g_snapshot.refs--;
+}
+
+err_t metrics_serve(http_conn_t *conn, const http_request_t *request) {
+    uint64_t now_us = time_us_64();
+    if (g_snapshot.refs == 0) {
+        http_server_get_counters(&g_snapshot.http);
+        http_server_get_open(&g_snapshot.open_pooled, &g_snapshot.open_detached);
+        mem_usage_get(&g_snapshot.mem);
+        g_snapshot.routes = http_server_get_routes(&g_snapshot.route_count);
+        g_snapshot.taken_us = now_us;
+    } else if (now_us - g_snapshot.taken_us >= METRICS_SNAPSHOT_SHARE_US) {
+        // Um stream lento segura a fotografia: não serve números tão velhos
+        return http_send_response(conn, 503, "Retry-After: 1\r\n", NULL, 0, false);
+    }
+
+    metrics_stream_state_t state = { 0, 0 };
+    g_snapshot.refs++; // Devolvida em metrics_stream_done (com HEAD, já dentro de http_send_stream)
+    err_t err = http_send_stream(conn, 200,
+                                 "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                                 "Cache-Control: no-store\r\n",
+                                 -1, metrics_stream_piece, metrics_stream_done, &state, sizeof(state));
+    if (err != ERR_OK) {
+        g_snapshot.refs--; // Sem stream (ERR_MEM: a requisição volta depois)
+    }
+    return err;
+}
@@ -0,0 +1,36 @@
+/**
+ * @file metrics.h
+ * @brief GET /metrics: contadores da LwIP, do servidor HTTP e da memória no formato texto do
+ * Prometheus.
+ *
+ * Nada é acumulado para a resposta: cada linha é formatada na hora, direto da fonte (lwip_stats,
+ * http_server_get_counters(), mem_usage_get()), e enviada em chunked pelo http_send_stream(), então
+ * a requisição custa algumas dezenas de snprintf e nenhum buffer grande. Pode ser coletada a cada
+ * poucos segundos.
+ *
+ * Requer LWIP_STATS com MEM_STATS, MEMP_STATS e TCP_STATS (ver lwipopts.h).
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include "http_server.h"
+
+// Contadores da aplicação mantidos fora do servidor HTTP (SSE, WebSocket e telemetria UDP).
+typedef enum {
+    METRICS_SSE_ABORTS,
+    METRICS_SSE_REJECTED,       // 503 por falta de slot
+    METRICS_WS_ABORTS,
+    METRICS_WS_REJECTED,
+    METRICS_UDP_DATAGRAMS,      // Datagramas de telemetria enviados
+    METRICS_UDP_SEND_ERRORS,    // Sem pbuf ou udp_sendto falhou
+    METRICS_APP_COUNTER_COUNT
+} metrics_app_counter_t;
+
+// Só o núcleo 0 (contexto da LwIP) incrementa.
+void metrics_count(metrics_app_counter_t counter);
+
+// Handler da rota /metrics.
+err_t metrics_serve(http_conn_t *conn, const http_request_t *request);
+
+#endif /* METRICS_H */
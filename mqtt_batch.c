@@ -0,0 +1,22 @@
+#include "mqtt_batch.h"
+
+#include <string.h>
+
+mqtt_batch_result_t mqtt_batch_append(mqtt_batch_t *batch, const char *line, size_t len, uint64_t sample_us) {
+    mqtt_batch_result_t result = MQTT_BATCH_APPENDED;
+    if (batch->len + len > MQTT_BATCH_LEN) {
+        // Lote cheio: a linha nova substitui a última, se couber no lugar dela
+        if (batch->last_line + len > MQTT_BATCH_LEN) {
+            return MQTT_BATCH_DROPPED;
+        }
+        batch->len = batch->last_line;
+        result = MQTT_BATCH_COALESCED;
+    }
+    if (batch->len == 0) {
+        batch->first_us = sample_us;
+    }
+    batch->last_line = batch->len;
+    memcpy(batch->data + batch->len, line, len);
+    batch->len = (uint16_t)(batch->len + len);
+    return result;
+}
@@ -0,0 +1,37 @@
+/**
+ * @file mqtt_batch.h
+ * @brief Lote de linhas de texto de um tópico MQTT, compartilhado entre o firmware
+ * (mqtt_publisher.c) e o teste do host (host/mqtt_broker.c -T).
+ *
+ * As linhas se acumulam até MQTT_BATCH_LEN bytes. Com o lote cheio, a linha nova substitui a
+ * última (coalescida); se nem no lugar da última ela cabe, é descartada e o lote fica como estava.
+ */
+
+#ifndef MQTT_BATCH_H
+#define MQTT_BATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MQTT_TOPIC_LEN 64
+#define MQTT_BATCH_LEN 256             // Bytes de cada lote (cerca de 12 linhas de joystick)
+
+typedef struct {
+    char topic[MQTT_TOPIC_LEN];
+    char data[MQTT_BATCH_LEN];
+    uint16_t len;              // 0 = nada pendente
+    uint16_t last_line;        // Início da última linha (substituída com o lote cheio)
+    uint64_t first_us;         // Amostra mais antiga do lote
+} mqtt_batch_t;
+
+typedef enum {
+    MQTT_BATCH_APPENDED,
+    MQTT_BATCH_COALESCED,      // Lote cheio: a linha substituiu a última
+    MQTT_BATCH_DROPPED         // Não cabe nem no lugar da última: descartada
+} mqtt_batch_result_t;
+
+// Acrescenta 'line' (com o '\n') amostrada em 'sample_us'. A primeira linha marca 'first_us',
+// que continua valendo quando a última é substituída.
+mqtt_batch_result_t mqtt_batch_append(mqtt_batch_t *batch, const char *line, size_t len, uint64_t sample_us);
+
+#endif /* MQTT_BATCH_H */
@@ -0,0 +1,419 @@
+#include "mqtt_publisher.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pico/cyw43_arch.h"
+#include "pico/time.h"
+#include "lwip/apps/mqtt.h"
+#include "lwip/ip_addr.h"
+
+#include "fmt.h"
+#include "mqtt_batch.h"
+
+#define MQTT_LINE_LEN 32
+#define MQTT_STATE_LEN 96
+#define MQTT_LATENCY_SLOTS MQTT_REQ_MAX_IN_FLIGHT   // Mensagens medidas aguardando ACK
+
+typedef enum {
+    MQTT_CH_JOYSTICK,
+    MQTT_CH_BUTTONS,
+    MQTT_CH_TEMPERATURE,
+    MQTT_CH_COUNT
+} mqtt_channel_t;
+
+static const char *const g_channel_names[MQTT_CH_COUNT] = { "joystick", "buttons", "temperature" };
+
+typedef enum {
+    MQTT_PUB_OFF,              // Sem enlace (ou não configurado)
+    MQTT_PUB_CONNECTING,
+    MQTT_PUB_UP,
+    MQTT_PUB_BACKOFF           // Esperando 'g_retry_at_us' para a próxima tentativa
+} mqtt_pub_state_t;
+
+static mqtt_publisher_config_t g_config;
+static mqtt_client_t *g_client = NULL;      // NULL: publicação desativada
+static ip_addr_t g_broker_addr;
+static char g_topic_state[MQTT_TOPIC_LEN];
+static char g_topic_status[MQTT_TOPIC_LEN];
+
+static mqtt_pub_state_t g_state = MQTT_PUB_OFF;
+static bool g_link_up = false;
+static uint64_t g_retry_at_us;
+static uint32_t g_backoff_ms = MQTT_BACKOFF_MIN_MS;
+
+static mqtt_batch_t g_batches[MQTT_CH_COUNT];
+static uint32_t g_sequence = 0;
+static uint32_t g_interval_us;
+static uint64_t g_last_flush_us;
+
+// Último valor enviado a cada lote (referência para detectar mudança) e último snapshot, para o
+// estado retido.
+static bool g_have_last = false;
+static input_snapshot_t g_last;
+static int32_t g_last_temperature_centi;
+static input_snapshot_t g_latest;
+static int32_t g_latest_temperature_centi;
+static bool g_state_dirty = false;
+static uint64_t g_last_state_us;
+
+// Instante da amostra mais antiga de cada mensagem aguardando o ACK (0 = slot livre).
+static uint64_t g_latency_slots[MQTT_LATENCY_SLOTS];
+static uint64_t g_latency_sum_us;
+static mqtt_publisher_stats_t g_stats;
+
+static void mqtt_publisher_do_work(async_context_t *context, async_at_time_worker_t *worker);
+static async_at_time_worker_t g_worker = { .do_work = mqtt_publisher_do_work };
+static bool g_worker_scheduled = false;
+static uint64_t g_worker_at_us;
+
+// Agenda o worker para 'at_us', a menos que ele já esteja agendado para antes.
+static void mqtt_publisher_schedule(uint64_t at_us) {
+    if (g_worker_scheduled && g_worker_at_us <= at_us) {
+        return;
+    }
+    async_context_t *context = cyw43_arch_async_context();
+    async_context_remove_at_time_worker(context, &g_worker);
+    uint64_t now_us = time_us_64();
+    uint32_t delay_ms = (at_us > now_us) ? (uint32_t)((at_us - now_us + 999) / 1000) : 0;
+    async_context_add_at_time_worker_in_ms(context, &g_worker, delay_ms);
+    g_worker_scheduled = true;
+    g_worker_at_us = at_us;
+}
+
+static void mqtt_publisher_unschedule(void) {
+    async_context_remove_at_time_worker(cyw43_arch_async_context(), &g_worker);
+    g_worker_scheduled = false;
+}
+
+// --- Lotes ---
+
+static void mqtt_publisher_append(mqtt_batch_t *batch, const char *line, size_t len, uint64_t sample_us) {
+    mqtt_batch_result_t result = mqtt_batch_append(batch, line, len, sample_us);
+    if (result == MQTT_BATCH_COALESCED) {
+        g_stats.coalesced++;
+    } else if (result == MQTT_BATCH_DROPPED) {
+        g_stats.dropped++;
+    }
+}
+
+// Uma linha por canal que mudou desde a última linha registrada.
+static void mqtt_publisher_record_changes(const input_snapshot_t *state, int32_t temperature_centi) {
+    char line[MQTT_LINE_LEN];
+    fmt_buf_t out;
+    uint32_t t_ms = (uint32_t)(state->timestamp_us / 1000);
+
+    if (!g_have_last || state->direction != g_last.direction ||
+        abs((int)state->vrx - (int)g_last.vrx) >= MQTT_AXIS_DELTA ||
+        abs((int)state->vry - (int)g_last.vry) >= MQTT_AXIS_DELTA) {
+        fmt_init(&out, line, sizeof(line));
+        fmt_u32(&out, t_ms);
+        fmt_char(&out, ',');
+        fmt_u32(&out, (uint32_t)state->direction);
+        fmt_char(&out, ',');
+        fmt_u32(&out, state->vrx);
+        fmt_char(&out, ',');
+        fmt_u32(&out, state->vry);
+        fmt_char(&out, '\n');
+        mqtt_publisher_append(&g_batches[MQTT_CH_JOYSTICK], line, out.len, state->timestamp_us);
+        g_last.direction = state->direction;
+        g_last.vrx = state->vrx;
+        g_last.vry = state->vry;
+    }
+    if (!g_have_last || state->button_state_bits != g_last.button_state_bits ||
+        state->button_event_count != g_last.button_event_count) {
+        fmt_init(&out, line, sizeof(line));
+        fmt_u32(&out, t_ms);
+        fmt_char(&out, ',');
+        fmt_u32(&out, state->button_state_bits);
+        fmt_char(&out, ',');
+        fmt_u32(&out, state->button_event_count);
+        fmt_char(&out, '\n');
+        mqtt_publisher_append(&g_batches[MQTT_CH_BUTTONS], line, out.len, state->timestamp_us);
+        g_last.button_state_bits = state->button_state_bits;
+        g_last.button_event_count = state->button_event_count;
+    }
+    if (!g_have_last || abs((int)(temperature_centi - g_last_temperature_centi)) >= MQTT_TEMP_DELTA_CENTI) {
+        fmt_init(&out, line, sizeof(line));
+        fmt_u32(&out, t_ms);
+        fmt_char(&out, ',');
+        fmt_centi(&out, temperature_centi);
+        fmt_char(&out, '\n');
+        mqtt_publisher_append(&g_batches[MQTT_CH_TEMPERATURE], line, out.len, state->timestamp_us);
+        g_last_temperature_centi = temperature_centi;
+    }
+    g_have_last = true;
+}
+
+// --- Publicação ---
+
+// ACK TCP de uma mensagem QoS 0 (a LwIP chama o callback de todas as pendentes nesse momento).
+static void mqtt_publisher_sent(void *arg, err_t err) {
+    uint64_t *slot = (uint64_t *)arg;
+    if (err == ERR_OK && *slot != 0) {
+        uint32_t latency_us = (uint32_t)(time_us_64() - *slot);
+        g_stats.acked++;
+        g_stats.latency_last_us = latency_us;
+        if (latency_us > g_stats.latency_max_us) g_stats.latency_max_us = latency_us;
+        g_latency_sum_us += latency_us;
+        g_stats.latency_mean_us = (uint32_t)(g_latency_sum_us / g_stats.acked);
+    }
+    *slot = 0;
+}
+
+static uint64_t *mqtt_publisher_latency_slot(uint64_t first_us) {
+    for (int i = 0; i < MQTT_LATENCY_SLOTS; i++) {
+        if (g_latency_slots[i] == 0) {
+            g_latency_slots[i] = first_us;
+            return &g_latency_slots[i];
+        }
+    }
+    return NULL; // Todas medindo: esta mensagem sai sem medida
+}
+
+static bool mqtt_publisher_publish_batch(mqtt_batch_t *batch) {
+    static char payload[MQTT_BATCH_LEN + 12]; // A LwIP copia para o seu buffer de saída
+    fmt_buf_t out;
+    fmt_init(&out, payload, sizeof(payload));
+    fmt_u32(&out, g_sequence);
+    fmt_char(&out, '\n');
+    fmt_mem(&out, batch->data, batch->len);
+
+    uint64_t *slot = mqtt_publisher_latency_slot(batch->first_us);
+    err_t err = mqtt_publish(g_client, batch->topic, payload, (u16_t)out.len, 0, 0,
+                             slot != NULL ? mqtt_publisher_sent : NULL, slot);
+    if (err != ERR_OK) {
+        if (slot != NULL) *slot = 0;
+        g_stats.errors++; // Buffer de saída ou slots de requisição cheios: tenta na próxima janela
+        return false;
+    }
+    g_stats.published++;
+    g_sequence++;
+    batch->len = 0;
+    return true;
+}
+
+// Mesmas chaves do JSON de /status, mais "p" (nível dos botões).
+static void mqtt_publisher_publish_state(uint64_t now_us) {
+    char json[MQTT_STATE_LEN];
+    fmt_buf_t out;
+    fmt_init(&out, json, sizeof(json));
+    FMT_LIT(&out, "{\"t\":");
+    fmt_centi(&out, g_latest_temperature_centi);
+    FMT_LIT(&out, ",\"x\":");
+    fmt_u32(&out, g_latest.vrx);
+    FMT_LIT(&out, ",\"y\":");
+    fmt_u32(&out, g_latest.vry);
+    FMT_LIT(&out, ",\"d\":");
+    fmt_u32(&out, (uint32_t)g_latest.direction);
+    FMT_LIT(&out, ",\"b\":");
+    fmt_u32(&out, (uint32_t)g_latest.last_button);
+    FMT_LIT(&out, ",\"p\":");
+    fmt_u32(&out, g_latest.button_state_bits);
+    fmt_char(&out, '}');
+    if (mqtt_publish(g_client, g_topic_state, json, (u16_t)out.len, 0, 1, NULL, NULL) == ERR_OK) {
+        g_stats.published++;
+        g_state_dirty = false;
+        g_last_state_us = now_us;
+    } else {
+        g_stats.errors++;
+    }
+}
+
+// Envia os lotes pendentes (e o estado retido, se venceu) se a janela da taxa permitir; senão,
+// agenda o worker para quando permitir.
+static void mqtt_publisher_flush(void) {
+    if (g_state != MQTT_PUB_UP) {
+        return; // Os lotes esperam a conexão
+    }
+    uint64_t now_us = time_us_64();
+    bool batches_pending = false;
+    for (int c = 0; c < MQTT_CH_COUNT; c++) {
+        batches_pending |= g_batches[c].len > 0;
+    }
+    uint64_t state_due_us = g_last_state_us + MQTT_STATE_INTERVAL_MS * 1000ull;
+    bool state_pending = g_state_dirty && g_have_last;
+
+    if (batches_pending) {
+        uint64_t window_us = g_last_flush_us + g_interval_us;
+        if (now_us < window_us) {
+            mqtt_publisher_schedule(window_us);
+        } else {
+            for (int c = 0; c < MQTT_CH_COUNT; c++) {
+                if (g_batches[c].len > 0 && !mqtt_publisher_publish_batch(&g_batches[c])) {
+                    break;
+                }
+            }
+            g_last_flush_us = now_us;
+            for (int c = 0; c < MQTT_CH_COUNT; c++) {
+                if (g_batches[c].len > 0) {
+                    mqtt_publisher_schedule(now_us + g_interval_us); // Sobrou (publicação recusada)
+                    break;
+                }
+            }
+        }
+    }
+    if (state_pending) {
+        if (now_us >= state_due_us) {
+            mqtt_publisher_publish_state(now_us);
+        } else {
+            mqtt_publisher_schedule(state_due_us);
+        }
+    }
+}
+
+// --- Conexão ---
+
+static void mqtt_publisher_connect(void);
+
+static void mqtt_publisher_schedule_retry(void) {
+    g_state = MQTT_PUB_BACKOFF;
+    g_retry_at_us = time_us_64() + g_backoff_ms * 1000ull;
+    printf("AVISO MQTT: Nova tentativa em %lu ms.\n", (unsigned long)g_backoff_ms);
+    mqtt_publisher_schedule(g_retry_at_us);
+    g_backoff_ms = (g_backoff_ms >= MQTT_BACKOFF_MAX_MS / 2) ? MQTT_BACKOFF_MAX_MS : g_backoff_ms * 2;
+}
+
+// As requisições pendentes somem com a conexão (a LwIP não chama os callbacks): libera as medidas.
+static void mqtt_publisher_drop_inflight(void) {
+    memset(g_latency_slots, 0, sizeof(g_latency_slots));
+}
+
+static void mqtt_publisher_connection_cb(mqtt_client_t *client, void *arg, mqtt_connection_status_t status) {
+    if (g_state == MQTT_PUB_OFF) {
+        return; // Fechamento pedido por mqtt_publisher_link_changed (algumas versões da LwIP avisam com status 0)
+    }
+    if (status == MQTT_CONNECT_ACCEPTED) {
+        g_state = MQTT_PUB_UP;
+        g_stats.connects++;
+        g_backoff_ms = MQTT_BACKOFF_MIN_MS;
+        printf("INFO: MQTT conectado a %s:%u.\n", g_config.broker, g_config.port);
+        if (mqtt_publish(g_client, g_topic_status, "online", 6, 0, 1, NULL, NULL) == ERR_OK) {
+            g_stats.published++;
+        }
+        // Retomada: o estado retido sai já, e os lotes acumulados durante a queda em seguida
+        g_state_dirty = true;
+        g_last_state_us = 0;
+        g_last_flush_us = 0;
+        mqtt_publisher_flush();
+        return;
+    }
+    mqtt_publisher_drop_inflight();
+    if (g_state == MQTT_PUB_UP) {
+        g_stats.disconnects++;
+        printf("AVISO MQTT: Conexão com o broker perdida (código %d).\n", (int)status);
+    } else {
+        g_stats.failures++;
+        printf("AVISO MQTT: Broker %s:%u recusou ou não respondeu (código %d).\n", g_config.broker,
+               g_config.port, (int)status);
+    }
+    if (g_link_up) {
+        mqtt_publisher_schedule_retry();
+    } else {
+        g_state = MQTT_PUB_OFF;
+    }
+}
+
+static void mqtt_publisher_connect(void) {
+    const struct mqtt_connect_client_info_t client_info = {
+        .client_id = g_config.client_id,
+        .keep_alive = MQTT_KEEP_ALIVE_S,
+        .will_topic = g_topic_status,
+        .will_msg = "offline",
+        .will_qos = 0,
+        .will_retain = 1,
+    };
+    g_stats.attempts++;
+    g_state = MQTT_PUB_CONNECTING;
+    err_t err = mqtt_client_connect(g_client, &g_broker_addr, g_config.port, mqtt_publisher_connection_cb, NULL,
+                                    &client_info);
+    if (err != ERR_OK) {
+        g_stats.failures++;
+        printf("AVISO MQTT: mqtt_client_connect falhou (código %d).\n", (int)err);
+        mqtt_publisher_schedule_retry();
+    }
+}
+
+static void mqtt_publisher_do_work(async_context_t *context, async_at_time_worker_t *worker) {
+    g_worker_scheduled = false;
+    if (g_state == MQTT_PUB_BACKOFF && g_link_up) {
+        if (time_us_64() >= g_retry_at_us) {
+            mqtt_publisher_connect();
+        } else {
+            mqtt_publisher_schedule(g_retry_at_us);
+        }
+        return;
+    }
+    mqtt_publisher_flush();
+}
+
+bool mqtt_publisher_init(const mqtt_publisher_config_t *config) {
+    if (!ipaddr_aton(config->broker, &g_broker_addr)) {
+        printf("ERRO MQTT: Endereço do broker inválido: '%s'\n", config->broker);
+        return false;
+    }
+    g_config = *config;
+    if (g_config.max_rate_hz == 0) g_config.max_rate_hz = 1;
+    g_interval_us = 1000000u / g_config.max_rate_hz;
+
+    for (int c = 0; c < MQTT_CH_COUNT; c++) {
+        snprintf(g_batches[c].topic, MQTT_TOPIC_LEN, "%s/%s", config->topic_prefix, g_channel_names[c]);
+        g_batches[c].len = 0;
+    }
+    snprintf(g_topic_state, sizeof(g_topic_state), "%s/state", config->topic_prefix);
+    snprintf(g_topic_status, sizeof(g_topic_status), "%s/status", config->topic_prefix);
+
+    g_client = mqtt_client_new();
+    if (g_client == NULL) {
+        printf("ERRO MQTT: Falha ao criar o cliente.\n");
+        return false;
+    }
+    printf("INFO: MQTT para %s:%u, tópicos %s/..., até %u lotes por segundo.\n", config->broker,
+           config->port, config->topic_prefix, g_config.max_rate_hz);
+    return true;
+}
+
+void mqtt_publisher_link_changed(bool up) {
+    g_link_up = up;
+    if (g_client == NULL) {
+        return;
+    }
+    if (up) {
+        if (g_state == MQTT_PUB_OFF) {
+            g_backoff_ms = MQTT_BACKOFF_MIN_MS;
+            mqtt_publisher_connect();
+        }
+        return;
+    }
+    // Sem enlace: fecha sem esperar o keep-alive; os lotes continuam acumulando até a volta
+    mqtt_pub_state_t previous = g_state;
+    g_state = MQTT_PUB_OFF; // Antes de mqtt_disconnect: o callback de conexão ignora o fechamento
+    if (previous == MQTT_PUB_UP) {
+        g_stats.disconnects++;
+    }
+    if (previous == MQTT_PUB_UP || previous == MQTT_PUB_CONNECTING) {
+        mqtt_disconnect(g_client);
+    }
+    mqtt_publisher_drop_inflight();
+    mqtt_publisher_unschedule();
+}
+
+void mqtt_publisher_add(const input_snapshot_t *state, int32_t temperature_centi) {
+    if (g_client == NULL) {
+        return;
+    }
+    mqtt_publisher_record_changes(state, temperature_centi);
+    if (state->change_generation != g_latest.change_generation || temperature_centi != g_latest_temperature_centi ||
+        state->vrx != g_latest.vrx || state->vry != g_latest.vry) {
+        g_state_dirty = true;
+    }
+    g_latest = *state;
+    g_latest_temperature_centi = temperature_centi;
+    mqtt_publisher_flush();
+}
+
+void mqtt_publisher_get_stats(mqtt_publisher_stats_t *out) {
+    *out = g_stats;
+    out->connected = (g_state == MQTT_PUB_UP);
+}
@@ -0,0 +1,85 @@
+/**
+ * @file mqtt_publisher.h
+ * @brief Publicação do estado das entradas num broker MQTT (app MQTT da LwIP), só quando algo
+ * muda, em lotes QoS 0 com taxa máxima configurável.
+ *
+ * O worker de publicação entrega cada snapshot (mqtt_publisher_add). Uma mudança vira uma linha
+ * no lote do seu canal; os lotes saem juntos, no máximo 'max_rate_hz' vezes por segundo, então
+ * uma rajada de mudanças a 200 Hz vira poucas mensagens. Tópicos, sob 'topic_prefix':
+ *
+ *   <prefixo>/joystick      "<seq>\n" e uma linha "t_ms,direção,VRx,VRy\n" por mudança (direção
+ *                           ou eixo além de MQTT_AXIS_DELTA)
+ *   <prefixo>/buttons       "<seq>\n" e "t_ms,botões,pressionamentos\n" (botões: bit0 = A, bit1 = B)
+ *   <prefixo>/temperature   "<seq>\n" e "t_ms,°C\n" (variação de MQTT_TEMP_DELTA_CENTI ou mais)
+ *   <prefixo>/state         retido: o JSON de /status com "p" (botões); a cada conexão e, havendo
+ *                           mudança, a cada MQTT_STATE_INTERVAL_MS
+ *   <prefixo>/status        retido: "online" na conexão; "offline" é o testamento (will) do broker
+ *
+ * 't_ms' é o relógio da placa (ms desde o boot) no instante da amostra; 'seq' cresce a cada
+ * mensagem de lote (lacuna = mensagem perdida). Um lote que enche antes de sair substitui a sua
+ * última linha pela mais nova (coalescida, contada nas estatísticas; ver mqtt_batch.h).
+ *
+ * Conexão: IPv4 fixo, keep-alive de MQTT_KEEP_ALIVE_S. Queda ou recusa => nova tentativa com
+ * backoff de MQTT_BACKOFF_MIN_MS dobrando até MQTT_BACKOFF_MAX_MS, como em wifi_link.c. O cliente
+ * da LwIP sempre conecta com sessão limpa (e QoS 0 não deixa estado no broker), então a sessão é
+ * retomada do lado da placa: os lotes pendentes e a sequência sobrevivem à queda e, na reconexão,
+ * saem junto com o estado retido.
+ *
+ * Latência de publicação: da amostra mais antiga do lote até o ACK TCP do broker (a LwIP chama o
+ * callback das mensagens QoS 0 nesse momento). Tudo roda no contexto da LwIP (núcleo 0).
+ */
+
+#ifndef MQTT_PUBLISHER_H
+#define MQTT_PUBLISHER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "input_state.h"
+
+#define MQTT_KEEP_ALIVE_S 30
+#define MQTT_BACKOFF_MIN_MS 1000
+#define MQTT_BACKOFF_MAX_MS 60000
+#define MQTT_AXIS_DELTA 32             // Variação de VRx/VRy que conta como mudança (como no /stream)
+#define MQTT_TEMP_DELTA_CENTI 10       // 0,1 °C
+#define MQTT_STATE_INTERVAL_MS 5000    // Intervalo mínimo entre atualizações do estado retido
+
+typedef struct {
+    const char *broker;        // IPv4 do broker ("192.168.1.10")
+    uint16_t port;
+    const char *client_id;
+    const char *topic_prefix;
+    uint16_t max_rate_hz;      // Envios de lotes por segundo, no máximo
+} mqtt_publisher_config_t;
+
+typedef struct {
+    bool connected;
+    uint32_t attempts;         // Chamadas a mqtt_client_connect
+    uint32_t connects;         // Conexões aceitas pelo broker
+    uint32_t failures;         // Conexões recusadas ou que não chegaram a abrir
+    uint32_t disconnects;      // Quedas depois de conectado
+    uint32_t published;        // Mensagens entregues à LwIP
+    uint32_t acked;            // Mensagens confirmadas (ACK TCP)
+    uint32_t errors;           // mqtt_publish recusou (sem memória ou sem slot): o lote espera
+    uint32_t coalesced;        // Linhas substituídas com o lote cheio
+    uint32_t dropped;          // Linhas descartadas: não cabiam nem no lugar da última
+    uint32_t latency_last_us;
+    uint32_t latency_max_us;
+    uint32_t latency_mean_us;
+} mqtt_publisher_stats_t;
+
+// Valida a configuração e guarda os tópicos. A conexão só é aberta com o enlace no ar
+// (mqtt_publisher_link_changed). Chamar com o lock da LwIP (cyw43_arch_lwip_begin); as strings
+// devem permanecer válidas.
+bool mqtt_publisher_init(const mqtt_publisher_config_t *config);
+
+// Enlace Wi-Fi subiu (conecta) ou caiu (desconecta e para as tentativas). Contexto da LwIP.
+void mqtt_publisher_link_changed(bool up);
+
+// Registra as mudanças do snapshot e envia os lotes se a janela da taxa permitir.
+// Contexto da LwIP (worker do async_context).
+void mqtt_publisher_add(const input_snapshot_t *state, int32_t temperature_centi);
+
+void mqtt_publisher_get_stats(mqtt_publisher_stats_t *out);
+
+#endif /* MQTT_PUBLISHER_H */
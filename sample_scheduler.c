@@ -0,0 +1,61 @@
+#include "sample_scheduler.h"
+
+static const char *const g_mode_names[SAMPLE_MODE_COUNT] = { "idle", "burst" };
+static const uint32_t g_mode_periods_us[SAMPLE_MODE_COUNT] = { SAMPLE_IDLE_PERIOD_US, SAMPLE_BURST_PERIOD_US };
+
+// Escrito só pelo núcleo 1. O tempo é acumulado em ms (32 bits, leitura atômica no M0+) quando o
+// modo muda; o trecho do modo atual é somado na leitura.
+static volatile sample_mode_t g_mode = SAMPLE_MODE_IDLE;
+static volatile uint32_t g_mode_since_ms;
+static volatile uint32_t g_entries[SAMPLE_MODE_COUNT];
+static volatile uint32_t g_time_ms[SAMPLE_MODE_COUNT];
+static volatile uint32_t g_samples[SAMPLE_MODE_COUNT];
+static uint64_t g_last_activity_us;
+
+static void sample_scheduler_enter(sample_mode_t mode, uint64_t now_us) {
+    uint32_t now_ms = (uint32_t)(now_us / 1000);
+    g_time_ms[g_mode] += now_ms - g_mode_since_ms;
+    g_mode_since_ms = now_ms;
+    g_entries[mode]++;
+    g_mode = mode;
+}
+
+void sample_scheduler_init(uint64_t now_us) {
+    g_mode = SAMPLE_MODE_IDLE;
+    g_mode_since_ms = (uint32_t)(now_us / 1000);
+    g_last_activity_us = now_us;
+}
+
+sample_mode_t sample_scheduler_update(uint64_t now_us, bool active) {
+    g_samples[g_mode]++;
+    if (active) {
+        g_last_activity_us = now_us;
+        if (g_mode != SAMPLE_MODE_BURST) {
+            sample_scheduler_enter(SAMPLE_MODE_BURST, now_us);
+        }
+    } else if (g_mode == SAMPLE_MODE_BURST && now_us - g_last_activity_us >= SAMPLE_QUIET_MS * 1000ull) {
+        sample_scheduler_enter(SAMPLE_MODE_IDLE, now_us);
+    }
+    return g_mode;
+}
+
+uint32_t sample_scheduler_period_us(sample_mode_t mode) {
+    return g_mode_periods_us[mode];
+}
+
+const char *sample_scheduler_mode_name(sample_mode_t mode) {
+    return g_mode_names[mode];
+}
+
+void sample_scheduler_get_stats(uint64_t now_us, sample_scheduler_stats_t *out) {
+    // Sem trava: uma troca de modo no meio da cópia só desloca alguns ms entre os dois totais
+    sample_mode_t mode = g_mode;
+    uint32_t since_ms = g_mode_since_ms;
+    out->mode = mode;
+    for (int m = 0; m < SAMPLE_MODE_COUNT; m++) {
+        out->entries[m] = g_entries[m];
+        out->time_ms[m] = g_time_ms[m];
+        out->samples[m] = g_samples[m];
+    }
+    out->time_ms[mode] += (uint32_t)(now_us / 1000) - since_ms;
+}
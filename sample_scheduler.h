@@ -0,0 +1,56 @@
+/**
+ * @file sample_scheduler.h
+ * @brief Taxa de amostragem do núcleo 1 conforme a atividade: modo ocioso (2 Hz) com o joystick no
+ * centro e os botões soltos, modo rajada (200 Hz) enquanto alguém usa a placa.
+ *
+ * O laço de aquisição (main.c) informa a cada amostra se houve atividade (joystick fora do centro,
+ * botão pressionado ou evento novo, um despertar antecipado pela IRQ do ADC ou dos botões, ou um
+ * cliente de /ws conectado, que espera 50 amostras/s ou mais) e recebe o período até a próxima.
+ * Qualquer atividade passa para a rajada na hora; depois de SAMPLE_QUIET_MS sem atividade, volta
+ * ao ocioso. No ocioso o núcleo 1 acorda 2 vezes por segundo em vez de 50 e o núcleo 0 (e o rádio,
+ * com telemetria ou MQTT) recebe 2 snapshots por segundo; a latência de um movimento não depende
+ * do período, porque a IRQ do ADC e a dos botões acordam o laço antes (ver adc_sampler_watch()).
+ *
+ * Lógica pura, sem SDK: os instantes vêm de quem chama. Só o núcleo 1 atualiza; as estatísticas
+ * podem ser lidas de qualquer contexto (/metrics).
+ */
+
+#ifndef SAMPLE_SCHEDULER_H
+#define SAMPLE_SCHEDULER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SAMPLE_IDLE_PERIOD_US 500000    // 2 Hz
+#define SAMPLE_BURST_PERIOD_US 5000     // 200 Hz
+#define SAMPLE_QUIET_MS 2000            // Sem atividade por este tempo: volta ao modo ocioso
+
+typedef enum {
+    SAMPLE_MODE_IDLE,
+    SAMPLE_MODE_BURST,
+    SAMPLE_MODE_COUNT
+} sample_mode_t;
+
+typedef struct {
+    sample_mode_t mode;
+    uint32_t entries[SAMPLE_MODE_COUNT];    // Transições para cada modo
+    uint32_t time_ms[SAMPLE_MODE_COUNT];    // Tempo em cada modo, incluindo o atual até agora
+    uint32_t samples[SAMPLE_MODE_COUNT];
+} sample_scheduler_stats_t;
+
+// Começa no modo ocioso em 'now_us'.
+void sample_scheduler_init(uint64_t now_us);
+
+// Registra a amostra de 'now_us' e devolve o modo para a próxima. 'active' = houve atividade
+// desde a amostra anterior.
+sample_mode_t sample_scheduler_update(uint64_t now_us, bool active);
+
+// Período entre amostras no modo 'mode'.
+uint32_t sample_scheduler_period_us(sample_mode_t mode);
+
+// Nome do modo ("idle" ou "burst"), também usado como rótulo em /metrics.
+const char *sample_scheduler_mode_name(sample_mode_t mode);
+
+void sample_scheduler_get_stats(uint64_t now_us, sample_scheduler_stats_t *out);
+
+#endif /* SAMPLE_SCHEDULER_H */
@@ -0,0 +1,109 @@
+#include "telemetry_codec.h"
+
+#include <string.h>
+
+static void put_u16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    put_u16(p, (uint16_t)v);
+    put_u16(p + 2, (uint16_t)(v >> 16));
+}
+
+static uint16_t get_u16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    return get_u16(p) | ((uint32_t)get_u16(p + 2) << 16);
+}
+
+static bool fits_i8(int32_t v) {
+    return v >= -128 && v <= 127;
+}
+
+void telemetry_batch_start(telemetry_batch_t *batch, uint32_t sequence, const telemetry_sample_t *sample) {
+    uint8_t *p = batch->data;
+    p[0] = 'T';
+    p[1] = 'L';
+    p[2] = TELEMETRY_VERSION;
+    p[3] = 1;
+    put_u32(p + 4, sequence);
+    put_u32(p + 8, (uint32_t)sample->timestamp_us);
+    put_u32(p + 12, (uint32_t)(sample->timestamp_us >> 32));
+    put_u16(p + 16, sample->vrx);
+    put_u16(p + 18, sample->vry);
+    put_u16(p + 20, sample->temp_raw);
+    p[22] = sample->buttons;
+    p[23] = 0;
+    batch->len = TELEMETRY_HEADER_LEN;
+    batch->count = 1;
+    batch->last = *sample;
+}
+
+bool telemetry_batch_append(telemetry_batch_t *batch, const telemetry_sample_t *sample) {
+    if (batch->count >= TELEMETRY_MAX_SAMPLES || sample->timestamp_us < batch->last.timestamp_us) {
+        return false;
+    }
+    uint64_t dt = (sample->timestamp_us - batch->last.timestamp_us + TELEMETRY_DT_UNIT_US / 2) / TELEMETRY_DT_UNIT_US;
+    int32_t dvrx = (int32_t)sample->vrx - batch->last.vrx;
+    int32_t dvry = (int32_t)sample->vry - batch->last.vry;
+    int32_t dtemp = (int32_t)sample->temp_raw - batch->last.temp_raw;
+    if (dt > UINT16_MAX || !fits_i8(dvrx) || !fits_i8(dvry) || !fits_i8(dtemp)) {
+        return false;
+    }
+
+    uint8_t *p = batch->data + batch->len;
+    put_u16(p, (uint16_t)dt);
+    p[2] = (uint8_t)(int8_t)dvrx;
+    p[3] = (uint8_t)(int8_t)dvry;
+    p[4] = (uint8_t)(int8_t)dtemp;
+    p[5] = sample->buttons;
+    batch->len += TELEMETRY_DELTA_LEN;
+    batch->count++;
+    batch->data[3] = batch->count;
+
+    // O receptor acumula os deltas arredondados: a referência do próximo é o valor reconstruído
+    uint64_t reconstructed_us = batch->last.timestamp_us + dt * TELEMETRY_DT_UNIT_US;
+    batch->last = *sample;
+    batch->last.timestamp_us = reconstructed_us;
+    return true;
+}
+
+int telemetry_decode(const uint8_t *data, size_t len, uint32_t *sequence,
+                     telemetry_sample_t *out, size_t max_samples) {
+    if (len < TELEMETRY_HEADER_LEN || data[0] != 'T' || data[1] != 'L' || data[2] != TELEMETRY_VERSION) {
+        return -1;
+    }
+    size_t count = data[3];
+    if (count == 0 || len != TELEMETRY_HEADER_LEN + (count - 1) * TELEMETRY_DELTA_LEN) {
+        return -1;
+    }
+    *sequence = get_u32(data + 4);
+
+    telemetry_sample_t sample;
+    sample.timestamp_us = get_u32(data + 8) | ((uint64_t)get_u32(data + 12) << 32);
+    sample.vrx = get_u16(data + 16);
+    sample.vry = get_u16(data + 18);
+    sample.temp_raw = get_u16(data + 20);
+    sample.buttons = data[22];
+
+    size_t written = 0;
+    const uint8_t *p = data + TELEMETRY_HEADER_LEN;
+    for (size_t i = 0; i < count; i++) {
+        if (i > 0) {
+            sample.timestamp_us += (uint64_t)get_u16(p) * TELEMETRY_DT_UNIT_US;
+            sample.vrx = (uint16_t)(sample.vrx + (int8_t)p[2]);
+            sample.vry = (uint16_t)(sample.vry + (int8_t)p[3]);
+            sample.temp_raw = (uint16_t)(sample.temp_raw + (int8_t)p[4]);
+            sample.buttons = p[5];
+            p += TELEMETRY_DELTA_LEN;
+        }
+        if (written < max_samples) {
+            out[written++] = sample;
+        }
+    }
+    return (int)written;
+}
@@ -0,0 +1,64 @@
+/**
+ * @file telemetry_codec.h
+ * @brief Formato do datagrama de telemetria UDP (versão 1), compartilhado entre o firmware
+ * (udp_telemetry.c) e o receptor do host (host/telemetry_rx.c).
+ *
+ * Layout fixo, little-endian:
+ *
+ *   0  'T' 'L'          magic
+ *   2  u8  versão       TELEMETRY_VERSION
+ *   3  u8  amostras     N (1..TELEMETRY_MAX_SAMPLES)
+ *   4  u32 sequência    +1 a cada datagrama: lacunas = perda, repetição/volta = reordenação
+ *   8  u64 t0           timestamp da 1ª amostra (µs desde o boot)
+ *  16  u16 VRx, u16 VRy, u16 temperatura (ADC bruto), u8 botões (bit0 = A, bit1 = B), u8 reservado
+ *  24  N-1 deltas de 6 bytes, cada um relativo à amostra anterior:
+ *        u16 dt (unidades de 10 µs), i8 dVRx, i8 dVRy, i8 dTemp, u8 botões (valor absoluto)
+ *
+ * Se uma amostra não cabe num delta (variação fora de -128..127 ou dt acima de ~655 ms), o lote
+ * atual é fechado e ela abre o próximo datagrama como amostra base, então a codificação é sem
+ * perdas (exceto o timestamp, arredondado a 10 µs sem erro acumulado).
+ */
+
+#ifndef TELEMETRY_CODEC_H
+#define TELEMETRY_CODEC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define TELEMETRY_VERSION 1
+#define TELEMETRY_HEADER_LEN 24         // Cabeçalho + amostra base
+#define TELEMETRY_DELTA_LEN 6
+#define TELEMETRY_DT_UNIT_US 10
+#define TELEMETRY_MAX_SAMPLES 64
+#define TELEMETRY_DATAGRAM_MAX (TELEMETRY_HEADER_LEN + (TELEMETRY_MAX_SAMPLES - 1) * TELEMETRY_DELTA_LEN)
+
+typedef struct {
+    uint64_t timestamp_us;
+    uint16_t vrx;
+    uint16_t vry;
+    uint16_t temp_raw;
+    uint8_t buttons;            // bit0 = A, bit1 = B pressionado
+} telemetry_sample_t;
+
+// Datagrama em montagem.
+typedef struct {
+    uint8_t data[TELEMETRY_DATAGRAM_MAX];
+    uint16_t len;
+    uint8_t count;
+    telemetry_sample_t last;    // Última amostra como o receptor vai reconstruí-la
+} telemetry_batch_t;
+
+// Começa um datagrama com 'sample' como amostra base.
+void telemetry_batch_start(telemetry_batch_t *batch, uint32_t sequence, const telemetry_sample_t *sample);
+
+// Acrescenta um delta. Retorna false (sem alterar o lote) se a amostra não cabe num delta ou o lote
+// está cheio: o chamador envia o lote e começa outro com ela.
+bool telemetry_batch_append(telemetry_batch_t *batch, const telemetry_sample_t *sample);
+
+// Decodifica um datagrama. Retorna o número de amostras escritas em 'out' (até 'max_samples'),
+// ou -1 se o datagrama é inválido (magic, versão ou tamanho).
+int telemetry_decode(const uint8_t *data, size_t len, uint32_t *sequence,
+                     telemetry_sample_t *out, size_t max_samples);
+
+#endif /* TELEMETRY_CODEC_H */
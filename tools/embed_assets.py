@@ -0,0 +1,133 @@
+#!/usr/bin/env python3
+"""Gera web_assets.c a partir das páginas em web/ (executado pelo CMake a cada build).
+
+Para cada arquivo de entrada:
+  1. HTML: <link rel="stylesheet" href="x.css"> e <script src="x.js"></script> locais são
+     substituídos pelo conteúdo dos arquivos, para a página sair numa única resposta;
+  2. minifica (conservador: remove comentários e espaços redundantes, sem reescrever código);
+  3. comprime com gzip (nível 9, sem data no cabeçalho, para o build ser reprodutível);
+  4. emite os dois arrays const (ficam em flash), os tamanhos e um ETag derivado do conteúdo.
+
+Uso: embed_assets.py -o web_assets.c arquivo.html [arquivo.css ...]
+"""
+
+import argparse
+import gzip
+import hashlib
+import os
+import re
+import sys
+
+CONTENT_TYPES = {
+    ".html": "text/html; charset=UTF-8",
+    ".css": "text/css; charset=UTF-8",
+    ".js": "application/javascript; charset=UTF-8",
+    ".json": "application/json",
+    ".svg": "image/svg+xml",
+    ".ico": "image/x-icon",
+}
+
+
+def minify_css(text):
+    text = re.sub(r"/\*.*?\*/", "", text, flags=re.S)
+    text = re.sub(r"\s+", " ", text)
+    text = re.sub(r"\s*([{};:,>])\s*", r"\1", text)
+    return text.replace(";}", "}").strip()
+
+
+def minify_js(text):
+    # Só remove comentários de linha inteira, indentação e linhas vazias. As quebras de linha
+    # são mantidas para não depender de inserção automática de ponto e vírgula.
+    lines = []
+    for line in text.splitlines():
+        line = line.strip()
+        if line and not line.startswith("//"):
+            lines.append(line)
+    return "\n".join(lines)
+
+
+def inline_local_assets(html, base_dir):
+    def read_local(href):
+        path = os.path.join(base_dir, href)
+        with open(path, encoding="utf-8") as f:
+            return f.read()
+
+    def replace_css(match):
+        return "<style>" + read_local(match.group(1)) + "</style>"
+
+    def replace_js(match):
+        return "<script>" + read_local(match.group(1)) + "</script>"
+
+    html = re.sub(r'<link rel="stylesheet" href="([\w./-]+\.css)">', replace_css, html)
+    html = re.sub(r'<script src="([\w./-]+\.js)"></script>', replace_js, html)
+    return html
+
+
+def minify_html(html):
+    # <style> e <script> são minificados com as regras próprias e protegidos do restante.
+    blocks = []
+
+    def protect(match):
+        tag, body = match.group(1), match.group(2)
+        body = minify_css(body) if tag == "style" else minify_js(body)
+        blocks.append("<%s>%s</%s>" % (tag, body, tag))
+        return "\0%d\0" % (len(blocks) - 1)
+
+    html = re.sub(r"<(style|script)>(.*?)</\1>", protect, html, flags=re.S)
+    html = re.sub(r"<!--.*?-->", "", html, flags=re.S)
+    html = re.sub(r"\s+", " ", html)
+    html = re.sub(r">\s+<", "><", html)
+    html = re.sub(r"\s*(\0\d+\0)\s*", r"\1", html).strip()
+    return re.sub(r"\0(\d+)\0", lambda m: blocks[int(m.group(1))], html)
+
+
+def c_array(name, data):
+    lines = []
+    for i in range(0, len(data), 16):
+        lines.append("    " + ", ".join("0x%02x" % b for b in data[i:i + 16]) + ",")
+    return "static const uint8_t %s[%d] = {\n%s\n};\n" % (name, max(len(data), 1), "\n".join(lines))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("-o", "--output", required=True, help="arquivo .c gerado")
+    parser.add_argument("inputs", nargs="+")
+    args = parser.parse_args()
+
+    out = [
+        "// Gerado por tools/embed_assets.py a partir de web/. NÃO EDITE.\n",
+        '#include "web_assets.h"\n',
+    ]
+    entries = []
+    for index, path in enumerate(args.inputs):
+        ext = os.path.splitext(path)[1].lower()
+        with open(path, encoding="utf-8") as f:
+            text = f.read()
+        if ext == ".html":
+            text = minify_html(inline_local_assets(text, os.path.dirname(path)))
+        elif ext == ".css":
+            text = minify_css(text)
+        elif ext == ".js":
+            text = minify_js(text)
+        raw = text.encode("utf-8")
+        packed = gzip.compress(raw, compresslevel=9, mtime=0)
+        etag = hashlib.sha1(raw).hexdigest()[:12]
+
+        out.append(c_array("asset_%d_raw" % index, raw))
+        out.append(c_array("asset_%d_gzip" % index, packed))
+        entries.append(
+            '    { "/%s", "%s", "\\"%s\\"", "\\"%s-gz\\"", asset_%d_raw, %d, asset_%d_gzip, %d },'
+            % (os.path.basename(path), CONTENT_TYPES.get(ext, "application/octet-stream"),
+               etag, etag, index, len(raw), index, len(packed)))
+        print("embed_assets: %s: %d bytes minificado, %d bytes gzip" % (os.path.basename(path), len(raw), len(packed)))
+
+    out.append("const web_asset_t web_assets[] = {\n%s\n};\n" % "\n".join(entries))
+    out.append("const size_t web_asset_count = sizeof(web_assets) / sizeof(web_assets[0]);\n")
+
+    with open(args.output, "w", encoding="utf-8") as f:
+        f.write("\n".join(out))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,83 @@
+#include "udp_telemetry.h"
+
+#include <stdio.h>
+
+#include "lwip/ip_addr.h"
+#include "lwip/pbuf.h"
+#include "lwip/udp.h"
+
+#include "metrics.h"
+#include "telemetry_codec.h"
+
+#define UDP_TELEMETRY_JITTER_US 2000 // Tolerância no intervalo entre amostras guardadas
+
+static struct udp_pcb *g_telemetry_pcb = NULL;
+static ip_addr_t g_telemetry_addr;
+static uint16_t g_telemetry_port;
+static uint8_t g_batch_samples;
+static uint32_t g_interval_us;
+
+static telemetry_batch_t g_batch;          // Lote em montagem (g_batch.count == 0: vazio)
+static uint32_t g_sequence = 0;
+static uint64_t g_last_sample_us = 0;
+
+bool udp_telemetry_init(const char *host, uint16_t port, uint8_t batch_samples, uint32_t interval_ms) {
+    if (!ipaddr_aton(host, &g_telemetry_addr)) {
+        printf("ERRO UDP: Endereço do coletor de telemetria inválido: '%s'\n", host);
+        return false;
+    }
+    g_telemetry_pcb = udp_new_ip_type(IPADDR_TYPE_V4);
+    if (g_telemetry_pcb == NULL) {
+        printf("ERRO UDP: Falha ao criar PCB de telemetria.\n");
+        return false;
+    }
+    ip_set_option(g_telemetry_pcb, SOF_BROADCAST); // Permite 255.255.255.255 / broadcast da sub-rede
+    g_telemetry_port = port;
+    g_batch_samples = (batch_samples == 0) ? 1 : (batch_samples > TELEMETRY_MAX_SAMPLES ? TELEMETRY_MAX_SAMPLES : batch_samples);
+    g_interval_us = interval_ms * 1000;
+    g_batch.count = 0;
+    printf("INFO: Telemetria UDP para %s:%u (%u amostras por datagrama, uma a cada %lu ms).\n",
+           host, port, g_batch_samples, (unsigned long)interval_ms);
+    return true;
+}
+
+static void udp_telemetry_flush(void) {
+    struct pbuf *p = pbuf_alloc(PBUF_TRANSPORT, g_batch.len, PBUF_RAM);
+    err_t err = ERR_MEM;
+    if (p != NULL) {
+        pbuf_take(p, g_batch.data, g_batch.len);
+        err = udp_sendto(g_telemetry_pcb, p, &g_telemetry_addr, g_telemetry_port);
+        pbuf_free(p);
+    }
+    // Um lote perdido aqui aparece no coletor como lacuna na sequência, como uma perda na rede
+    metrics_count(err == ERR_OK ? METRICS_UDP_DATAGRAMS : METRICS_UDP_SEND_ERRORS);
+    g_sequence++;
+    g_batch.count = 0;
+}
+
+void udp_telemetry_add(const input_snapshot_t *state) {
+    if (g_telemetry_pcb == NULL) {
+        return;
+    }
+    if (g_last_sample_us != 0 && state->timestamp_us - g_last_sample_us + UDP_TELEMETRY_JITTER_US < g_interval_us) {
+        return;
+    }
+    g_last_sample_us = state->timestamp_us;
+
+    telemetry_sample_t sample = {
+        .timestamp_us = state->timestamp_us,
+        .vrx = state->vrx,
+        .vry = state->vry,
+        .temp_raw = state->temp_raw,
+        .buttons = state->button_state_bits,
+    };
+    if (g_batch.count > 0 && !telemetry_batch_append(&g_batch, &sample)) {
+        udp_telemetry_flush(); // Variação grande demais para um delta: a amostra abre outro lote
+    }
+    if (g_batch.count == 0) {
+        telemetry_batch_start(&g_batch, g_sequence, &sample);
+    }
+    if (g_batch.count >= g_batch_samples) {
+        udp_telemetry_flush();
+    }
+}
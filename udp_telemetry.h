@@ -0,0 +1,28 @@
+/**
+ * @file udp_telemetry.h
+ * @brief Telemetria binária por UDP: lotes de amostras com delta (telemetry_codec.h) enviados a um
+ * coletor fixo ou em broadcast.
+ *
+ * O worker de publicação entrega cada snapshot; uma amostra é guardada a cada 'interval_ms' e o lote
+ * sai quando junta 'batch_samples' amostras (ou quando uma variação não cabe num delta). Com
+ * intervalo de 20 ms e lotes de 25, são 2 datagramas de 168 bytes por segundo, contra uma
+ * requisição HTTP por leitura. O coletor detecta perdas pela sequência (host/telemetry_rx.c).
+ */
+
+#ifndef UDP_TELEMETRY_H
+#define UDP_TELEMETRY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "input_state.h"
+
+// Cria o PCB UDP. 'host' é um IPv4 ("192.168.1.10", ou "255.255.255.255" para broadcast).
+// Chamar com o lock da LwIP (cyw43_arch_lwip_begin).
+bool udp_telemetry_init(const char *host, uint16_t port, uint8_t batch_samples, uint32_t interval_ms);
+
+// Acrescenta o snapshot ao lote (se o intervalo venceu) e envia o lote quando completo.
+// Chamar no contexto da LwIP (worker do async_context).
+void udp_telemetry_add(const input_snapshot_t *state);
+
+#endif /* UDP_TELEMETRY_H */
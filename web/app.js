@@ -0,0 +1,49 @@
+// Script do painel. Incorporado em index.html por tools/embed_assets.py.
+// A ordem dos vetores segue joystick_direction_t e button_event_type_t.
+var N = ['Centro', 'Norte', 'Nordeste', 'Leste', 'Sudeste', 'Sul', 'Sudoeste', 'Oeste', 'Noroeste'];
+var C = ['dir-center', 'dir-n', 'dir-ne', 'dir-e', 'dir-se', 'dir-s', 'dir-sw', 'dir-w', 'dir-nw'];
+var B = ['Nenhum', 'A', 'B'];
+
+function $(i) { return document.getElementById(i); }
+
+// Atualiza a página com o JSON de /status ou de um evento de /stream.
+function u(s) {
+  var t = $('temp');
+  t.textContent = 'Temperatura interna: ' + s.t.toFixed(2) + ' °C';
+  t.style.color = s.t < 55 ? 'green' : (s.t <= 70 ? 'orange' : 'red');
+  $('btn').textContent = 'Ultimo botão pressionado: ' + (B[s.b] || '?');
+  $('compass').className = 'compass ' + (C[s.d] || 'dir-unknown');
+  $('dir').textContent = 'Direção: ' + (N[s.d] || 'Desconhecido');
+  $('vals').textContent = 'Valores: VRx=' + s.x + ', VRy=' + s.y;
+}
+
+function p() {
+  fetch('/status', { cache: 'no-store' })
+    .then(function (r) { return r.json(); })
+    .then(u)
+    .catch(function () {})
+    .then(function () { setTimeout(p, 1000); });
+}
+
+// Usa o stream de eventos (/stream); cai para polling de /status se o navegador não suportar.
+// Uma recusa (503 com o stream cheio) fecha o EventSource de vez: lê /status uma vez e tenta
+// de novo depois do Retry-After do servidor (5 s).
+function s() {
+  var es = new EventSource('/stream');
+  es.onmessage = function (e) { u(JSON.parse(e.data)); };
+  es.onerror = function () {
+    if (es.readyState === EventSource.CLOSED) {
+      fetch('/status', { cache: 'no-store' })
+        .then(function (r) { return r.json(); })
+        .then(u)
+        .catch(function () {});
+      setTimeout(s, 5000);
+    }
+  };
+}
+
+if (window.EventSource) {
+  s();
+} else {
+  p();
+}
@@ -0,0 +1,26 @@
+# Gera web_assets.c (páginas de web/ minificadas + gzip, em arrays const) e o adiciona ao alvo.
+# Usado pelo CMakeLists.txt do firmware e pelo de host/.
+#
+#   web_embed_assets(<alvo>)
+#
+# Só os arquivos listados em WEB_ASSET_ENTRIES viram respostas; CSS e JS referenciados por eles
+# são incorporados no HTML pelo gerador, mas continuam como dependências do build.
+
+set(WEB_ASSETS_DIR ${CMAKE_CURRENT_LIST_DIR})
+set(WEB_ASSET_ENTRIES ${WEB_ASSETS_DIR}/index.html)
+
+function(web_embed_assets target)
+    find_package(Python3 REQUIRED COMPONENTS Interpreter)
+    file(GLOB web_sources ${WEB_ASSETS_DIR}/*.html ${WEB_ASSETS_DIR}/*.css ${WEB_ASSETS_DIR}/*.js)
+    set(generator ${WEB_ASSETS_DIR}/../tools/embed_assets.py)
+    set(output ${CMAKE_CURRENT_BINARY_DIR}/web_assets.c)
+
+    add_custom_command(
+        OUTPUT ${output}
+        COMMAND ${Python3_EXECUTABLE} ${generator} -o ${output} ${WEB_ASSET_ENTRIES}
+        DEPENDS ${generator} ${web_sources}
+        COMMENT "Minificando e comprimindo a interface web (web/)"
+        VERBATIM
+    )
+    target_sources(${target} PRIVATE ${output})
+endfunction()
@@ -0,0 +1,30 @@
+/**
+ * @file web_assets.h
+ * @brief Arquivos estáticos da interface web, embutidos em flash no build.
+ *
+ * web_assets.c é gerado por tools/embed_assets.py (ver web/web_assets.cmake) a partir de web/:
+ * cada arquivo é minificado e comprimido com gzip, e as duas versões ficam em arrays const com
+ * tamanho e ETag calculados no build. Nada é processado em tempo de execução.
+ */
+
+#ifndef WEB_ASSETS_H
+#define WEB_ASSETS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    const char *path;           // Ex.: "/index.html"
+    const char *content_type;
+    const char *etag;           // ETag da versão sem compressão (com aspas)
+    const char *etag_gzip;      // ETag da versão gzip (representações diferentes, ETags diferentes)
+    const uint8_t *data;        // Minificado
+    uint32_t len;
+    const uint8_t *gzip_data;   // Minificado + gzip
+    uint32_t gzip_len;
+} web_asset_t;
+
+extern const web_asset_t web_assets[];
+extern const size_t web_asset_count;
+
+#endif /* WEB_ASSETS_H */
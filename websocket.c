@@ -0,0 +1,188 @@
+#include "websocket.h"
+
+#include <string.h>
+
+// GUID fixo definido pela RFC 6455 para o cálculo do Sec-WebSocket-Accept
+static const char WS_GUID[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+// --- SHA-1 (FIPS 180-1), suficiente para o handshake: uma chamada por conexão ---
+
+typedef struct {
+    uint32_t state[5];
+    uint64_t total_len;
+    uint8_t block[64];
+    size_t block_len;
+} sha1_ctx_t;
+
+static uint32_t rol32(uint32_t value, unsigned bits) {
+    return (value << bits) | (value >> (32 - bits));
+}
+
+static void sha1_process_block(sha1_ctx_t *ctx, const uint8_t *block) {
+    uint32_t w[80];
+    for (int i = 0; i < 16; i++) {
+        w[i] = ((uint32_t)block[i * 4] << 24) | ((uint32_t)block[i * 4 + 1] << 16) |
+               ((uint32_t)block[i * 4 + 2] << 8) | (uint32_t)block[i * 4 + 3];
+    }
+    for (int i = 16; i < 80; i++) {
+        w[i] = rol32(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    }
+
+    uint32_t a = ctx->state[0], b = ctx->state[1], c = ctx->state[2], d = ctx->state[3], e = ctx->state[4];
+    for (int i = 0; i < 80; i++) {
+        uint32_t f, k;
+        if (i < 20)      { f = (b & c) | (~b & d);          k = 0x5A827999; }
+        else if (i < 40) { f = b ^ c ^ d;                   k = 0x6ED9EBA1; }
+        else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+        else             { f = b ^ c ^ d;                   k = 0xCA62C1D6; }
+        uint32_t temp = rol32(a, 5) + f + e + k + w[i];
+        e = d;
+        d = c;
+        c = rol32(b, 30);
+        b = a;
+        a = temp;
+    }
+    ctx->state[0] += a;
+    ctx->state[1] += b;
+    ctx->state[2] += c;
+    ctx->state[3] += d;
+    ctx->state[4] += e;
+}
+
+static void sha1_init(sha1_ctx_t *ctx) {
+    ctx->state[0] = 0x67452301;
+    ctx->state[1] = 0xEFCDAB89;
+    ctx->state[2] = 0x98BADCFE;
+    ctx->state[3] = 0x10325476;
+    ctx->state[4] = 0xC3D2E1F0;
+    ctx->total_len = 0;
+    ctx->block_len = 0;
+}
+
+static void sha1_update(sha1_ctx_t *ctx, const uint8_t *data, size_t len) {
+    ctx->total_len += len;
+    while (len > 0) {
+        size_t chunk = 64 - ctx->block_len;
+        if (chunk > len) chunk = len;
+        memcpy(ctx->block + ctx->block_len, data, chunk);
+        ctx->block_len += chunk;
+        data += chunk;
+        len -= chunk;
+        if (ctx->block_len == 64) {
+            sha1_process_block(ctx, ctx->block);
+            ctx->block_len = 0;
+        }
+    }
+}
+
+static void sha1_final(sha1_ctx_t *ctx, uint8_t digest[20]) {
+    uint64_t bit_len = ctx->total_len * 8;
+    uint8_t pad = 0x80;
+    sha1_update(ctx, &pad, 1);
+    pad = 0x00;
+    while (ctx->block_len != 56) {
+        sha1_update(ctx, &pad, 1);
+    }
+    uint8_t len_bytes[8];
+    for (int i = 0; i < 8; i++) {
+        len_bytes[i] = (uint8_t)(bit_len >> (56 - 8 * i));
+    }
+    sha1_update(ctx, len_bytes, 8);
+    for (int i = 0; i < 5; i++) {
+        digest[i * 4]     = (uint8_t)(ctx->state[i] >> 24);
+        digest[i * 4 + 1] = (uint8_t)(ctx->state[i] >> 16);
+        digest[i * 4 + 2] = (uint8_t)(ctx->state[i] >> 8);
+        digest[i * 4 + 3] = (uint8_t)ctx->state[i];
+    }
+}
+
+// --- Base64 (RFC 4648) ---
+
+static size_t base64_encode(const uint8_t *in, size_t len, char *out) {
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t o = 0;
+    for (size_t i = 0; i < len; i += 3) {
+        uint32_t triple = (uint32_t)in[i] << 16;
+        if (i + 1 < len) triple |= (uint32_t)in[i + 1] << 8;
+        if (i + 2 < len) triple |= in[i + 2];
+        out[o++] = alphabet[(triple >> 18) & 0x3F];
+        out[o++] = alphabet[(triple >> 12) & 0x3F];
+        out[o++] = (i + 1 < len) ? alphabet[(triple >> 6) & 0x3F] : '=';
+        out[o++] = (i + 2 < len) ? alphabet[triple & 0x3F] : '=';
+    }
+    out[o] = '\0';
+    return o;
+}
+
+// --- API pública ---
+
+void ws_compute_accept_key(const char *client_key, size_t client_key_len, char out[WS_ACCEPT_LEN + 1]) {
+    sha1_ctx_t ctx;
+    uint8_t digest[20];
+    sha1_init(&ctx);
+    sha1_update(&ctx, (const uint8_t *)client_key, client_key_len);
+    sha1_update(&ctx, (const uint8_t *)WS_GUID, sizeof(WS_GUID) - 1);
+    sha1_final(&ctx, digest);
+    base64_encode(digest, sizeof(digest), out);
+}
+
+size_t ws_encode_frame_header(uint8_t *out, ws_opcode_t opcode, uint64_t payload_len) {
+    out[0] = 0x80 | (uint8_t)opcode; // FIN + opcode
+    if (payload_len < 126) {
+        out[1] = (uint8_t)payload_len;
+        return 2;
+    }
+    if (payload_len <= 0xFFFF) {
+        out[1] = 126;
+        out[2] = (uint8_t)(payload_len >> 8);
+        out[3] = (uint8_t)payload_len;
+        return 4;
+    }
+    out[1] = 127;
+    for (int i = 0; i < 8; i++) {
+        out[2 + i] = (uint8_t)(payload_len >> (56 - 8 * i));
+    }
+    return 10;
+}
+
+int ws_parse_frame_header(const uint8_t *buf, size_t len, uint64_t max_payload, ws_frame_info_t *info) {
+    if (len < 2) return 0;
+    info->fin = (buf[0] & 0x80) != 0;
+    info->opcode = buf[0] & 0x0F;
+    info->masked = (buf[1] & 0x80) != 0;
+
+    size_t pos = 2;
+    uint64_t payload_len = buf[1] & 0x7F;
+    if (payload_len == 126) {
+        if (len < pos + 2) return 0;
+        payload_len = ((uint64_t)buf[2] << 8) | buf[3];
+        pos += 2;
+    } else if (payload_len == 127) {
+        if (len < pos + 8) return 0;
+        payload_len = 0;
+        for (int i = 0; i < 8; i++) {
+            payload_len = (payload_len << 8) | buf[2 + i];
+        }
+        pos += 8;
+        if (payload_len >> 63) {
+            return WS_PARSE_INVALID;
+        }
+    }
+    if (payload_len > max_payload) {
+        return WS_PARSE_TOO_BIG;
+    }
+    if (info->masked) {
+        if (len < pos + 4) return 0;
+        memcpy(info->mask, buf + pos, 4);
+        pos += 4;
+    }
+    info->header_len = pos;
+    info->payload_len = payload_len;
+    return 1;
+}
+
+void ws_apply_mask(uint8_t *payload, size_t len, const uint8_t mask[4]) {
+    for (size_t i = 0; i < len; i++) {
+        payload[i] ^= mask[i & 3];
+    }
+}
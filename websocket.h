@@ -0,0 +1,61 @@
+/**
+ * @file websocket.h
+ * @brief Funções auxiliares do protocolo WebSocket (RFC 6455) usadas pelo servidor em main.c.
+ *
+ * Aqui fica apenas a parte "pura" do protocolo (handshake SHA-1/base64 e codificação/decodificação
+ * de cabeçalhos de quadro), sem dependência da LwIP. O envio e a recepção pela rede ficam em main.c.
+ */
+
+#ifndef WEBSOCKET_H
+#define WEBSOCKET_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define WS_KEY_LEN 24        // Sec-WebSocket-Key: 16 bytes aleatórios em base64
+#define WS_ACCEPT_LEN 28     // Sec-WebSocket-Accept: SHA-1 (20 bytes) em base64
+#define WS_MAX_HEADER_LEN 14 // Maior cabeçalho possível (payload de 64 bits + máscara)
+
+// Opcodes definidos pela RFC 6455, seção 5.2
+typedef enum {
+    WS_OPCODE_CONTINUATION = 0x0,
+    WS_OPCODE_TEXT = 0x1,
+    WS_OPCODE_BINARY = 0x2,
+    WS_OPCODE_CLOSE = 0x8,
+    WS_OPCODE_PING = 0x9,
+    WS_OPCODE_PONG = 0xA
+} ws_opcode_t;
+
+// Códigos de fechamento usados pelo servidor (RFC 6455, seção 7.4.1)
+#define WS_CLOSE_NORMAL 1000
+#define WS_CLOSE_PROTOCOL_ERROR 1002
+#define WS_CLOSE_TOO_BIG 1009
+
+typedef struct {
+    bool fin;
+    uint8_t opcode;
+    bool masked;
+    uint8_t mask[4];
+    size_t header_len;
+    uint64_t payload_len;
+} ws_frame_info_t;
+
+// Calcula Sec-WebSocket-Accept = base64(SHA-1(chave + GUID)). 'out' recebe WS_ACCEPT_LEN + '\0'.
+void ws_compute_accept_key(const char *client_key, size_t client_key_len, char out[WS_ACCEPT_LEN + 1]);
+
+// Escreve o cabeçalho de um quadro servidor->cliente (FIN=1, sem máscara). Retorna o tamanho (2, 4 ou 10).
+size_t ws_encode_frame_header(uint8_t *out, ws_opcode_t opcode, uint64_t payload_len);
+
+// Resultados de ws_parse_frame_header() além de 1 (completo) e 0 (faltam bytes)
+#define WS_PARSE_INVALID -1  // Tamanho de 64 bits com o bit mais significativo ligado (seção 5.2)
+#define WS_PARSE_TOO_BIG -2  // Payload maior que 'max_payload'
+
+// Decodifica o cabeçalho de um quadro recebido. Retorna 1 se o cabeçalho está completo, 0 se
+// faltam bytes, ou WS_PARSE_INVALID/WS_PARSE_TOO_BIG assim que o tamanho é lido.
+int ws_parse_frame_header(const uint8_t *buf, size_t len, uint64_t max_payload, ws_frame_info_t *info);
+
+// Aplica (ou remove) a máscara do cliente sobre o payload, no próprio buffer.
+void ws_apply_mask(uint8_t *payload, size_t len, const uint8_t mask[4]);
+
+#endif /* WEBSOCKET_H */
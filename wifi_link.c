@@ -0,0 +1,104 @@
+#include "wifi_link.h"
+
+#include <stdio.h>
+
+#include "pico/cyw43_arch.h"
+#include "lwip/ip_addr.h"
+#include "lwip/netif.h"
+
+typedef enum {
+    WIFI_LINK_CONNECTING,
+    WIFI_LINK_UP,
+    WIFI_LINK_BACKOFF          // Esperando 'g_retry_at' para a próxima tentativa
+} wifi_link_state_t;
+
+static const char *g_ssid;
+static const char *g_password;
+static uint32_t g_auth;
+static wifi_link_change_fn g_on_change;
+
+static wifi_link_state_t g_state;
+static absolute_time_t g_attempt_start;
+static absolute_time_t g_retry_at;
+static uint32_t g_backoff_ms = WIFI_BACKOFF_MIN_MS;
+static wifi_link_stats_t g_stats;
+
+static void wifi_link_do_work(async_context_t *context, async_at_time_worker_t *worker);
+static async_at_time_worker_t g_link_worker = { .do_work = wifi_link_do_work };
+
+// Desiste da associação em curso e agenda a próxima após 'delay_ms'.
+static void wifi_link_schedule_retry(uint32_t delay_ms) {
+    cyw43_wifi_leave(&cyw43_state, CYW43_ITF_STA);
+    g_retry_at = make_timeout_time_ms(delay_ms);
+    g_state = WIFI_LINK_BACKOFF;
+}
+
+static void wifi_link_attempt_failed(int status) {
+    g_stats.failures++;
+    printf("AVISO WIFI: Falha ao conectar a '%s' (código %d). Nova tentativa em %lu ms.\n",
+           g_ssid, status, (unsigned long)g_backoff_ms);
+    wifi_link_schedule_retry(g_backoff_ms);
+    g_backoff_ms = (g_backoff_ms >= WIFI_BACKOFF_MAX_MS / 2) ? WIFI_BACKOFF_MAX_MS : g_backoff_ms * 2;
+}
+
+static void wifi_link_begin_attempt(void) {
+    g_stats.attempts++;
+    g_state = WIFI_LINK_CONNECTING;
+    g_attempt_start = get_absolute_time();
+    int err = cyw43_arch_wifi_connect_async(g_ssid, g_password, g_auth);
+    if (err != 0) {
+        wifi_link_attempt_failed(err);
+    }
+}
+
+static void wifi_link_do_work(async_context_t *context, async_at_time_worker_t *worker) {
+    int status = cyw43_tcpip_link_status(&cyw43_state, CYW43_ITF_STA);
+    switch (g_state) {
+        case WIFI_LINK_CONNECTING:
+            if (status == CYW43_LINK_UP) {
+                g_state = WIFI_LINK_UP;
+                g_backoff_ms = WIFI_BACKOFF_MIN_MS;
+                g_stats.connects++;
+                g_stats.up = true;
+                printf("INFO: Wi-Fi conectado a '%s' (tentativa %lu). Endereço IP: %s\n", g_ssid,
+                       (unsigned long)g_stats.attempts, ipaddr_ntoa(netif_ip_addr4(netif_default)));
+                g_on_change(true);
+            } else if (status < 0) {
+                wifi_link_attempt_failed(status); // CYW43_LINK_FAIL, _NONET ou _BADAUTH
+            } else if (absolute_time_diff_us(g_attempt_start, get_absolute_time()) > WIFI_CONNECT_TIMEOUT_MS * 1000ll) {
+                wifi_link_attempt_failed(status); // Preso em JOIN/NOIP (ex.: DHCP sem resposta)
+            }
+            break;
+        case WIFI_LINK_UP:
+            if (status != CYW43_LINK_UP) {
+                g_stats.disconnects++;
+                g_stats.up = false;
+                printf("AVISO WIFI: Enlace perdido (estado %d). Reconectando em %d ms.\n", status, WIFI_BACKOFF_MIN_MS);
+                g_on_change(false);
+                wifi_link_schedule_retry(WIFI_BACKOFF_MIN_MS);
+            }
+            break;
+        case WIFI_LINK_BACKOFF:
+            if (time_reached(g_retry_at)) {
+                wifi_link_begin_attempt();
+            }
+            break;
+    }
+    async_context_add_at_time_worker_in_ms(context, worker, WIFI_LINK_POLL_MS);
+}
+
+void wifi_link_start(const char *ssid, const char *password, uint32_t auth, wifi_link_change_fn on_change) {
+    g_ssid = ssid;
+    g_password = password;
+    g_auth = auth;
+    g_on_change = on_change;
+    printf("INFO: Conectando a '%s' em segundo plano...\n", ssid);
+    cyw43_arch_lwip_begin();
+    wifi_link_begin_attempt();
+    cyw43_arch_lwip_end();
+    async_context_add_at_time_worker_in_ms(cyw43_arch_async_context(), &g_link_worker, WIFI_LINK_POLL_MS);
+}
+
+void wifi_link_get_stats(wifi_link_stats_t *out) {
+    *out = g_stats;
+}
@@ -0,0 +1,42 @@
+/**
+ * @file wifi_link.h
+ * @brief Conexão Wi-Fi assíncrona com monitoramento do enlace e reconexão com backoff.
+ *
+ * wifi_link_start() só dispara a associação (cyw43_arch_wifi_connect_async) e retorna: o boot
+ * segue, e a amostragem e o histórico já rodam enquanto o rádio associa. Um worker do
+ * async_context confere o estado a cada WIFI_LINK_POLL_MS:
+ *  - conectando: enlace com IP => conectado; falha (senha, rede ausente) ou WIFI_CONNECT_TIMEOUT_MS
+ *    sem IP => nova tentativa após o backoff, que dobra a cada falha até WIFI_BACKOFF_MAX_MS;
+ *  - conectado: perda do enlace ou do IP => desconecta e tenta de novo após WIFI_BACKOFF_MIN_MS.
+ * Cada transição chama 'on_change' no contexto da LwIP (lock já tomado).
+ */
+
+#ifndef WIFI_LINK_H
+#define WIFI_LINK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define WIFI_LINK_POLL_MS 250
+#define WIFI_CONNECT_TIMEOUT_MS 20000 // Associação + DHCP
+#define WIFI_BACKOFF_MIN_MS 1000
+#define WIFI_BACKOFF_MAX_MS 60000
+
+// 'up' = true: conectado e com IP; false: enlace perdido.
+typedef void (*wifi_link_change_fn)(bool up);
+
+typedef struct {
+    bool up;
+    uint32_t attempts;         // Chamadas a cyw43_arch_wifi_connect_async
+    uint32_t connects;         // Tentativas que chegaram a ter IP
+    uint32_t failures;         // Tentativas que falharam ou expiraram
+    uint32_t disconnects;      // Enlace perdido depois de conectado
+} wifi_link_stats_t;
+
+// Inicia a primeira tentativa e registra o worker de monitoramento. Chamar após cyw43_arch_init()
+// e cyw43_arch_enable_sta_mode(). As strings devem permanecer válidas.
+void wifi_link_start(const char *ssid, const char *password, uint32_t auth, wifi_link_change_fn on_change);
+
+void wifi_link_get_stats(wifi_link_stats_t *out);
+
+#endif /* WIFI_LINK_H */